@@ -28,6 +28,70 @@ endif
 
 include $(BUILD_LIBRARY)
 
+###############################################################################
+# io-bench
+###############################################################################
+
+include $(CLEAR_VARS)
+
+LOCAL_MODULE := io-bench-sep
+LOCAL_DESCRIPTION := Benchmark of the libioutils separator source
+LOCAL_CATEGORY_PATH := devel
+
+LOCAL_SRC_FILES := bench/io_src_sep_bench.c
+
+LOCAL_LIBRARIES := libioutils libutils
+
+include $(BUILD_EXECUTABLE)
+
+include $(CLEAR_VARS)
+
+LOCAL_MODULE := io-bench-sock
+LOCAL_DESCRIPTION := Benchmark of the libioutils socket sources
+LOCAL_CATEGORY_PATH := devel
+
+LOCAL_SRC_FILES := bench/io_src_sock_bench.c
+
+LOCAL_LIBRARIES := libioutils libutils
+
+include $(BUILD_EXECUTABLE)
+
+include $(CLEAR_VARS)
+
+LOCAL_MODULE := io-bench-inot
+LOCAL_DESCRIPTION := Benchmark of the libioutils inotify source
+LOCAL_CATEGORY_PATH := devel
+
+LOCAL_SRC_FILES := bench/io_src_inot_bench.c
+
+LOCAL_LIBRARIES := libioutils libutils
+
+include $(BUILD_EXECUTABLE)
+
+include $(CLEAR_VARS)
+
+LOCAL_MODULE := io-bench-busy-poll
+LOCAL_DESCRIPTION := Benchmark of the libioutils monitor busy-polling
+LOCAL_CATEGORY_PATH := devel
+
+LOCAL_SRC_FILES := bench/io_mon_busy_poll_bench.c
+
+LOCAL_LIBRARIES := libioutils libutils
+
+include $(BUILD_EXECUTABLE)
+
+include $(CLEAR_VARS)
+
+LOCAL_MODULE := io-bench-shm
+LOCAL_DESCRIPTION := Benchmark of the libioutils shared memory ring source
+LOCAL_CATEGORY_PATH := devel
+
+LOCAL_SRC_FILES := bench/io_src_shm_bench.c
+
+LOCAL_LIBRARIES := libioutils librs libutils
+
+include $(BUILD_EXECUTABLE)
+
 ###############################################################################
 # tst-libioutils
 ###############################################################################
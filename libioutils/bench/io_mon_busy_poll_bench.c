@@ -0,0 +1,224 @@
+/**
+ * @file io_mon_busy_poll_bench.c
+ * @brief Benchmark of the busy-polling of io_mon, a child process echoes the
+ * bytes it receives on a pipe to another pipe, the parent measures the round
+ * trip latency, both sides running an io_mon with the same busy-polling
+ * policy. An optional pause between round trips shows how the adaptive policy
+ * behaves with rarer events. Busy-polling only pays off when both processes
+ * have a core of their own, on a single core, the spinning side delays the
+ * other one until it's time slice ends.
+ *
+ * usage: io_mon_busy_poll_bench [nb_round_trips [interval_us [duration_us]]]
+ *
+ * Copyright (C) 2026 Parrot S.A.
+ */
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif /* _GNU_SOURCE */
+#include <sys/wait.h>
+
+#include <unistd.h>
+
+#include <stdbool.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <inttypes.h>
+#include <time.h>
+#include <errno.h>
+#include <error.h>
+
+#include <ut_utils.h>
+#include <ut_file.h>
+
+#include <io_mon.h>
+#include <io_utils.h>
+
+#define DEFAULT_NB_ROUND_TRIPS 20000
+#define DEFAULT_INTERVAL_US 0
+#define DEFAULT_DURATION_US 1000
+
+struct endpoint {
+	struct io_mon mon;
+	struct io_src src;
+	int out;
+	bool received;
+	bool done;
+};
+
+struct bench_policy {
+	enum io_mon_busy_poll busy_poll;
+	const char *name;
+};
+
+static double now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static int compare_doubles(const void *a, const void *b)
+{
+	double da = *(const double *)a;
+	double db = *(const double *)b;
+
+	return (da > db) - (da < db);
+}
+
+static void echo_cb(struct io_src *src)
+{
+	struct endpoint *e = ut_container_of(src, struct endpoint, src);
+	char c;
+	ssize_t sret;
+
+	sret = io_read(src->fd, &c, 1);
+	if (sret <= 0) {
+		e->done = true;
+		return;
+	}
+	if (io_write(e->out, &c, 1) != 1)
+		error(EXIT_FAILURE, errno, "write");
+}
+
+static void pong_cb(struct io_src *src)
+{
+	struct endpoint *e = ut_container_of(src, struct endpoint, src);
+	char c;
+
+	if (io_read(src->fd, &c, 1) != 1)
+		error(EXIT_FAILURE, errno, "read");
+	e->received = true;
+}
+
+static void init_endpoint(struct endpoint *e, int in, int out,
+		io_src_cb *cb, const struct bench_policy *p,
+		unsigned duration_us)
+{
+	int ret;
+
+	memset(e, 0, sizeof(*e));
+	e->out = out;
+	ret = io_mon_init(&e->mon);
+	if (ret < 0)
+		error(EXIT_FAILURE, -ret, "io_mon_init");
+	ret = io_mon_set_busy_poll(&e->mon, p->busy_poll, duration_us);
+	if (ret < 0)
+		error(EXIT_FAILURE, -ret, "io_mon_set_busy_poll");
+	io_src_init(&e->src, in, IO_IN, cb);
+	ret = io_mon_add_source(&e->mon, &e->src);
+	if (ret < 0)
+		error(EXIT_FAILURE, -ret, "io_mon_add_source");
+}
+
+static void echo(int in, int out, const struct bench_policy *p,
+		unsigned duration_us)
+{
+	struct endpoint e;
+	int ret;
+
+	init_endpoint(&e, in, out, echo_cb, p, duration_us);
+	while (!e.done) {
+		ret = io_mon_poll(&e.mon, -1);
+		if (ret < 0)
+			error(EXIT_FAILURE, -ret, "io_mon_poll");
+	}
+	io_mon_clean(&e.mon);
+}
+
+static void run(const struct bench_policy *p, unsigned long nb_round_trips,
+		unsigned interval_us, unsigned duration_us)
+{
+	int ping[2];
+	int pong[2];
+	pid_t pid;
+	struct endpoint e;
+	struct io_mon_busy_poll_stats stats;
+	double *latencies;
+	double start;
+	double total = 0;
+	unsigned long i;
+	int ret;
+
+	latencies = calloc(nb_round_trips, sizeof(*latencies));
+	if (NULL == latencies)
+		error(EXIT_FAILURE, ENOMEM, "calloc");
+	if (-1 == pipe(ping) || -1 == pipe(pong))
+		error(EXIT_FAILURE, errno, "pipe");
+
+	pid = fork();
+	if (-1 == pid)
+		error(EXIT_FAILURE, errno, "fork");
+	if (0 == pid) {
+		close(ping[1]);
+		close(pong[0]);
+		echo(ping[0], pong[1], p, duration_us);
+		_exit(EXIT_SUCCESS);
+	}
+	ut_file_fd_close(&ping[0]);
+	ut_file_fd_close(&pong[1]);
+
+	init_endpoint(&e, pong[0], ping[1], pong_cb, p, duration_us);
+	for (i = 0; i < nb_round_trips; i++) {
+		if (interval_us != 0)
+			usleep(interval_us);
+		e.received = false;
+		start = now();
+		if (io_write(e.out, "x", 1) != 1)
+			error(EXIT_FAILURE, errno, "write");
+		while (!e.received) {
+			ret = io_mon_poll(&e.mon, -1);
+			if (ret < 0)
+				error(EXIT_FAILURE, -ret, "io_mon_poll");
+		}
+		latencies[i] = now() - start;
+		total += latencies[i];
+	}
+	io_mon_get_busy_poll_stats(&e.mon, &stats);
+
+	ut_file_fd_close(&ping[1]);
+	io_waitpid(pid, NULL, 0);
+	io_mon_clean(&e.mon);
+	ut_file_fd_close(&pong[0]);
+
+	qsort(latencies, nb_round_trips, sizeof(*latencies), compare_doubles);
+	printf("%-10s avg %8.2f us p50 %8.2f us p99 %8.2f us "
+			"spins %10"PRIu64" hits %8"PRIu64" blocking %8"PRIu64"\n",
+			p->name, total / nb_round_trips * 1e6,
+			latencies[nb_round_trips / 2] * 1e6,
+			latencies[nb_round_trips * 99 / 100] * 1e6,
+			stats.spins, stats.hits, stats.blocking_waits);
+
+	free(latencies);
+}
+
+int main(int argc, char *argv[])
+{
+	unsigned long nb_round_trips = DEFAULT_NB_ROUND_TRIPS;
+	unsigned interval_us = DEFAULT_INTERVAL_US;
+	unsigned duration_us = DEFAULT_DURATION_US;
+	const struct bench_policy policies[] = {
+		{.busy_poll = IO_MON_BUSY_POLL_OFF, .name = "off"},
+		{.busy_poll = IO_MON_BUSY_POLL_FIXED, .name = "fixed"},
+		{.busy_poll = IO_MON_BUSY_POLL_ADAPTIVE, .name = "adaptive"},
+	};
+	unsigned i;
+
+	if (argc > 1)
+		nb_round_trips = strtoul(argv[1], NULL, 0);
+	if (argc > 2)
+		interval_us = strtoul(argv[2], NULL, 0);
+	if (argc > 3)
+		duration_us = strtoul(argv[3], NULL, 0);
+	if (nb_round_trips == 0)
+		error(EXIT_FAILURE, EINVAL, "nb_round_trips");
+
+	printf("%lu round trips, %u us apart, spinning up to %u us\n",
+			nb_round_trips, interval_us, duration_us);
+	for (i = 0; i < UT_ARRAY_SIZE(policies); i++)
+		run(policies + i, nb_round_trips, interval_us, duration_us);
+
+	return EXIT_SUCCESS;
+}
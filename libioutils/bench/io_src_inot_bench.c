@@ -0,0 +1,191 @@
+/**
+ * @file io_src_inot_bench.c
+ * @brief Benchmark of the inotify source, with a large number of watches. A
+ * temporary tree of directories is created, then the time needed for adding a
+ * watch on each of them, for updating them, for removing them and for watching
+ * the whole tree with a recursive watch, is measured.
+ *
+ * usage: io_src_inot_bench [nb_directories]
+ *
+ * Copyright (C) 2026 Parrot S.A.
+ */
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif /* _GNU_SOURCE */
+#include <sys/stat.h>
+
+#include <ftw.h>
+#include <unistd.h>
+
+#include <stdbool.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <errno.h>
+#include <error.h>
+
+#include <ut_utils.h>
+
+#include <io_src_inot.h>
+
+#define DEFAULT_NB_DIRECTORIES 50000
+#define DIRS_PER_LEVEL 200
+#define MAX_USER_WATCHES "/proc/sys/fs/inotify/max_user_watches"
+/* watches left for the other processes of the user */
+#define WATCHES_MARGIN 256
+
+static double now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void report(const char *name, unsigned long count, double elapsed)
+{
+	printf("%-12s %8lu watches %8.3f s %10.0f ns/watch\n", name, count,
+			elapsed, elapsed * 1e9 / count);
+}
+
+static void dummy_cb(struct io_src_inot *inot, struct inotify_event *evt,
+		struct io_src_inot_watch *watch)
+{
+
+}
+
+static unsigned long max_user_watches(void)
+{
+	FILE *f;
+	unsigned long max = 0;
+
+	f = fopen(MAX_USER_WATCHES, "re");
+	if (f == NULL)
+		return 0;
+	if (fscanf(f, "%lu", &max) != 1)
+		max = 0;
+	fclose(f);
+
+	return max;
+}
+
+static int remove_entry(const char *path, const struct stat *st, int flag,
+		struct FTW *ftw)
+{
+	return remove(path);
+}
+
+/*
+ * builds a two levels tree of nb directories below root, not counting it,
+ * returns their paths
+ */
+static char **create_tree(const char *root, unsigned long nb)
+{
+	char **paths;
+	unsigned long i;
+	unsigned long top = 0;
+	int ret;
+
+	paths = calloc(nb, sizeof(*paths));
+	if (paths == NULL)
+		error(EXIT_FAILURE, errno, "calloc");
+
+	for (i = 0; i < nb; i++) {
+		if (i % (DIRS_PER_LEVEL + 1) == 0) {
+			top = i;
+			ret = asprintf(paths + i, "%s/%lu", root, i);
+		} else {
+			ret = asprintf(paths + i, "%s/%lu", paths[top], i);
+		}
+		if (ret < 0)
+			error(EXIT_FAILURE, errno, "asprintf");
+		if (mkdir(paths[i], S_IRWXU) < 0)
+			error(EXIT_FAILURE, errno, "mkdir %s", paths[i]);
+	}
+
+	return paths;
+}
+
+int main(int argc, char *argv[])
+{
+	int ret;
+	char root[] = "/tmp/io_src_inot_bench.XXXXXX";
+	char **paths;
+	unsigned long nb = DEFAULT_NB_DIRECTORIES;
+	unsigned long max;
+	unsigned long i;
+	double start;
+	struct io_src_inot inot;
+	struct io_src_inot_watch watch = {
+		.events = IN_CREATE | IN_DELETE | IN_MOVE,
+		.cb = dummy_cb,
+	};
+
+	if (argc > 1)
+		nb = strtoul(argv[1], NULL, 0);
+	max = max_user_watches();
+	if (max > WATCHES_MARGIN && nb + 1 > max - WATCHES_MARGIN) {
+		nb = max - WATCHES_MARGIN - 1;
+		fprintf(stderr, "%s limits the number of directories to %lu\n",
+				MAX_USER_WATCHES, nb);
+	}
+
+	if (mkdtemp(root) == NULL)
+		error(EXIT_FAILURE, errno, "mkdtemp");
+	paths = create_tree(root, nb);
+
+	ret = io_src_inot_init(&inot);
+	if (ret < 0)
+		error(EXIT_FAILURE, -ret, "io_src_inot_init");
+
+	start = now();
+	for (i = 0; i < nb; i++) {
+		watch.path = paths[i];
+		ret = io_src_inot_add_watch(&inot, &watch);
+		if (ret < 0)
+			error(EXIT_FAILURE, -ret, "io_src_inot_add_watch");
+	}
+	report("add", nb, now() - start);
+
+	watch.events |= IN_ATTRIB;
+	start = now();
+	for (i = 0; i < nb; i++) {
+		watch.path = paths[i];
+		ret = io_src_inot_add_watch(&inot, &watch);
+		if (ret < 0)
+			error(EXIT_FAILURE, -ret, "io_src_inot_add_watch");
+	}
+	report("update", nb, now() - start);
+
+	start = now();
+	for (i = 0; i < nb; i++) {
+		watch.path = paths[i];
+		ret = io_src_inot_rm_watch(&inot, &watch);
+		if (ret < 0)
+			error(EXIT_FAILURE, -ret, "io_src_inot_rm_watch");
+	}
+	report("remove", nb, now() - start);
+
+	watch.path = root;
+	start = now();
+	ret = io_src_inot_add_watch_recursive(&inot, &watch);
+	if (ret < 0)
+		error(EXIT_FAILURE, -ret, "io_src_inot_add_watch_recursive");
+	report("recursive", io_src_inot_get_watch_count(&inot), now() - start);
+
+	start = now();
+	ret = io_src_inot_rm_watch(&inot, &watch);
+	if (ret < 0)
+		error(EXIT_FAILURE, -ret, "io_src_inot_rm_watch");
+	report("remove tree", nb + 1, now() - start);
+
+	io_src_inot_clean(&inot);
+	for (i = 0; i < nb; i++)
+		free(paths[i]);
+	free(paths);
+	nftw(root, remove_entry, 16, FTW_DEPTH | FTW_PHYS);
+
+	return EXIT_SUCCESS;
+}
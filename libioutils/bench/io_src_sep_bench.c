@@ -0,0 +1,189 @@
+/**
+ * @file io_src_sep_bench.c
+ * @brief Benchmark of the separator source, measures the number of lines per
+ * second parsed for short and long lines, fed through a pipe by a child
+ * process, in per-line and in batch mode.
+ *
+ * usage: io_src_sep_bench [nb_lines [buffer_size]]
+ *
+ * Copyright (C) 2012 Parrot S.A.
+ */
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif /* _GNU_SOURCE */
+#include <sys/wait.h>
+
+#include <signal.h>
+
+#include <unistd.h>
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <errno.h>
+#include <error.h>
+
+#include <ut_utils.h>
+#include <ut_file.h>
+
+#include <io_mon.h>
+#include <io_utils.h>
+#include <io_src_sep.h>
+
+#define DEFAULT_NB_LINES 1000000
+#define WRITE_BATCH 0x10000
+
+struct bench_sep {
+	struct io_src_sep sep;
+	unsigned long lines;
+};
+
+static void bench_cb(struct io_src_sep *sep, char *chunk, unsigned len)
+{
+	struct bench_sep *bench = ut_container_of(sep, struct bench_sep, sep);
+
+	if (0 != len)
+		bench->lines++;
+}
+
+static void bench_batch_cb(struct io_src_sep *sep,
+		struct io_src_sep_chunk *chunks, unsigned nb_chunks)
+{
+	struct bench_sep *bench = ut_container_of(sep, struct bench_sep, sep);
+
+	bench->lines += nb_chunks;
+}
+
+static double now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void writer(int fd, unsigned long nb_lines, unsigned line_len,
+		const char *delim)
+{
+	char *buf;
+	size_t delim_len = strlen(delim);
+	size_t per_batch = WRITE_BATCH / (line_len + delim_len);
+	size_t i;
+	size_t len;
+	unsigned long written = 0;
+
+	if (0 == per_batch)
+		per_batch = 1;
+	buf = malloc(per_batch * (line_len + delim_len));
+	if (NULL == buf)
+		_exit(EXIT_FAILURE);
+	for (i = 0; i < per_batch; i++) {
+		memset(buf + i * (line_len + delim_len), 'a' + i % 26,
+				line_len);
+		memcpy(buf + i * (line_len + delim_len) + line_len, delim,
+				delim_len);
+	}
+
+	while (written < nb_lines) {
+		i = nb_lines - written < per_batch ? nb_lines - written :
+				per_batch;
+		len = i * (line_len + delim_len);
+		if (io_write(fd, buf, len) != (ssize_t)len)
+			_exit(EXIT_FAILURE);
+		written += i;
+	}
+
+	/*
+	 * a hang up would make the monitor drop the source before all the data
+	 * is consumed, so wait for the parent to kill us
+	 */
+	while (1)
+		pause();
+}
+
+static void run(unsigned long nb_lines, unsigned line_len, const char *delim,
+		const char *name, unsigned size, int batch)
+{
+	int ret;
+	int pipefd[2];
+	pid_t pid;
+	struct io_mon mon;
+	struct bench_sep bench = {.lines = 0};
+	double start;
+	double elapsed;
+
+	if (-1 == pipe(pipefd))
+		error(EXIT_FAILURE, errno, "pipe");
+
+	pid = fork();
+	if (-1 == pid)
+		error(EXIT_FAILURE, errno, "fork");
+	if (0 == pid) {
+		close(pipefd[0]);
+		writer(pipefd[1], nb_lines, line_len, delim);
+	}
+	ut_file_fd_close(&pipefd[1]);
+
+	ret = io_mon_init(&mon);
+	if (ret < 0)
+		error(EXIT_FAILURE, -ret, "io_mon_init");
+	if (batch)
+		ret = io_src_sep_init_batch(&bench.sep, pipefd[0],
+				bench_batch_cb, delim, strlen(delim), size);
+	else
+		ret = io_src_sep_init_delim(&bench.sep, pipefd[0], bench_cb,
+				delim, strlen(delim), size);
+	if (ret < 0)
+		error(EXIT_FAILURE, -ret, "io_src_sep_init");
+	ret = io_mon_add_source(&mon, io_src_sep_get_source(&bench.sep));
+	if (ret < 0)
+		error(EXIT_FAILURE, -ret, "io_mon_add_source");
+
+	start = now();
+	while (bench.lines < nb_lines) {
+		ret = io_mon_poll(&mon, -1);
+		if (ret < 0)
+			error(EXIT_FAILURE, -ret, "io_mon_poll");
+	}
+	elapsed = now() - start;
+
+	printf("%-24s %-6s %8u %10lu lines %8.3f s %12.0f lines/s\n", name,
+			batch ? "batch" : "line", line_len, bench.lines,
+			elapsed, bench.lines / elapsed);
+
+	io_mon_clean(&mon);
+	io_src_sep_clean(&bench.sep);
+	ut_file_fd_close(&pipefd[0]);
+	kill(pid, SIGTERM);
+	io_waitpid(pid, NULL, 0);
+}
+
+int main(int argc, char *argv[])
+{
+	unsigned long nb_lines = DEFAULT_NB_LINES;
+	unsigned size = IO_SRC_SEP_SIZE;
+	int batch;
+
+	if (argc > 1)
+		nb_lines = strtoul(argv[1], NULL, 0);
+	if (argc > 2)
+		size = strtoul(argv[2], NULL, 0);
+
+	printf("%-24s %-6s %8s %16s %10s %18s\n", "delimiter", "mode",
+			"line len", "lines", "time", "rate");
+	for (batch = 0; batch < 2; batch++) {
+		run(nb_lines, 16, "\n", "\\n, short lines", size, batch);
+		run(nb_lines, size / 2, "\n", "\\n, long lines", size, batch);
+		run(nb_lines, 16, "\r\n", "\\r\\n, short lines", size, batch);
+		run(nb_lines, size / 2, "\r\n", "\\r\\n, long lines", size,
+				batch);
+		run(nb_lines, 16, "\r\n\r\n", "\\r\\n\\r\\n, short lines",
+				size, batch);
+		run(nb_lines, size / 2, "\r\n\r\n", "\\r\\n\\r\\n, long lines",
+				size, batch);
+	}
+
+	return EXIT_SUCCESS;
+}
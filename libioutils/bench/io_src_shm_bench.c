@@ -0,0 +1,245 @@
+/**
+ * @file io_src_shm_bench.c
+ * @brief Benchmark of the shared memory ring source, measures the number of
+ * fixed size messages per second sent by a child process and received through
+ * an io_src_shm, compared to an UAD source, in plain and in batch mode.
+ *
+ * usage: io_src_shm_bench [nb_messages]
+ *
+ * Copyright (C) 2026 Parrot S.A.
+ */
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif /* _GNU_SOURCE */
+#include <sys/socket.h>
+
+#include <sched.h>
+#include <unistd.h>
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <errno.h>
+#include <error.h>
+
+#include <ut_utils.h>
+#include <ut_file.h>
+
+#include <io_mon.h>
+#include <io_utils.h>
+#include <io_src_msg_uad.h>
+#include <io_src_shm.h>
+
+#define DEFAULT_NB_MESSAGES 1000000
+#define MAX_MSG_SIZE 1024
+#define NB_SLOTS 64
+#define SHM_SIZE 0x40000
+
+enum mode {
+	MODE_UAD,
+	MODE_UAD_BATCH,
+	MODE_SHM,
+};
+
+static const char * const mode_names[] = {
+	[MODE_UAD] = "uad",
+	[MODE_UAD_BATCH] = "uad batch",
+	[MODE_SHM] = "shm",
+};
+
+struct bench {
+	struct io_src_msg_uad uad;
+	struct io_src_shm shm;
+	char msg[MAX_MSG_SIZE];
+	unsigned long msgs;
+};
+
+static void uad_cb(struct io_src_msg_uad *uad, enum io_src_event evt)
+{
+	struct bench *bench = ut_container_of(uad, struct bench, uad);
+
+	if (IO_IN == evt)
+		bench->msgs++;
+}
+
+static void uad_batch_cb(struct io_src_msg_uad *uad, enum io_src_event evt,
+		const struct iovec *msgs, unsigned nb_msgs)
+{
+	struct bench *bench = ut_container_of(uad, struct bench, uad);
+
+	bench->msgs += nb_msgs;
+}
+
+static void shm_cb(struct io_src_shm *shm, const void *msg, size_t len)
+{
+	struct bench *bench = ut_container_of(shm, struct bench, shm);
+
+	bench->msgs++;
+}
+
+static double now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void uad_writer(struct bench *bench, unsigned long nb_msgs,
+		unsigned len, int batch)
+{
+	static char buf[MAX_MSG_SIZE];
+	struct iovec iov = {.iov_base = buf, .iov_len = len};
+	struct mmsghdr msgs[NB_SLOTS];
+	unsigned long sent = 0;
+	unsigned n;
+	int ret;
+	int fd;
+
+	/* blocking, the sender waits for the receiver's queue to drain */
+	fd = socket(AF_UNIX, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+	if (-1 == fd)
+		_exit(EXIT_FAILURE);
+	memset(msgs, 0, sizeof(msgs));
+	for (n = 0; n < NB_SLOTS; n++) {
+		msgs[n].msg_hdr.msg_name = &bench->uad.addr;
+		msgs[n].msg_hdr.msg_namelen = sizeof(bench->uad.addr);
+		msgs[n].msg_hdr.msg_iov = &iov;
+		msgs[n].msg_hdr.msg_iovlen = 1;
+	}
+
+	while (sent < nb_msgs) {
+		n = batch ? NB_SLOTS : 1;
+		if (nb_msgs - sent < n)
+			n = nb_msgs - sent;
+		ret = io_sendmmsg(fd, msgs, n, 0);
+		if (ret < 0)
+			_exit(EXIT_FAILURE);
+		sent += ret;
+	}
+
+	_exit(EXIT_SUCCESS);
+}
+
+static void shm_writer(struct bench *bench, unsigned long nb_msgs,
+		unsigned len)
+{
+	static char buf[MAX_MSG_SIZE];
+	struct io_src_shm producer;
+	unsigned long sent;
+	int mem_fd;
+	int evt_fd;
+	int ret;
+
+	io_src_shm_get_fds(&bench->shm, &mem_fd, &evt_fd);
+	ret = io_src_shm_init_producer(&producer, mem_fd, evt_fd);
+	if (ret < 0)
+		_exit(EXIT_FAILURE);
+
+	for (sent = 0; sent < nb_msgs; sent++) {
+		/* the consumer needs the cpu to drain the ring */
+		while ((ret = io_src_shm_send(&producer, buf, len)) == -EAGAIN)
+			sched_yield();
+		if (ret < 0)
+			_exit(EXIT_FAILURE);
+	}
+
+	_exit(EXIT_SUCCESS);
+}
+
+static int init_source(struct bench *bench, enum mode mode, unsigned len)
+{
+	switch (mode) {
+	case MODE_UAD:
+		return io_src_msg_uad_init(&bench->uad, uad_cb, bench->msg,
+				len, "io_src_shm_bench_%d", getpid());
+
+	case MODE_UAD_BATCH:
+		return io_src_msg_uad_init_batch(&bench->uad, uad_batch_cb,
+				len, NB_SLOTS, "io_src_shm_bench_%d",
+				getpid());
+
+	case MODE_SHM:
+		return io_src_shm_init(&bench->shm, shm_cb, SHM_SIZE);
+
+	default:
+		return -EINVAL;
+	}
+}
+
+static void run(unsigned long nb_msgs, unsigned len, enum mode mode)
+{
+	int ret;
+	pid_t pid;
+	struct io_mon mon;
+	struct io_src *src;
+	struct bench bench;
+	double start;
+	double elapsed;
+
+	memset(&bench, 0, sizeof(bench));
+	ret = init_source(&bench, mode, len);
+	if (ret < 0)
+		error(EXIT_FAILURE, -ret, "init %s", mode_names[mode]);
+	src = MODE_SHM == mode ? io_src_shm_get_source(&bench.shm) :
+			io_src_msg_uad_get_source(&bench.uad);
+	ret = io_mon_init(&mon);
+	if (ret < 0)
+		error(EXIT_FAILURE, -ret, "io_mon_init");
+	ret = io_mon_add_source(&mon, src);
+	if (ret < 0)
+		error(EXIT_FAILURE, -ret, "io_mon_add_source");
+
+	start = now();
+	pid = fork();
+	if (-1 == pid)
+		error(EXIT_FAILURE, errno, "fork");
+	if (0 == pid) {
+		if (MODE_SHM == mode)
+			shm_writer(&bench, nb_msgs, len);
+		else
+			uad_writer(&bench, nb_msgs, len,
+					MODE_UAD_BATCH == mode);
+	}
+
+	while (bench.msgs < nb_msgs) {
+		ret = io_mon_poll(&mon, -1);
+		if (ret < 0)
+			error(EXIT_FAILURE, -ret, "io_mon_poll");
+	}
+	elapsed = now() - start;
+
+	printf("%-10s %8u %10lu msgs %8.3f s %12.0f msgs/s %10.2f MB/s\n",
+			mode_names[mode], len, bench.msgs, elapsed,
+			bench.msgs / elapsed, bench.msgs * len / elapsed / 1e6);
+
+	io_waitpid(pid, NULL, 0);
+	io_mon_clean(&mon);
+	if (MODE_SHM == mode)
+		io_src_shm_clean(&bench.shm);
+	else
+		io_src_msg_uad_clean(&bench.uad);
+}
+
+int main(int argc, char *argv[])
+{
+	const unsigned lens[] = {16, 256, MAX_MSG_SIZE};
+	unsigned long nb_msgs = DEFAULT_NB_MESSAGES;
+	enum mode mode;
+	unsigned i;
+
+	if (argc > 2)
+		error(EXIT_FAILURE, EINVAL, "usage: %s [nb_messages]", argv[0]);
+	if (argc > 1)
+		nb_msgs = strtoul(argv[1], NULL, 0);
+
+	printf("%-10s %8s %15s %10s %18s %15s\n", "source", "msg size",
+			"messages", "time", "rate", "throughput");
+	for (i = 0; i < UT_ARRAY_SIZE(lens); i++)
+		for (mode = MODE_UAD; mode <= MODE_SHM; mode++)
+			run(nb_msgs, lens[i], mode);
+
+	return EXIT_SUCCESS;
+}
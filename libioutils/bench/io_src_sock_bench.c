@@ -0,0 +1,342 @@
+/**
+ * @file io_src_sock_bench.c
+ * @brief Benchmark of the socket sources, an echo server built on a listener
+ * and io_io connections runs in the main process, a child process acts as a
+ * blocking client and measures the connection rate (connect, 1 byte round
+ * trip, close) and the throughput of round trips of large chunks on a single
+ * connection, for UNIX stream, UNIX seqpacket and TCP loopback sockets.
+ *
+ * usage: io_src_sock_bench [nb_connections [nb_megabytes]]
+ *
+ * Copyright (C) 2026 Parrot S.A.
+ */
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif /* _GNU_SOURCE */
+#include <sys/wait.h>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <stdbool.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <errno.h>
+#include <error.h>
+
+#include <ut_utils.h>
+#include <ut_file.h>
+
+#include <io_mon.h>
+#include <io_utils.h>
+#include <io_src_sock.h>
+
+#define DEFAULT_NB_CONNECTIONS 5000
+#define DEFAULT_NB_MEGABYTES 64
+#define STREAM_CHUNK 0x10000
+#define MAX_CONNS 16
+
+struct echo_conn {
+	struct io_src_sock_conn conn;
+	bool in_use;
+	bool dead;
+	bool writing;
+	struct io_io_write_buffer buffer;
+	size_t pos;
+	char echo[STREAM_CHUNK];
+};
+
+struct echo_server {
+	struct io_src_sock_listener listener;
+	struct echo_conn conns[MAX_CONNS];
+	struct io_src child;
+	bool done;
+	struct io_mon mon;
+};
+
+struct bench_type {
+	enum io_src_sock_type type;
+	const char *name;
+	const char *address;
+	size_t chunk;
+};
+
+static struct echo_server server;
+
+static double now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void echo_start_write(struct echo_conn *conn)
+{
+	int ret;
+
+	conn->writing = true;
+	conn->buffer.address = conn->echo;
+	conn->buffer.length = conn->pos;
+	ret = io_io_write_add(&conn->conn.io, &conn->buffer);
+	if (ret < 0)
+		error(EXIT_FAILURE, -ret, "io_io_write_add");
+}
+
+static void echo_write_cb(struct io_io_write_buffer *buffer,
+		enum io_io_write_status status)
+{
+	struct echo_conn *conn = ut_container_of(buffer, struct echo_conn,
+			buffer);
+
+	conn->writing = false;
+	if (status != IO_IO_WRITE_OK) {
+		conn->dead = true;
+		return;
+	}
+
+	/* data received during the write is moved to the front */
+	conn->pos -= buffer->length;
+	memmove(conn->echo, conn->echo + buffer->length, conn->pos);
+	if (conn->pos != 0)
+		echo_start_write(conn);
+}
+
+static int echo_read_cb(struct io_io *io, struct rs_rb *rb, void *data)
+{
+	struct echo_conn *conn = data;
+	size_t len;
+
+	if (io_io_has_read_error(io)) {
+		conn->dead = true;
+		return 0;
+	}
+
+	/* the client never has more than one chunk in flight */
+	len = rs_rb_get_read_length(rb);
+	if (len > sizeof(conn->echo) - conn->pos)
+		error(EXIT_FAILURE, ENOBUFS, "echo_read_cb");
+	memcpy(conn->echo + conn->pos, rs_rb_get_read_ptr(rb), len);
+	rs_rb_read_incr(rb, len);
+	conn->pos += len;
+	if (!conn->writing)
+		echo_start_write(conn);
+
+	return 0;
+}
+
+static void accept_cb(struct io_src_sock_listener *listener, int fd)
+{
+	struct echo_conn *conn;
+	unsigned i;
+	int ret;
+
+	for (i = 0; i < MAX_CONNS && server.conns[i].in_use; i++)
+		;
+	if (i == MAX_CONNS) {
+		close(fd);
+		return;
+	}
+	conn = server.conns + i;
+
+	memset(conn, 0, offsetof(struct echo_conn, echo));
+	ret = io_src_sock_conn_init(&conn->conn, &server.mon, "echo", fd);
+	if (ret < 0)
+		error(EXIT_FAILURE, -ret, "io_src_sock_conn_init");
+	conn->buffer.cb = echo_write_cb;
+	conn->in_use = true;
+	ret = io_io_read_start(&conn->conn.io, echo_read_cb, conn, 0);
+	if (ret < 0)
+		error(EXIT_FAILURE, -ret, "io_io_read_start");
+}
+
+static void child_cb(struct io_src *src)
+{
+	server.done = true;
+}
+
+static void reap_connections(void)
+{
+	unsigned i;
+
+	for (i = 0; i < MAX_CONNS; i++) {
+		if (!server.conns[i].in_use || !server.conns[i].dead)
+			continue;
+		io_src_sock_conn_clean(&server.conns[i].conn);
+		server.conns[i].in_use = false;
+	}
+}
+
+static int client_connect(const struct bench_type *t, int port)
+{
+	int fd;
+
+	if (t->type == IO_SRC_SOCK_TCP)
+		fd = io_src_sock_connect(t->type, "127.0.0.1:%d", port);
+	else
+		fd = io_src_sock_connect(t->type, "%s", t->address);
+	if (fd < 0)
+		error(EXIT_FAILURE, -fd, "io_src_sock_connect");
+
+	/* the client is a plain, blocking one */
+	if (fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) & ~O_NONBLOCK) == -1)
+		error(EXIT_FAILURE, errno, "fcntl");
+
+	return fd;
+}
+
+static void round_trip(int fd, char *buf, size_t len)
+{
+	ssize_t ret;
+	size_t done;
+
+	for (done = 0; done < len; done += ret) {
+		ret = io_write(fd, buf + done, len - done);
+		if (ret <= 0)
+			error(EXIT_FAILURE, errno, "write");
+	}
+	for (done = 0; done < len; done += ret) {
+		ret = io_read(fd, buf + done, len - done);
+		if (ret <= 0)
+			error(EXIT_FAILURE, errno, "read");
+	}
+}
+
+static void client(const struct bench_type *t, int port,
+		unsigned long nb_connections, unsigned long nb_megabytes)
+{
+	char *buf;
+	unsigned long i;
+	unsigned long nb_chunks;
+	double start;
+	double elapsed;
+	int fd;
+
+	buf = calloc(t->chunk, 1);
+	if (NULL == buf)
+		error(EXIT_FAILURE, ENOMEM, "calloc");
+
+	start = now();
+	for (i = 0; i < nb_connections; i++) {
+		fd = client_connect(t, port);
+		round_trip(fd, buf, 1);
+		close(fd);
+	}
+	elapsed = now() - start;
+	printf("%-16s %-10s %10lu conns %8.3f s %12.0f conns/s\n", t->name,
+			"connect", nb_connections, elapsed,
+			nb_connections / elapsed);
+
+	nb_chunks = (nb_megabytes << 20) / t->chunk;
+	fd = client_connect(t, port);
+	start = now();
+	for (i = 0; i < nb_chunks; i++)
+		round_trip(fd, buf, t->chunk);
+	elapsed = now() - start;
+	close(fd);
+	printf("%-16s %-10s %10lu MiB   %8.3f s %12.1f MiB/s\n", t->name,
+			"echo", nb_megabytes, elapsed,
+			nb_chunks * t->chunk / elapsed / (1 << 20));
+
+	free(buf);
+}
+
+static void run(const struct bench_type *t, unsigned long nb_connections,
+		unsigned long nb_megabytes)
+{
+	int ret;
+	int port = 0;
+	int pipefd[2];
+	pid_t pid;
+	unsigned i;
+
+	memset(&server, 0, sizeof(server));
+	ret = io_mon_init(&server.mon);
+	if (ret < 0)
+		error(EXIT_FAILURE, -ret, "io_mon_init");
+	ret = io_src_sock_listener_init(&server.listener, t->type, accept_cb,
+			"%s", t->address);
+	if (ret < 0)
+		error(EXIT_FAILURE, -ret, "io_src_sock_listener_init");
+	ret = io_mon_add_source(&server.mon,
+			io_src_sock_listener_get_source(&server.listener));
+	if (ret < 0)
+		error(EXIT_FAILURE, -ret, "io_mon_add_source");
+	if (t->type == IO_SRC_SOCK_TCP)
+		port = io_src_sock_get_port(&server.listener);
+
+	/* the child's end of the pipe hangs up when it's done */
+	if (-1 == pipe(pipefd))
+		error(EXIT_FAILURE, errno, "pipe");
+	pid = fork();
+	if (-1 == pid)
+		error(EXIT_FAILURE, errno, "fork");
+	if (0 == pid) {
+		close(pipefd[0]);
+		client(t, port, nb_connections, nb_megabytes);
+		fflush(stdout);
+		_exit(EXIT_SUCCESS);
+	}
+	ut_file_fd_close(&pipefd[1]);
+	io_src_init(&server.child, pipefd[0], IO_IN, child_cb);
+	ret = io_mon_add_source(&server.mon, &server.child);
+	if (ret < 0)
+		error(EXIT_FAILURE, -ret, "io_mon_add_source");
+
+	while (!server.done) {
+		ret = io_mon_poll(&server.mon, -1);
+		if (ret < 0)
+			error(EXIT_FAILURE, -ret, "io_mon_poll");
+		reap_connections();
+	}
+	io_waitpid(pid, NULL, 0);
+
+	for (i = 0; i < MAX_CONNS; i++)
+		if (server.conns[i].in_use)
+			io_src_sock_conn_clean(&server.conns[i].conn);
+	io_mon_clean(&server.mon);
+	io_src_sock_listener_clean(&server.listener);
+	io_src_close_fd(&server.child);
+	io_src_clean(&server.child);
+}
+
+int main(int argc, char *argv[])
+{
+	unsigned long nb_connections = DEFAULT_NB_CONNECTIONS;
+	unsigned long nb_megabytes = DEFAULT_NB_MEGABYTES;
+	const struct bench_type types[] = {
+		{
+			.type = IO_SRC_SOCK_UNIX_STREAM,
+			.name = "unix stream",
+			.address = "@io_src_sock_bench_stream",
+			.chunk = STREAM_CHUNK,
+		},
+		{
+			.type = IO_SRC_SOCK_UNIX_SEQPACKET,
+			.name = "unix seqpacket",
+			.address = "@io_src_sock_bench_seqpacket",
+			/* bigger packets would be truncated by io_io */
+			.chunk = IO_IO_RB_BUFFER_SIZE,
+		},
+		{
+			.type = IO_SRC_SOCK_TCP,
+			.name = "tcp loopback",
+			.address = "127.0.0.1:0",
+			.chunk = STREAM_CHUNK,
+		},
+	};
+	unsigned i;
+
+	if (argc > 1)
+		nb_connections = strtoul(argv[1], NULL, 0);
+	if (argc > 2)
+		nb_megabytes = strtoul(argv[2], NULL, 0);
+
+	for (i = 0; i < UT_ARRAY_SIZE(types); i++)
+		run(types + i, nb_connections, nb_megabytes);
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,194 @@
+/**
+ * @file io_frame.h
+ * @date 19 oct. 2026
+ * @author nicolas.carrier@parrot.com
+ * @brief Framing of a byte stream stored in a ring buffer, typically the one of
+ * an io_io read context. Three kinds of framing are supported, fixed header
+ * with a length field, delimiter and TLV. The ring buffer must be mirrored, so
+ * that each frame can be passed to the user without any copy, in one
+ * contiguous chunk
+ *
+ * Copyright (C) 2026 Parrot S.A.
+ */
+
+#ifndef IO_FRAME_H_
+#define IO_FRAME_H_
+#include <stdint.h>
+#include <stdbool.h>
+
+#include <rs_rb.h>
+
+#include <io_io.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @enum io_frame_type
+ * @brief Kind of framing
+ */
+enum io_frame_type {
+	/** fixed size header, containing the length of the frame */
+	IO_FRAME_LENGTH,
+	/** frames separated by a delimiter */
+	IO_FRAME_DELIM,
+	/** tag, length, value */
+	IO_FRAME_TLV,
+};
+
+/**
+ * @enum io_frame_endianness
+ * @brief Byte order of the length and tag fields
+ */
+enum io_frame_endianness {
+	IO_FRAME_BIG_ENDIAN,
+	IO_FRAME_LITTLE_ENDIAN,
+};
+
+/**
+ * @struct io_frame
+ * @brief Framing engine
+ */
+struct io_frame;
+
+/**
+ * @typedef io_frame_cb
+ * @brief Called for each complete frame
+ * @param frame Framing engine
+ * @param tag Tag of the frame, in TLV framing, 0 otherwise
+ * @param payload Payload of the frame, that is, what follows the header in
+ * length framing, what precedes the delimiter in delimiter framing and the
+ * value in TLV framing. In length and TLV framing, the header precedes it
+ * immediately in memory. It points inside the ring buffer and is valid only
+ * during the callback. NULL when the end of the stream is reached, or on read
+ * error, when the engine is used through io_frame_io_read_cb()
+ * @param len Size of the payload
+ * @return 0 to continue parsing, non-zero to stop parsing the remaining frames,
+ * which are kept in the ring buffer until the next call to io_frame_process()
+ */
+typedef int (io_frame_cb)(struct io_frame *frame, uint64_t tag,
+		const void *payload, size_t len);
+
+/**
+ * @struct io_frame
+ * @brief Framing engine
+ */
+struct io_frame {
+	/** kind of framing */
+	enum io_frame_type type;
+	/** user callback, notified of each frame */
+	io_frame_cb *cb;
+
+	/** size of the header, in length and TLV framing */
+	size_t header_size;
+	/** offset of the length field in the header */
+	size_t length_offset;
+	/** width of the length field, in bytes */
+	unsigned length_width;
+	/** width of the tag field, in bytes, in TLV framing */
+	unsigned tag_width;
+	/** byte order of the length and tag fields */
+	enum io_frame_endianness endianness;
+	/** true if the length field counts the header too */
+	bool includes_header;
+
+	/** delimiter, in delimiter framing */
+	char *delim;
+	/** length of the delimiter */
+	size_t delim_len;
+	/** offset from which the next search of the delimiter will start */
+	size_t scan_from;
+	/**
+	 * true if the data is discarded until the next delimiter, because the
+	 * current frame couldn't fit in the ring buffer
+	 */
+	bool discard;
+
+	/** number of bytes of an oversized frame still to be discarded */
+	uint64_t skip;
+	/** number of frames discarded, because they couldn't fit the buffer */
+	unsigned long nb_dropped;
+};
+
+/**
+ * Initializes a framing engine for frames made of a fixed size header,
+ * containing a length field, followed by a payload
+ * @param frame Framing engine to initialize
+ * @param cb Callback notified of each frame
+ * @param header_size Size of the header
+ * @param length_offset Offset of the length field in the header
+ * @param length_width Width of the length field, 1, 2, 4 or 8 bytes
+ * @param endianness Byte order of the length field
+ * @param includes_header true if the length field counts the header and the
+ * payload, false if it counts only the payload
+ * @return errno-compatible negative value on error, 0 otherwise
+ */
+int io_frame_init_length(struct io_frame *frame, io_frame_cb *cb,
+		size_t header_size, size_t length_offset,
+		unsigned length_width, enum io_frame_endianness endianness,
+		bool includes_header);
+
+/**
+ * Initializes a framing engine for frames separated by a delimiter
+ * @param frame Framing engine to initialize
+ * @param cb Callback notified of each frame
+ * @param delim Delimiter, copied internally
+ * @param delim_len Length of the delimiter, must be less than rb_size, so that
+ * the engine can resynchronize on the next delimiter after an oversized frame
+ * @param rb_size Size of the ring buffer the frames will be read from,
+ * IO_IO_RB_BUFFER_SIZE for the read context of an io_io
+ * @return errno-compatible negative value on error, 0 otherwise
+ */
+int io_frame_init_delim(struct io_frame *frame, io_frame_cb *cb,
+		const char *delim, size_t delim_len, size_t rb_size);
+
+/**
+ * Initializes a framing engine for TLV frames, made of a tag field, a length
+ * field counting the value only, and the value
+ * @param frame Framing engine to initialize
+ * @param cb Callback notified of each frame
+ * @param tag_width Width of the tag field, 1, 2, 4 or 8 bytes
+ * @param length_width Width of the length field, 1, 2, 4 or 8 bytes
+ * @param endianness Byte order of the tag and length fields
+ * @return errno-compatible negative value on error, 0 otherwise
+ */
+int io_frame_init_tlv(struct io_frame *frame, io_frame_cb *cb,
+		unsigned tag_width, unsigned length_width,
+		enum io_frame_endianness endianness);
+
+/**
+ * Notifies all the complete frames stored in a ring buffer and consumes them.
+ * Frames which can't fit in the ring buffer are discarded and counted in
+ * nb_dropped
+ * @param frame Framing engine
+ * @param rb Ring buffer, must be mirrored, see rs_rb_init(), in delimiter
+ * framing, it must be bigger than the delimiter
+ * @return errno-compatible negative value on error, 0 if the parsing stopped
+ * because more data is needed, 1 if it was stopped by the callback, whatever
+ * the non-zero value it returned
+ */
+int io_frame_process(struct io_frame *frame, struct rs_rb *rb);
+
+/**
+ * Read callback, suitable for io_io_read_start(), with the framing engine as
+ * the user data. On end of file or on read error, the frame callback is called
+ * with a NULL payload
+ * @param io IO context
+ * @param rb Ring buffer of the io's read context
+ * @param data Framing engine
+ * @return 0 if and only if more data is needed on read
+ */
+int io_frame_io_read_cb(struct io_io *io, struct rs_rb *rb, void *data);
+
+/**
+ * Cleans up a framing engine, releasing it's resources
+ * @param frame Framing engine
+ */
+void io_frame_clean(struct io_frame *frame);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* IO_FRAME_H_ */
@@ -13,6 +13,9 @@
 #include <sys/epoll.h>
 
 #include <stdbool.h>
+#include <stdint.h>
+
+#include <rs_dll.h>
 
 #include <io_src.h>
 
@@ -20,6 +23,87 @@
 extern "C" {
 #endif
 
+/**
+ * @struct io_mon_task
+ * @brief task posted to a monitor, to be run on it's thread
+ */
+struct io_mon_task;
+
+/**
+ * @typedef io_mon_task_cb
+ * @brief callback of a task posted, called on the monitor's thread
+ * @param task Task posted, it can be posted again, or disposed
+ */
+typedef void (io_mon_task_cb)(struct io_mon_task *task);
+
+/**
+ * @struct io_mon_task
+ * @brief task posted to a monitor, allocated by the caller, usually embedded
+ * in a bigger structure carrying the payload, retrieved with ut_container_of()
+ */
+struct io_mon_task {
+	/** callback of the task */
+	io_mon_task_cb *cb;
+	/** next task posted, internal */
+	struct io_mon_task *next;
+};
+
+/**
+ * @struct io_mon_deferred
+ * @brief callback deferred, run by the monitor without any file descriptor
+ */
+struct io_mon_deferred;
+
+/**
+ * @typedef io_mon_deferred_cb
+ * @brief deferred callback, called on the monitor's thread
+ * @param deferred Deferred callback, it can be scheduled again, or disposed
+ */
+typedef void (io_mon_deferred_cb)(struct io_mon_deferred *deferred);
+
+/**
+ * @struct io_mon_deferred
+ * @brief callback deferred, allocated by the caller, usually embedded in a
+ * bigger structure, retrieved with ut_container_of()
+ */
+struct io_mon_deferred {
+	/** node for chaining in the list of the monitor, internal */
+	struct rs_node node;
+	/** callback */
+	io_mon_deferred_cb *cb;
+	/** list the callback is scheduled in, NULL if none, internal */
+	struct rs_dll *list;
+};
+
+/**
+ * @enum io_mon_busy_poll
+ * @brief busy-polling policies, for io_mon_poll() to spin instead of sleeping
+ */
+enum io_mon_busy_poll {
+	/** always sleep in epoll_wait() */
+	IO_MON_BUSY_POLL_OFF,
+	/** spin for the configured duration before sleeping */
+	IO_MON_BUSY_POLL_FIXED,
+	/**
+	 * spin for twice the average time between events, bounded by the
+	 * configured duration, don't spin if events are rarer than that
+	 */
+	IO_MON_BUSY_POLL_ADAPTIVE,
+};
+
+/**
+ * @struct io_mon_busy_poll_stats
+ * @brief statistics of the busy-polling of a monitor
+ */
+struct io_mon_busy_poll_stats {
+	/** zero-timeout calls to epoll_wait() done while spinning */
+	uint64_t spins;
+	/** spins which found events */
+	uint64_t hits;
+	/** calls to epoll_wait() which could block */
+	uint64_t blocking_waits;
+};
+
 /**
  * @struct io_mon
  * @brief global monitor's context, handles the pool of sources and callbacks
@@ -36,6 +120,29 @@ struct io_mon {
 	struct rs_node source;
 	/** file descriptor for monitoring all the sources */
 	int epollfd;
+	/**
+	 * eventfd source waking the monitor up when tasks are posted, not part
+	 * of the sources list
+	 */
+	struct io_src post_src;
+	/** lock-free stack of the tasks posted, last posted first */
+	struct io_mon_task *posted;
+	/** callbacks to run after the current events batch */
+	struct rs_dll deferred;
+	/** true while an events batch is processed */
+	bool processing;
+	/** callbacks to run when no event is pending */
+	struct rs_dll idle;
+	/** busy-polling policy */
+	enum io_mon_busy_poll busy_poll;
+	/** maximum spinning duration, in nanoseconds */
+	uint64_t busy_poll_ns;
+	/** average time between events, for the adaptive policy */
+	uint64_t interarrival_ns;
+	/** time of the last events received, for the adaptive policy */
+	uint64_t last_events_ns;
+	/** busy-polling statistics */
+	struct io_mon_busy_poll_stats busy_poll_stats;
 };
 
 /**
@@ -113,6 +220,83 @@ int io_mon_remove_source(struct io_mon *mon, struct io_src *src);
 int io_mon_remove_sources(struct io_mon *mon, ...)
 	__attribute__ ((sentinel(0)));
 
+/**
+ * Posts a task to a monitor, it's callback will be called on the thread
+ * polling the monitor. Can be called from any thread, including the monitor's
+ * one and from a task's callback. The tasks are run in the order they were
+ * posted, the posts done before the monitor has run the pending tasks cost only
+ * one eventfd write and one read
+ * @param mon Monitor, must outlive the threads posting to it
+ * @param task Task to post, mustn't be modified nor disposed before it's
+ * callback is called. Tasks still pending when the monitor is cleaned are
+ * discarded without being run
+ * @param cb Callback of the task
+ * @return negative errno value on error, 0 otherwise
+ */
+int io_mon_post(struct io_mon *mon, struct io_mon_task *task,
+		io_mon_task_cb *cb);
+
+/**
+ * Schedules a callback to be run once, after the events batch currently
+ * processed, or by the next call to io_mon_poll() or io_mon_process_events(),
+ * io_mon_poll() won't block then. Scheduling from a callback of the monitor
+ * costs no system call, otherwise, the monitor's file descriptor is made
+ * readable, for a parent monitor to process it. The callbacks scheduled by a
+ * deferred callback are run by the next call
+ * @param mon Monitor, must be called from it's thread
+ * @param deferred Deferred callback, mustn't be modified nor disposed before
+ * it's callback is called, or it has been cancelled. If already scheduled, it
+ * is left untouched
+ * @param cb Callback
+ * @return negative errno value on error, 0 otherwise
+ */
+int io_mon_defer(struct io_mon *mon, struct io_mon_deferred *deferred,
+		io_mon_deferred_cb *cb);
+
+/**
+ * Schedules a callback to be run once, when io_mon_poll() finds no event
+ * pending, instead of blocking. io_mon_process_events() doesn't run them
+ * @param mon Monitor, must be called from it's thread
+ * @param deferred Deferred callback, mustn't be modified nor disposed before
+ * it's callback is called, or it has been cancelled. If already scheduled, it
+ * is left untouched
+ * @param cb Callback
+ * @return negative errno value on error, 0 otherwise
+ */
+int io_mon_defer_idle(struct io_mon *mon, struct io_mon_deferred *deferred,
+		io_mon_deferred_cb *cb);
+
+/**
+ * Cancels a deferred callback
+ * @param mon Monitor
+ * @param deferred Deferred callback to cancel
+ * @return negative errno value on error, -ENOENT if it wasn't scheduled, 0
+ * otherwise
+ */
+int io_mon_defer_cancel(struct io_mon *mon, struct io_mon_deferred *deferred);
+
+/**
+ * Configures the busy-polling of a monitor, that is, io_mon_poll() calls
+ * which would block, first spin with zero-timeout polls, trading CPU time for
+ * latency. Resets the statistics
+ * @param mon Monitor
+ * @param busy_poll Busy-polling policy
+ * @param duration_us Maximum spinning duration, in microseconds, ignored if
+ * busy_poll is IO_MON_BUSY_POLL_OFF
+ * @return negative errno value on error, 0 otherwise
+ */
+int io_mon_set_busy_poll(struct io_mon *mon, enum io_mon_busy_poll busy_poll,
+		unsigned duration_us);
+
+/**
+ * Retrieves the busy-polling statistics of a monitor
+ * @param mon Monitor
+ * @param stats Output statistics
+ * @return negative errno value on error, 0 otherwise
+ */
+int io_mon_get_busy_poll_stats(struct io_mon *mon,
+		struct io_mon_busy_poll_stats *stats);
+
 /**
  * Dumps the events in an epoll event flag set
  * @param events Epoll events set
@@ -147,7 +331,9 @@ int io_mon_activate_in_source(struct io_mon *mon, struct io_src *src,
  * When monitor's fd is ready for reading operation, a call to
  * io_mon_poll will dispatch each event to the relevant
  * callback.<br />
- * If no source has pending events, blocks during the given amount of time<br />
+ * If no source has pending events, blocks during the given amount of time,
+ * unless callbacks are deferred, or run the idle callbacks, if any. If
+ * busy-polling is configured, spins before blocking<br />
  * Sources which encounter errors (io_src_has_error() returns true) are removed
  * automatically
  * @param timeout Number of milliseconds io_mon_poll should block waiting for
@@ -162,7 +348,8 @@ int io_mon_poll(struct io_mon *mon, int timeout);
  * @brief processes pending events. Doesn't block. Any source with error is
  * removed after the user has been called back.
  *
- * Equivalent to io_mon_poll(mon, 0);
+ * Equivalent to io_mon_poll(mon, 0), except that the idle callbacks aren't run,
+ * the monitor's file descriptor being readable means it isn't idle
  *
  * @see io_mon_poll
  * @param mon Monitor's context
@@ -172,7 +359,8 @@ int io_mon_poll(struct io_mon *mon, int timeout);
 int io_mon_process_events(struct io_mon *mon);
 
 /**
- * Cleans up a monitor, unregister the sources and releases the resources
+ * Cleans up a monitor, unregister the sources and releases the resources. The
+ * deferred callbacks still scheduled are discarded
  * @param mon Monitor context
  * @return negative errno value on error, 0 otherwise
  */
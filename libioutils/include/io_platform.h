@@ -24,6 +24,7 @@
 #include <sys/inotify.h>
 
 #include <unistd.h>
+#include <stdint.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -151,6 +152,19 @@ int io_pipe2(int pipefd[2], int flags);
  */
 int io_inotify_init1(int flags);
 
+/**
+ * Wrapper around fanotify_init, defining it on toolchains where it is missing
+ * @see fanotify_init
+ */
+int io_fanotify_init(unsigned int flags, unsigned int event_f_flags);
+
+/**
+ * Wrapper around fanotify_mark, defining it on toolchains where it is missing
+ * @see fanotify_mark
+ */
+int io_fanotify_mark(int fanotify_fd, unsigned int flags, uint64_t mask,
+		int dirfd, const char *pathname);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,196 @@
+/**
+ * @file io_src_fanotify.h
+ * @date 19 oct. 2026
+ * @author nicolas.carrier@parrot.com
+ * @brief Source for fanotify file descriptors. Allows to monitor events
+ * occurring on a whole filesystem or mount with only one mark, where
+ * io_src_inot needs one watch per directory. Events identify the files by
+ * their file handle, the one of their parent directory and their name, thus
+ * creations, deletions and moves are reported too.
+ *
+ * Copyright (C) 2026 Parrot S.A.
+ */
+
+#ifndef IO_SRC_FANOTIFY_H_
+#define IO_SRC_FANOTIFY_H_
+#include <sys/types.h>
+
+#include <stdint.h>
+
+#include <linux/fanotify.h>
+
+#include <rs_dll.h>
+
+#include "io_src.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @struct io_src_fanotify
+ * @brief Fanotify source type
+ */
+struct io_src_fanotify;
+
+/**
+ * @struct io_src_fanotify_mark
+ * @brief structure for describing a mark to install
+ */
+struct io_src_fanotify_mark;
+
+/* opaque file handle, see open_by_handle_at(2) */
+struct file_handle;
+
+/**
+ * @enum io_src_fanotify_type
+ * @brief What a mark covers
+ */
+enum io_src_fanotify_type {
+	/** the file or directory itself, it's entries if FAN_EVENT_ON_CHILD */
+	IO_SRC_FANOTIFY_INODE,
+	/** all the files of the mount, directory entry events excluded */
+	IO_SRC_FANOTIFY_MOUNT,
+	/** all the files of the filesystem */
+	IO_SRC_FANOTIFY_FILESYSTEM,
+};
+
+/**
+ * @struct io_src_fanotify_event
+ * @brief Decoded fanotify event
+ */
+struct io_src_fanotify_event {
+	/** event occurred, FAN_* flags, FAN_ONDIR for directories */
+	uint64_t mask;
+	/** process which caused the event */
+	pid_t pid;
+	/** handle of the file the event concerns, NULL if not reported */
+	const struct file_handle *handle;
+	/** handle of the parent directory, NULL if not reported */
+	const struct file_handle *dir_handle;
+	/**
+	 * name of the entry in the parent directory, NULL if not reported,
+	 * "." if the event concerns the directory itself
+	 */
+	const char *name;
+};
+
+/**
+ * @typedef io_src_fanotify_cb
+ * @brief Type of the callback used to be notified of fanotify events
+ * @param fan Fanotify source
+ * @param evt Event, valid only during the callback
+ * @param mark Mark of the filesystem the event occurred on
+ */
+typedef void (io_src_fanotify_cb)(struct io_src_fanotify *fan,
+		struct io_src_fanotify_event *evt,
+		struct io_src_fanotify_mark *mark);
+
+/**
+ * @struct io_src_fanotify
+ * @brief Fanotify source type
+ */
+struct io_src_fanotify {
+	/** inner monitor source */
+	struct io_src src;
+	/** marks installed */
+	struct rs_dll marks;
+	/** buffer the events are read into, in batches */
+	char *buf;
+};
+
+/**
+ * @struct io_src_fanotify_mark
+ * @brief structure for describing a mark to install
+ */
+struct io_src_fanotify_mark {
+	/** node for chaining the marks installed */
+	struct rs_node node;
+	/** path of the file system element marked */
+	const char *path;
+	/** what the mark covers */
+	enum io_src_fanotify_type type;
+	/** fanotify events set, FAN_* flags */
+	uint64_t events;
+	/** callback called on events concerning the mark */
+	io_src_fanotify_cb *cb;
+	/** file descriptor of path, for open_by_handle_at(2), internal */
+	int mount_fd;
+	/** identifier of the filesystem of path, internal */
+	int fsid[2];
+};
+
+/**
+ * @brief Initializes a fanotify source, reporting file identifiers, that is,
+ * file handles, the parent directory's handle and the entry name. Since Linux
+ * 5.13, it doesn't require CAP_SYS_ADMIN, but only inode marks are allowed
+ * unprivileged, filesystem marks can be placed in a user namespace, on the
+ * filesystems mounted in it
+ * @param fan Fanotify source
+ * @return errno-compatible negative value on error, 0 on success
+ */
+int io_src_fanotify_init(struct io_src_fanotify *fan);
+
+/**
+ * @brief Returns the underlying io_src of the fanotify source
+ * @param fan Fanotify source
+ * @return io_src of the fanotify source
+ */
+static inline struct io_src *io_src_fanotify_get_source(
+		struct io_src_fanotify *fan)
+{
+	return NULL == fan ? NULL : &fan->src;
+}
+
+/**
+ * @brief Adds, or modifies, a mark
+ * @see fanotify_mark
+ * @param fan Fanotify source
+ * @param mark Description of the mark to install. The path, type, events and
+ * cb fields must be valid, the other ones are ignored in input. The mark is
+ * copied internally, thus the caller is free to dispose this structure after
+ * the function has returned. Only one mark can be installed per filesystem,
+ * events are dispatched to it, events not attached to any filesystem, like
+ * FAN_Q_OVERFLOW, are dispatched to all the marks
+ * @return errno-compatible negative value on error, -EBUSY if another mark is
+ * installed on the same filesystem, 0 on success
+ */
+int io_src_fanotify_add_mark(struct io_src_fanotify *fan,
+		struct io_src_fanotify_mark *mark);
+
+/**
+ * @brief Removes a mark
+ * @param fan Fanotify source
+ * @param mark Mark to remove, only the fields path and type are used, for the
+ * lookup of the internal copy
+ * @return errno-compatible negative value on error, -ENOENT if no such mark
+ * is installed, 0 on success
+ */
+int io_src_fanotify_rm_mark(struct io_src_fanotify *fan,
+		struct io_src_fanotify_mark *mark);
+
+/**
+ * @brief Builds the path of the file an event concerns, from the handle of
+ * it's parent directory and it's name, or from it's handle. Needs the
+ * CAP_DAC_READ_SEARCH capability
+ * @param mark Mark passed to the callback
+ * @param evt Event passed to the callback
+ * @param path Output buffer
+ * @param size Size of the output buffer
+ * @return errno-compatible negative value on error, 0 on success
+ */
+int io_src_fanotify_get_path(struct io_src_fanotify_mark *mark,
+		struct io_src_fanotify_event *evt, char *path, size_t size);
+
+/**
+ * @brief Cleans up a fanotify source, by properly closing fd, zeroing fields
+ * etc...
+ * @param fan Fanotify source
+ */
+void io_src_fanotify_clean(struct io_src_fanotify *fan);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* IO_SRC_FANOTIFY_H_ */
@@ -13,6 +13,8 @@
 #include <sys/inotify.h>
 
 #include "io_src.h"
+#include "io_src_tmr.h"
+#include "io_mon.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -30,6 +32,9 @@ struct io_src_inot;
  */
 struct io_src_inot_watch;
 
+/* internal representation of a watch */
+struct inot_watch;
+
 /**
  * @typedef io_src_inot_cb
  * @brief Type of the callback used to be notified of inotify events
@@ -37,6 +42,20 @@ struct io_src_inot_watch;
 typedef void (io_src_inot_cb)(struct io_src_inot *inot,
 		struct inotify_event *evt, struct io_src_inot_watch *watch);
 
+/**
+ * @struct io_src_inot_table
+ * @brief Hash table of watches, the nodes are allocated along with the watches
+ * they index, so that no allocation is needed for storing a watch
+ */
+struct io_src_inot_table {
+	/** array of buckets, the number of buckets is a power of 2 */
+	struct inot_watch **buckets;
+	/** number of buckets, minus one */
+	size_t mask;
+	/** number of watches stored */
+	size_t count;
+};
+
 /**
  * @struct io_src_inot
  * @brief Inotify source type
@@ -45,19 +64,47 @@ struct io_src_inot {
 	/** inner monitor source */
 	struct io_src src;
 	/*
-	 * watch descriptors are stored in two containers: one indexing by path,
-	 * so that lookups performed in io_src_inot_add_watch() and
+	 * watch descriptors are stored in two hash tables: one indexing by
+	 * path, for the lookups performed in io_src_inot_add_watch() and
 	 * io_src_inot_rm_watch(), the other indexing by the watch descriptor
-	 * use internally by the inotify API, use by lookups performed when
-	 * inotify events are processed.
-	 * tsearch(3) is used, because they are already part of POSIX, so they
-	 * are already implemented and because the eglibc implementation is
-	 * based on red-black trees, which should be fairly efficient.
+	 * used internally by the inotify API, for the lookups performed when
+	 * inotify events are processed. Each path is interned, stored once,
+	 * along with the watch and it's hash, and shared by both tables.
 	 */
 	/** watch descriptors indexed by their path */
-	void *watches_by_path;
+	struct io_src_inot_table watches_by_path;
 	/** watch descriptors indexed by their watch descriptor */
-	void *watches_by_wd;
+	struct io_src_inot_table watches_by_wd;
+	/** directories of recursive watches, waiting for being scanned */
+	struct inot_watch *to_scan;
+
+	/** buffer the events are read into, reused and grown as needed */
+	char *buf;
+	/** size of buf */
+	size_t buf_size;
+
+	/** number of occurrences of the event being notified */
+	unsigned count;
+	/** monitor the coalescing timer is registered in, NULL if disabled */
+	struct io_mon *mon;
+	/** timer flushing the coalesced events at the end of the window */
+	struct io_src_tmr tmr;
+	/** duration of the coalescing window, in milliseconds */
+	int window;
+	/** events which can be coalesced */
+	uint32_t coalesced_events;
+	/** coalesced events waiting for the end of the window, in order */
+	char *pending;
+	/** size of pending */
+	size_t pending_size;
+	/** number of bytes of pending in use */
+	size_t pending_len;
+	/** number of distinct events in pending */
+	size_t nb_pending;
+	/** open addressing index of pending, offsets plus one, 0 when free */
+	uint32_t *index;
+	/** number of slots of the index, minus one */
+	size_t index_mask;
 };
 
 /**
@@ -104,17 +151,91 @@ static inline struct io_src *io_src_inot_get_source(struct io_src_inot *inot)
  * be valid and the other fields are ignored in input. In output, wd is set to
  * the watch descriptor value returned by inotify_add_watch. The content of the
  * path, this API is interested in, is copied internally, thus the caller is
- * free to dispose this structure after the function has returned.
+ * free to dispose this structure after the function has returned. Trailing
+ * slashes of the path are ignored, so that "dir" and "dir/" designate the same
+ * watch.
  * @return errno-compatible negative value on error, 0 on success
  */
 int io_src_inot_add_watch(struct io_src_inot *inot,
 		struct io_src_inot_watch *watch);
 
+/**
+ * @brief adds, or modifies a watch for a directory and for all the directories
+ * below it. Directories created or moved in the tree later on, are watched
+ * automatically. Because a directory can be populated before it's watch is
+ * installed, each new directory is scanned after it's watch has been added and
+ * an IN_CREATE event is synthesized for each of the entries found, if IN_CREATE
+ * is part of the events monitored. As a consequence, the creation of an entry
+ * can be notified twice. Symbolic links aren't followed and a directory already
+ * watched, for example because of a bind mount, isn't watched twice.
+ * @note Each directory consumes a watch, which counts in the
+ * /proc/sys/fs/inotify/max_user_watches limit.
+ * @param inot Inotify source
+ * @param watch Description of the watch to install, same as for
+ * io_src_inot_add_watch(), path must be a directory. For the events concerning
+ * the sub-directories, the watch passed to the callback is an internal one,
+ * whose path field is the one of the sub-directory.
+ * @return errno-compatible negative value on error, 0 on success. If the watch
+ * of the root directory could be installed but not all the ones of the
+ * sub-directories, the first error encountered is returned, but the watches
+ * already installed are kept
+ */
+int io_src_inot_add_watch_recursive(struct io_src_inot *inot,
+		struct io_src_inot_watch *watch);
+
+/**
+ * @brief Enables, or disables, the coalescing of the events. When enabled,
+ * occurrences of the same event, that is, with the same mask, for the same
+ * watch and the same name, are merged into only one callback, when they occur
+ * during the coalescing window, which starts at the first occurrence. To keep
+ * the events in order, the window is closed as soon as an event which can't be
+ * coalesced arrives. The number of occurrences merged is available in the
+ * callback through io_src_inot_get_event_count(). Sub-directories of recursive
+ * watches are still watched, as soon as their events are read.
+ * @param inot Inotify source
+ * @param mon Monitor the inotify source is registered in, the timer closing
+ * the windows is registered there too, ignored when disabling. It can be
+ * cleaned before the inotify source, but then, not used through it anymore
+ * @param events Events which can be coalesced, typically IN_MODIFY, IN_ACCESS
+ * or IN_ATTRIB. IN_MOVED_FROM and IN_MOVED_TO are never coalesced, because of
+ * their cookie
+ * @param window Duration of the coalescing window, in milliseconds, 0 disables
+ * the coalescing, after having notified the events pending
+ * @return errno-compatible negative value on error, 0 on success
+ */
+int io_src_inot_set_coalescing(struct io_src_inot *inot, struct io_mon *mon,
+		uint32_t events, int window);
+
+/**
+ * @brief Returns the number of occurrences of the event being notified, can
+ * only be called from a callback
+ * @param inot Inotify source
+ * @return number of occurrences merged in the event being notified, 1 if it
+ * wasn't coalesced
+ */
+static inline unsigned io_src_inot_get_event_count(struct io_src_inot *inot)
+{
+	return NULL == inot ? 0 : inot->count;
+}
+
+/**
+ * @brief Returns the number of watches currently installed, including the ones
+ * of the sub-directories of recursive watches
+ * @param inot Inotify source
+ * @return number of watches
+ */
+static inline size_t io_src_inot_get_watch_count(struct io_src_inot *inot)
+{
+	return NULL == inot ? 0 : inot->watches_by_path.count;
+}
+
 /**
  * @brief Removes a watch for a path
  * @param inot Inotify source
  * @param watch Watch to remove, only the field "path" is used, for the lookup
- * of the internal watch descriptor copy
+ * of the internal watch descriptor copy. If the watch was installed with
+ * io_src_inot_add_watch_recursive(), the watches of all it's sub-directories
+ * are removed too
  * @return errno-compatible negative value on error, -ENOENT if no watch is
  * installed for the given path, 0 on success
  */
@@ -123,7 +244,7 @@ int io_src_inot_rm_watch(struct io_src_inot *inot,
 
 /**
  * @brief Cleans up an inotify source, by properly closing fd, zeroing fields
- * etc...
+ * etc... The coalesced events still pending are discarded
  * @param inot Inotify source
  */
 void io_src_inot_clean(struct io_src_inot *inot);
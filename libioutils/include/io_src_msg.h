@@ -13,6 +13,8 @@
 #include <ut_utils.h>
 #include <ut_file.h>
 
+#include <rs_dll.h>
+
 #include <io_src.h>
 
 #ifdef __cplusplus
@@ -46,6 +48,56 @@ struct io_src_msg;
  */
 typedef void (io_src_msg_cb)(struct io_src_msg *src, enum io_src_event evt);
 
+/* forward declaration, for io_src_msg_send() */
+struct io_mon;
+
+/**
+ * @struct io_src_msg_out
+ * @brief Message queued for sending
+ */
+struct io_src_msg_out;
+
+/**
+ * @typedef io_src_msg_out_cb
+ * @brief Called when a queued message has been processed, it isn't referenced
+ * by the source anymore and can be released or queued again
+ * @param out Message processed
+ * @param status 0 if the message has been sent entirely, -ECANCELED if the
+ * source has been cleaned before, errno-compatible negative value on error
+ */
+typedef void (io_src_msg_out_cb)(struct io_src_msg_out *out, int status);
+
+/**
+ * @struct io_src_msg_out
+ * @brief Message queued for sending, to be embedded in a user structure
+ */
+struct io_src_msg_out {
+	/** node for chaining in the send queue */
+	struct rs_node node;
+	/** message to send, must stay valid until cb is called */
+	const void *buf;
+	/** size of the message to send */
+	unsigned len;
+	/** callback notified once the message is processed */
+	io_src_msg_out_cb *cb;
+	/** number of bytes already written, managed by the source */
+	unsigned offset;
+};
+
+/**
+ * @typedef io_src_msg_write_cb
+ * @brief Writes one message, without blocking
+ * @param src Message source
+ * @param buf Message, or what remains to be written of it
+ * @param len Size of buf
+ * @return -EAGAIN if the message can't be written for now, errno compatible
+ * negative value on error, 0 if it has been written entirely, or the number of
+ * bytes written, if only part of it could be, the rest is written on the next
+ * OUT event
+ */
+typedef int (io_src_msg_write_cb)(struct io_src_msg *src, const void *buf,
+		unsigned len);
+
 /**
  * @typedef io_src_msg
  * @brief Message source type
@@ -71,6 +123,12 @@ struct io_src_msg {
 	 * source manages it itself in it's io cb
 	 */
 	unsigned perform_io;
+	/** queue of the messages to send, of type struct io_src_msg_out */
+	struct rs_dll send_queue;
+	/** monitor in which OUT events are activated while messages are queued */
+	struct io_mon *mon;
+	/** writes the queued messages, defaults to a plain write() */
+	io_src_msg_write_cb *write;
 };
 
 /**
@@ -110,6 +168,31 @@ int io_src_msg_init(struct io_src_msg *msg_src, int fd, enum io_src_event type,
 		io_src_msg_cb *cb, void *rcv_buf, unsigned len,
 		unsigned perform_io);
 
+/**
+ * Queues a message for sending. The monitoring of OUT events is activated
+ * automatically while messages are queued and on each OUT event, messages are
+ * written until the queue is empty or the file descriptor would block. The
+ * callback of the message is then notified with it's status.
+ * While messages are queued, the user callback isn't called for OUT events,
+ * thus the send queue shouldn't be used in conjunction with manual activation
+ * of the OUT events and io_src_msg_set_next_message().
+ * @param msg_src Message source, of type IO_OUT or IO_DUPLEX
+ * @param mon Monitor the source is registered into
+ * @param out Message to queue, with it's buf and cb fields set, it must not
+ * be modified until it's callback is called
+ * @return errno compatible negative value on error, 0 on success
+ */
+int io_src_msg_send(struct io_src_msg *msg_src, struct io_mon *mon,
+		struct io_src_msg_out *out);
+
+/**
+ * Returns the number of messages queued for sending, allowing the producer to
+ * throttle
+ * @param msg_src Message source
+ * @return number of messages queued, 0 on error
+ */
+unsigned io_src_msg_get_send_queue_length(struct io_src_msg *msg_src);
+
 /**
  * Returns the underlying io_src of the message source
  * @param msg Message source
@@ -122,6 +205,7 @@ static inline struct io_src *io_src_msg_get_source(struct io_src_msg *msg)
 
 /**
  * Cleans up a message source, by properly closing fd, zeroing fields etc...
+ * The messages still queued are notified with the -ECANCELED status
  * @param msg Message source to clean
  */
 void io_src_msg_clean(struct io_src_msg *msg);
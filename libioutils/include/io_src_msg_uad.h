@@ -12,6 +12,7 @@
 #define IO_SRC_MSG_UAD_H_
 
 #include <sys/un.h>
+#include <sys/uio.h>
 
 #include "io_src_msg.h"
 
@@ -43,6 +44,45 @@ struct sockaddr_un sun_sizecheck;
 typedef void (io_src_msg_uad_cb)(struct io_src_msg_uad *src,
 		enum io_src_event evt);
 
+/**
+ * Callback called when I/O is possible, for an UAD source in batch mode.
+ * If evt is IO_OUT, the callback can queue messages with
+ * io_src_msg_uad_queue_message(), they will be sent, with the ones already
+ * queued, by a single sendmmsg() call just after the callback returns.
+ * If evt is IO_IN, the callback is called with all the messages retrieved by a
+ * single recvmmsg() call.
+ * @param src UAD source
+ * @param evt Event type, either IO or OUT not both
+ * @param msgs Messages received, each iov_len is the size of the datagram,
+ * valid only during the callback. NULL on IO_OUT events
+ * @param nb_msgs Number of messages received, 0 on IO_OUT events
+ */
+typedef void (io_src_msg_uad_batch_cb)(struct io_src_msg_uad *src,
+		enum io_src_event evt, const struct iovec *msgs,
+		unsigned nb_msgs);
+
+/**
+ * Callback called when I/O is possible, for an UAD source in blob mode.
+ * If evt is IO_OUT, the callback can send blobs with
+ * io_src_msg_uad_send_blob().
+ * If evt is IO_IN, the callback is called with the blob just received, either
+ * stored inline or mapped read-only from the memfd which transported it.
+ * @param src UAD source
+ * @param evt Event type, either IO or OUT not both
+ * @param blob Blob received, valid only during the callback, in the case of a
+ * memfd, it is unmapped and the fd is closed when the callback returns. NULL
+ * on IO_OUT events
+ * @param len Size of the blob, 0 on IO_OUT events
+ */
+typedef void (io_src_msg_uad_blob_cb)(struct io_src_msg_uad *src,
+		enum io_src_event evt, const void *blob, size_t len);
+
+/**
+ * @struct io_src_msg_uad_batch
+ * @brief Receive slots and send queue of an UAD source in batch mode
+ */
+struct io_src_msg_uad_batch;
+
 /**
  * @struct io_src_msg_uad
  * @brief Message source type
@@ -54,6 +94,14 @@ struct io_src_msg_uad {
 	io_src_msg_uad_cb *cb;
 	/** path of the socket */
 	struct sockaddr_un addr;
+	/** user callback in batch mode, NULL otherwise */
+	io_src_msg_uad_batch_cb *batch_cb;
+	/** batch mode context, NULL if not in batch mode */
+	struct io_src_msg_uad_batch *batch;
+	/** user callback in blob mode, NULL otherwise */
+	io_src_msg_uad_blob_cb *blob_cb;
+	/** storage for blobs received inline, in blob mode */
+	void *blob_buf;
 };
 
 /**
@@ -89,6 +137,77 @@ int io_src_msg_uad_init(struct io_src_msg_uad *uad, io_src_msg_uad_cb *cb,
 		void *rcv_buf, unsigned len, const char *fmt, ...)
 __attribute__((format(printf, 5, 6)));
 
+/**
+ * Initializes a bidirectional message source, from an UAD, in batch mode.
+ * Messages are received in a set of slots filled by one recvmmsg() call and
+ * are sent from a queue flushed by one sendmmsg() call. As in normal mode, the
+ * monitoring of the output direction must be activated by the user.
+ * @param uad UAD source to initialize
+ * @param cb Callback notified
+ * @param msg_size Maximum size of a message
+ * @param nb_slots Number of receive slots, which is also the capacity of the
+ * send queue
+ * @param fmt A la printf format string for the construction of the path
+ * @return errno compatible negative value
+ */
+int io_src_msg_uad_init_batch(struct io_src_msg_uad *uad,
+		io_src_msg_uad_batch_cb *cb, unsigned msg_size,
+		unsigned nb_slots, const char *fmt, ...)
+__attribute__((format(printf, 5, 6)));
+
+/**
+ * Queues a message for sending, in batch mode. The message is copied.
+ * @param uad UAD source
+ * @param msg Message to send
+ * @param len Size of the message, at most the msg_size given at
+ * initialization
+ * @return errno compatible negative value on error, -ENOBUFS if the queue is
+ * full, 0 on success
+ */
+int io_src_msg_uad_queue_message(struct io_src_msg_uad *uad, const void *msg,
+		unsigned len);
+
+/**
+ * Sends as much queued messages as possible without blocking, with
+ * sendmmsg(), in batch mode. Called automatically on IO_OUT events.
+ * @param uad UAD source
+ * @return errno compatible negative value on error, number of messages still
+ * queued on success
+ */
+int io_src_msg_uad_flush(struct io_src_msg_uad *uad);
+
+/**
+ * Initializes a bidirectional message source, from an UAD, in blob mode.
+ * Blobs are messages of variable size, the small ones are transmitted inline,
+ * in the datagram, the large ones are copied in a sealed memfd whose file
+ * descriptor is passed alongside the datagram, with SCM_RIGHTS, so that the
+ * receiver only has to map it. As in normal mode, the monitoring of the output
+ * direction must be activated by the user.
+ * @param uad UAD source to initialize
+ * @param cb Callback notified
+ * @param inline_size Maximum size of a blob transmitted inline, larger ones
+ * are transmitted in a memfd
+ * @param fmt A la printf format string for the construction of the path
+ * @return errno compatible negative value
+ */
+int io_src_msg_uad_init_blob(struct io_src_msg_uad *uad,
+		io_src_msg_uad_blob_cb *cb, unsigned inline_size,
+		const char *fmt, ...)
+__attribute__((format(printf, 4, 5)));
+
+/**
+ * Sends a blob, in blob mode, without blocking. If it is larger than the
+ * inline_size given at initialization, it is transmitted through a sealed
+ * memfd, created, sent and closed by this function.
+ * @param uad UAD source
+ * @param blob Blob to send
+ * @param len Size of the blob
+ * @return errno compatible negative value on error, -EAGAIN if the socket's
+ * buffer is full, 0 on success
+ */
+int io_src_msg_uad_send_blob(struct io_src_msg_uad *uad, const void *blob,
+		size_t len);
+
 /**
  * Returns the underlying io_src of the UAD source
  * @param uad UAD source
@@ -3,9 +3,9 @@
  * @date 23 oct. 2012
  * @author nicolas.carrier@parrot.com
  * @brief Separator source, for input. Bytes read are stored in an internal
- * buffer of size IO_SRC_SEP_SIZE and the client is notified each time a given
- * separator or separator pair (for example \r\n) is found, if the buffer is
- * full or if end of file is reached.
+ * buffer of configurable size (IO_SRC_SEP_SIZE by default) and the client is
+ * notified each time a given delimiter (for example \n, \r\n or \r\n\r\n) is
+ * found, if the buffer is full or if end of file is reached.
  *
  * Copyright (C) 2012 Parrot S.A.
  */
@@ -25,7 +25,7 @@ extern "C" {
 
 /**
  * @def IO_SRC_SEP_SIZE
- * @brief Maximum size of a message that can be reads
+ * @brief Default maximum size of a message that can be read
  */
 #define IO_SRC_SEP_SIZE 0x100
 
@@ -59,11 +59,42 @@ struct io_src_sep;
  * @param len amount of data contained in the chunk, including the unmodified
  * separator if present
  * @note it is guaranteed that chunk[len] can be written, for example to add a
- * null byte for terminating a string, even if len == IO_SRC_SEP_SIZE
+ * null byte for terminating a string, even if len is the buffer size
  */
 typedef void (io_src_sep_cb)(struct io_src_sep *sep, char *chunk,
 		unsigned len);
 
+/**
+ * @struct io_src_sep_chunk
+ * @brief Chunk of data delivered in batch mode
+ */
+struct io_src_sep_chunk {
+	/** start of the chunk, points inside the source's buffer */
+	char *data;
+	/**
+	 * amount of data contained in the chunk, including the unmodified
+	 * delimiter if present
+	 */
+	unsigned len;
+};
+
+/**
+ * @typedef io_src_sep_batch_cb
+ * @brief User callback for the batch mode, called once per read, with all the
+ * chunks completed by the data read, in order. Partial chunks are notified
+ * under the same conditions as with io_src_sep_cb. Called with nb_chunks equal
+ * to 0 on end of file, after a last call with the remaining data if any, or on
+ * error, in this case, io_src_has_error(io_src_sep_get_source(sep)) will be
+ * true
+ * @param sep Source separator buffer
+ * @param chunks Array of the chunks found, valid only during the callback
+ * @param nb_chunks Number of chunks in the array
+ * @note contrary to io_src_sep_cb, chunks can't be written past their length,
+ * data[len] is the first byte of the next chunk
+ */
+typedef void (io_src_sep_batch_cb)(struct io_src_sep *sep,
+		struct io_src_sep_chunk *chunks, unsigned nb_chunks);
+
 /**
  * @typedef io_src_sep
  * @brief Separator source type
@@ -71,16 +102,28 @@ typedef void (io_src_sep_cb)(struct io_src_sep *sep, char *chunk,
 struct io_src_sep {
 	/** inner monitor source */
 	struct io_src src;
-	/** first separator byte */
+	/** first separator byte, set by io_src_sep_init() only */
 	char sep1;
-	/** second separator byte, INT_MAX for none */
+	/** second separator byte, '\0' for none */
 	char sep2;
 	/** 1 if the separator is made of two bytes, 0 otherwise */
 	bool two_bytes;
-	/** user callback, notified when one of the registered signals occur */
+	/** delimiter bytes, not null terminated */
+	char *delim;
+	/** number of bytes in the delimiter */
+	unsigned delim_len;
+	/** user callback, notified for each chunk, NULL in batch mode */
 	io_src_sep_cb *cb;
-	/** buffer containing the bytes read from the source */
-	char buf[2 * IO_SRC_SEP_SIZE + 1];
+	/** user callback, notified once per read in batch mode, NULL if not */
+	io_src_sep_batch_cb *batch_cb;
+	/** chunks found in the last read, in batch mode */
+	struct io_src_sep_chunk *chunks;
+	/** number of elements the chunks array can hold */
+	unsigned chunks_capacity;
+	/** maximum size of a chunk */
+	unsigned size;
+	/** buffer of 2 * size + 1 bytes, containing the bytes read */
+	char *buf;
 
 	/** first byte to be consumed for the next line to send to the client */
 	unsigned from;
@@ -89,6 +132,18 @@ struct io_src_sep {
 	 * the client
 	 */
 	unsigned up_to;
+	/**
+	 * first byte where a delimiter could start, bytes between from and
+	 * scan_from are already known not to contain one
+	 */
+	unsigned scan_from;
+	/** true while a user callback is running */
+	bool notifying;
+	/**
+	 * true if io_src_sep_clean() has been called from a user callback, the
+	 * clean up is then performed once the callback has returned
+	 */
+	bool clean_pending;
 };
 
 /**
@@ -110,6 +165,43 @@ struct io_src_sep {
 int io_src_sep_init(struct io_src_sep *sep_src, int fd, io_src_sep_cb *cb,
 		int sep1, int sep2);
 
+/**
+ * Initializes a separator source with a delimiter of arbitrary length and a
+ * custom buffer size
+ * @param sep_src Separator source to initialize
+ * @param fd File descriptor
+ * @param cb Callback called on each chunk of data, retrieved before a delimiter
+ * @param delim Delimiter between the chunks of data, copied internally. Can
+ * contain null bytes
+ * @param delim_len Number of bytes of the delimiter, must be non-zero and
+ * strictly less than size
+ * @param size Maximum size of a chunk, pass IO_SRC_SEP_SIZE for the default
+ * @return Negative errno compatible value on error, 0 otherwise
+ */
+int io_src_sep_init_delim(struct io_src_sep *sep_src, int fd,
+		io_src_sep_cb *cb, const char *delim, unsigned delim_len,
+		unsigned size);
+
+/**
+ * Initializes a separator source in batch mode : each read fills as much of
+ * the buffer as possible, the chunks found are notified in one call to cb and
+ * the remaining partial chunk is moved to the start of the buffer once, after
+ * the notification
+ * @param sep_src Separator source to initialize
+ * @param fd File descriptor
+ * @param cb Callback called once per read with the chunks found
+ * @param delim Delimiter between the chunks of data, copied internally. Can
+ * contain null bytes
+ * @param delim_len Number of bytes of the delimiter, must be non-zero and
+ * strictly less than size
+ * @param size Maximum size of a chunk, a read can retrieve up to twice this
+ * size
+ * @return Negative errno compatible value on error, 0 otherwise
+ */
+int io_src_sep_init_batch(struct io_src_sep *sep_src, int fd,
+		io_src_sep_batch_cb *cb, const char *delim, unsigned delim_len,
+		unsigned size);
+
 /**
  * Returns the underlying io_src of the separator source
  * @param sep Separator source
@@ -121,7 +213,9 @@ static inline struct io_src *io_src_sep_get_source(struct io_src_sep *sep)
 }
 
 /**
- * Cleans up a separator source
+ * Cleans up a separator source, releasing it's buffers. Can be called from the
+ * user callback, in which case no other chunk is notified and the clean up is
+ * completed when the callback returns
  * @param sep Separator source
  */
 void io_src_sep_clean(struct io_src_sep *sep);
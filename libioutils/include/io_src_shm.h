@@ -0,0 +1,142 @@
+/**
+ * @file io_src_shm.h
+ * @date 19 oct. 2026
+ * @author nicolas.carrier@parrot.com
+ * @brief Source for receiving messages from another process through a ring
+ * buffer in shared memory.
+ * The consumer creates the ring, a memfd holding a control block followed by
+ * a mirrored buffer (see rs_rb_init_from_fd_at()), and an eventfd, both to be
+ * passed to the producer, with SCM_RIGHTS or by inheritance. Sending a message
+ * copies it in the ring and publishes it with a store, the eventfd is written
+ * only if the consumer sleeps, that is, if it has emptied the ring and
+ * returned to it's event loop, so that a busy consumer costs the producer no
+ * system call.
+ * A ring has one producer and one consumer, messages in the other direction
+ * need a second ring. The producer can't block, sending fails with -EAGAIN
+ * when the ring is full. The consumer doesn't trust the producer, a message
+ * overflowing the data published drops all the data published.
+ *
+ * Copyright (C) 2026 Parrot S.A.
+ */
+#ifndef IO_SRC_SHM_H_
+#define IO_SRC_SHM_H_
+#include <stddef.h>
+#include <stdint.h>
+
+#include <rs_rb.h>
+
+#include <io_src.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @struct io_src_shm
+ * @brief Shared memory ring source type
+ */
+struct io_src_shm;
+
+/**
+ * @struct io_src_shm_ctl
+ * @brief Control block of a ring, shared by the producer and the consumer
+ */
+struct io_src_shm_ctl;
+
+/**
+ * @typedef io_src_shm_cb
+ * @brief Called for each message received, on the consumer side
+ * @param shm Shared memory source
+ * @param msg Message, in the ring, valid only during the callback
+ * @param len Size of the message
+ */
+typedef void (io_src_shm_cb)(struct io_src_shm *shm, const void *msg,
+		size_t len);
+
+/**
+ * @struct io_src_shm
+ * @brief Shared memory ring source type
+ */
+struct io_src_shm {
+	/** eventfd, only monitored on the consumer side */
+	struct io_src src;
+	/** user callback, NULL on the producer side */
+	io_src_shm_cb *cb;
+	/** control block, in shared memory */
+	struct io_src_shm_ctl *ctl;
+	/** mirrored buffer of the ring, it's offsets are unused */
+	struct rs_rb rb;
+	/** memfd, kept by the consumer to be passed to the producer */
+	int mem_fd;
+	/** last read index seen by the producer */
+	uint64_t read_cache;
+};
+
+/**
+ * Initializes the consumer side of a shared memory ring, creating it
+ * @param shm Shared memory source to initialize
+ * @param cb Callback notified for each message received
+ * @param size Size of the ring's buffer, rounded to the next multiple of the
+ * size of a page, must then be a power of two. Each message takes 8 bytes of
+ * header, plus it's size rounded to the next multiple of 8
+ * @return errno compatible negative value on error, 0 on success
+ */
+int io_src_shm_init(struct io_src_shm *shm, io_src_shm_cb *cb, size_t size);
+
+/**
+ * Returns the file descriptors to pass to the producer, they stay owned by
+ * the consumer
+ * @param shm Shared memory source, consumer side
+ * @param mem_fd In output, memfd of the ring
+ * @param evt_fd In output, eventfd of the consumer
+ * @return errno compatible negative value on error, 0 on success
+ */
+int io_src_shm_get_fds(const struct io_src_shm *shm, int *mem_fd,
+		int *evt_fd);
+
+/**
+ * Initializes the producer side of a shared memory ring, the source must not
+ * be registered in a monitor
+ * @param shm Shared memory source to initialize
+ * @param mem_fd memfd of the ring, as returned by io_src_shm_get_fds(), the
+ * caller can close it once this function returns
+ * @param evt_fd eventfd of the consumer, duplicated, the caller can close it
+ * once this function returns
+ * @return errno compatible negative value on error, -EPERM if the memfd isn't
+ * sealed against shrinking, -EBADMSG if it isn't a valid ring, 0 on success
+ */
+int io_src_shm_init_producer(struct io_src_shm *shm, int mem_fd, int evt_fd);
+
+/**
+ * Sends a message, without blocking. The consumer is woken up if needed
+ * @param shm Shared memory source, producer side
+ * @param msg Message to send, can be NULL if len is 0
+ * @param len Size of the message
+ * @return errno compatible negative value on error, -EAGAIN if the ring is
+ * full, -EMSGSIZE if the message can't fit in the ring, 0 on success
+ */
+int io_src_shm_send(struct io_src_shm *shm, const void *msg, size_t len);
+
+/**
+ * Returns the underlying io_src of the shared memory source, to register in
+ * the consumer's monitor
+ * @param shm Shared memory source
+ * @return io_src of the shared memory source, NULL on the producer side
+ */
+static inline struct io_src *io_src_shm_get_source(struct io_src_shm *shm)
+{
+	return NULL == shm || NULL == shm->cb ? NULL : &shm->src;
+}
+
+/**
+ * Cleans up a shared memory source, unmapping the ring and closing it's file
+ * descriptors
+ * @param shm Shared memory source to clean
+ */
+void io_src_shm_clean(struct io_src_shm *shm);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* IO_SRC_SHM_H_ */
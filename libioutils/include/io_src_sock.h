@@ -0,0 +1,182 @@
+/**
+ * @file io_src_sock.h
+ * @date 19 oct. 2026
+ * @author nicolas.carrier@parrot.com
+ * @brief Sources for connection oriented sockets : UNIX stream, UNIX seqpacket
+ * and TCP. A listener source accepts the incoming connections, each connection
+ * can then be managed with an io_io buffered read / write context
+ *
+ * Copyright (C) 2026 Parrot S.A.
+ */
+
+#ifndef IO_SRC_SOCK_H_
+#define IO_SRC_SOCK_H_
+#include <sys/socket.h>
+
+#include <io_src.h>
+#include <io_io.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @enum io_src_sock_type
+ * @brief kind of socket to create
+ */
+enum io_src_sock_type {
+	/** UNIX socket in stream mode */
+	IO_SRC_SOCK_UNIX_STREAM,
+	/** UNIX socket in sequenced packet mode */
+	IO_SRC_SOCK_UNIX_SEQPACKET,
+	/** IPv4 TCP socket */
+	IO_SRC_SOCK_TCP,
+};
+
+/**
+ * @struct io_src_sock_listener
+ * @brief Listening socket source, accepting incoming connections
+ */
+struct io_src_sock_listener;
+
+/**
+ * @typedef io_src_sock_accept_cb
+ * @brief Called once per accepted connection
+ * @param listener Listener which accepted the connection
+ * @param fd File descriptor of the new connection, non-blocking and
+ * close-on-exec, the callback takes it's ownership, for example by passing it
+ * to io_src_sock_conn_init()
+ */
+typedef void (io_src_sock_accept_cb)(struct io_src_sock_listener *listener,
+		int fd);
+
+/**
+ * @struct io_src_sock_listener
+ * @brief Listening socket source, accepting incoming connections
+ */
+struct io_src_sock_listener {
+	/** inner monitor source */
+	struct io_src src;
+	/** kind of the socket */
+	enum io_src_sock_type type;
+	/** user callback, notified of each new connection */
+	io_src_sock_accept_cb *cb;
+	/** address the socket is bound to */
+	struct sockaddr_storage addr;
+	/** length of the address */
+	socklen_t addr_len;
+	/**
+	 * spare file descriptor, released to accept and close the pending
+	 * connections when the process runs out of file descriptors
+	 */
+	int reserve_fd;
+};
+
+/**
+ * @struct io_src_sock_conn
+ * @brief Connected socket, with buffered reads and writes
+ */
+struct io_src_sock_conn {
+	/** buffered read / write context */
+	struct io_io io;
+	/** file descriptor of the connection, owned by the connection */
+	int fd;
+};
+
+/**
+ * Creates a socket, binds it and listens on it for incoming connections. Each
+ * time the monitor notifies the listener, connections are accepted until none
+ * is pending anymore. If the process runs out of file descriptors, the pending
+ * connections are closed right after being accepted, so that they don't stay
+ * in the backlog and wake up the monitor in loop.
+ * @param listener Listener source to initialize
+ * @param type Kind of socket
+ * @param cb Callback notified for each new connection
+ * @param fmt Format of the address to listen to. For UNIX sockets, the path of
+ * the socket, or it's abstract name prefixed with a '@'. For TCP sockets, the
+ * dotted IPv4 address and the port, in the form "127.0.0.1:4242", a port of 0
+ * lets the system choose a free one, see io_src_sock_get_port()
+ * @return errno-compatible negative value on error, 0 otherwise
+ */
+int io_src_sock_listener_init(struct io_src_sock_listener *listener,
+		enum io_src_sock_type type, io_src_sock_accept_cb *cb,
+		const char *fmt, ...) __attribute__ ((format (printf, 4, 5)));
+
+/**
+ * Returns the port a TCP listener is bound to, useful when it was initialized
+ * with a port of 0
+ * @param listener Listener source
+ * @return errno-compatible negative value on error, port in host order
+ * otherwise
+ */
+int io_src_sock_get_port(struct io_src_sock_listener *listener);
+
+/**
+ * Returns the underlying io_src of the listener
+ * @param listener Listener source
+ * @return io_src of the listener
+ */
+static inline struct io_src *io_src_sock_listener_get_source(
+		struct io_src_sock_listener *listener)
+{
+	return NULL == listener ? NULL : &listener->src;
+}
+
+/**
+ * Cleans up a listener, closing it's socket. If it was bound to a UNIX socket
+ * path, the socket file is removed
+ * @param listener Listener source
+ */
+void io_src_sock_listener_clean(struct io_src_sock_listener *listener);
+
+/**
+ * Connects a new socket to a listening peer, synchronously
+ * @param type Kind of socket
+ * @param fmt Format of the address to connect to, same syntax as for
+ * io_src_sock_listener_init()
+ * @return errno-compatible negative value on error, file descriptor of the
+ * connected socket otherwise, non-blocking and close-on-exec
+ */
+int io_src_sock_connect(enum io_src_sock_type type, const char *fmt, ...)
+		__attribute__ ((format (printf, 2, 3)));
+
+/**
+ * Initializes a connection context, registering it in the monitor. The data
+ * can then be read and written with the io_io API, applied on conn->io.
+ * For seqpacket sockets, a read never returns more than one packet, but the
+ * packet boundaries aren't kept in the read ring buffer and packets longer than
+ * IO_IO_RB_BUFFER_SIZE are truncated
+ * @param conn Connection to initialize
+ * @param mon Monitor the connection will be registered into
+ * @param name Name of the connection, for logging purpose
+ * @param fd File descriptor of the connected socket, as returned by
+ * io_src_sock_connect() or passed to an io_src_sock_accept_cb, on success, the
+ * connection takes it's ownership
+ * @return errno-compatible negative value on error, 0 otherwise
+ */
+int io_src_sock_conn_init(struct io_src_sock_conn *conn, struct io_mon *mon,
+		const char *name, int fd);
+
+/**
+ * Returns the buffered read / write context of a connection
+ * @param conn Connection
+ * @return io_io context of the connection
+ */
+static inline struct io_io *io_src_sock_conn_get_io(
+		struct io_src_sock_conn *conn)
+{
+	return NULL == conn ? NULL : &conn->io;
+}
+
+/**
+ * Cleans up a connection, unregistering it from it's monitor, aborting the
+ * pending writes and closing it's socket
+ * @param conn Connection
+ */
+void io_src_sock_conn_clean(struct io_src_sock_conn *conn);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* IO_SRC_SOCK_H_ */
@@ -0,0 +1,164 @@
+/**
+ * @file io_src_thread_pool.h
+ * @date 19 oct. 2026
+ * @author nicolas.carrier@parrot.com
+ * @brief Fixed size pool of worker threads, running blocking jobs on behalf of
+ * an event loop. Where io_src_thread creates a thread and an eventfd per job,
+ * the pool's workers are created once, each one has it's own queue of jobs and
+ * steals jobs from the others' queues when it's own is empty. Completed jobs
+ * are pushed on a lock-free queue and notified through one shared eventfd,
+ * their completion callbacks are called on the monitor's thread.
+ *
+ * Copyright (C) 2026 Parrot S.A.
+ */
+#ifndef IO_SRC_THREAD_POOL_H_
+#define IO_SRC_THREAD_POOL_H_
+#include <pthread.h>
+
+#include <stdbool.h>
+
+#include <io_src_evt.h>
+#include <io_mon.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @struct io_src_thread_pool
+ * @brief thread pool source type
+ */
+struct io_src_thread_pool;
+
+/**
+ * @struct io_src_thread_pool_job
+ * @brief job to run in a worker thread
+ */
+struct io_src_thread_pool_job;
+
+/* worker thread, internal */
+struct thread_pool_worker;
+
+/**
+ * @typedef io_src_thread_pool_work
+ * @brief work of a job, executed in one of the worker threads
+ * @param job Job being run
+ * @return value passed to the completion callback
+ */
+typedef int (io_src_thread_pool_work)(struct io_src_thread_pool_job *job);
+
+/**
+ * @typedef io_src_thread_pool_done_cb
+ * @brief callback called on the monitor's thread, when a job has completed
+ * @param job Job completed, it can be submitted again, or disposed
+ * @param ret Value returned by the job's work, -ECANCELED if the pool was
+ * cleaned before the job could be run
+ */
+typedef void (io_src_thread_pool_done_cb)(struct io_src_thread_pool_job *job,
+		int ret);
+
+/**
+ * @struct io_src_thread_pool_job
+ * @brief job to run in a worker thread, allocated by the caller, usually
+ * embedded in a bigger structure, retrieved with ut_container_of()
+ */
+struct io_src_thread_pool_job {
+	/** work of the job */
+	io_src_thread_pool_work *work;
+	/** completion callback */
+	io_src_thread_pool_done_cb *done;
+	/** return value of the work */
+	int ret;
+	/** next job in the queue the job is in, internal */
+	struct io_src_thread_pool_job *next;
+};
+
+/**
+ * @struct io_src_thread_pool
+ * @brief thread pool source type
+ */
+struct io_src_thread_pool {
+	/** event source, notifying of the completion of jobs */
+	struct io_src_evt evt;
+	/** monitor the pool is registered in */
+	struct io_mon *mon;
+	/** worker threads */
+	struct thread_pool_worker *workers;
+	/** number of worker threads */
+	unsigned nb_workers;
+	/** worker the next job submitted will be queued to */
+	unsigned next_worker;
+	/** protects nb_queued and stop, for the workers to sleep */
+	pthread_mutex_t lock;
+	/** signaled when jobs are queued, or the pool is stopped */
+	pthread_cond_t cond;
+	/** number of jobs queued, not yet taken by a worker */
+	unsigned nb_queued;
+	/** true when the workers must exit, without taking the jobs queued */
+	bool stop;
+	/** lock-free stack of the jobs completed, last completed first */
+	struct io_src_thread_pool_job *completed;
+	/** number of jobs submitted, whose completion hasn't been notified */
+	unsigned nb_pending;
+};
+
+/**
+ * Initializes a thread pool, starts it's workers and registers it in a monitor
+ * @param pool Thread pool to initialize
+ * @param mon Monitor the completions will be notified through
+ * @param nb_workers Number of worker threads, 0 for one per online CPU
+ * @return errno-compatible negative value on error, 0 on success
+ */
+int io_src_thread_pool_init(struct io_src_thread_pool *pool,
+		struct io_mon *mon, unsigned nb_workers);
+
+/**
+ * Submits a job to the pool, must be called from the monitor's thread
+ * @param pool Thread pool
+ * @param job Job to run, mustn't be modified nor disposed before it's
+ * completion callback is called
+ * @param work Work of the job, run in a worker thread
+ * @param done Completion callback, called on the monitor's thread
+ * @return errno-compatible negative value on error, 0 on success
+ */
+int io_src_thread_pool_submit(struct io_src_thread_pool *pool,
+		struct io_src_thread_pool_job *job,
+		io_src_thread_pool_work *work,
+		io_src_thread_pool_done_cb *done);
+
+/**
+ * Returns the number of jobs submitted, whose completion hasn't been notified
+ * yet
+ * @param pool Thread pool
+ * @return number of jobs pending
+ */
+static inline unsigned io_src_thread_pool_get_pending(
+		struct io_src_thread_pool *pool)
+{
+	return NULL == pool ? 0 : pool->nb_pending;
+}
+
+/**
+ * Retrieves the underlying io_src of the thread pool
+ * @param pool Thread pool
+ * @return io_src of the thread pool
+ */
+static inline struct io_src *io_src_thread_pool_get_source(
+		struct io_src_thread_pool *pool)
+{
+	return NULL == pool ? NULL : io_src_evt_get_source(&pool->evt);
+}
+
+/**
+ * Cleans up a thread pool, waits for the jobs running to finish and
+ * unregisters it from it's monitor. The completion callbacks of the jobs still
+ * pending are called, with -ECANCELED for those which couldn't be run
+ * @param pool Thread pool
+ */
+void io_src_thread_pool_clean(struct io_src_thread_pool *pool);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* IO_SRC_THREAD_POOL_H_ */
@@ -49,6 +49,31 @@ ssize_t io_recvfrom(int sockfd, void *buf, size_t len, int flags,
 ssize_t io_sendto(int sockfd, const void *buf, size_t len, int flags,
 		const struct sockaddr *dest_addr, socklen_t addrlen);
 
+/* only defined by glibc if _GNU_SOURCE was set before the first include */
+struct mmsghdr;
+struct timespec;
+
+/**
+ * Wrapper around recvmmsg, discarding EINTR errors
+ * @see recvmmsg
+ */
+int io_recvmmsg(int sockfd, struct mmsghdr *msgvec, unsigned int vlen,
+		int flags, struct timespec *timeout);
+
+/**
+ * Wrapper around sendmmsg, discarding EINTR errors
+ * @see sendmmsg
+ */
+int io_sendmmsg(int sockfd, struct mmsghdr *msgvec, unsigned int vlen,
+		int flags);
+
+/**
+ * Wrapper around accept4, discarding EINTR errors
+ * @see accept4
+ */
+int io_accept4(int sockfd, struct sockaddr *addr, socklen_t *addrlen,
+		int flags);
+
 /**
  * Wrapper around waitpid, discarding EINTR errors
  * @see waitpid
@@ -0,0 +1,276 @@
+/**
+ * @file io_frame.c
+ * @date 19 oct. 2026
+ * @author nicolas.carrier@parrot.com
+ * @brief Framing of a byte stream stored in a ring buffer
+ *
+ * Copyright (C) 2026 Parrot S.A.
+ */
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif /* _GNU_SOURCE */
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+#include "io_frame.h"
+
+static bool width_is_invalid(unsigned width)
+{
+	return width != 1 && width != 2 && width != 4 && width != 8;
+}
+
+/**
+ * Decodes an unsigned integer field
+ * @param p Start of the field
+ * @param width Width of the field, in bytes
+ * @param endianness Byte order of the field
+ * @return Value of the field
+ */
+static uint64_t read_field(const unsigned char *p, unsigned width,
+		enum io_frame_endianness endianness)
+{
+	uint64_t value = 0;
+	unsigned i;
+
+	if (endianness == IO_FRAME_BIG_ENDIAN)
+		for (i = 0; i < width; i++)
+			value = (value << 8) | p[i];
+	else
+		for (i = width; i > 0; i--)
+			value = (value << 8) | p[i - 1];
+
+	return value;
+}
+
+/**
+ * Marks a frame which can't fit in the ring buffer for being discarded, as it
+ * arrives
+ * @param frame Framing engine
+ * @param frame_len Total size of the frame
+ */
+static void drop(struct io_frame *frame, uint64_t frame_len)
+{
+	frame->skip = frame_len;
+	frame->nb_dropped++;
+}
+
+/**
+ * Extracts and notifies a frame, in length and TLV framing
+ * @param frame Framing engine
+ * @param rb Ring buffer
+ * @param p Contiguous view of the data stored in the ring buffer
+ * @param avail Size of the data stored in the ring buffer
+ * @param stop In output, the user callback's return value, if called
+ * @return false if the frame isn't complete, true if a frame has been consumed
+ */
+static bool next_length(struct io_frame *frame, struct rs_rb *rb,
+		const unsigned char *p, size_t avail, int *stop)
+{
+	uint64_t len;
+	uint64_t frame_len;
+	uint64_t tag = 0;
+
+	if (avail < frame->header_size)
+		return false;
+
+	len = read_field(p + frame->length_offset, frame->length_width,
+			frame->endianness);
+	if (frame->includes_header)
+		/* if malformed, at least skip the header to make progress */
+		frame_len = len < frame->header_size ? 0 : len;
+	else
+		frame_len = len > UINT64_MAX - frame->header_size ?
+				UINT64_MAX : frame->header_size + len;
+	if (0 == frame_len || frame_len > rs_rb_get_size(rb)) {
+		drop(frame, 0 == frame_len ? frame->header_size : frame_len);
+		return true;
+	}
+	if (avail < frame_len)
+		return false;
+
+	if (frame->type == IO_FRAME_TLV)
+		tag = read_field(p, frame->tag_width, frame->endianness);
+
+	*stop = frame->cb(frame, tag, p + frame->header_size,
+			frame_len - frame->header_size);
+	rs_rb_read_incr(rb, frame_len);
+
+	return true;
+}
+
+/**
+ * Extracts and notifies a frame, in delimiter framing
+ * @param frame Framing engine
+ * @param rb Ring buffer
+ * @param p Contiguous view of the data stored in the ring buffer
+ * @param avail Size of the data stored in the ring buffer
+ * @param stop In output, the user callback's return value, if called
+ * @return false if the frame isn't complete, true if a frame has been consumed
+ */
+static bool next_delim(struct io_frame *frame, struct rs_rb *rb,
+		const unsigned char *p, size_t avail, int *stop)
+{
+	const unsigned char *found;
+	size_t len;
+	size_t keep;
+
+	found = memmem(p + frame->scan_from, avail - frame->scan_from,
+			frame->delim, frame->delim_len);
+	if (NULL == found) {
+		/* a delimiter may start in the last bytes */
+		keep = avail < frame->delim_len ? avail : frame->delim_len - 1;
+		if (frame->discard || avail == rs_rb_get_size(rb)) {
+			/* no room left for the delimiter to arrive */
+			if (!frame->discard)
+				frame->nb_dropped++;
+			frame->discard = true;
+			rs_rb_read_incr(rb, avail - keep);
+			frame->scan_from = 0;
+			return false;
+		}
+		frame->scan_from = avail - keep;
+		return false;
+	}
+
+	len = found - p;
+	frame->scan_from = 0;
+	if (frame->discard)
+		/* end of the oversized frame, it's tail isn't a frame */
+		frame->discard = false;
+	else
+		*stop = frame->cb(frame, 0, p, len);
+	rs_rb_read_incr(rb, len + frame->delim_len);
+
+	return true;
+}
+
+int io_frame_process(struct io_frame *frame, struct rs_rb *rb)
+{
+	size_t avail;
+	size_t n;
+	bool consumed;
+	int stop = 0;
+
+	if (NULL == frame || NULL == rb || !rb->mirror ||
+			frame->delim_len >= rs_rb_get_size(rb))
+		return -EINVAL;
+
+	do {
+		avail = rs_rb_get_read_length(rb);
+		if (0 != frame->skip) {
+			n = frame->skip < avail ? frame->skip : avail;
+			rs_rb_read_incr(rb, n);
+			frame->skip -= n;
+			consumed = 0 == frame->skip;
+			continue;
+		}
+		if (0 == avail)
+			return 0;
+
+		/* thanks to the mirroring, the data stored is contiguous */
+		if (frame->type == IO_FRAME_DELIM)
+			consumed = next_delim(frame, rb, rs_rb_get_read_ptr(rb),
+					avail, &stop);
+		else
+			consumed = next_length(frame, rb,
+					rs_rb_get_read_ptr(rb), avail, &stop);
+	} while (consumed && 0 == stop);
+
+	return 0 == stop ? 0 : 1;
+}
+
+int io_frame_io_read_cb(struct io_io *io, struct rs_rb *rb, void *data)
+{
+	struct io_frame *frame = data;
+	int ret;
+
+	ret = io_frame_process(frame, rb);
+	if (io_io_has_read_error(io))
+		frame->cb(frame, 0, NULL, 0);
+
+	return ret;
+}
+
+/**
+ * Initializes the fields common to the length and TLV framing
+ * @see io_frame_init_length
+ */
+static int length_init(struct io_frame *frame, enum io_frame_type type,
+		io_frame_cb *cb, size_t header_size, size_t length_offset,
+		unsigned length_width, enum io_frame_endianness endianness,
+		bool includes_header)
+{
+	if (NULL == frame || NULL == cb || width_is_invalid(length_width) ||
+			length_offset + length_width > header_size ||
+			(endianness != IO_FRAME_BIG_ENDIAN &&
+			endianness != IO_FRAME_LITTLE_ENDIAN))
+		return -EINVAL;
+
+	memset(frame, 0, sizeof(*frame));
+	frame->type = type;
+	frame->cb = cb;
+	frame->header_size = header_size;
+	frame->length_offset = length_offset;
+	frame->length_width = length_width;
+	frame->endianness = endianness;
+	frame->includes_header = includes_header;
+
+	return 0;
+}
+
+int io_frame_init_length(struct io_frame *frame, io_frame_cb *cb,
+		size_t header_size, size_t length_offset,
+		unsigned length_width, enum io_frame_endianness endianness,
+		bool includes_header)
+{
+	return length_init(frame, IO_FRAME_LENGTH, cb, header_size,
+			length_offset, length_width, endianness,
+			includes_header);
+}
+
+int io_frame_init_delim(struct io_frame *frame, io_frame_cb *cb,
+		const char *delim, size_t delim_len, size_t rb_size)
+{
+	if (NULL == frame || NULL == cb || NULL == delim || 0 == delim_len ||
+			delim_len >= rb_size)
+		return -EINVAL;
+
+	memset(frame, 0, sizeof(*frame));
+	frame->delim = malloc(delim_len);
+	if (NULL == frame->delim)
+		return -ENOMEM;
+	memcpy(frame->delim, delim, delim_len);
+	frame->delim_len = delim_len;
+	frame->type = IO_FRAME_DELIM;
+	frame->cb = cb;
+
+	return 0;
+}
+
+int io_frame_init_tlv(struct io_frame *frame, io_frame_cb *cb,
+		unsigned tag_width, unsigned length_width,
+		enum io_frame_endianness endianness)
+{
+	int ret;
+
+	if (width_is_invalid(tag_width))
+		return -EINVAL;
+
+	ret = length_init(frame, IO_FRAME_TLV, cb, tag_width + length_width,
+			tag_width, length_width, endianness, false);
+	if (ret < 0)
+		return ret;
+	frame->tag_width = tag_width;
+
+	return 0;
+}
+
+void io_frame_clean(struct io_frame *frame)
+{
+	if (NULL == frame)
+		return;
+
+	free(frame->delim);
+	memset(frame, 0, sizeof(*frame));
+}
@@ -9,6 +9,8 @@
 #ifndef _GNU_SOURCE
 #define _GNU_SOURCE
 #endif /* _GNU_SOURCE */
+#include <sys/eventfd.h>
+
 #include <unistd.h>
 
 #include <errno.h>
@@ -18,6 +20,7 @@
 #include <stdio.h>
 #include <string.h>
 #include <inttypes.h>
+#include <time.h>
 
 #include <ut_utils.h>
 #include <ut_file.h>
@@ -29,6 +32,9 @@
 
 #define MONITOR_MAX_SOURCES 10
 
+/* weight of the last sample in the average time between events, 1/2^n */
+#define INTERARRIVAL_SHIFT 3
+
 /**
  * Adds a source to the monitor
  * @param monitor Monitor context
@@ -207,6 +213,112 @@ static int process_event_sets(struct io_mon *mon, struct io_src *src)
 	return 0;
 }
 
+/**
+ * Runs the tasks posted to a monitor, in the order they were posted. The
+ * eventfd is read before the stack is taken, so that a task posted meanwhile
+ * re-arms it
+ * @param mon Monitor
+ */
+static void run_posted_tasks(struct io_mon *mon)
+{
+	uint64_t value;
+	struct io_mon_task *task;
+	struct io_mon_task *next;
+	struct io_mon_task *fifo = NULL;
+
+	io_read(mon->post_src.fd, &value, sizeof(value));
+	task = __atomic_exchange_n(&mon->posted, NULL, __ATOMIC_ACQUIRE);
+	for (; task != NULL; task = next) {
+		next = task->next;
+		task->next = fifo;
+		fifo = task;
+	}
+
+	for (task = fifo; task != NULL; task = next) {
+		next = task->next;
+		task->cb(task);
+	}
+}
+
+/**
+ * Runs the deferred callbacks scheduled in a list, those scheduled by the
+ * callbacks themselves are left for the next pass
+ * @param list List of deferred callbacks
+ */
+static void run_deferred(struct rs_dll *list)
+{
+	unsigned count = rs_dll_get_count(list);
+	struct rs_node *node;
+	struct io_mon_deferred *deferred;
+
+	while (count-- > 0) {
+		node = rs_dll_pop(list);
+		if (NULL == node)
+			break;
+		deferred = ut_container_of(node, struct io_mon_deferred, node);
+		deferred->list = NULL;
+		deferred->cb(deferred);
+	}
+}
+
+/**
+ * Drops the deferred callbacks scheduled in a list, without running them
+ * @param list List of deferred callbacks
+ */
+static void drop_deferred(struct rs_dll *list)
+{
+	struct rs_node *node;
+	struct io_mon_deferred *deferred;
+
+	while ((node = rs_dll_pop(list)) != NULL) {
+		deferred = ut_container_of(node, struct io_mon_deferred, node);
+		deferred->list = NULL;
+	}
+}
+
+/**
+ * Makes the monitor's file descriptor readable, through the post source
+ * @param mon Monitor
+ * @return negative errno value on error, 0 otherwise
+ */
+static int wake_up(struct io_mon *mon)
+{
+	uint64_t one = 1;
+
+	return -1 == io_write(mon->post_src.fd, &one, sizeof(one)) ? -errno : 0;
+}
+
+/**
+ * Schedules a deferred callback in a list, if it isn't already
+ * @param list List of deferred callbacks
+ * @param deferred Deferred callback
+ * @param cb Callback
+ * @return negative errno value on error, 0 otherwise
+ */
+static int schedule_deferred(struct rs_dll *list,
+		struct io_mon_deferred *deferred, io_mon_deferred_cb *cb)
+{
+	if (NULL == deferred || NULL == cb)
+		return -EINVAL;
+
+	if (NULL != deferred->list)
+		return 0;
+	deferred->cb = cb;
+	deferred->list = list;
+
+	return rs_dll_enqueue(list, &deferred->node);
+}
+
+/**
+ * Callback of the post source, which isn't in the sources list, thus is
+ * dispatched directly by do_process_events_sets()
+ * @param src Post source
+ */
+static void post_cb(struct io_src *src)
+{
+	run_posted_tasks(ut_container_of(src, struct io_mon, post_src));
+}
+
 /**
  * Notifies client of I/O events sets pending for a source and checks for
  * errors.
@@ -230,6 +342,12 @@ static int do_process_events_sets(struct io_mon *mon, int n,
 			/* coverity[dead_error_line : FALSE] */
 			return -EINVAL;
 
+		/* the post source isn't in the sources list */
+		if (src == &mon->post_src) {
+			run_posted_tasks(mon);
+			continue;
+		}
+
 		/*
 		 * a source can have been removed by a previous source's
 		 * callback, in this case, we must skip it
@@ -275,6 +393,151 @@ static int activate_source(struct io_mon *mon, struct io_src *src,
 	return alter_source(mon->epollfd, src, EPOLL_CTL_MOD);
 }
 
+/**
+ * Returns the current time of the monotonic clock
+ * @return time in nanoseconds
+ */
+static uint64_t now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+/**
+ * Computes how long a poll which would block must spin first
+ * @param mon Monitor
+ * @return spinning duration in nanoseconds, 0 for not spinning
+ */
+static uint64_t busy_poll_budget(struct io_mon *mon)
+{
+	switch (mon->busy_poll) {
+	case IO_MON_BUSY_POLL_FIXED:
+		return mon->busy_poll_ns;
+
+	case IO_MON_BUSY_POLL_ADAPTIVE:
+		/* the next event won't arrive in time, don't waste cpu */
+		if (mon->interarrival_ns > mon->busy_poll_ns)
+			return 0;
+		return 2 * mon->interarrival_ns < mon->busy_poll_ns ?
+				2 * mon->interarrival_ns : mon->busy_poll_ns;
+
+	default:
+		return 0;
+	}
+}
+
+/**
+ * Updates the average time between events, when events are received
+ * @param mon Monitor
+ */
+static void update_interarrival(struct io_mon *mon)
+{
+	uint64_t now;
+	int64_t delta;
+
+	if (mon->busy_poll != IO_MON_BUSY_POLL_ADAPTIVE)
+		return;
+
+	now = now_ns();
+	if (mon->last_events_ns != 0) {
+		delta = (int64_t)(now - mon->last_events_ns) -
+				(int64_t)mon->interarrival_ns;
+		mon->interarrival_ns += delta / (1 << INTERARRIVAL_SHIFT);
+	}
+	mon->last_events_ns = now;
+}
+
+/**
+ * Waits for events, spinning before blocking if busy-polling is configured
+ * @param mon Monitor
+ * @param events Output events
+ * @param timeout Timeout in milliseconds, -1 for infinite
+ * @return number of events retrieved, -1 on error, with errno set
+ */
+static int wait_events(struct io_mon *mon, struct epoll_event *events,
+		int timeout)
+{
+	uint64_t budget;
+	uint64_t start;
+	uint64_t elapsed;
+	int n;
+
+	budget = timeout == 0 ? 0 : busy_poll_budget(mon);
+	if (budget != 0) {
+		start = now_ns();
+		do {
+			n = io_epoll_wait(mon->epollfd, events,
+					MONITOR_MAX_SOURCES, 0);
+			mon->busy_poll_stats.spins++;
+			if (n != 0) {
+				if (n > 0)
+					mon->busy_poll_stats.hits++;
+				return n;
+			}
+			elapsed = now_ns() - start;
+		} while (elapsed < budget && (timeout < 0 ||
+				elapsed < timeout * 1000000ull));
+
+		if (timeout > 0) {
+			timeout -= elapsed / 1000000;
+			if (timeout <= 0)
+				return 0;
+		}
+	}
+
+	if (timeout != 0)
+		mon->busy_poll_stats.blocking_waits++;
+
+	return io_epoll_wait(mon->epollfd, events, MONITOR_MAX_SOURCES,
+			timeout);
+}
+
+/**
+ * Processes the events pending, then the deferred callbacks
+ * @param mon Monitor
+ * @param timeout Timeout in milliseconds, -1 for infinite
+ * @param run_idle true if the idle callbacks must be run when no event is
+ * pending
+ * @return negative errno value on error, the number of processed events
+ * sources otherwise
+ */
+static int process_events(struct io_mon *mon, int timeout, bool run_idle)
+{
+	int ret;
+	ssize_t n = 0;
+	bool idle;
+	struct epoll_event events[MONITOR_MAX_SOURCES];
+
+	/* deferred and idle callbacks mustn't wait for an event */
+	idle = run_idle && rs_dll_is_empty(&mon->deferred) &&
+			!rs_dll_is_empty(&mon->idle);
+	if (idle || !rs_dll_is_empty(&mon->deferred))
+		timeout = 0;
+
+	/* retrieve events */
+	n = wait_events(mon, events, timeout);
+	if (-1 == n)
+		return -errno;
+	if (n > 0)
+		update_interarrival(mon);
+
+	mon->processing = true;
+	if (idle && 0 == n)
+		run_deferred(&mon->idle);
+	ret = do_process_events_sets(mon, n, events);
+	run_deferred(&mon->deferred);
+	mon->processing = false;
+
+	/* those scheduled by deferred callbacks, for a parent monitor */
+	if (!rs_dll_is_empty(&mon->deferred))
+		wake_up(mon);
+
+	return ret < 0 ? ret : n;
+}
+
 /**
  * Source callback for integrating a libioutils monitor into another one
  * @param src Underlying source of the monitor
@@ -315,16 +578,57 @@ static int add_remove_sources(struct io_mon *mon,
 	return ret;
 }
 
+/**
+ * Creates the eventfd the tasks posted are notified through and registers it
+ * in the monitor's epoll set, but not in the sources list
+ * @param mon Monitor
+ * @return negative errno value on error, 0 otherwise
+ */
+static int init_post_source(struct io_mon *mon)
+{
+	int ret;
+	int fd;
+
+	fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+	if (-1 == fd)
+		return -errno;
+	ret = io_src_init(&mon->post_src, fd, IO_IN, post_cb);
+	if (0 != ret)
+		goto err;
+	mon->post_src.active = IO_IN;
+	ret = register_source(mon, &mon->post_src);
+	if (0 != ret)
+		goto err;
+
+	return 0;
+err:
+	close(fd);
+	mon->post_src.fd = -1;
+
+	return ret;
+}
+
 int io_mon_init(struct io_mon *mon)
 {
+	int ret;
+
 	if (NULL == mon)
 		return -EINVAL;
 
 	memset(mon, 0, sizeof(*mon));
+	rs_dll_init(&mon->deferred, NULL);
+	rs_dll_init(&mon->idle, NULL);
+	mon->post_src.fd = -1;
 	mon->epollfd = io_epoll_create1(EPOLL_CLOEXEC);
 	if (-1 == mon->epollfd)
 		return -errno;
 
+	ret = init_post_source(mon);
+	if (0 != ret) {
+		ut_file_fd_close(&mon->epollfd);
+		return ret;
+	}
+
 	return io_src_init(&mon->src, io_mon_get_fd(mon), IO_IN, mon_cb);
 }
 
@@ -409,6 +713,96 @@ int io_mon_remove_sources(struct io_mon *mon, ...)
 	return ret;
 }
 
+int io_mon_post(struct io_mon *mon, struct io_mon_task *task,
+		io_mon_task_cb *cb)
+{
+	struct io_mon_task *head;
+
+	if (NULL == mon || NULL == task || NULL == cb)
+		return -EINVAL;
+
+	task->cb = cb;
+	head = __atomic_load_n(&mon->posted, __ATOMIC_RELAXED);
+	do
+		task->next = head;
+	while (!__atomic_compare_exchange_n(&mon->posted, &head, task, true,
+			__ATOMIC_RELEASE, __ATOMIC_RELAXED));
+
+	/* otherwise, the monitor has yet to take the stack, wake up pending */
+	if (NULL != head)
+		return 0;
+
+	return wake_up(mon);
+}
+
+int io_mon_defer(struct io_mon *mon, struct io_mon_deferred *deferred,
+		io_mon_deferred_cb *cb)
+{
+	int ret;
+	bool was_empty;
+
+	if (NULL == mon)
+		return -EINVAL;
+
+	was_empty = rs_dll_is_empty(&mon->deferred);
+	ret = schedule_deferred(&mon->deferred, deferred, cb);
+	if (ret < 0)
+		return ret;
+
+	/* run at the end of the batch, or wake up the next processing */
+	return mon->processing || !was_empty ? 0 : wake_up(mon);
+}
+
+int io_mon_defer_idle(struct io_mon *mon, struct io_mon_deferred *deferred,
+		io_mon_deferred_cb *cb)
+{
+	if (NULL == mon)
+		return -EINVAL;
+
+	return schedule_deferred(&mon->idle, deferred, cb);
+}
+
+int io_mon_defer_cancel(struct io_mon *mon, struct io_mon_deferred *deferred)
+{
+	if (NULL == mon || NULL == deferred)
+		return -EINVAL;
+
+	if (deferred->list != &mon->deferred && deferred->list != &mon->idle)
+		return -ENOENT;
+	rs_dll_remove(deferred->list, &deferred->node);
+	deferred->list = NULL;
+
+	return 0;
+}
+
+int io_mon_set_busy_poll(struct io_mon *mon, enum io_mon_busy_poll busy_poll,
+		unsigned duration_us)
+{
+	if (NULL == mon || busy_poll > IO_MON_BUSY_POLL_ADAPTIVE)
+		return -EINVAL;
+
+	mon->busy_poll = busy_poll;
+	mon->busy_poll_ns = busy_poll == IO_MON_BUSY_POLL_OFF ? 0 :
+			duration_us * 1000ull;
+	/* optimistic start, spin until events prove to be rare */
+	mon->interarrival_ns = mon->busy_poll_ns / 2;
+	mon->last_events_ns = 0;
+	memset(&mon->busy_poll_stats, 0, sizeof(mon->busy_poll_stats));
+
+	return 0;
+}
+
+int io_mon_get_busy_poll_stats(struct io_mon *mon,
+		struct io_mon_busy_poll_stats *stats)
+{
+	if (NULL == mon || NULL == stats)
+		return -EINVAL;
+
+	*stats = mon->busy_poll_stats;
+
+	return 0;
+}
+
 void io_mon_dump_epoll_event(uint32_t events)
 {
 	fprintf(stderr, "epoll events :\n");
@@ -441,27 +835,18 @@ int io_mon_activate_in_source(struct io_mon *mon, struct io_src *src,
 
 int io_mon_poll(struct io_mon *mon, int timeout)
 {
-	int ret;
-	ssize_t n = 0;
-	struct epoll_event events[MONITOR_MAX_SOURCES];
-
 	if (NULL == mon)
 		return -EINVAL;
 
-	/* retrieve events */
-	n = io_epoll_wait(mon->epollfd, events, MONITOR_MAX_SOURCES, timeout);
-	if (-1 == n)
-		return -errno;
-
-	ret = do_process_events_sets(mon, n, events);
-
-	return ret < 0 ? ret : n;
-
+	return process_events(mon, timeout, true);
 }
 
 int io_mon_process_events(struct io_mon *mon)
 {
-	return io_mon_poll(mon, 0 /* don't block */);
+	if (NULL == mon)
+		return -EINVAL;
+
+	return process_events(mon, 0 /* don't block */, false);
 }
 
 int io_mon_clean(struct io_mon *mon)
@@ -475,12 +860,17 @@ int io_mon_clean(struct io_mon *mon)
 		src = to_src(mon->source.next);
 		remove_source(mon, src);
 	}
+	drop_deferred(&mon->deferred);
+	drop_deferred(&mon->idle);
 
 	if (-1 != mon->epollfd)
 		ut_file_fd_close(&mon->epollfd);
+	if (-1 != mon->post_src.fd)
+		io_src_close_fd(&mon->post_src);
 	memset(mon, 0, sizeof(*mon));
 	io_src_clean(&mon->src);
 	mon->epollfd = -1;
+	mon->post_src.fd = -1;
 
 	return 0;
 }
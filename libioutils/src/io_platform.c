@@ -9,6 +9,14 @@
  */
 #include <io_platform.h>
 
+#include <sys/syscall.h>
+#if defined(__has_include)
+#if __has_include(<sys/fanotify.h>)
+#include <sys/fanotify.h>
+#define IO_HAS_FANOTIFY_H
+#endif
+#endif
+
 #include <unistd.h>
 
 #include <errno.h>
@@ -93,3 +101,30 @@ int io_inotify_init1(int flags)
 	return inotify_init1(flags);
 #endif
 }
+
+int io_fanotify_init(unsigned int flags, unsigned int event_f_flags)
+{
+#ifdef IO_HAS_FANOTIFY_H
+	return fanotify_init(flags, event_f_flags);
+#elif defined(SYS_fanotify_init)
+	return syscall(SYS_fanotify_init, flags, event_f_flags);
+#else
+	errno = ENOSYS;
+	return -1;
+#endif
+}
+
+int io_fanotify_mark(int fanotify_fd, unsigned int flags, uint64_t mask,
+		int dirfd, const char *pathname)
+{
+#ifdef IO_HAS_FANOTIFY_H
+	return fanotify_mark(fanotify_fd, flags, mask, dirfd, pathname);
+#elif defined(SYS_fanotify_mark) && defined(__LP64__)
+	/* on 32 bits architectures, the mask is split in two registers */
+	return syscall(SYS_fanotify_mark, fanotify_fd, flags, mask, dirfd,
+			pathname);
+#else
+	errno = ENOSYS;
+	return -1;
+#endif
+}
@@ -0,0 +1,495 @@
+/**
+ * @file io_src_fanotify.c
+ * @brief Source for fanotify file descriptors. Allows to monitor events
+ * occurring on a whole filesystem or mount with only one mark.
+ *
+ * Marks are stored in a list, they are expected to be few. Each one records
+ * the identifier of the filesystem it is placed on, so that the events, which
+ * carry it in their file identifier records, can be dispatched to it. Hence
+ * only one mark is allowed per filesystem.
+ *
+ * @date 19 oct. 2026
+ * @author nicolas.carrier@parrot.com
+ * @copyright Copyright (C) 2026 Parrot S.A.
+ */
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif /* _GNU_SOURCE */
+#include <sys/vfs.h>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <limits.h>
+
+#include <ut_utils.h>
+#include <ut_string.h>
+#include <ut_file.h>
+
+#include "io_src_fanotify.h"
+#include "io_platform.h"
+
+/**
+ * @def IO_SRC_FANOTIFY_BUFFER_SIZE
+ * @brief size of the buffer the events are read into, a batch of events with
+ * their file identifiers
+ */
+#define IO_SRC_FANOTIFY_BUFFER_SIZE 0x10000
+
+/**
+ * @def IO_SRC_FANOTIFY_INIT_FLAGS
+ * @brief flags common to all the fanotify_init() attempts
+ */
+#define IO_SRC_FANOTIFY_INIT_FLAGS (FAN_CLASS_NOTIF | FAN_CLOEXEC | \
+		FAN_NONBLOCK | FAN_REPORT_FID)
+
+/**
+ * @def to_fan
+ * @brief retrieve a fanotify context knowing it's libioutils source
+ */
+#define to_fan(s) ut_container_of((s), struct io_src_fanotify, src)
+
+/**
+ * @def to_mark
+ * @brief retrieve a mark knowing it's node
+ */
+#define to_mark(n) ut_container_of((n), struct io_src_fanotify_mark, node)
+
+/**
+ * @brief Converts a mark type to the corresponding fanotify_mark() flag
+ * @param type Mark type
+ * @return fanotify_mark() flag
+ */
+static unsigned type_to_flag(enum io_src_fanotify_type type)
+{
+	switch (type) {
+	case IO_SRC_FANOTIFY_MOUNT:
+		return FAN_MARK_MOUNT;
+	case IO_SRC_FANOTIFY_FILESYSTEM:
+		return FAN_MARK_FILESYSTEM;
+	case IO_SRC_FANOTIFY_INODE:
+	default:
+		return 0;
+	}
+}
+
+/**
+ * @brief Tests if a mark is valid and ok to be installed
+ * @param mark Mark to test
+ * @return true if the mark is invalid
+ */
+static bool mark_is_invalid(struct io_src_fanotify_mark *mark)
+{
+	return mark == NULL || ut_string_is_invalid(mark->path) ||
+			mark->events == 0 || mark->cb == NULL ||
+			(mark->type != IO_SRC_FANOTIFY_INODE &&
+			mark->type != IO_SRC_FANOTIFY_MOUNT &&
+			mark->type != IO_SRC_FANOTIFY_FILESYSTEM);
+}
+
+/**
+ * @brief Finds an installed mark, knowing it's path and type
+ * @param fan Fanotify source
+ * @param path Path of the mark
+ * @param type Type of the mark
+ * @return mark if found, NULL otherwise
+ */
+static struct io_src_fanotify_mark *find_mark(struct io_src_fanotify *fan,
+		const char *path, enum io_src_fanotify_type type)
+{
+	struct rs_node *node;
+	struct io_src_fanotify_mark *m;
+
+	for (node = fan->marks.head; node != NULL; node = node->next) {
+		m = to_mark(node);
+		if (m->type == type && strcmp(m->path, path) == 0)
+			return m;
+	}
+
+	return NULL;
+}
+
+/**
+ * @brief Finds the mark installed on a filesystem, there is at most one
+ * @param fan Fanotify source
+ * @param fsid Identifier of the filesystem
+ * @return mark if found, NULL otherwise
+ */
+static struct io_src_fanotify_mark *find_mark_by_fsid(
+		struct io_src_fanotify *fan, const int fsid[2])
+{
+	struct rs_node *node;
+	struct io_src_fanotify_mark *m;
+
+	for (node = fan->marks.head; node != NULL; node = node->next) {
+		m = to_mark(node);
+		if (m->fsid[0] == fsid[0] && m->fsid[1] == fsid[1])
+			return m;
+	}
+
+	return NULL;
+}
+
+/**
+ * @brief Destroys an internal copy of a mark
+ * @param mark Mark to destroy
+ */
+static void mark_delete(struct io_src_fanotify_mark **mark)
+{
+	struct io_src_fanotify_mark *m;
+
+	if (mark == NULL || *mark == NULL)
+		return;
+	m = *mark;
+
+	ut_file_fd_close(&m->mount_fd);
+	ut_string_free((char **)&m->path);
+	memset(m, 0, sizeof(*m));
+	free(m);
+
+	*mark = NULL;
+}
+
+/**
+ * @brief Creates an internal copy of a mark, opening it's path
+ * @param src Mark to copy
+ * @param dst In output, the copy
+ * @return errno-compatible negative value on error, 0 on success
+ */
+static int mark_clone(struct io_src_fanotify_mark *src,
+		struct io_src_fanotify_mark **dst)
+{
+	int ret;
+	struct io_src_fanotify_mark *d;
+	struct statfs st;
+
+	d = calloc(1, sizeof(*d));
+	if (d == NULL)
+		return -errno;
+	*d = *src;
+	d->mount_fd = -1;
+	d->path = strdup(src->path);
+	if (d->path == NULL) {
+		ret = -errno;
+		goto err;
+	}
+	/* open_by_handle_at() rejects O_PATH file descriptors */
+	d->mount_fd = open(d->path, O_RDONLY | O_NONBLOCK | O_CLOEXEC);
+	if (d->mount_fd == -1) {
+		ret = -errno;
+		goto err;
+	}
+	if (fstatfs(d->mount_fd, &st) == -1) {
+		ret = -errno;
+		goto err;
+	}
+	memcpy(d->fsid, &st.f_fsid, sizeof(d->fsid));
+
+	*dst = d;
+
+	return 0;
+err:
+	mark_delete(&d);
+
+	return ret;
+}
+
+/**
+ * @brief Decodes the information records following an event's metadata
+ * @param meta Metadata of the event
+ * @param evt In output, the decoded event
+ * @return identifier of the filesystem of the event, NULL if none is reported
+ */
+static const __kernel_fsid_t *decode_info(
+		const struct fanotify_event_metadata *meta,
+		struct io_src_fanotify_event *evt)
+{
+	const char *p = (const char *)meta + meta->metadata_len;
+	const char *end = (const char *)meta + meta->event_len;
+	const struct fanotify_event_info_header *hdr;
+	const struct fanotify_event_info_fid *fid;
+	const struct file_handle *handle;
+	const __kernel_fsid_t *fsid = NULL;
+
+	for (; p + sizeof(*hdr) <= end; p += hdr->len) {
+		hdr = (const struct fanotify_event_info_header *)p;
+		if (hdr->len < sizeof(*hdr) || p + hdr->len > end)
+			break;
+		if (hdr->info_type != FAN_EVENT_INFO_TYPE_FID &&
+				hdr->info_type != FAN_EVENT_INFO_TYPE_DFID &&
+				hdr->info_type != FAN_EVENT_INFO_TYPE_DFID_NAME)
+			continue;
+
+		fid = (const struct fanotify_event_info_fid *)p;
+		fsid = &fid->fsid;
+		handle = (const struct file_handle *)fid->handle;
+		if (hdr->info_type == FAN_EVENT_INFO_TYPE_FID) {
+			evt->handle = handle;
+			continue;
+		}
+		evt->dir_handle = handle;
+		if (hdr->info_type == FAN_EVENT_INFO_TYPE_DFID_NAME)
+			evt->name = (const char *)(handle + 1) +
+					handle->handle_bytes;
+	}
+
+	return fsid;
+}
+
+/**
+ * @brief Notifies all the marks of an event which isn't attached to any
+ * filesystem, e.g. a queue overflow
+ * @param fan Fanotify source
+ * @param evt Event
+ */
+static void notify_all(struct io_src_fanotify *fan,
+		struct io_src_fanotify_event *evt)
+{
+	struct rs_node *node;
+	struct rs_node *next;
+	struct io_src_fanotify_mark *m;
+
+	for (node = fan->marks.head; node != NULL; node = next) {
+		next = node->next;
+		m = to_mark(node);
+		m->cb(fan, evt, m);
+	}
+}
+
+/**
+ * @brief Processes a batch of fanotify events, calling back the user
+ * @param fan Fanotify source
+ * @param len Number of bytes read in the buffer
+ */
+static void process_events(struct io_src_fanotify *fan, ssize_t len)
+{
+	const struct fanotify_event_metadata *meta;
+	struct io_src_fanotify_event evt;
+	struct io_src_fanotify_mark *mark;
+	const __kernel_fsid_t *fsid;
+
+	meta = (const struct fanotify_event_metadata *)fan->buf;
+	for (; FAN_EVENT_OK(meta, len); meta = FAN_EVENT_NEXT(meta, len)) {
+		if (meta->vers != FANOTIFY_METADATA_VERSION)
+			return;
+		/* not in file identifier mode, shouldn't happen */
+		if (meta->fd >= 0)
+			close(meta->fd);
+
+		memset(&evt, 0, sizeof(evt));
+		evt.mask = meta->mask;
+		evt.pid = meta->pid;
+		fsid = decode_info(meta, &evt);
+		if (fsid == NULL) {
+			notify_all(fan, &evt);
+			continue;
+		}
+		mark = find_mark_by_fsid(fan, fsid->val);
+		if (mark != NULL)
+			mark->cb(fan, &evt, mark);
+	}
+}
+
+/**
+ * @brief callback called when fanotify events are ready to be read
+ * @param src I/O source
+ */
+static void fanotify_cb(struct io_src *src)
+{
+	struct io_src_fanotify *fan = to_fan(src);
+	ssize_t sret;
+
+	sret = read(src->fd, fan->buf, IO_SRC_FANOTIFY_BUFFER_SIZE);
+	if (sret <= 0)
+		return;
+
+	process_events(fan, sret);
+}
+
+int io_src_fanotify_init(struct io_src_fanotify *fan)
+{
+	int fd;
+	int ret;
+
+	if (fan == NULL)
+		return -EINVAL;
+
+	memset(fan, 0, sizeof(*fan));
+
+	fd = io_fanotify_init(IO_SRC_FANOTIFY_INIT_FLAGS | FAN_REPORT_DFID_NAME,
+			O_RDONLY | O_CLOEXEC);
+	/* reporting both the file's and the directory's needs Linux 5.9 */
+	if (fd == -1 && errno == EINVAL)
+		fd = io_fanotify_init(IO_SRC_FANOTIFY_INIT_FLAGS,
+				O_RDONLY | O_CLOEXEC);
+	if (fd == -1)
+		return -errno;
+
+	ret = io_src_init(&fan->src, fd, IO_IN, fanotify_cb);
+	if (ret != 0) {
+		close(fd);
+		return ret;
+	}
+
+	ret = rs_dll_init(&fan->marks, NULL);
+	if (ret < 0)
+		goto err;
+
+	fan->buf = malloc(IO_SRC_FANOTIFY_BUFFER_SIZE);
+	if (fan->buf == NULL) {
+		ret = -errno;
+		goto err;
+	}
+
+	return 0;
+err:
+	io_src_fanotify_clean(fan);
+
+	return ret;
+}
+
+int io_src_fanotify_add_mark(struct io_src_fanotify *fan,
+		struct io_src_fanotify_mark *mark)
+{
+	int ret;
+	unsigned flags;
+	uint64_t removed;
+	struct io_src_fanotify_mark *m;
+
+	if (fan == NULL || mark_is_invalid(mark))
+		return -EINVAL;
+	flags = type_to_flag(mark->type);
+
+	m = find_mark(fan, mark->path, mark->type);
+	if (m != NULL) {
+		/* marks accumulate events, those not wanted anymore go away */
+		removed = m->events & ~mark->events;
+		if (removed != 0 && io_fanotify_mark(fan->src.fd,
+				FAN_MARK_REMOVE | flags, removed, AT_FDCWD,
+				m->path) == -1)
+			return -errno;
+		if (io_fanotify_mark(fan->src.fd, FAN_MARK_ADD | flags,
+				mark->events, AT_FDCWD, m->path) == -1)
+			return -errno;
+		m->events = mark->events;
+		m->cb = mark->cb;
+
+		return 0;
+	}
+
+	ret = mark_clone(mark, &m);
+	if (ret < 0)
+		return ret;
+	/* events carry no hint of the mark they matched */
+	if (find_mark_by_fsid(fan, m->fsid) != NULL) {
+		ret = -EBUSY;
+		goto err;
+	}
+	if (io_fanotify_mark(fan->src.fd, FAN_MARK_ADD | flags, m->events,
+			AT_FDCWD, m->path) == -1) {
+		ret = -errno;
+		goto err;
+	}
+	ret = rs_dll_enqueue(&fan->marks, &m->node);
+	if (ret < 0) {
+		io_fanotify_mark(fan->src.fd, FAN_MARK_REMOVE | flags,
+				m->events, AT_FDCWD, m->path);
+		goto err;
+	}
+
+	return 0;
+err:
+	mark_delete(&m);
+
+	return ret;
+}
+
+int io_src_fanotify_rm_mark(struct io_src_fanotify *fan,
+		struct io_src_fanotify_mark *mark)
+{
+	int ret = 0;
+	struct io_src_fanotify_mark *m;
+
+	if (fan == NULL || mark == NULL || ut_string_is_invalid(mark->path))
+		return -EINVAL;
+
+	m = find_mark(fan, mark->path, mark->type);
+	if (m == NULL)
+		return -ENOENT;
+	rs_dll_remove(&fan->marks, &m->node);
+
+	if (io_fanotify_mark(fan->src.fd, FAN_MARK_REMOVE |
+			type_to_flag(m->type), m->events, AT_FDCWD,
+			m->path) == -1)
+		ret = -errno;
+	mark_delete(&m);
+
+	return ret;
+}
+
+int io_src_fanotify_get_path(struct io_src_fanotify_mark *mark,
+		struct io_src_fanotify_event *evt, char *path, size_t size)
+{
+	int ret;
+	int fd;
+	ssize_t sret;
+	char proc[32];
+	const struct file_handle *handle;
+	bool with_name;
+
+	if (mark == NULL || evt == NULL || path == NULL || size == 0)
+		return -EINVAL;
+
+	with_name = evt->dir_handle != NULL && evt->name != NULL &&
+			strcmp(evt->name, ".") != 0;
+	handle = with_name || evt->handle == NULL ? evt->dir_handle :
+			evt->handle;
+	if (handle == NULL)
+		return -ENOENT;
+
+	/* open_by_handle_at() doesn't take a const handle */
+	fd = open_by_handle_at(mark->mount_fd, (struct file_handle *)handle,
+			O_PATH | O_CLOEXEC);
+	if (fd == -1)
+		return -errno;
+	snprintf(proc, sizeof(proc), "/proc/self/fd/%d", fd);
+	sret = readlink(proc, path, size);
+	ret = -errno;
+	close(fd);
+	if (sret < 0)
+		return ret;
+	if ((size_t)sret == size)
+		return -ENAMETOOLONG;
+	path[sret] = '\0';
+
+	if (!with_name)
+		return 0;
+	ret = snprintf(path + sret, size - sret, "%s%s",
+			strcmp(path, "/") == 0 ? "" : "/", evt->name);
+
+	return (size_t)ret >= size - sret ? -ENAMETOOLONG : 0;
+}
+
+void io_src_fanotify_clean(struct io_src_fanotify *fan)
+{
+	struct rs_node *node;
+	struct io_src_fanotify_mark *m;
+
+	if (fan == NULL)
+		return;
+
+	/* closing the fanotify fd removes the marks */
+	while ((node = rs_dll_pop(&fan->marks)) != NULL) {
+		m = to_mark(node);
+		mark_delete(&m);
+	}
+	free(fan->buf);
+	io_src_close_fd(&fan->src);
+	io_src_clean(&fan->src);
+
+	memset(fan, 0, sizeof(*fan));
+}
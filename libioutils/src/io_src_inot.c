@@ -4,7 +4,7 @@
  * occurring on files/directories: creation, modification, open...
  *
  * When registering a watch on a file (or directory), information concerning
- * this watch are stored in the 'watches' container, so that it can be given
+ * this watch are stored in the 'watches' hash tables, so that it can be given
  * back to the client when he is notified of an event.
  *
  * @date 21 juil. 2014
@@ -15,13 +15,15 @@
 #define _GNU_SOURCE
 #endif /* _GNU_SOURCE */
 #include <sys/inotify.h>
-#include <sys/ioctl.h>
 
-#include <search.h>
+#include <sys/stat.h>
 
+#include <fcntl.h>
+#include <dirent.h>
+
+#include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
-#include <assert.h>
 #include <errno.h>
 #include <limits.h>
 #include <inttypes.h>
@@ -41,6 +43,44 @@
  */
 #define IO_SRC_INVALID_WATCH_DESCRIPTOR -1
 
+/**
+ * @def IO_SRC_INOT_INITIAL_BUCKETS
+ * @brief initial number of buckets of the watches hash tables, must be a power
+ * of 2
+ */
+#define IO_SRC_INOT_INITIAL_BUCKETS 64
+
+/**
+ * @def IO_SRC_INOT_RECURSIVE_EVENTS
+ * @brief events needed internally, for keeping a recursive watch up to date
+ */
+#define IO_SRC_INOT_RECURSIVE_EVENTS (IN_CREATE | IN_MOVED_FROM | IN_MOVED_TO)
+
+/**
+ * @def IO_SRC_INOT_EVENT_MAX
+ * @brief maximum size of an inotify event
+ */
+#define IO_SRC_INOT_EVENT_MAX (sizeof(struct inotify_event) + NAME_MAX + 1)
+
+/**
+ * @def IO_SRC_INOT_BUFFER_MIN
+ * @brief initial size of the buffer the events are read into
+ */
+#define IO_SRC_INOT_BUFFER_MIN (16 * IO_SRC_INOT_EVENT_MAX)
+
+/**
+ * @def IO_SRC_INOT_BUFFER_MAX
+ * @brief size the buffer the events are read into, can't grow beyond
+ */
+#define IO_SRC_INOT_BUFFER_MAX (256 * IO_SRC_INOT_EVENT_MAX)
+
+/**
+ * @def IO_SRC_INOT_PENDING_MAX
+ * @brief number of distinct coalesced events, above which the window is closed
+ * early
+ */
+#define IO_SRC_INOT_PENDING_MAX 4096
+
 /**
  * @def to_inot
  * @brief retrieve an inotify context knowing it's libioutils source
@@ -48,105 +88,190 @@
 #define to_inot(s) ut_container_of((s), struct io_src_inot, src)
 
 /**
- * @def to_inot_watch
- * @brief retrieve an inotify watch descriptor knowing it's node
+ * @def tmr_to_inot
+ * @brief retrieve an inotify context knowing it's coalescing timer
  */
-#define to_inot_watch(n) rs_container_of((n), struct io_src_inot_watch, node)
+#define tmr_to_inot(t) ut_container_of((t), struct io_src_inot, tmr)
 
 /**
- * @brief Destroys a watch and frees it's allocated resources
- * @param watch Inotify watch descriptor structure to free
+ * @struct inot_pending
+ * @brief header of a coalesced event, stored in the pending buffer, followed
+ * by a copy of the inotify event
  */
-static void inot_watch_delete(struct io_src_inot_watch **watch)
-{
-	struct io_src_inot_watch *w;
+struct inot_pending {
+	/** hash of the wd, the mask and the name of the event */
+	uint32_t hash;
+	/** number of occurrences of the event */
+	unsigned count;
+};
 
-	if (watch == NULL || *watch == NULL)
-		return;
-	w = *watch;
+/**
+ * @struct inot_watch
+ * @brief internal representation of a watch, indexed by the two hash tables
+ */
+struct inot_watch {
+	/** public part, passed to the user callback */
+	struct io_src_inot_watch watch;
+	/** events passed to inotify_add_watch() */
+	uint32_t kernel_events;
+	/** true if the sub-directories are watched too */
+	bool recursive;
+	/** true if IN_CREATE events must be synthesized when scanned */
+	bool notify_scan;
+	/** next watch in the same bucket of the table indexed by wd */
+	struct inot_watch *next_by_wd;
+	/** next watch in the same bucket of the table indexed by path */
+	struct inot_watch *next_by_path;
+	/** next watch in the list of the directories to scan */
+	struct inot_watch *next_scan;
+	/** hash of the path */
+	uint32_t hash;
+	/** length of the path */
+	size_t len;
+	/** interned path, the path field of the public part points here */
+	char path[];
+};
 
-	/*
-	 * the path field is const to inform the user that in add_watch and
-	 * rm_watch, this field won't be modified. But when we allocate ourself
-	 * a watch (clone) we strdup() it and so we must free it
-	 */
-	ut_string_free((char **)&w->path);
-	memset(w, 0, sizeof(*w));
-	free(w);
+/**
+ * @brief Computes the length of a path, ignoring the trailing slashes
+ * @param path Path
+ * @return length of the path, without it's trailing slashes
+ */
+static size_t path_length(const char *path)
+{
+	size_t len = strlen(path);
 
-	*watch = NULL;
+	while (len > 1 && path[len - 1] == '/')
+		len--;
+
+	return len;
 }
 
 /**
- * @brief Callback for deleting a watch in a list
- * @param node node of the watch to delete
+ * @brief FNV-1a hash of a path
+ * @param path Path to hash, not necessarily null-terminated
+ * @param len Length of the path
+ * @return hash value
  */
-static void watch_remove(void *watch)
+static uint32_t hash_path(const char *path, size_t len)
 {
-	struct io_src_inot_watch *w = watch;
+	const unsigned char *p = (const unsigned char *)path;
+	uint32_t hash = 2166136261u;
+
+	while (len--) {
+		hash ^= *p++;
+		hash *= 16777619u;
+	}
 
-	inot_watch_delete(&w);
+	return hash;
 }
 
 /**
- * @brief Does nothing. Needed because tdestroy stupidly doesn't accept a NULL
- * pointer
- * @param node node of the watch to delete
+ * @brief Returns the link of a watch, in one of the hash tables
+ * @param w Watch
+ * @param by_wd true for the table indexed by wd, false for the one indexed by
+ * path
+ * @return address of the link
  */
-static void dummy_watch_remove(void *watch)
+static struct inot_watch **next_of(struct inot_watch *w, bool by_wd)
 {
-
+	return by_wd ? &w->next_by_wd : &w->next_by_path;
 }
 
 /**
- * @brief Compare watch descriptors by their path field.
- * @param w1 first watch descriptor to compare
- * @param w2 second watch descriptor to compare
- * @return an integer less than, equal to, or greater than zero if w1 is found,
- * respectively, to be less than, to match, or be greater than w2.
+ * @brief Returns the hash of a watch, in one of the hash tables. Watch
+ * descriptors are allocated sequentially by the kernel, hence they are their
+ * own hash
+ * @param w Watch
+ * @param by_wd true for the table indexed by wd, false for the one indexed by
+ * path
+ * @return hash of the watch
  */
-static int compare_watches_by_path(const void *w1, const void *w2)
+static uint32_t hash_of(struct inot_watch *w, bool by_wd)
 {
-	const struct io_src_inot_watch *watch1 = w1;
-	const struct io_src_inot_watch *watch2 = w2;
+	return by_wd ? (uint32_t)w->watch.wd : w->hash;
+}
 
-	return strcmp(watch1->path, watch2->path);
+static int table_init(struct io_src_inot_table *table)
+{
+	table->buckets = calloc(IO_SRC_INOT_INITIAL_BUCKETS,
+			sizeof(*table->buckets));
+	if (table->buckets == NULL)
+		return -errno;
+	table->mask = IO_SRC_INOT_INITIAL_BUCKETS - 1;
+	table->count = 0;
+
+	return 0;
 }
 
 /**
- * @brief Compare watch descriptors by their path wd.
- * @param w1 first watch descriptor to compare
- * @param w2 second watch descriptor to compare
- * @return an integer less than, equal to, or greater than zero if w1 is found,
- * respectively, to be less than, to match, or be greater than w2.
+ * @brief Doubles the number of buckets of a table and redistributes the
+ * watches
+ * @param table Hash table
+ * @param by_wd true for the table indexed by wd, false for the one indexed by
+ * path
+ * @return errno-compatible negative value on error, 0 otherwise
  */
-static int compare_watches_by_wd(const void *w1, const void *w2)
+static int table_grow(struct io_src_inot_table *table, bool by_wd)
 {
-	const struct io_src_inot_watch *watch1 = w1;
-	const struct io_src_inot_watch *watch2 = w2;
+	struct inot_watch **buckets;
+	struct inot_watch *w;
+	struct inot_watch *next;
+	size_t mask = (table->mask << 1) | 1;
+	size_t i;
+	size_t b;
+
+	buckets = calloc(mask + 1, sizeof(*buckets));
+	if (buckets == NULL)
+		return -errno;
+
+	for (i = 0; i <= table->mask; i++)
+		for (w = table->buckets[i]; w != NULL; w = next) {
+			next = *next_of(w, by_wd);
+			b = hash_of(w, by_wd) & mask;
+			*next_of(w, by_wd) = buckets[b];
+			buckets[b] = w;
+		}
+	free(table->buckets);
+	table->buckets = buckets;
+	table->mask = mask;
 
-	return watch1->wd - watch2->wd;
+	return 0;
 }
 
-/**
- * Lookup function for finding a watch descriptor in a container, with a given
- * matching criteria
- * @param watches watch descriptors container
- * @param watch structure holding the information used to match the watch
- * descriptor with
- * @param compare function of comparison for the matching criteria
- * @return watch descriptor if found, NULL otherwise
- */
-static struct io_src_inot_watch *find_watch(void *watches,
-		struct io_src_inot_watch *watch, comparison_fn_t compare)
+static int table_insert(struct io_src_inot_table *table, struct inot_watch *w,
+		bool by_wd)
 {
-	struct io_src_inot_watch **ret;
+	int ret;
+	size_t b;
 
-	ret = tfind(watch, watches, compare);
-	if (ret == NULL)
-		return NULL;
+	/* keeps the load factor under 1 */
+	if (table->count > table->mask) {
+		ret = table_grow(table, by_wd);
+		if (ret < 0)
+			return ret;
+	}
+
+	b = hash_of(w, by_wd) & table->mask;
+	*next_of(w, by_wd) = table->buckets[b];
+	table->buckets[b] = w;
+	table->count++;
+
+	return 0;
+}
 
-	return *ret;
+static void table_remove(struct io_src_inot_table *table, struct inot_watch *w,
+		bool by_wd)
+{
+	struct inot_watch **link;
+
+	link = table->buckets + (hash_of(w, by_wd) & table->mask);
+	for (; *link != NULL; link = next_of(*link, by_wd))
+		if (*link == w) {
+			*link = *next_of(w, by_wd);
+			table->count--;
+			return;
+		}
 }
 
 /**
@@ -156,84 +281,161 @@ static struct io_src_inot_watch *find_watch(void *watches,
  * @param wd inotify watch descriptor index
  * @return watch descriptor if found, NULL otherwise
  */
-static struct io_src_inot_watch *find_watch_by_wd(struct io_src_inot *inot,
-		int wd)
+static struct inot_watch *find_watch_by_wd(struct io_src_inot *inot, int wd)
 {
-	struct io_src_inot_watch w = { .wd = wd };
+	struct io_src_inot_table *table = &inot->watches_by_wd;
+	struct inot_watch *w;
+
+	w = table->buckets[(uint32_t)wd & table->mask];
+	while (w != NULL && w->watch.wd != wd)
+		w = w->next_by_wd;
 
-	return find_watch(&inot->watches_by_wd, &w, compare_watches_by_wd);
+	return w;
 }
 
 /**
  * @brief Finds a watch descriptor structure, knowing the path it monitors
  * @param inot inotify source
- * @param path Path of the file or directory being monitored
+ * @param path Path of the file or directory being monitored, not necessarily
+ * null-terminated
+ * @param len Length of the path, without it's trailing slashes
  * @return watch descriptor if found, NULL otherwise
  */
-static struct io_src_inot_watch *find_watch_by_path(struct io_src_inot *inot,
-		const char *path)
+static struct inot_watch *find_watch_by_path(struct io_src_inot *inot,
+		const char *path, size_t len)
 {
-	struct io_src_inot_watch w = { .path = path };
+	struct io_src_inot_table *table = &inot->watches_by_path;
+	struct inot_watch *w;
+	uint32_t hash = hash_path(path, len);
+
+	w = table->buckets[hash & table->mask];
+	while (w != NULL && (w->hash != hash || w->len != len ||
+			memcmp(w->path, path, len) != 0))
+		w = w->next_by_path;
 
-	return find_watch(&inot->watches_by_path, &w, compare_watches_by_path);
+	return w;
 }
 
 /**
  * @brief Store a watch descriptor in the watch descriptors set
  * @param inot inotify source
- * @param watch watch descriptor to store
+ * @param w watch descriptor to store
  * @return errno-compatible negative value on error, 0 otherwise
  */
-static int store_watch(struct io_src_inot *inot,
-		struct io_src_inot_watch *watch)
+static int store_watch(struct io_src_inot *inot, struct inot_watch *w)
 {
-	void *val;
+	int ret;
 
-	val = tsearch(watch, &inot->watches_by_path, compare_watches_by_path);
-	if (val == NULL)
-		return -ENOMEM;
-	val = tsearch(watch, &inot->watches_by_wd, compare_watches_by_wd);
-	if (val == NULL) {
-		tdelete(watch, &inot->watches_by_path, compare_watches_by_path);
-		return -ENOMEM;
+	ret = table_insert(&inot->watches_by_path, w, false);
+	if (ret < 0)
+		return ret;
+	ret = table_insert(&inot->watches_by_wd, w, true);
+	if (ret < 0) {
+		table_remove(&inot->watches_by_path, w, false);
+		return ret;
 	}
 
 	return 0;
 }
 
 /**
- * @brief Removes a watch descriptor, knowing the path being monitored
- * @param inot inotify source
- * @param path Path of the watch descriptor to remove
- * @return watch descriptor removed
+ * @brief Allocates a watch, in one chunk with it's interned path
+ * @param src Watch description, the cb and events fields are copied
+ * @param path Path of the watch, not necessarily null-terminated
+ * @param len Length of the path, without it's trailing slashes
+ * @return watch allocated, NULL on error, with errno set
  */
-static struct io_src_inot_watch *remove_watch(struct io_src_inot *inot,
-		const char *path)
+static struct inot_watch *watch_new(const struct io_src_inot_watch *src,
+		const char *path, size_t len)
 {
-	struct io_src_inot_watch *w = find_watch_by_path(inot, path);
+	struct inot_watch *w;
 
+	w = calloc(1, sizeof(*w) + len + 1);
 	if (w == NULL)
 		return NULL;
-
-	tdelete(w, &inot->watches_by_path, compare_watches_by_path);
-	tdelete(w, &inot->watches_by_wd, compare_watches_by_wd);
+	memcpy(w->path, path, len);
+	w->len = len;
+	w->hash = hash_path(path, len);
+	w->watch.wd = IO_SRC_INVALID_WATCH_DESCRIPTOR;
+	w->watch.path = w->path;
+	w->watch.events = src->events;
+	w->watch.cb = src->cb;
 
 	return w;
 }
 
 /**
- * @brief Initializes the watch descriptors set
+ * @brief Unregisters a watch, removes it from the watch descriptors set and
+ * destroys it
  * @param inot inotify source
+ * @param w Watch to drop
+ * @param rm true if the inotify watch must be removed, false if the kernel has
+ * already done it
  * @return errno-compatible negative value on error, 0 otherwise
  */
-static int init_watches(struct io_src_inot *inot)
+static int drop_watch(struct io_src_inot *inot, struct inot_watch *w, bool rm)
 {
-	inot->watches_by_path = inot->watches_by_wd = NULL;
+	int ret = 0;
+	struct inot_watch **link;
+
+	table_remove(&inot->watches_by_path, w, false);
+	table_remove(&inot->watches_by_wd, w, true);
+	for (link = &inot->to_scan; *link != NULL; link = &(*link)->next_scan)
+		if (*link == w) {
+			*link = w->next_scan;
+			break;
+		}
+
+	if (rm && inotify_rm_watch(inot->src.fd, w->watch.wd) < 0)
+		ret = -errno;
+	free(w);
 
-	return 0;
+	return ret;
 }
 
+/**
+ * @brief Drops the watches of all the sub-directories of a directory
+ * @param inot inotify source
+ * @param path Path of the directory, not necessarily null-terminated
+ * @param len Length of the path, without it's trailing slashes
+ */
+static void drop_tree(struct io_src_inot *inot, const char *path, size_t len)
+{
+	struct io_src_inot_table *table = &inot->watches_by_path;
+	struct inot_watch *w;
+	struct inot_watch *next;
+	size_t i;
+
+	/* the root directory's path already ends with a slash */
+	if (len == 1 && path[0] == '/')
+		len = 0;
+
+	/* the tables never shrink, hence dropping doesn't reorganize them */
+	for (i = 0; i <= table->mask; i++)
+		for (w = table->buckets[i]; w != NULL; w = next) {
+			next = w->next_by_path;
+			if (w->len > len + 1 && w->path[len] == '/' &&
+					memcmp(w->path, path, len) == 0)
+				drop_watch(inot, w, true);
+		}
+}
 
+/**
+ * @brief Initializes the watch descriptors set
+ * @param inot inotify source
+ * @return errno-compatible negative value on error, 0 otherwise
+ */
+static int init_watches(struct io_src_inot *inot)
+{
+	int ret;
+
+	inot->to_scan = NULL;
+	ret = table_init(&inot->watches_by_path);
+	if (ret < 0)
+		return ret;
+
+	return table_init(&inot->watches_by_wd);
+}
 
 /**
  * @brief Cleans up the watch descriptors set and destroys all the watch
@@ -242,10 +444,579 @@ static int init_watches(struct io_src_inot *inot)
  */
 static void clean_watches(struct io_src_inot *inot)
 {
-	tdestroy(inot->watches_by_path, dummy_watch_remove);
-	inot->watches_by_path = NULL;
-	tdestroy(inot->watches_by_wd, watch_remove);
-	inot->watches_by_wd = NULL;
+	struct io_src_inot_table *table = &inot->watches_by_path;
+	struct inot_watch *w;
+	struct inot_watch *next;
+	size_t i;
+
+	if (table->buckets != NULL)
+		for (i = 0; i <= table->mask; i++)
+			for (w = table->buckets[i]; w != NULL; w = next) {
+				next = w->next_by_path;
+				free(w);
+			}
+	free(inot->watches_by_path.buckets);
+	free(inot->watches_by_wd.buckets);
+	memset(&inot->watches_by_path, 0, sizeof(inot->watches_by_path));
+	memset(&inot->watches_by_wd, 0, sizeof(inot->watches_by_wd));
+	inot->to_scan = NULL;
+}
+
+/**
+ * @brief Installs a watch, or updates it if it's path is already watched
+ * @param inot inotify source
+ * @param watch Description of the watch
+ * @param path Path to watch, not necessarily null-terminated
+ * @param len Length of the path, without it's trailing slashes
+ * @param flags Additional inotify flags, for a new watch
+ * @param recursive true if the sub-directories must be watched too
+ * @param out In output, the watch installed, if it is a new one, NULL
+ * otherwise, can be NULL
+ * @return errno-compatible negative value on error, 0 on success. -EEXIST if
+ * the file is already watched, but through another path
+ */
+static int add_watch(struct io_src_inot *inot,
+		const struct io_src_inot_watch *watch, const char *path,
+		size_t len, uint32_t flags, bool recursive,
+		struct inot_watch **out)
+{
+	int ret;
+	struct inot_watch *w;
+	uint32_t events;
+
+	if (out != NULL)
+		*out = NULL;
+	events = watch->events;
+	if (recursive)
+		events |= IO_SRC_INOT_RECURSIVE_EVENTS;
+
+	/*
+	 * mustn't create a new watch if already registered, just update:
+	 * guarantees uniqueness
+	 */
+	w = find_watch_by_path(inot, path, len);
+	if (w != NULL) {
+		/* file is already watched, update the watch information */
+		recursive = recursive || w->recursive;
+		events = watch->events;
+		if (recursive)
+			events |= IO_SRC_INOT_RECURSIVE_EVENTS;
+		ret = inotify_add_watch(inot->src.fd, w->path, events);
+		if (ret < 0) {
+			/* the watch is destroyed, we must unregister it */
+			ret = -errno;
+			drop_watch(inot, w, true);
+			return ret;
+		}
+		w->watch.events = watch->events;
+		w->watch.cb = watch->cb;
+		w->kernel_events = events;
+		w->recursive = recursive;
+
+		return 0;
+	}
+
+	/* not watch found for the file, build one */
+	w = watch_new(watch, path, len);
+	if (w == NULL)
+		return -errno;
+	w->kernel_events = events;
+	w->recursive = recursive;
+
+	/*
+	 * IN_MASK_ADD, so that if the inode is already watched through another
+	 * path, the events it's watch is interested in aren't lost
+	 */
+	ret = inotify_add_watch(inot->src.fd, w->path,
+			events | flags | IN_MASK_ADD);
+	if (ret < 0) {
+		ret = -errno;
+		goto err;
+	}
+	if (find_watch_by_wd(inot, ret) != NULL) {
+		ret = -EEXIST;
+		goto err;
+	}
+	w->watch.wd = ret;
+	ret = store_watch(inot, w);
+	if (ret < 0) {
+		inotify_rm_watch(inot->src.fd, w->watch.wd);
+		goto err;
+	}
+	if (out != NULL)
+		*out = w;
+
+	return 0;
+err:
+	free(w);
+
+	return ret;
+}
+
+/**
+ * @brief Queues the directory of a recursive watch for being scanned, if it
+ * isn't already
+ * @param inot inotify source
+ * @param w Watch of the directory
+ * @param notify true if IN_CREATE events must be synthesized when scanned
+ */
+static void queue_scan(struct io_src_inot *inot, struct inot_watch *w,
+		bool notify)
+{
+	struct inot_watch *cur;
+
+	for (cur = inot->to_scan; cur != NULL; cur = cur->next_scan)
+		if (cur == w)
+			return;
+
+	w->notify_scan = notify;
+	w->next_scan = inot->to_scan;
+	inot->to_scan = w;
+}
+
+/**
+ * @brief Returns the inotify event stored in a coalesced event
+ * @param rec Coalesced event
+ * @return inotify event
+ */
+static struct inotify_event *pending_event(struct inot_pending *rec)
+{
+	return (struct inotify_event *)(rec + 1);
+}
+
+/**
+ * @brief Computes the size of a coalesced event in the pending buffer
+ * @param evt inotify event
+ * @return size, rounded up for the next one to be aligned
+ */
+static size_t pending_record_size(const struct inotify_event *evt)
+{
+	size_t size = sizeof(struct inot_pending) + sizeof(*evt) + evt->len;
+
+	return (size + sizeof(uint64_t) - 1) & ~(sizeof(uint64_t) - 1);
+}
+
+/**
+ * @brief FNV-1a hash of the fields which identify an event, when coalescing
+ * @param evt inotify event
+ * @return hash value
+ */
+static uint32_t hash_event(const struct inotify_event *evt)
+{
+	uint32_t hash = 2166136261u;
+	uint32_t fields[] = {evt->wd, evt->mask, evt->len};
+	const unsigned char *p = (const unsigned char *)fields;
+	size_t i;
+
+	for (i = 0; i < sizeof(fields); i++) {
+		hash ^= p[i];
+		hash *= 16777619u;
+	}
+
+	return hash ^ hash_path(evt->name, evt->len);
+}
+
+/**
+ * @brief Indexes a coalesced event
+ * @param inot inotify source
+ * @param offset Offset of the coalesced event in the pending buffer
+ */
+static void index_pending(struct io_src_inot *inot, size_t offset)
+{
+	struct inot_pending *rec = (struct inot_pending *)(inot->pending +
+			offset);
+	size_t i = rec->hash & inot->index_mask;
+
+	while (inot->index[i] != 0)
+		i = (i + 1) & inot->index_mask;
+	inot->index[i] = offset + 1;
+}
+
+/**
+ * @brief Makes room for one more coalesced event
+ * @param inot inotify source
+ * @param size Size of the coalesced event to add
+ * @return errno-compatible negative value on error, 0 on success
+ */
+static int reserve_pending(struct io_src_inot *inot, size_t size)
+{
+	char *pending;
+	uint32_t *index;
+	size_t pending_size;
+	size_t index_size;
+	size_t offset;
+
+	if (inot->pending_len + size > inot->pending_size) {
+		pending_size = inot->pending_size == 0 ?
+				IO_SRC_INOT_BUFFER_MIN : 2 * inot->pending_size;
+		if (pending_size < inot->pending_len + size)
+			pending_size = inot->pending_len + size;
+		pending = realloc(inot->pending, pending_size);
+		if (pending == NULL)
+			return -errno;
+		inot->pending = pending;
+		inot->pending_size = pending_size;
+	}
+
+	/* keeps the load factor of the index under 1/2 */
+	if (2 * (inot->nb_pending + 1) <= inot->index_mask + 1)
+		return 0;
+	index_size = inot->index == NULL ? 64 : 2 * (inot->index_mask + 1);
+	index = calloc(index_size, sizeof(*index));
+	if (index == NULL)
+		return -errno;
+	free(inot->index);
+	inot->index = index;
+	inot->index_mask = index_size - 1;
+	for (offset = 0; offset < inot->pending_len;
+			offset += pending_record_size(pending_event(
+			(struct inot_pending *)(inot->pending + offset))))
+		index_pending(inot, offset);
+
+	return 0;
+}
+
+/**
+ * @brief Notifies the coalesced events pending, in the order of their first
+ * occurrence and closes the coalescing window
+ * @param inot inotify source
+ */
+static void flush_pending(struct io_src_inot *inot)
+{
+	char *pending = inot->pending;
+	size_t pending_size = inot->pending_size;
+	size_t len = inot->pending_len;
+	size_t offset;
+	struct inot_pending *rec;
+	struct inotify_event *evt;
+	struct inot_watch *w;
+
+	if (inot->nb_pending == 0)
+		return;
+
+	if (inot->mon != NULL)
+		io_src_tmr_set(&inot->tmr, IO_SRC_TMR_DISARM);
+	memset(inot->index, 0, (inot->index_mask + 1) * sizeof(*inot->index));
+	/*
+	 * the pending buffer is detached, because the callbacks can produce new
+	 * events to coalesce, for example by adding a recursive watch
+	 */
+	inot->pending = NULL;
+	inot->pending_size = inot->pending_len = inot->nb_pending = 0;
+
+	for (offset = 0; offset < len; offset += pending_record_size(evt)) {
+		rec = (struct inot_pending *)(pending + offset);
+		evt = pending_event(rec);
+		/* the watch may have been removed in the meantime */
+		w = find_watch_by_wd(inot, evt->wd);
+		if (w == NULL)
+			continue;
+		inot->count = rec->count;
+		w->watch.cb(inot, evt, &w->watch);
+		inot->count = 1;
+	}
+
+	/* reuse the buffer, if the callbacks haven't needed a new one */
+	if (inot->pending == NULL) {
+		inot->pending = pending;
+		inot->pending_size = pending_size;
+	} else {
+		free(pending);
+	}
+}
+
+/**
+ * @brief Stores an event in the pending buffer, or increments it's count if
+ * it already occurred during the coalescing window
+ * @param inot inotify source
+ * @param evt inotify event
+ * @return errno-compatible negative value on error, 0 on success
+ */
+static int coalesce(struct io_src_inot *inot, const struct inotify_event *evt)
+{
+	int ret;
+	uint32_t hash = hash_event(evt);
+	size_t i;
+	size_t size;
+	struct inot_pending *rec;
+	struct inotify_event *cur;
+
+	for (i = hash & inot->index_mask; inot->index != NULL &&
+			inot->index[i] != 0; i = (i + 1) & inot->index_mask) {
+		rec = (struct inot_pending *)(inot->pending +
+				inot->index[i] - 1);
+		cur = pending_event(rec);
+		if (rec->hash == hash && cur->wd == evt->wd &&
+				cur->mask == evt->mask &&
+				cur->len == evt->len &&
+				memcmp(cur->name, evt->name, evt->len) == 0) {
+			rec->count++;
+			return 0;
+		}
+	}
+
+	if (inot->nb_pending >= IO_SRC_INOT_PENDING_MAX)
+		flush_pending(inot);
+	size = pending_record_size(evt);
+	ret = reserve_pending(inot, size);
+	if (ret < 0)
+		return ret;
+
+	rec = (struct inot_pending *)(inot->pending + inot->pending_len);
+	rec->hash = hash;
+	rec->count = 1;
+	memcpy(pending_event(rec), evt, sizeof(*evt) + evt->len);
+	index_pending(inot, inot->pending_len);
+	inot->pending_len += size;
+	/* the window opens with it's first event */
+	if (inot->nb_pending++ == 0)
+		io_src_tmr_set(&inot->tmr, inot->window);
+
+	return 0;
+}
+
+/**
+ * @brief Notifies an event to the user, or coalesces it, if enabled
+ * @param inot inotify source
+ * @param w Watch the event concerns
+ * @param evt inotify event
+ */
+static void notify(struct io_src_inot *inot, struct inot_watch *w,
+		struct inotify_event *evt)
+{
+	int wd = w->watch.wd;
+
+	if (inot->window > 0 && (evt->mask & inot->coalesced_events) &&
+			coalesce(inot, evt) == 0)
+		return;
+
+	/* keeps the events in order */
+	if (inot->nb_pending != 0) {
+		flush_pending(inot);
+		w = find_watch_by_wd(inot, wd);
+		if (w == NULL)
+			return;
+	}
+
+	w->watch.cb(inot, evt, &w->watch);
+}
+
+/**
+ * @brief Closes the coalescing window, when the timer expires
+ * @param tmr Coalescing timer
+ * @param nbexpired Number of expirations of the timer
+ */
+static void tmr_cb(struct io_src_tmr *tmr, uint64_t *nbexpired)
+{
+	flush_pending(tmr_to_inot(tmr));
+}
+
+/**
+ * @brief Checks whether the coalescing timer is still registered in it's
+ * monitor, which isn't the case anymore if the monitor has been cleaned before
+ * the source, the monitor mustn't be accessed then
+ * @param inot inotify source
+ * @return true if the timer is registered
+ */
+static bool tmr_is_registered(struct io_src_inot *inot)
+{
+	/* the sources of a monitor are chained after it's list head */
+	return inot->tmr.src.node.prev != NULL;
+}
+
+/**
+ * @brief Disables the coalescing, unregisters and destroys it's timer
+ * @param inot inotify source
+ */
+static void disable_coalescing(struct io_src_inot *inot)
+{
+	if (inot->mon != NULL) {
+		if (tmr_is_registered(inot))
+			io_mon_remove_source(inot->mon, &inot->tmr.src);
+		io_src_tmr_clean(&inot->tmr);
+	}
+	inot->mon = NULL;
+	inot->window = 0;
+	inot->coalesced_events = 0;
+}
+
+/**
+ * @brief Watches a sub-directory of a recursive watch and queues it for being
+ * scanned
+ * @param inot inotify source
+ * @param parent Watch of the parent directory
+ * @param name Name of the sub-directory
+ * @param notify true if IN_CREATE events must be synthesized when scanned
+ * @return errno-compatible negative value on error, 0 on success
+ */
+static int add_child(struct io_src_inot *inot, struct inot_watch *parent,
+		const char *name, bool notify)
+{
+	int ret;
+	char path[PATH_MAX];
+	struct inot_watch *w;
+
+	ret = snprintf(path, PATH_MAX, "%s/%s",
+			parent->len == 1 ? "" : parent->path, name);
+	if (ret >= PATH_MAX)
+		return -ENAMETOOLONG;
+
+	ret = add_watch(inot, &parent->watch, path, ret,
+			IN_ONLYDIR | IN_DONT_FOLLOW, true, &w);
+	/* the directory vanished in between, or is already watched */
+	if (ret == -ENOENT || ret == -ENOTDIR || ret == -EEXIST)
+		return 0;
+	if (ret < 0)
+		return ret;
+
+	if (w != NULL)
+		queue_scan(inot, w, notify);
+
+	return 0;
+}
+
+/**
+ * @brief Tells whether a directory entry is a directory, without following
+ * symbolic links
+ * @param dir Directory containing the entry
+ * @param entry Directory entry
+ * @return true if the entry is a directory
+ */
+static bool entry_is_dir(DIR *dir, struct dirent *entry)
+{
+	struct stat st;
+
+	if (entry->d_type != DT_UNKNOWN)
+		return entry->d_type == DT_DIR;
+	if (fstatat(dirfd(dir), entry->d_name, &st, AT_SYMLINK_NOFOLLOW) < 0)
+		return false;
+
+	return S_ISDIR(st.st_mode);
+}
+
+/**
+ * @brief Synthesizes an IN_CREATE event, for an entry found when scanning a
+ * directory
+ * @param inot inotify source
+ * @param w Watch of the directory scanned
+ * @param name Name of the entry
+ * @param is_dir true if the entry is a directory
+ */
+static void notify_entry(struct io_src_inot *inot, struct inot_watch *w,
+		const char *name, bool is_dir)
+{
+	union {
+		struct inotify_event evt;
+		char buf[sizeof(struct inotify_event) + NAME_MAX + 1];
+	} u;
+	size_t len = strlen(name) + 1;
+
+	memset(&u.evt, 0, sizeof(u.evt));
+	u.evt.wd = w->watch.wd;
+	u.evt.mask = IN_CREATE | (is_dir ? IN_ISDIR : 0);
+	u.evt.len = len;
+	memcpy(u.evt.name, name, len);
+
+	notify(inot, w, &u.evt);
+}
+
+/**
+ * @brief Scans a directory of a recursive watch, watching it's
+ * sub-directories. Catches those which were created before the watch of the
+ * directory was installed
+ * @param inot inotify source
+ * @param w Watch of the directory to scan
+ * @return errno-compatible negative value on error, 0 on success
+ */
+static int scan_dir(struct io_src_inot *inot, struct inot_watch *w)
+{
+	int ret = 0;
+	int err;
+	int wd = w->watch.wd;
+	bool notify = w->notify_scan && (w->watch.events & IN_CREATE);
+	bool is_dir;
+	DIR *dir;
+	struct dirent *entry;
+
+	dir = opendir(w->path);
+	if (dir == NULL)
+		/* the directory may have vanished in between */
+		return errno == ENOENT || errno == ENOTDIR ? 0 : -errno;
+
+	while ((entry = readdir(dir)) != NULL) {
+		if (strcmp(entry->d_name, ".") == 0 ||
+				strcmp(entry->d_name, "..") == 0)
+			continue;
+		is_dir = entry_is_dir(dir, entry);
+		if (is_dir) {
+			err = add_child(inot, w, entry->d_name, notify);
+			if (err < 0 && ret == 0)
+				ret = err;
+		}
+		if (notify) {
+			notify_entry(inot, w, entry->d_name, is_dir);
+			/* the callback may have removed the watch */
+			if (find_watch_by_wd(inot, wd) != w)
+				break;
+		}
+	}
+	closedir(dir);
+
+	return ret;
+}
+
+/**
+ * @brief Scans all the directories queued for being scanned, until none is
+ * left
+ * @param inot inotify source
+ * @return errno-compatible negative value on error, the first one encountered,
+ * 0 on success
+ */
+static int scan_pending(struct io_src_inot *inot)
+{
+	int ret = 0;
+	int err;
+	struct inot_watch *w;
+
+	while (inot->to_scan != NULL) {
+		w = inot->to_scan;
+		inot->to_scan = w->next_scan;
+		w->next_scan = NULL;
+		err = scan_dir(inot, w);
+		if (err < 0 && ret == 0)
+			ret = err;
+	}
+
+	return ret;
+}
+
+/**
+ * @brief Keeps a recursive watch up to date with the sub-directories created,
+ * or moved in or out of the tree
+ * @param inot inotify source
+ * @param w Watch of the directory the event occurred in
+ * @param event Event concerning a sub-directory
+ */
+static void update_tree(struct io_src_inot *inot, struct inot_watch *w,
+		struct inotify_event *event)
+{
+	char path[PATH_MAX];
+	int ret;
+
+	if (event->mask & (IN_CREATE | IN_MOVED_TO)) {
+		add_child(inot, w, event->name, event->mask & IN_CREATE);
+		scan_pending(inot);
+	} else if (event->mask & IN_MOVED_FROM) {
+		ret = snprintf(path, PATH_MAX, "%s/%s",
+				w->len == 1 ? "" : w->path, event->name);
+		if (ret >= PATH_MAX)
+			return;
+		w = find_watch_by_path(inot, path, ret);
+		if (w == NULL)
+			return;
+		drop_tree(inot, w->path, w->len);
+		drop_watch(inot, w, true);
+	}
 }
 
 /**
@@ -259,35 +1030,45 @@ static int process_events(struct io_src_inot *inot, char *buf, size_t bytes)
 {
 	char *p, *upper_bound;
 	struct inotify_event *event;
-	struct io_src_inot_watch *watch;
+	struct inot_watch *w;
+	int wd;
 
 	p = buf;
 	upper_bound = buf + bytes;
-	while (p < upper_bound) {
+	for (; p < upper_bound; p += sizeof(struct inotify_event) + event->len) {
 		/* inotify events can't be partial, according to the kernel */
 		event = (struct inotify_event *)p;
 
-		watch = find_watch_by_wd(inot, event->wd);
 		/*
-		 * if we receive an ignored event and we couldn't find the
-		 * watch, it must be because the caller has removed the watch
-		 * explicitely by calling io_src_inot_rm_watch()
+		 * if we receive an event and we couldn't find the watch, it
+		 * must be because the caller has removed the watch explicitely,
+		 * by calling io_src_inot_rm_watch(), while the event was queued
 		 */
-		if (watch == NULL && event->mask == IN_IGNORED)
-			return 0;
-		if (watch == NULL && event->mask != IN_IGNORED)
-			return -ENOENT;
+		w = find_watch_by_wd(inot, event->wd);
+		if (w == NULL)
+			continue;
 
 		/*
 		 * IN_IGNORED are not passed to the user, but they are used
 		 * internally to remove the corresponding watch
 		 */
-		if (event->mask == IN_IGNORED)
-			io_src_inot_rm_watch(inot, watch);
-		else
-			watch->cb(inot, event, watch);
-
-		p += sizeof(struct inotify_event) + event->len;
+		if (event->mask & IN_IGNORED) {
+			drop_watch(inot, w, false);
+			continue;
+		}
+
+		/* don't notify the events added for the recursive watches */
+		wd = w->watch.wd;
+		if (!(event->mask & IN_ALL_EVENTS) ||
+				(event->mask & w->watch.events))
+			notify(inot, w, event);
+
+		/* the callback may have removed the watch */
+		if (!(event->mask & IN_ISDIR) || event->len == 0)
+			continue;
+		w = find_watch_by_wd(inot, wd);
+		if (w != NULL && w->recursive)
+			update_tree(inot, w, event);
 	}
 
 	return 0;
@@ -299,70 +1080,31 @@ static int process_events(struct io_src_inot *inot, char *buf, size_t bytes)
  */
 static void inot_cb(struct io_src *src)
 {
+	struct io_src_inot *inot = to_inot(src);
 	ssize_t sret;
-	int ret;
-	int toread;
-	char __attribute__((cleanup(ut_string_free)))*buf = NULL;
-	size_t buf_size;
+	bool full;
+	char *buf;
 
-	ret = ioctl(src->fd, FIONREAD, &toread);
-	if (ret < 0 || toread == 0)
-		return;
 	/*
-	 * according to fs/notify/inotify/inotify_user.c:inotify_ioctl(),
-	 * the value returned by FIONREAD is positive, hence the cast is safe.
+	 * the buffer can always hold at least one event, so the read can't fail
+	 * with EINVAL, if more events are pending, the source will be notified
+	 * again
 	 */
-	assert(toread >= 0);
-	buf_size = (size_t)toread;
-
-	buf = calloc(1, buf_size);
-	if (buf == NULL)
-		return;
-
-	sret = read(src->fd, buf, buf_size);
-	if (sret < 0)
+	sret = read(src->fd, inot->buf, inot->buf_size);
+	if (sret <= 0)
 		return;
+	full = (size_t)sret > inot->buf_size - IO_SRC_INOT_EVENT_MAX;
 
-	ret = process_events(to_inot(src), buf, buf_size);
-}
-
-/**
- * @brief Clones a watch descriptor structure
- *
- * Copies all the fields except wd (which has no meaning before the call to
- * inotify_add_watch() and creates a private copy of the path field
- * @param src Source watch to clone
- * @param dst Output parameter, clone of src
- * @return errno-compatible negative value on error, 0 on success
- */
-static int inot_watch_clone(struct io_src_inot_watch *src,
-		struct io_src_inot_watch **dst)
-{
-	int ret;
-	struct io_src_inot_watch *d;
-
-	if (src == NULL || dst == NULL)
-		return -EINVAL;
-
-	d = calloc(1, sizeof(*d));
-	if (d == NULL)
-		return -ENOMEM;
-	d->wd = IO_SRC_INVALID_WATCH_DESCRIPTOR;
-	*d = *src;
+	process_events(inot, inot->buf, (size_t)sret);
 
-	d->path = strdup(src->path);
-	if (d->path == NULL) {
-		ret = -errno;
-		goto err;
-	}
-
-	*dst = d;
-
-	return 0;
-err:
-	inot_watch_delete(&d);
-
-	return ret;
+	/* the buffer was filled, more events may be read at once next time */
+	if (!full || inot->buf_size >= IO_SRC_INOT_BUFFER_MAX)
+		return;
+	buf = realloc(inot->buf, 2 * inot->buf_size);
+	if (buf == NULL)
+		return;
+	inot->buf = buf;
+	inot->buf_size *= 2;
 }
 
 /**
@@ -399,6 +1141,14 @@ int io_src_inot_init(struct io_src_inot *inot)
 	if (ret < 0)
 		goto err;
 
+	inot->count = 1;
+	inot->buf_size = IO_SRC_INOT_BUFFER_MIN;
+	inot->buf = malloc(inot->buf_size);
+	if (inot->buf == NULL) {
+		ret = -errno;
+		goto err;
+	}
+
 	return 0;
 err:
 	io_src_inot_clean(inot);
@@ -408,84 +1158,107 @@ err:
 /*
  * performs the inotify_add_watch call and keeps the watches set up to date
  * if a watch is already registered for the given path, it will be updated,
- * otherwise, a clone of the watch parameter will be stored
+ * otherwise, a copy of the watch parameter will be stored
  */
 int io_src_inot_add_watch(struct io_src_inot *inot,
 		struct io_src_inot_watch *watch)
 {
 	int ret;
-	struct io_src_inot_watch *w;
-	bool update; /* true iif the file is already being watched */
+	struct inot_watch *w;
+	size_t len;
 
 	if (inot == NULL || watch_is_invalid(watch))
 		return -EINVAL;
 
-	/*
-	 * mustn't clone if already registered, just update: guarantees
-	 * uniqueness
-	 */
-	w = find_watch_by_path(inot, watch->path);
-	if (w == NULL) {
-		/* not watch found for the file, build one */
-		update = false;
-		ret = inot_watch_clone(watch, &w);
-		if (ret != 0)
-			return ret;
-	} else {
-		/* file is already watched, update the watch information */
-		update = true;
-		w->events = watch->events;
-		w->cb = watch->cb;
-	}
+	len = path_length(watch->path);
+	ret = add_watch(inot, watch, watch->path, len, 0, false, NULL);
+	if (ret < 0)
+		return ret;
+	w = find_watch_by_path(inot, watch->path, len);
+	watch->wd = w->watch.wd;
 
-	ret = inotify_add_watch(inot->src.fd, w->path, w->events);
-	if (ret < 0) {
-		ret = -errno;
-		goto err;
-	}
+	return 0;
+}
 
-	if (!update) {
-		watch->wd = w->wd = ret;
-		ret = store_watch(inot, w);
-		if (ret != 0)
-			goto err;
-	}
+int io_src_inot_add_watch_recursive(struct io_src_inot *inot,
+		struct io_src_inot_watch *watch)
+{
+	int ret;
+	struct inot_watch *w;
+	size_t len;
 
-	return 0;
-err:
-	remove_watch(inot, watch->path);
-	/* on update, because we destroy the watch, we must unregister it */
-	if (update && w->wd != IO_SRC_INVALID_WATCH_DESCRIPTOR)
-		inotify_rm_watch(inot->src.fd, w->wd);
-	inot_watch_delete(&w);
+	if (inot == NULL || watch_is_invalid(watch))
+		return -EINVAL;
 
-	return ret;
+	len = path_length(watch->path);
+	ret = add_watch(inot, watch, watch->path, len, IN_ONLYDIR, true, &w);
+	if (ret < 0)
+		return ret;
+	if (w == NULL)
+		/* an existing watch, made recursive, must be scanned too */
+		w = find_watch_by_path(inot, watch->path, len);
+	watch->wd = w->watch.wd;
+	/* an initial scan mustn't synthesize events */
+	queue_scan(inot, w, false);
+
+	return scan_pending(inot);
 }
 
 int io_src_inot_rm_watch(struct io_src_inot *inot,
 		struct io_src_inot_watch *watch)
 {
-	int ret;
-	struct io_src_inot_watch *w;
+	struct inot_watch *w;
 
 	if (inot == NULL || watch == NULL || ut_string_is_invalid(watch->path))
 		return -EINVAL;
 
-	w = remove_watch(inot, watch->path);
+	w = find_watch_by_path(inot, watch->path, path_length(watch->path));
 	if (w == NULL)
 		return -ENOENT;
 
-	ret = inotify_rm_watch(inot->src.fd, w->wd);
-	if (ret < 0) {
-		ret = -errno;
-		goto out;
+	if (w->recursive)
+		drop_tree(inot, w->path, w->len);
+
+	return drop_watch(inot, w, true);
+}
+
+int io_src_inot_set_coalescing(struct io_src_inot *inot, struct io_mon *mon,
+		uint32_t events, int window)
+{
+	int ret;
+
+	if (inot == NULL || window < 0)
+		return -EINVAL;
+
+	if (window == 0) {
+		flush_pending(inot);
+		disable_coalescing(inot);
+		return 0;
 	}
 
-	ret = 0;
-out:
-	inot_watch_delete(&w);
+	events &= IN_ALL_EVENTS & ~IN_MOVE;
+	if (mon == NULL || events == 0)
+		return -EINVAL;
 
-	return ret;
+	if (inot->mon != NULL && inot->mon != mon) {
+		flush_pending(inot);
+		disable_coalescing(inot);
+	}
+	if (inot->mon == NULL) {
+		ret = io_src_tmr_init(&inot->tmr, tmr_cb);
+		if (ret < 0)
+			return ret;
+		ret = io_mon_add_source(mon, &inot->tmr.src);
+		if (ret < 0) {
+			io_src_tmr_clean(&inot->tmr);
+			return ret;
+		}
+		inot->mon = mon;
+	}
+	inot->coalesced_events = events;
+	inot->window = window;
+
+	return 0;
 }
 
 void io_src_inot_clean(struct io_src_inot *inot)
@@ -493,6 +1266,10 @@ void io_src_inot_clean(struct io_src_inot *inot)
 	if (inot == NULL)
 		return;
 
+	disable_coalescing(inot);
+	free(inot->pending);
+	free(inot->index);
+	free(inot->buf);
 	clean_watches(inot);
 	io_src_clean(&inot->src);
 	ut_file_fd_close(&inot->src.fd);
@@ -14,6 +14,12 @@
 #include "io_mon.h"
 #include "io_src_msg.h"
 
+/**
+ * @def to_src_msg_out
+ * @brief Convert a send queue node to it's message
+ */
+#define to_src_msg_out(p) ut_container_of(p, struct io_src_msg_out, node)
+
 /**
  * Receives a message and notifies it to the client
  * @param msg Message source
@@ -62,6 +68,60 @@ static int out_msg(struct io_src_msg *msg, int fd)
 	return 0;
 }
 
+/**
+ * Default write operation for queued messages
+ * @param msg Message source
+ * @param buf Message, or what remains to be written of it
+ * @param len Size of buf
+ * @return errno compatible value on error, 0 if buf has been written entirely,
+ * number of bytes written otherwise
+ */
+static int msg_write(struct io_src_msg *msg, const void *buf, unsigned len)
+{
+	ssize_t sret;
+
+	sret = io_write(msg->src.fd, buf, len);
+	if (-1 == sret)
+		return -errno;
+
+	/* cast is ok, sret is positive and less than len */
+	return (ssize_t)len == sret ? 0 : (int)sret;
+}
+
+/**
+ * Writes the queued messages until the queue is empty or the file descriptor
+ * would block. The monitoring of OUT events is deactivated once the queue is
+ * empty
+ * @param msg Message source
+ */
+static void drain_send_queue(struct io_src_msg *msg)
+{
+	struct io_src_msg_out *out;
+	int ret;
+
+	/* the completion callbacks may queue other messages */
+	while (!rs_dll_is_empty(&msg->send_queue)) {
+		out = to_src_msg_out(msg->send_queue.head);
+		ret = msg->write(msg, (const char *)out->buf + out->offset,
+				out->len - out->offset);
+		if (ret > 0) {
+			/*
+			 * short write, the peer must receive the message
+			 * entirely, the rest is sent on the next OUT event
+			 */
+			out->offset += ret;
+			return;
+		}
+		if (-EAGAIN == ret)
+			return;
+
+		rs_dll_pop(&msg->send_queue);
+		out->cb(out, ret);
+	}
+
+	io_mon_activate_out_source(msg->mon, &msg->src, false);
+}
+
 /**
  * Source callback, either performs in or out operation, depending on the event
  * type
@@ -80,7 +140,10 @@ static void msg_cb(struct io_src *src)
 		return;
 	}
 
-	out_msg(msg, src->fd);
+	if (!rs_dll_is_empty(&msg->send_queue))
+		drain_send_queue(msg);
+	else
+		out_msg(msg, src->fd);
 }
 
 int io_src_msg_set_next_message(struct io_src_msg *msg_src,
@@ -95,6 +158,34 @@ int io_src_msg_set_next_message(struct io_src_msg *msg_src,
 	return 0;
 }
 
+int io_src_msg_send(struct io_src_msg *msg_src, struct io_mon *mon,
+		struct io_src_msg_out *out)
+{
+	int ret;
+
+	if (NULL == msg_src || NULL == mon || NULL == out || NULL == out->buf ||
+			NULL == out->cb || !(msg_src->src.type & IO_OUT))
+		return -EINVAL;
+
+	if (rs_dll_is_empty(&msg_src->send_queue)) {
+		ret = io_mon_activate_out_source(mon, &msg_src->src, true);
+		if (ret < 0)
+			return ret;
+	}
+	msg_src->mon = mon;
+	out->offset = 0;
+
+	return rs_dll_enqueue(&msg_src->send_queue, &out->node);
+}
+
+unsigned io_src_msg_get_send_queue_length(struct io_src_msg *msg_src)
+{
+	if (NULL == msg_src)
+		return 0;
+
+	return rs_dll_get_count(&msg_src->send_queue);
+}
+
 int io_src_msg_get_message(struct io_src_msg *msg_src, void **msg)
 {
 	if (NULL == msg_src || NULL == msg)
@@ -120,6 +211,8 @@ int io_src_msg_init(struct io_src_msg *msg_src, int fd, enum io_src_event type,
 	msg_src->rcv_buf_size = len;
 	msg_src->send_buf_size = 0;
 	msg_src->perform_io = perform_io;
+	rs_dll_init(&msg_src->send_queue, NULL);
+	msg_src->write = msg_write;
 
 	/* can fail only on parameters */
 	return io_src_init(&(msg_src->src), fd, type, msg_cb);
@@ -127,9 +220,19 @@ int io_src_msg_init(struct io_src_msg *msg_src, int fd, enum io_src_event type,
 
 void io_src_msg_clean(struct io_src_msg *msg)
 {
+	struct rs_node *node;
+	struct io_src_msg_out *out;
+
 	if (NULL == msg)
 		return;
 
+	while ((node = rs_dll_pop(&msg->send_queue))) {
+		out = to_src_msg_out(node);
+		out->cb(out, -ECANCELED);
+	}
+	msg->mon = NULL;
+	msg->write = NULL;
+
 	msg->cb = NULL;
 	msg->rcv_buf_size = 0;
 	msg->rcv_buf = NULL;
@@ -10,14 +10,18 @@
 #define _GNU_SOURCE
 #endif /* _GNU_SOURCE */
 #include <sys/socket.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 
 #include <fcntl.h>
 #include <unistd.h>
 
 #include <errno.h>
+#include <stdlib.h>
 #include <string.h>
 #include <stdarg.h>
 #include <stdio.h>
+#include <stdint.h>
 
 #include <ut_utils.h>
 #include <ut_string.h>
@@ -35,6 +39,37 @@
  */
 #define to_src_msg_uad(p) ut_container_of(p, struct io_src_msg_uad, src_msg)
 
+/**
+ * @struct io_src_msg_uad_batch
+ * @brief Receive slots and send queue of an UAD source in batch mode
+ */
+struct io_src_msg_uad_batch {
+	/** maximum size of a message */
+	unsigned msg_size;
+	/** number of receive slots and capacity of the send queue */
+	unsigned nb_slots;
+
+	/** storage of the receive slots, nb_slots * msg_size bytes */
+	char *rcv_buf;
+	/** one iovec per receive slot, pointing to it's storage */
+	struct iovec *rcv_iov;
+	/** headers passed to recvmmsg(), one per receive slot */
+	struct mmsghdr *rcv_msgs;
+	/** messages received, as passed to the user */
+	struct iovec *msgs;
+
+	/** storage of the send queue, nb_slots * msg_size bytes */
+	char *send_buf;
+	/** one iovec per send slot, iov_len is the queued message's size */
+	struct iovec *send_iov;
+	/** headers passed to sendmmsg(), one per send slot */
+	struct mmsghdr *send_msgs;
+	/** index of the oldest message queued */
+	unsigned send_head;
+	/** number of messages queued */
+	unsigned send_count;
+};
+
 /**
  * Performs input
  * @param uad Source
@@ -75,6 +110,204 @@ static int process_out_event(struct io_src_msg_uad *uad)
 	return 0;
 }
 
+/**
+ * Writes a queued message to the UAD's address
+ * @param src_msg Message source of the UAD source
+ * @param buf Message
+ * @param len Size of the message
+ * @return errno compatible value on error, 0 on success
+ */
+static int uad_write(struct io_src_msg *src_msg, const void *buf,
+		unsigned len)
+{
+	struct io_src_msg_uad *uad = to_src_msg_uad(src_msg);
+	ssize_t sret;
+
+	sret = io_sendto(src_msg->src.fd, buf, len, MSG_DONTWAIT,
+			(const struct sockaddr *)&(uad->addr),
+			sizeof(uad->addr));
+	if (-1 == sret)
+		return -errno;
+
+	return (ssize_t)len == sret ? 0 : -EIO;
+}
+
+/**
+ * Performs input in batch mode, retrieving as much messages as there are slots
+ * @param uad Source
+ * @return errno compatible value on error, 0 on success
+ */
+static int process_in_batch_event(struct io_src_msg_uad *uad)
+{
+	struct io_src_msg_uad_batch *batch = uad->batch;
+	int n;
+	int i;
+
+	n = io_recvmmsg(uad->src_msg.src.fd, batch->rcv_msgs, batch->nb_slots,
+			MSG_DONTWAIT, NULL);
+	if (-1 == n)
+		return -errno;
+
+	for (i = 0; i < n; i++) {
+		batch->msgs[i].iov_base = batch->rcv_iov[i].iov_base;
+		batch->msgs[i].iov_len = batch->rcv_msgs[i].msg_len;
+	}
+
+	/* cast is ok, n has been checked non-negative */
+	uad->batch_cb(uad, IO_IN, batch->msgs, (unsigned)n);
+
+	return 0;
+}
+
+/**
+ * Performs output in batch mode, lets the user queue messages, then flushes
+ * the queue
+ * @param uad Source
+ * @return errno compatible value on error, 0 on success
+ */
+static int process_out_batch_event(struct io_src_msg_uad *uad)
+{
+	int ret;
+
+	uad->batch_cb(uad, IO_OUT, NULL, 0);
+
+	ret = io_src_msg_uad_flush(uad);
+
+	return ret < 0 ? ret : 0;
+}
+
+/**
+ * @def BLOB_SEALS
+ * @brief Seals a memfd must have for it's mapping to be safe to read
+ */
+#define BLOB_SEALS (F_SEAL_SHRINK | F_SEAL_WRITE)
+
+/**
+ * Extracts the file descriptor passed alongside a datagram, if any
+ * @param msg Message header, as filled by recvmsg()
+ * @return File descriptor received, -1 if none
+ */
+static int blob_received_fd(struct msghdr *msg)
+{
+	struct cmsghdr *cmsg;
+	int fd;
+
+	for (cmsg = CMSG_FIRSTHDR(msg); NULL != cmsg;
+			cmsg = CMSG_NXTHDR(msg, cmsg)) {
+		if (SOL_SOCKET != cmsg->cmsg_level ||
+				SCM_RIGHTS != cmsg->cmsg_type ||
+				cmsg->cmsg_len < CMSG_LEN(sizeof(fd)))
+			continue;
+		memcpy(&fd, CMSG_DATA(cmsg), sizeof(fd));
+		return fd;
+	}
+
+	return -1;
+}
+
+/**
+ * Maps read-only a memfd received, after having checked that the sender can't
+ * modify it anymore, nor truncate it under our feet
+ * @param fd memfd received
+ * @param len Size of the blob, as announced by the sender
+ * @param blob In output, address of the mapping
+ * @return errno compatible value on error, 0 on success
+ */
+static int blob_map(int fd, uint64_t len, void **blob)
+{
+	struct stat st;
+	int seals;
+
+	seals = fcntl(fd, F_GET_SEALS);
+	if (-1 == seals)
+		return -errno;
+	if ((seals & BLOB_SEALS) != BLOB_SEALS)
+		return -EPERM;
+	if (-1 == fstat(fd, &st))
+		return -errno;
+	if (0 == len || len > SIZE_MAX || len > (uint64_t)st.st_size)
+		return -EBADMSG;
+
+	*blob = mmap(NULL, len, PROT_READ, MAP_SHARED, fd, 0);
+	if (MAP_FAILED == *blob)
+		return -errno;
+
+	return 0;
+}
+
+/**
+ * Performs input in blob mode, the blob is either inline or in a memfd, which
+ * is mapped for the time of the user callback
+ * @param uad Source
+ * @return errno compatible value on error, 0 on success
+ */
+static int process_in_blob_event(struct io_src_msg_uad *uad)
+{
+	union {
+		struct cmsghdr align;
+		char buf[CMSG_SPACE(sizeof(int))];
+	} control;
+	struct iovec iov = {
+		.iov_base = uad->blob_buf,
+		.iov_len = uad->src_msg.rcv_buf_size,
+	};
+	struct msghdr msg = {
+		.msg_iov = &iov,
+		.msg_iovlen = 1,
+		.msg_control = control.buf,
+		.msg_controllen = sizeof(control.buf),
+	};
+	ssize_t sret;
+	uint64_t len;
+	void *blob;
+	int fd;
+	int ret;
+
+	sret = TEMP_FAILURE_RETRY(recvmsg(uad->src_msg.src.fd, &msg,
+			MSG_DONTWAIT | MSG_CMSG_CLOEXEC));
+	if (-1 == sret)
+		return -errno;
+
+	fd = blob_received_fd(&msg);
+	if (-1 == fd) {
+		if (msg.msg_flags & MSG_TRUNC)
+			return -EMSGSIZE;
+		/* cast is ok, sret has been checked non-negative */
+		uad->blob_cb(uad, IO_IN, uad->blob_buf, (size_t)sret);
+		return 0;
+	}
+
+	/* the datagram of a memfd blob only holds the blob's size */
+	if ((ssize_t)sizeof(len) != sret) {
+		ret = -EBADMSG;
+		goto out;
+	}
+	memcpy(&len, uad->blob_buf, sizeof(len));
+	ret = blob_map(fd, len, &blob);
+	if (ret < 0)
+		goto out;
+
+	uad->blob_cb(uad, IO_IN, blob, len);
+
+	munmap(blob, len);
+out:
+	ut_file_fd_close(&fd);
+
+	return ret;
+}
+
+/**
+ * Performs output in blob mode, lets the user send blobs
+ * @param uad Source
+ * @return errno compatible value on error, 0 on success
+ */
+static int process_out_blob_event(struct io_src_msg_uad *uad)
+{
+	uad->blob_cb(uad, IO_OUT, NULL, 0);
+
+	return 0;
+}
+
 /**
  * Performs I/O, after arguments are already verified
  * @param uad Source
@@ -84,6 +317,15 @@ static int process_out_event(struct io_src_msg_uad *uad)
 static int process_event(struct io_src_msg_uad *uad, enum io_src_event evt)
 {
 	/* here evt is either IO_IN or IO_OUT, not both */
+	if (NULL != uad->blob_cb)
+		/* coverity[mixed_enums] */
+		return IO_IN == evt ? process_in_blob_event(uad) :
+				process_out_blob_event(uad);
+	if (NULL != uad->batch)
+		/* coverity[mixed_enums] */
+		return IO_IN == evt ? process_in_batch_event(uad) :
+				process_out_batch_event(uad);
+
 	/* coverity[mixed_enums] */
 	return IO_IN == evt ? process_in_event(uad) : process_out_event(uad);
 }
@@ -131,42 +373,375 @@ int io_src_msg_uad_get_message(struct io_src_msg_uad *uad, void **msg)
 	return io_src_msg_get_message(&(uad->src_msg), msg);
 }
 
-int io_src_msg_uad_init(struct io_src_msg_uad *uad, io_src_msg_uad_cb *cb,
-		void *rcv_buf, unsigned len, const char *fmt, ...)
+/**
+ * Creates the socket of an UAD source and binds it to it's abstract address
+ * @param uad UAD source, the address is stored in it
+ * @param fmt A la printf format string for the construction of the path
+ * @param args Arguments of the format string
+ * @return errno compatible negative value on error, socket on success
+ */
+static int uad_socket(struct io_src_msg_uad *uad, const char *fmt,
+		va_list args)
 {
 	int sockfd;
-	va_list args;
 	int ret;
 
-	if (uad_init_args_are_invalid(uad, cb, rcv_buf, len, fmt))
-		return -EINVAL;
-
-	memset(uad, 0, sizeof(*uad));
-
 	sockfd = socket(AF_UNIX, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
 	if (sockfd < 0)
 		return -errno;
 
 	uad->addr.sun_path[0] = '\0';
-	va_start(args, fmt);
 	vsnprintf(uad->addr.sun_path + 1, UNIX_PATH_MAX - 1, fmt, args);
-	va_end(args);
 	uad->addr.sun_family = AF_UNIX;
 	ret = bind(sockfd, (struct sockaddr *) &(uad->addr),
 			sizeof(uad->addr));
 	if (ret < 0) {
 		ret = -errno;
-		goto out;
+		ut_file_fd_close(&sockfd);
+		return ret;
 	}
 
-	uad->cb = cb;
+	return sockfd;
+}
+
+/**
+ * Initializes the message source of an UAD source, queued messages are sent to
+ * the UAD's address
+ * @param uad UAD source
+ * @param sockfd Socket of the UAD source
+ * @param rcv_buf Buffer where received data are stored
+ * @param len Size of rcv_buf
+ * @return errno compatible negative value
+ */
+static int uad_src_msg_init(struct io_src_msg_uad *uad, int sockfd,
+		void *rcv_buf, unsigned len)
+{
+	int ret;
 
 	/* can fail only on parameters */
-	return io_src_msg_init(&(uad->src_msg), sockfd, IO_DUPLEX, uad_cb,
+	ret = io_src_msg_init(&(uad->src_msg), sockfd, IO_DUPLEX, uad_cb,
 			rcv_buf, len, 0);
+	if (ret < 0)
+		return ret;
+	uad->src_msg.write = uad_write;
 
-out:
-	ut_file_fd_close(&sockfd);
+	return 0;
+}
+
+int io_src_msg_uad_init(struct io_src_msg_uad *uad, io_src_msg_uad_cb *cb,
+		void *rcv_buf, unsigned len, const char *fmt, ...)
+{
+	int sockfd;
+	va_list args;
+
+	if (uad_init_args_are_invalid(uad, cb, rcv_buf, len, fmt))
+		return -EINVAL;
+
+	memset(uad, 0, sizeof(*uad));
+
+	va_start(args, fmt);
+	sockfd = uad_socket(uad, fmt, args);
+	va_end(args);
+	if (sockfd < 0)
+		return sockfd;
+
+	uad->cb = cb;
+
+	return uad_src_msg_init(uad, sockfd, rcv_buf, len);
+}
+
+/**
+ * Releases the slots and the queue of an UAD source in batch mode
+ * @param batch Batch mode context, can be NULL
+ */
+static void batch_free(struct io_src_msg_uad_batch *batch)
+{
+	if (NULL == batch)
+		return;
+
+	free(batch->rcv_buf);
+	free(batch->rcv_iov);
+	free(batch->rcv_msgs);
+	free(batch->msgs);
+	free(batch->send_buf);
+	free(batch->send_iov);
+	free(batch->send_msgs);
+	free(batch);
+}
+
+/**
+ * Allocates the slots and the queue of an UAD source in batch mode and chains
+ * the headers with their storage
+ * @param uad UAD source, whose address must be set
+ * @param msg_size Maximum size of a message
+ * @param nb_slots Number of slots
+ * @return Batch context, NULL on allocation error
+ */
+static struct io_src_msg_uad_batch *batch_new(struct io_src_msg_uad *uad,
+		unsigned msg_size, unsigned nb_slots)
+{
+	struct io_src_msg_uad_batch *batch;
+	unsigned i;
+
+	batch = calloc(1, sizeof(*batch));
+	if (NULL == batch)
+		return NULL;
+
+	batch->msg_size = msg_size;
+	batch->nb_slots = nb_slots;
+	batch->rcv_buf = calloc(nb_slots, msg_size);
+	batch->rcv_iov = calloc(nb_slots, sizeof(*batch->rcv_iov));
+	batch->rcv_msgs = calloc(nb_slots, sizeof(*batch->rcv_msgs));
+	batch->msgs = calloc(nb_slots, sizeof(*batch->msgs));
+	batch->send_buf = calloc(nb_slots, msg_size);
+	batch->send_iov = calloc(nb_slots, sizeof(*batch->send_iov));
+	batch->send_msgs = calloc(nb_slots, sizeof(*batch->send_msgs));
+	if (NULL == batch->rcv_buf || NULL == batch->rcv_iov ||
+			NULL == batch->rcv_msgs || NULL == batch->msgs ||
+			NULL == batch->send_buf || NULL == batch->send_iov ||
+			NULL == batch->send_msgs) {
+		batch_free(batch);
+		return NULL;
+	}
+
+	for (i = 0; i < nb_slots; i++) {
+		batch->rcv_iov[i].iov_base = batch->rcv_buf + i * msg_size;
+		batch->rcv_iov[i].iov_len = msg_size;
+		batch->rcv_msgs[i].msg_hdr.msg_iov = batch->rcv_iov + i;
+		batch->rcv_msgs[i].msg_hdr.msg_iovlen = 1;
+
+		batch->send_iov[i].iov_base = batch->send_buf + i * msg_size;
+		batch->send_msgs[i].msg_hdr.msg_iov = batch->send_iov + i;
+		batch->send_msgs[i].msg_hdr.msg_iovlen = 1;
+		batch->send_msgs[i].msg_hdr.msg_name = &uad->addr;
+		batch->send_msgs[i].msg_hdr.msg_namelen = sizeof(uad->addr);
+	}
+
+	return batch;
+}
+
+int io_src_msg_uad_init_batch(struct io_src_msg_uad *uad,
+		io_src_msg_uad_batch_cb *cb, unsigned msg_size,
+		unsigned nb_slots, const char *fmt, ...)
+{
+	int sockfd;
+	va_list args;
+
+	if (NULL == uad || NULL == cb || 0 == msg_size || 0 == nb_slots ||
+			NULL == fmt || '\0' == *fmt)
+		return -EINVAL;
+
+	memset(uad, 0, sizeof(*uad));
+
+	va_start(args, fmt);
+	sockfd = uad_socket(uad, fmt, args);
+	va_end(args);
+	if (sockfd < 0)
+		return sockfd;
+
+	uad->batch = batch_new(uad, msg_size, nb_slots);
+	if (NULL == uad->batch) {
+		ut_file_fd_close(&sockfd);
+		return -ENOMEM;
+	}
+	uad->batch_cb = cb;
+
+	return uad_src_msg_init(uad, sockfd, uad->batch->rcv_buf, msg_size);
+}
+
+int io_src_msg_uad_queue_message(struct io_src_msg_uad *uad, const void *msg,
+		unsigned len)
+{
+	struct io_src_msg_uad_batch *batch;
+	unsigned i;
+
+	if (NULL == uad || NULL == uad->batch || NULL == msg)
+		return -EINVAL;
+	batch = uad->batch;
+	if (len > batch->msg_size)
+		return -EMSGSIZE;
+	if (batch->send_count == batch->nb_slots)
+		return -ENOBUFS;
+
+	i = (batch->send_head + batch->send_count) % batch->nb_slots;
+	memcpy(batch->send_iov[i].iov_base, msg, len);
+	batch->send_iov[i].iov_len = len;
+	batch->send_count++;
+
+	return 0;
+}
+
+int io_src_msg_uad_flush(struct io_src_msg_uad *uad)
+{
+	struct io_src_msg_uad_batch *batch;
+	unsigned run;
+	int n;
+
+	if (NULL == uad || NULL == uad->batch)
+		return -EINVAL;
+	batch = uad->batch;
+
+	while (0 != batch->send_count) {
+		/* the queue is a ring, send the contiguous part first */
+		run = batch->nb_slots - batch->send_head;
+		if (run > batch->send_count)
+			run = batch->send_count;
+		n = io_sendmmsg(uad->src_msg.src.fd,
+				batch->send_msgs + batch->send_head, run,
+				MSG_DONTWAIT);
+		if (-1 == n) {
+			if (EAGAIN == errno)
+				break;
+			/* the message in error is dropped */
+			n = -errno;
+			batch->send_head = (batch->send_head + 1) %
+					batch->nb_slots;
+			batch->send_count--;
+			return n;
+		}
+
+		/* cast is ok, n has been checked non-negative */
+		batch->send_head = (batch->send_head + (unsigned)n) %
+				batch->nb_slots;
+		batch->send_count -= (unsigned)n;
+		if ((unsigned)n < run)
+			break;
+	}
+
+	/* cast is ok, send_count is at most nb_slots, given as an unsigned */
+	return (int)batch->send_count;
+}
+
+int io_src_msg_uad_init_blob(struct io_src_msg_uad *uad,
+		io_src_msg_uad_blob_cb *cb, unsigned inline_size,
+		const char *fmt, ...)
+{
+	int sockfd;
+	va_list args;
+
+	/* the inline storage also receives the size of the memfd blobs */
+	if (NULL == uad || NULL == cb || inline_size < sizeof(uint64_t) ||
+			NULL == fmt || '\0' == *fmt)
+		return -EINVAL;
+
+	memset(uad, 0, sizeof(*uad));
+
+	va_start(args, fmt);
+	sockfd = uad_socket(uad, fmt, args);
+	va_end(args);
+	if (sockfd < 0)
+		return sockfd;
+
+	uad->blob_buf = malloc(inline_size);
+	if (NULL == uad->blob_buf) {
+		ut_file_fd_close(&sockfd);
+		return -ENOMEM;
+	}
+	uad->blob_cb = cb;
+
+	return uad_src_msg_init(uad, sockfd, uad->blob_buf, inline_size);
+}
+
+/**
+ * Creates a memfd holding a copy of a blob and seals it, so that the receiver
+ * can trust it's content won't change while mapped
+ * @param blob Blob to copy
+ * @param len Size of the blob, non zero
+ * @return errno compatible value on error, memfd on success
+ */
+static int blob_memfd(const void *blob, size_t len)
+{
+	void *map;
+	int fd;
+	int ret;
+
+	fd = memfd_create("io_src_msg_uad", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+	if (-1 == fd)
+		return -errno;
+	if (-1 == ftruncate(fd, len))
+		goto err;
+	map = mmap(NULL, len, PROT_WRITE, MAP_SHARED, fd, 0);
+	if (MAP_FAILED == map)
+		goto err;
+	memcpy(map, blob, len);
+	/* F_SEAL_WRITE fails while a writable mapping exists */
+	munmap(map, len);
+	if (-1 == fcntl(fd, F_ADD_SEALS, BLOB_SEALS | F_SEAL_GROW |
+			F_SEAL_SEAL))
+		goto err;
+
+	return fd;
+err:
+	ret = -errno;
+	ut_file_fd_close(&fd);
+
+	return ret;
+}
+
+/**
+ * Sends a datagram, with a file descriptor alongside if needed
+ * @param uad UAD source
+ * @param buf Payload of the datagram
+ * @param len Size of the payload
+ * @param fd File descriptor to pass, -1 for none
+ * @return errno compatible value on error, 0 on success
+ */
+static int blob_send(struct io_src_msg_uad *uad, const void *buf, size_t len,
+		int fd)
+{
+	union {
+		struct cmsghdr align;
+		char buf[CMSG_SPACE(sizeof(int))];
+	} control;
+	struct iovec iov = {
+		.iov_base = (void *)buf,
+		.iov_len = len,
+	};
+	struct msghdr msg = {
+		.msg_name = &uad->addr,
+		.msg_namelen = sizeof(uad->addr),
+		.msg_iov = &iov,
+		.msg_iovlen = 1,
+	};
+	struct cmsghdr *cmsg;
+	ssize_t sret;
+
+	if (-1 != fd) {
+		memset(&control, 0, sizeof(control));
+		msg.msg_control = control.buf;
+		msg.msg_controllen = sizeof(control.buf);
+		cmsg = CMSG_FIRSTHDR(&msg);
+		cmsg->cmsg_level = SOL_SOCKET;
+		cmsg->cmsg_type = SCM_RIGHTS;
+		cmsg->cmsg_len = CMSG_LEN(sizeof(fd));
+		memcpy(CMSG_DATA(cmsg), &fd, sizeof(fd));
+	}
+
+	sret = TEMP_FAILURE_RETRY(sendmsg(uad->src_msg.src.fd, &msg,
+			MSG_DONTWAIT));
+
+	return -1 == sret ? -errno : 0;
+}
+
+int io_src_msg_uad_send_blob(struct io_src_msg_uad *uad, const void *blob,
+		size_t len)
+{
+	uint64_t size = len;
+	int fd;
+	int ret;
+
+	if (NULL == uad || NULL == uad->blob_cb || (NULL == blob && 0 != len))
+		return -EINVAL;
+
+	if (len <= uad->src_msg.rcv_buf_size)
+		return blob_send(uad, blob, len, -1);
+
+	fd = blob_memfd(blob, len);
+	if (fd < 0)
+		return fd;
+	/* once sent, the receiver holds it's own reference on the memfd */
+	ret = blob_send(uad, &size, sizeof(size), fd);
+	ut_file_fd_close(&fd);
 
 	return ret;
 }
@@ -177,11 +752,16 @@ void io_src_msg_uad_clean(struct io_src_msg_uad *uad)
 		return;
 
 	uad->cb = NULL;
+	uad->batch_cb = NULL;
 	memset(&(uad->addr), 0, sizeof(uad->addr));
 	shutdown(uad->src_msg.src.fd, SHUT_RDWR);
 
 	ut_file_fd_close(&uad->src_msg.src.fd);
 
 	io_src_msg_clean((&uad->src_msg));
+	batch_free(uad->batch);
+	uad->batch = NULL;
+	uad->blob_cb = NULL;
+	free(uad->blob_buf);
+	uad->blob_buf = NULL;
 }
-
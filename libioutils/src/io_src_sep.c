@@ -3,8 +3,8 @@
  * @date 23 oct. 2012
  * @author nicolas.carrier@parrot.com
  * @brief Separator source, for input. Bytes read are stored in an internal
- * buffer of size IO_SRC_SEP_SIZE and the client is notified each time a given
- * character separator is found, or the buffer is full.
+ * buffer of configurable size and the client is notified each time a given
+ * delimiter is found, or the buffer is full.
  *
  * Copyright (C) 2012 Parrot S.A.
  */
@@ -14,6 +14,7 @@
 #include <unistd.h>
 
 #include <errno.h>
+#include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
 
@@ -40,7 +41,7 @@
  * @brief computes the maximum number of bytes which can be read in order to
  * build a chunk of acceptable size
  */
-#define to_read(sep) (IO_SRC_SEP_SIZE - already_read(sep))
+#define to_read(sep) ((sep)->size - already_read(sep))
 
 /**
  * @define buf_read_start
@@ -48,22 +49,49 @@
  */
 #define buf_read_start(sep) ((sep)->buf + (sep)->from)
 
+/**
+ * Finishes a notification of the client, completing the clean up of the source
+ * if it was requested from the callback
+ * @param sep Separator source
+ * @return -ECANCELED if the source has been cleaned, in which case it mustn't
+ * be accessed anymore, 0 otherwise
+ */
+static int notification_done(struct io_src_sep *sep)
+{
+	sep->notifying = false;
+	if (!sep->clean_pending)
+		return 0;
+
+	io_src_sep_clean(sep);
+
+	return -ECANCELED;
+}
+
 /**
  * Calls back the client with a chunk and updates the internal buffer state to
  * reflect that we have consumed some bytes
  * @param sep
  * @param len
- * @return 0
+ * @return -ECANCELED if the client has cleaned the source, 0 otherwise
  */
 static int notify_user(struct io_src_sep *sep, unsigned len)
 {
 	char *chunk = buf_read_start(sep);
+	/* the client is allowed to write chunk[len], which may be buffered data */
+	char next = chunk[len];
 
+	sep->notifying = true;
 	sep->cb(sep, chunk, len);
+	if (notification_done(sep) < 0)
+		return -ECANCELED;
+	chunk[len] = next;
 	sep->from += len;
-	if (sep->from >= IO_SRC_SEP_SIZE) {
+	if (sep->scan_from < sep->from)
+		sep->scan_from = sep->from;
+	if (sep->from >= sep->size) {
 		memmove(sep->buf, buf_read_start(sep), already_read(sep));
 		sep->up_to -= sep->from;
+		sep->scan_from -= sep->from;
 		sep->from = 0;
 	}
 
@@ -89,18 +117,31 @@ static int end_of_file(struct io_src_sep *sep)
 }
 
 /**
- * Checks if the separator byt(s) is (are) found at a given position in a string
+ * Searches the next delimiter in the data not yet scanned. The search relies on
+ * memmem(), which glibc implements with vectorized scans (memchr() for one-byte
+ * delimiters, two-way string matching otherwise)
  * @param sep Separator source
- * @param c Current position in the string
- * @return
+ * @return Address of the first byte of the delimiter if found, NULL otherwise
  */
-static int separator_found(struct io_src_sep *sep, char *c)
+static char *find_delim(struct io_src_sep *sep)
 {
-	return *c == sep->sep1 && (!sep->two_bytes || *(c + 1) == sep->sep2);
+	char *found;
+	unsigned tail = sep->delim_len - 1;
+
+	found = memmem(sep->buf + sep->scan_from, sep->up_to - sep->scan_from,
+			sep->delim, sep->delim_len);
+	if (NULL != found)
+		return found;
+
+	/* next search must restart where a partial delimiter may begin */
+	if (already_read(sep) > tail)
+		sep->scan_from = sep->up_to - tail;
+
+	return NULL;
 }
 
 /**
- * Searches each separator occurrences and notifies user of each corresponding
+ * Searches each delimiter occurrences and notifies user of each corresponding
  * chunk
  * @param sep Separator source
  * @return First critical error code from user callback
@@ -108,24 +149,18 @@ static int separator_found(struct io_src_sep *sep, char *c)
 static int parse(struct io_src_sep *sep)
 {
 	int ret;
-	char *cur = NULL;
-
-	for (cur = buf_read_start(sep);
-			cur + sep->two_bytes < buf_write_start(sep);
-			cur++)
-		if (separator_found(sep, cur)) {
-			/* cast is ok because !!two_bytes is 0 or 1 */
-			unsigned sep_offset = 1 + (unsigned)(!!sep->two_bytes);
-			ptrdiff_t data_len = cur - buf_read_start(sep);
-			unsigned chunk_len = sep_offset + (unsigned)data_len;
-
-			ret = notify_user(sep, chunk_len);
-			if (0 > ret)
-				return ret;
-			if (0 < ret)
-				fprintf(stderr, "sep->cb: %s", strerror(-ret));
-			cur += sep->two_bytes;
-		}
+	char *cur;
+	ptrdiff_t data_len;
+
+	while ((cur = find_delim(sep)) != NULL) {
+		data_len = cur - buf_read_start(sep);
+		/* cast is ok, data_len is positive and less than sep->size */
+		ret = notify_user(sep, (unsigned)data_len + sep->delim_len);
+		if (0 > ret)
+			return ret;
+		if (0 < ret)
+			fprintf(stderr, "sep->cb: %s", strerror(-ret));
+	}
 
 	return 0;
 }
@@ -145,7 +180,7 @@ static int consume(struct io_src_sep *sep)
 		return ret;
 
 	/* buffer is full : notify */
-	if (already_read(sep) == IO_SRC_SEP_SIZE)
+	if (already_read(sep) == sep->size)
 		return notify_user(sep, already_read(sep));
 
 	return 0;
@@ -182,30 +217,291 @@ static void sep_cb(struct io_src *src)
 
 }
 
+/**
+ * @def BATCH_INITIAL_CAPACITY
+ * @brief initial number of chunks of the batch array, which is grown on demand
+ */
+#define BATCH_INITIAL_CAPACITY 16
+
+/**
+ * @def batch_to_read
+ * @brief computes the maximum number of bytes which can be read in batch mode,
+ * one byte is kept at the end of the buffer, as in normal mode
+ */
+#define batch_to_read(sep) (2 * (sep)->size - (sep)->up_to)
+
+/**
+ * Appends a chunk to the current batch and updates the internal buffer state
+ * to reflect that we have consumed some bytes
+ * @param sep Separator source
+ * @param nb_chunks Number of chunks already in the batch, incremented
+ * @param len Size of the chunk
+ * @return -ENOMEM if the chunks array couldn't be grown, 0 otherwise
+ */
+static int batch_push(struct io_src_sep *sep, unsigned *nb_chunks,
+		unsigned len)
+{
+	struct io_src_sep_chunk *chunks;
+	unsigned capacity;
+
+	if (*nb_chunks == sep->chunks_capacity) {
+		capacity = 2 * sep->chunks_capacity;
+		chunks = realloc(sep->chunks, capacity * sizeof(*chunks));
+		if (NULL == chunks)
+			return -ENOMEM;
+		sep->chunks = chunks;
+		sep->chunks_capacity = capacity;
+	}
+
+	sep->chunks[*nb_chunks].data = buf_read_start(sep);
+	sep->chunks[*nb_chunks].len = len;
+	(*nb_chunks)++;
+	sep->from += len;
+	if (sep->scan_from < sep->from)
+		sep->scan_from = sep->from;
+
+	return 0;
+}
+
+/**
+ * Searches each delimiter occurrences and stores the corresponding chunks in
+ * the batch, without notifying the user
+ * @param sep Separator source
+ * @param nb_chunks In output, number of chunks found
+ * @return -ENOMEM if the chunks array couldn't be grown, 0 otherwise
+ */
+static int batch_parse(struct io_src_sep *sep, unsigned *nb_chunks)
+{
+	int ret;
+	char *cur;
+	unsigned len = 0;
+
+	*nb_chunks = 0;
+	do {
+		cur = find_delim(sep);
+		if (NULL != cur)
+			/* cast is ok, cur is after the read start */
+			len = (unsigned)(cur - buf_read_start(sep)) +
+					sep->delim_len;
+		if (NULL == cur || len > sep->size) {
+			/* no complete chunk, cut one only if it is too big */
+			if (already_read(sep) < sep->size)
+				return 0;
+			len = sep->size;
+		}
+		ret = batch_push(sep, nb_chunks, len);
+	} while (0 == ret);
+
+	return ret;
+}
+
+/**
+ * Moves the remaining partial chunk at the start of the buffer
+ * @param sep Separator source
+ */
+static void batch_compact(struct io_src_sep *sep)
+{
+	if (0 == sep->from)
+		return;
+
+	memmove(sep->buf, buf_read_start(sep), already_read(sep));
+	sep->up_to -= sep->from;
+	sep->scan_from -= sep->from;
+	sep->from = 0;
+}
+
+/**
+ * Sends what we have in a last batch, then notifies with an empty one
+ * @param sep Separator source
+ */
+static void batch_end_of_file(struct io_src_sep *sep)
+{
+	struct io_src_sep_chunk last = {
+		.data = buf_read_start(sep),
+		.len = already_read(sep),
+	};
+
+	if (0 != last.len) {
+		sep->notifying = true;
+		sep->batch_cb(sep, &last, 1);
+		if (notification_done(sep) < 0)
+			return;
+	}
+	sep->from = sep->up_to = sep->scan_from = 0;
+
+	sep->notifying = true;
+	sep->batch_cb(sep, sep->chunks, 0);
+	notification_done(sep);
+}
+
+/**
+ * Source callback for the batch mode, reads as much data as possible and
+ * notifies the client with all the chunks found
+ * @param src Underlying monitor source of the separator source
+ */
+static void sep_batch_cb(struct io_src *src)
+{
+	int ret;
+	ssize_t sret;
+	unsigned nb_chunks;
+	struct io_src_sep *sep = to_src_sep(src);
+
+	if (!io_src_has_in(src)) {
+		/* here, there must be an error, notify with no chunk */
+		sep->notifying = true;
+		sep->batch_cb(sep, sep->chunks, 0);
+		notification_done(sep);
+		return;
+	}
+
+	/*
+	 * after an allocation error, the buffer can be full of chunks not
+	 * consumed yet, reading 0 bytes would then be mistaken for an end of
+	 * file, so only retry to parse them
+	 */
+	if (0 != batch_to_read(sep)) {
+		sret = io_read(src->fd, buf_write_start(sep),
+				batch_to_read(sep));
+		if (sret < 0)
+			return;
+		if (0 == sret) {
+			batch_end_of_file(sep);
+			return;
+		}
+		/* cast is ok because sret just has been tested positive */
+		sep->up_to += (unsigned)sret;
+	}
+
+	/* on allocation error, the chunks left will be retried next event */
+	ret = batch_parse(sep, &nb_chunks);
+	if (0 > ret)
+		fprintf(stderr, "batch_parse: %s", strerror(-ret));
+	if (0 != nb_chunks) {
+		sep->notifying = true;
+		sep->batch_cb(sep, sep->chunks, nb_chunks);
+		if (notification_done(sep) < 0)
+			return;
+	}
+
+	batch_compact(sep);
+}
+
+/**
+ * Checks if the arguments common to the initialization functions are valid
+ * @param sep_src Separator source to initialize
+ * @param fd File descriptor
+ * @param delim Delimiter between the chunks of data
+ * @param delim_len Number of bytes of the delimiter
+ * @param size Maximum size of a chunk
+ * @return 1 if one argument at least is invalid, 0 otherwise
+ */
+static int init_args_are_invalid(struct io_src_sep *sep_src, int fd,
+		const char *delim, unsigned delim_len, unsigned size)
+{
+	return NULL == sep_src || -1 == fd || NULL == delim ||
+			0 == delim_len || delim_len >= size ||
+			size > (UINT_MAX - 1) / 2;
+}
+
+/**
+ * Allocates the buffers of a separator source and initializes it's underlying
+ * source
+ * @param sep_src Separator source, already checked and zeroed
+ * @param fd File descriptor
+ * @param delim Delimiter between the chunks of data
+ * @param delim_len Number of bytes of the delimiter
+ * @param size Maximum size of a chunk
+ * @param cb Callback of the underlying source
+ * @return Negative errno compatible value on error, 0 otherwise
+ */
+static int sep_init(struct io_src_sep *sep_src, int fd, const char *delim,
+		unsigned delim_len, unsigned size, io_src_cb *cb)
+{
+	int ret;
+
+	sep_src->size = size;
+	sep_src->delim_len = delim_len;
+	sep_src->delim = malloc(delim_len);
+	sep_src->buf = malloc(2 * size + 1);
+	if (NULL == sep_src->delim || NULL == sep_src->buf) {
+		ret = -ENOMEM;
+		goto err;
+	}
+	memcpy(sep_src->delim, delim, delim_len);
+
+	ret = io_src_init(&(sep_src->src), fd, IO_IN, cb);
+	if (0 != ret)
+		goto err;
+
+	return 0;
+err:
+	io_src_sep_clean(sep_src);
+
+	return ret;
+}
+
 int io_src_sep_init(struct io_src_sep *sep_src, int fd, io_src_sep_cb *cb,
 		int sep1, int sep2)
 {
+	int ret;
+	char delim[2];
+
 	if (sep1 != (char)sep1)
 		return -EINVAL;
 	if (sep2 != (char)sep2 && sep2 != IO_SRC_SEP_NO_SEP2)
 		return -EINVAL;
 
-	if (NULL == sep_src || NULL == cb || -1 == fd)
-		return -EINVAL;
-
-	memset(sep_src, 0, sizeof(*sep_src));
-
-	sep_src->cb = cb;
 	/*
 	 * both the two following casts are ok because the values have been
 	 * tested to be in range at the begining of the function
 	 */
-	sep_src->sep1 = (char)sep1;
+	delim[0] = (char)sep1;
+	delim[1] = (char)sep2;
+
+	ret = io_src_sep_init_delim(sep_src, fd, cb, delim,
+			IO_SRC_SEP_NO_SEP2 == sep2 ? 1 : 2, IO_SRC_SEP_SIZE);
+	if (0 != ret)
+		return ret;
+
+	/* kept for the clients of the former single or double byte api */
+	sep_src->sep1 = delim[0];
 	sep_src->two_bytes = IO_SRC_SEP_NO_SEP2 != sep2;
-	sep_src->sep2 = (char)(sep_src->two_bytes ? sep2 : '\0');
+	sep_src->sep2 = sep_src->two_bytes ? delim[1] : '\0';
+
+	return 0;
+}
+
+int io_src_sep_init_delim(struct io_src_sep *sep_src, int fd,
+		io_src_sep_cb *cb, const char *delim, unsigned delim_len,
+		unsigned size)
+{
+	if (init_args_are_invalid(sep_src, fd, delim, delim_len, size) ||
+			NULL == cb)
+		return -EINVAL;
+
+	memset(sep_src, 0, sizeof(*sep_src));
+	sep_src->cb = cb;
+
+	return sep_init(sep_src, fd, delim, delim_len, size, sep_cb);
+}
+
+int io_src_sep_init_batch(struct io_src_sep *sep_src, int fd,
+		io_src_sep_batch_cb *cb, const char *delim, unsigned delim_len,
+		unsigned size)
+{
+	if (init_args_are_invalid(sep_src, fd, delim, delim_len, size) ||
+			NULL == cb)
+		return -EINVAL;
 
-	/* can fail only on parameters */
-	return io_src_init(&(sep_src->src), fd, IO_IN, sep_cb);
+	memset(sep_src, 0, sizeof(*sep_src));
+	sep_src->batch_cb = cb;
+	sep_src->chunks_capacity = BATCH_INITIAL_CAPACITY;
+	sep_src->chunks = calloc(sep_src->chunks_capacity,
+			sizeof(*sep_src->chunks));
+	if (NULL == sep_src->chunks)
+		return -ENOMEM;
+
+	return sep_init(sep_src, fd, delim, delim_len, size, sep_batch_cb);
 }
 
 void io_src_sep_clean(struct io_src_sep *sep)
@@ -213,5 +509,16 @@ void io_src_sep_clean(struct io_src_sep *sep)
 	if (NULL == sep)
 		return;
 
+	/* the buffer is still in use by the code notifying the client */
+	if (sep->notifying) {
+		sep->clean_pending = true;
+		return;
+	}
+
 	io_src_clean(&(sep->src));
+	free(sep->chunks);
+	free(sep->buf);
+	free(sep->delim);
+	memset(sep, 0, sizeof(*sep));
+	sep->src.fd = -1;
 }
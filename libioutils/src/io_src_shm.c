@@ -0,0 +1,347 @@
+/**
+ * @file io_src_shm.c
+ * @date 19 oct. 2026
+ * @author nicolas.carrier@parrot.com
+ * @brief Source for receiving messages through a ring buffer in shared memory
+ *
+ * The memfd starts with the control block, on one page, followed by the
+ * buffer. The read and write indices run freely, the consumer publishes the
+ * read index and the producer the write index, with release stores. Each
+ * message is an 8 bytes header holding it's size, followed by it's content,
+ * padded to 8 bytes.
+ * The sleeping flag avoids lost wakeups without a system call per message: the
+ * consumer sets it, then checks the write index, the producer publishes the
+ * write index, then checks the flag, with a full barrier between the store and
+ * the load on both sides, so that at least one of them sees the other's store.
+ * The one which clears the flag writes the eventfd.
+ *
+ * Copyright (C) 2026 Parrot S.A.
+ */
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif /* _GNU_SOURCE */
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <errno.h>
+#include <string.h>
+
+#include <ut_utils.h>
+#include <ut_file.h>
+
+#include <io_utils.h>
+
+#include "io_src_shm.h"
+
+/**
+ * @def IO_SRC_SHM_MAGIC
+ * @brief First bytes of the control block, "IOSM" in little endian
+ */
+#define IO_SRC_SHM_MAGIC 0x4d534f49u
+
+/**
+ * @def IO_SRC_SHM_VERSION
+ * @brief Version of the layout of the ring
+ */
+#define IO_SRC_SHM_VERSION 1
+
+/**
+ * @def SHM_SEALS
+ * @brief Seals the memfd must have for it's mappings to be safe to access
+ */
+#define SHM_SEALS (F_SEAL_SHRINK | F_SEAL_GROW)
+
+/**
+ * @def HEADER_SIZE
+ * @brief Size of the header of a message
+ */
+#define HEADER_SIZE sizeof(uint64_t)
+
+/**
+ * @def to_src_shm
+ * @brief Convert a source to it's shared memory source container
+ */
+#define to_src_shm(p) ut_container_of(p, struct io_src_shm, src)
+
+struct io_src_shm_ctl {
+	/** IO_SRC_SHM_MAGIC */
+	uint32_t magic;
+	/** IO_SRC_SHM_VERSION */
+	uint32_t version;
+	/** size of the buffer */
+	uint64_t size;
+	/** read index, written by the consumer */
+	uint64_t read __attribute__((aligned(64)));
+	/** write index, written by the producer */
+	uint64_t write __attribute__((aligned(64)));
+	/** non-zero if the consumer waits for a notification */
+	uint32_t sleeping __attribute__((aligned(64)));
+};
+
+/**
+ * Returns the space a message takes in the ring
+ * @param len Size of the message, at most the size of the ring
+ * @return Size of the message, with it's header and padding
+ */
+static uint64_t record_size(uint64_t len)
+{
+	return HEADER_SIZE + ((len + 7) & ~(uint64_t)7);
+}
+
+/**
+ * Writes the eventfd, to wake the consumer up
+ * @param shm Shared memory source
+ * @return errno compatible negative value on error, 0 on success
+ */
+static int wake_up(struct io_src_shm *shm)
+{
+	uint64_t value = 1;
+
+	return -1 == io_write(shm->src.fd, &value, sizeof(value)) ? -errno : 0;
+}
+
+/**
+ * Maps the control block of a ring
+ * @param fd memfd of the ring
+ * @param page_size Size of a page, the size of the mapping
+ * @return Control block, NULL on error, with errno set
+ */
+static struct io_src_shm_ctl *map_ctl(int fd, size_t page_size)
+{
+	void *ctl;
+
+	ctl = mmap(NULL, page_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+
+	return MAP_FAILED == ctl ? NULL : ctl;
+}
+
+/**
+ * Notifies the messages published, then goes to sleep, unless the producer has
+ * published others meanwhile, in which case the source notifies itself, to
+ * process them at the next loop iteration, after the other sources
+ * @param src Underlying io_src of the shared memory source
+ */
+static void shm_cb(struct io_src *src)
+{
+	struct io_src_shm *shm = to_src_shm(src);
+	struct io_src_shm_ctl *ctl = shm->ctl;
+	const uint64_t *header;
+	uint64_t value;
+	uint64_t read;
+	uint64_t write;
+	uint64_t len;
+
+	/* resets the counter, whatever number of notifications */
+	io_read(src->fd, &value, sizeof(value));
+
+	read = ctl->read;
+	write = __atomic_load_n(&ctl->write, __ATOMIC_ACQUIRE);
+	if (write - read > shm->rb.size)
+		/* corrupted, drops everything */
+		read = write;
+	while (read != write) {
+		header = (const uint64_t *)((const char *)shm->rb.base +
+				(read & shm->rb.size_mask));
+		len = *header;
+		if (write - read < HEADER_SIZE || len > write - read ||
+				record_size(len) > write - read) {
+			read = write;
+			break;
+		}
+		shm->cb(shm, header + 1, len);
+		read += record_size(len);
+		/* the producer can reuse the space once it sees the index */
+		__atomic_store_n(&ctl->read, read, __ATOMIC_RELEASE);
+	}
+	__atomic_store_n(&ctl->read, read, __ATOMIC_RELEASE);
+
+	__atomic_store_n(&ctl->sleeping, 1, __ATOMIC_RELAXED);
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+	if (__atomic_load_n(&ctl->write, __ATOMIC_RELAXED) != read &&
+			__atomic_exchange_n(&ctl->sleeping, 0,
+					__ATOMIC_ACQ_REL))
+		wake_up(shm);
+}
+
+int io_src_shm_init(struct io_src_shm *shm, io_src_shm_cb *cb, size_t size)
+{
+	int ret;
+	int evt_fd;
+	size_t page_size = sysconf(_SC_PAGE_SIZE);
+
+	if (NULL == shm || NULL == cb || 0 == size)
+		return -EINVAL;
+
+	memset(shm, 0, sizeof(*shm));
+	shm->mem_fd = -1;
+	shm->src.fd = -1;
+	if ((size % page_size) != 0)
+		size = ((size / page_size) + 1) * page_size;
+
+	shm->mem_fd = memfd_create("io_src_shm", MFD_CLOEXEC |
+			MFD_ALLOW_SEALING);
+	if (-1 == shm->mem_fd)
+		return -errno;
+	if (-1 == ftruncate(shm->mem_fd, page_size + size) ||
+			-1 == fcntl(shm->mem_fd, F_ADD_SEALS, SHM_SEALS |
+					F_SEAL_SEAL)) {
+		ret = -errno;
+		goto err;
+	}
+	shm->ctl = map_ctl(shm->mem_fd, page_size);
+	if (NULL == shm->ctl) {
+		ret = -errno;
+		goto err;
+	}
+	ret = rs_rb_init_from_fd_at(&shm->rb, shm->mem_fd, page_size, size);
+	if (ret < 0)
+		goto err;
+	shm->ctl->magic = IO_SRC_SHM_MAGIC;
+	shm->ctl->version = IO_SRC_SHM_VERSION;
+	shm->ctl->size = size;
+	shm->ctl->sleeping = 1;
+
+	evt_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+	if (-1 == evt_fd) {
+		ret = -errno;
+		goto err;
+	}
+	shm->cb = cb;
+
+	/* can fail only on parameters */
+	return io_src_init(&shm->src, evt_fd, IO_IN, shm_cb);
+err:
+	io_src_shm_clean(shm);
+
+	return ret;
+}
+
+int io_src_shm_get_fds(const struct io_src_shm *shm, int *mem_fd,
+		int *evt_fd)
+{
+	if (NULL == shm || NULL == shm->cb || NULL == mem_fd || NULL == evt_fd)
+		return -EINVAL;
+
+	*mem_fd = shm->mem_fd;
+	*evt_fd = shm->src.fd;
+
+	return 0;
+}
+
+int io_src_shm_init_producer(struct io_src_shm *shm, int mem_fd, int evt_fd)
+{
+	int ret;
+	int seals;
+	struct stat st;
+	uint64_t size;
+	size_t page_size = sysconf(_SC_PAGE_SIZE);
+
+	if (NULL == shm || mem_fd < 0 || evt_fd < 0)
+		return -EINVAL;
+
+	memset(shm, 0, sizeof(*shm));
+	shm->mem_fd = -1;
+	shm->src.fd = -1;
+
+	/* the consumer can't truncate the ring under our feet */
+	seals = fcntl(mem_fd, F_GET_SEALS);
+	if (-1 == seals)
+		return -errno;
+	if ((seals & SHM_SEALS) != SHM_SEALS)
+		return -EPERM;
+	if (-1 == fstat(mem_fd, &st))
+		return -errno;
+	if ((uint64_t)st.st_size <= page_size)
+		return -EBADMSG;
+	shm->ctl = map_ctl(mem_fd, page_size);
+	if (NULL == shm->ctl)
+		return -errno;
+	/* read once, the consumer could change it meanwhile */
+	size = shm->ctl->size;
+	if (IO_SRC_SHM_MAGIC != shm->ctl->magic ||
+			IO_SRC_SHM_VERSION != shm->ctl->version ||
+			size != (uint64_t)st.st_size - page_size) {
+		ret = -EBADMSG;
+		goto err;
+	}
+	ret = rs_rb_init_from_fd_at(&shm->rb, mem_fd, page_size, size);
+	if (ret < 0)
+		goto err;
+	shm->read_cache = __atomic_load_n(&shm->ctl->read, __ATOMIC_ACQUIRE);
+
+	shm->src.fd = fcntl(evt_fd, F_DUPFD_CLOEXEC, 0);
+	if (-1 == shm->src.fd) {
+		ret = -errno;
+		goto err;
+	}
+
+	return 0;
+err:
+	io_src_shm_clean(shm);
+
+	return ret;
+}
+
+int io_src_shm_send(struct io_src_shm *shm, const void *msg, size_t len)
+{
+	struct io_src_shm_ctl *ctl;
+	uint64_t *header;
+	uint64_t write;
+	uint64_t needed;
+
+	if (NULL == shm || NULL != shm->cb || NULL == shm->ctl ||
+			(NULL == msg && 0 != len))
+		return -EINVAL;
+	ctl = shm->ctl;
+	if (len > shm->rb.size - HEADER_SIZE ||
+			record_size(len) > shm->rb.size)
+		return -EMSGSIZE;
+
+	needed = record_size(len);
+	write = ctl->write;
+	if (needed > shm->rb.size - (write - shm->read_cache)) {
+		shm->read_cache = __atomic_load_n(&ctl->read,
+				__ATOMIC_ACQUIRE);
+		if (write - shm->read_cache > shm->rb.size)
+			return -EBADMSG;
+		if (needed > shm->rb.size - (write - shm->read_cache))
+			return -EAGAIN;
+	}
+
+	/* thanks to the mirroring, the message is contiguous */
+	header = (uint64_t *)((char *)shm->rb.base +
+			(write & shm->rb.size_mask));
+	*header = len;
+	memcpy(header + 1, msg, len);
+	__atomic_store_n(&ctl->write, write + needed, __ATOMIC_RELEASE);
+
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+	if (__atomic_load_n(&ctl->sleeping, __ATOMIC_RELAXED) &&
+			__atomic_exchange_n(&ctl->sleeping, 0,
+					__ATOMIC_ACQ_REL))
+		return wake_up(shm);
+
+	return 0;
+}
+
+void io_src_shm_clean(struct io_src_shm *shm)
+{
+	if (NULL == shm)
+		return;
+
+	if (NULL != shm->rb.base)
+		rs_rb_clean(&shm->rb);
+	if (NULL != shm->ctl)
+		munmap(shm->ctl, sysconf(_SC_PAGE_SIZE));
+	shm->ctl = NULL;
+	ut_file_fd_close(&shm->mem_fd);
+	io_src_close_fd(&shm->src);
+	shm->cb = NULL;
+	shm->read_cache = 0;
+
+	io_src_clean(&shm->src);
+}
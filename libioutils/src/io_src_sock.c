@@ -0,0 +1,397 @@
+/**
+ * @file io_src_sock.c
+ * @date 19 oct. 2026
+ * @author nicolas.carrier@parrot.com
+ * @brief Sources for connection oriented sockets
+ *
+ * Copyright (C) 2026 Parrot S.A.
+ */
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif /* _GNU_SOURCE */
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+
+#include <stddef.h>
+#include <unistd.h>
+#include <fcntl.h>
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <stdio.h>
+
+#include <ut_utils.h>
+#include <ut_file.h>
+
+#include <io_utils.h>
+
+#include "io_platform.h"
+#include "io_mon.h"
+#include "io_src_sock.h"
+
+/**
+ * @def to_src_sock_listener
+ * @brief Convert a source to it's listener container
+ */
+#define to_src_sock_listener(p) ut_container_of(p, struct io_src_sock_listener, \
+		src)
+
+/**
+ * @def SOCK_ADDRESS_MAX
+ * @brief Maximum length of a formatted address, including the final '\0'
+ */
+#define SOCK_ADDRESS_MAX (sizeof(((struct sockaddr_un *)0)->sun_path) + 1)
+
+static bool type_is_invalid(enum io_src_sock_type type)
+{
+	return type != IO_SRC_SOCK_UNIX_STREAM &&
+			type != IO_SRC_SOCK_UNIX_SEQPACKET &&
+			type != IO_SRC_SOCK_TCP;
+}
+
+/**
+ * Fills a UNIX socket address, an address starting with a '@' is an abstract
+ * one
+ * @param address Address to parse
+ * @param addr In output, address parsed
+ * @param addr_len In output, length of the address parsed
+ * @return errno-compatible negative value on error, 0 otherwise
+ */
+static int unix_address(const char *address, struct sockaddr_storage *addr,
+		socklen_t *addr_len)
+{
+	struct sockaddr_un *sun = (struct sockaddr_un *)addr;
+	size_t len = strlen(address);
+
+	if (len >= sizeof(sun->sun_path))
+		return -ENAMETOOLONG;
+
+	sun->sun_family = AF_UNIX;
+	memcpy(sun->sun_path, address, len + 1);
+	if ('@' == *address) {
+		/* abstract names aren't null-terminated */
+		sun->sun_path[0] = '\0';
+		*addr_len = offsetof(struct sockaddr_un, sun_path) + len;
+	} else {
+		*addr_len = sizeof(*sun);
+	}
+
+	return 0;
+}
+
+/**
+ * Fills an IPv4 socket address, from a string of the form "a.b.c.d:port"
+ * @param address Address to parse
+ * @param addr In output, address parsed
+ * @param addr_len In output, length of the address parsed
+ * @return errno-compatible negative value on error, 0 otherwise
+ */
+static int tcp_address(char *address, struct sockaddr_storage *addr,
+		socklen_t *addr_len)
+{
+	struct sockaddr_in *sin = (struct sockaddr_in *)addr;
+	char *colon;
+	char *endptr;
+	unsigned long port;
+
+	colon = strrchr(address, ':');
+	if (NULL == colon || '\0' == colon[1])
+		return -EINVAL;
+	*colon = '\0';
+
+	errno = 0;
+	port = strtoul(colon + 1, &endptr, 10);
+	if (0 != errno || '\0' != *endptr || port > UINT16_MAX)
+		return -EINVAL;
+
+	sin->sin_family = AF_INET;
+	sin->sin_port = htons(port);
+	if (inet_pton(AF_INET, address, &sin->sin_addr) != 1)
+		return -EINVAL;
+	*addr_len = sizeof(*sin);
+
+	return 0;
+}
+
+/**
+ * Creates a socket of the given type and computes the address corresponding
+ * to the format string
+ * @param type Kind of socket
+ * @param addr In output, address
+ * @param addr_len In output, length of the address
+ * @param fmt Format of the address
+ * @param args Arguments of the format
+ * @return errno-compatible negative value on error, file descriptor of the
+ * socket otherwise
+ */
+static int sock_socket(enum io_src_sock_type type,
+		struct sockaddr_storage *addr, socklen_t *addr_len,
+		const char *fmt, va_list args)
+{
+	char address[SOCK_ADDRESS_MAX];
+	int sockfd;
+	int ret;
+
+	ret = vsnprintf(address, SOCK_ADDRESS_MAX, fmt, args);
+	if (ret < 0)
+		return -EINVAL;
+	if ((size_t)ret >= SOCK_ADDRESS_MAX)
+		return -ENAMETOOLONG;
+
+	memset(addr, 0, sizeof(*addr));
+	switch (type) {
+	case IO_SRC_SOCK_UNIX_STREAM:
+	case IO_SRC_SOCK_UNIX_SEQPACKET:
+		ret = unix_address(address, addr, addr_len);
+		break;
+
+	case IO_SRC_SOCK_TCP:
+		ret = tcp_address(address, addr, addr_len);
+		break;
+
+	default:
+		ret = -EINVAL;
+	}
+	if (ret < 0)
+		return ret;
+
+	sockfd = socket(addr->ss_family, (type == IO_SRC_SOCK_UNIX_SEQPACKET ?
+			SOCK_SEQPACKET : SOCK_STREAM) | SOCK_CLOEXEC, 0);
+	if (sockfd < 0)
+		return -errno;
+
+	return sockfd;
+}
+
+/**
+ * Disables Nagle's algorithm on TCP sockets, the io_io write context already
+ * coalesces the small writes
+ * @param type Kind of socket
+ * @param fd Socket
+ */
+static void set_no_delay(enum io_src_sock_type type, int fd)
+{
+	int one = 1;
+
+	if (type == IO_SRC_SOCK_TCP)
+		setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+}
+
+/**
+ * Opens the spare file descriptor of a listener
+ * @return File descriptor, or -1 with errno set on error
+ */
+static int open_reserve_fd(void)
+{
+	return open("/dev/null", O_RDONLY | O_CLOEXEC);
+}
+
+/**
+ * Called when no file descriptor is left to accept a connection. Releases the
+ * spare one to accept the first pending connection and closes it at once,
+ * otherwise it would stay in the backlog and the monitor would notify the
+ * listener again and again
+ * @param listener Listener source
+ * @return 0 if a connection has been dropped or if the peer gave up,
+ * errno-compatible negative value if none was pending or if the spare file
+ * descriptor isn't available
+ */
+static int drop_connection(struct io_src_sock_listener *listener)
+{
+	int fd;
+	int ret = 0;
+
+	if (-1 == listener->reserve_fd)
+		return -EMFILE;
+
+	ut_file_fd_close(&listener->reserve_fd);
+	fd = io_accept4(listener->src.fd, NULL, NULL, SOCK_CLOEXEC);
+	if (-1 == fd)
+		ret = errno == ECONNABORTED || errno == EPROTO ? 0 : -errno;
+	else
+		ut_file_fd_close(&fd);
+	/* if this fails, we'll retry next time fds are exhausted */
+	listener->reserve_fd = open_reserve_fd();
+
+	return ret;
+}
+
+/**
+ * Callback called when connections are pending on the listening socket, they
+ * are all accepted before returning to the monitor
+ * @param src Underlying io_src of the listener
+ */
+static void listener_cb(struct io_src *src)
+{
+	struct io_src_sock_listener *listener = to_src_sock_listener(src);
+	int fd;
+
+	if (io_src_has_error(src))
+		return; /* the monitor will remove the source */
+
+	while (true) {
+		fd = io_accept4(src->fd, NULL, NULL,
+				SOCK_NONBLOCK | SOCK_CLOEXEC);
+		if (-1 == fd) {
+			/* the peer gave up before being accepted, try next */
+			if (errno == ECONNABORTED || errno == EPROTO)
+				continue;
+			/* no fd left, refuse the connections pending */
+			if ((errno == EMFILE || errno == ENFILE) &&
+					drop_connection(listener) == 0)
+				continue;
+			/*
+			 * EAGAIN means we're done, for other errors, we can't
+			 * do better than waiting for the next notification
+			 */
+			return;
+		}
+		set_no_delay(listener->type, fd);
+
+		listener->cb(listener, fd);
+	}
+}
+
+int io_src_sock_listener_init(struct io_src_sock_listener *listener,
+		enum io_src_sock_type type, io_src_sock_accept_cb *cb,
+		const char *fmt, ...)
+{
+	int sockfd;
+	int ret;
+	int one = 1;
+	va_list args;
+
+	if (NULL == listener || type_is_invalid(type) || NULL == cb ||
+			NULL == fmt || '\0' == *fmt)
+		return -EINVAL;
+
+	memset(listener, 0, sizeof(*listener));
+
+	va_start(args, fmt);
+	sockfd = sock_socket(type, &listener->addr, &listener->addr_len, fmt,
+			args);
+	va_end(args);
+	if (sockfd < 0)
+		return sockfd;
+
+	if (type == IO_SRC_SOCK_TCP)
+		setsockopt(sockfd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+
+	ret = bind(sockfd, (struct sockaddr *)&listener->addr,
+			listener->addr_len);
+	if (ret < 0)
+		goto err;
+	ret = listen(sockfd, SOMAXCONN);
+	if (ret < 0)
+		goto err;
+
+	listener->reserve_fd = open_reserve_fd();
+	if (-1 == listener->reserve_fd)
+		goto err;
+
+	listener->type = type;
+	listener->cb = cb;
+
+	/* can fail only on parameters */
+	return io_src_init(&listener->src, sockfd, IO_IN, listener_cb);
+err:
+	ret = -errno;
+	ut_file_fd_close(&sockfd);
+
+	return ret;
+}
+
+int io_src_sock_get_port(struct io_src_sock_listener *listener)
+{
+	struct sockaddr_in sin;
+	socklen_t len = sizeof(sin);
+
+	if (NULL == listener || listener->type != IO_SRC_SOCK_TCP)
+		return -EINVAL;
+
+	if (getsockname(listener->src.fd, (struct sockaddr *)&sin, &len) < 0)
+		return -errno;
+
+	return ntohs(sin.sin_port);
+}
+
+void io_src_sock_listener_clean(struct io_src_sock_listener *listener)
+{
+	struct sockaddr_un *sun;
+
+	if (NULL == listener)
+		return;
+
+	io_src_close_fd(&listener->src);
+	ut_file_fd_close(&listener->reserve_fd);
+	sun = (struct sockaddr_un *)&listener->addr;
+	if (listener->type != IO_SRC_SOCK_TCP && '\0' != sun->sun_path[0])
+		unlink(sun->sun_path);
+	io_src_clean(&listener->src);
+	memset(listener, 0, sizeof(*listener));
+}
+
+int io_src_sock_connect(enum io_src_sock_type type, const char *fmt, ...)
+{
+	struct sockaddr_storage addr;
+	socklen_t addr_len;
+	int sockfd;
+	int ret;
+	va_list args;
+
+	if (type_is_invalid(type) || NULL == fmt || '\0' == *fmt)
+		return -EINVAL;
+
+	va_start(args, fmt);
+	sockfd = sock_socket(type, &addr, &addr_len, fmt, args);
+	va_end(args);
+	if (sockfd < 0)
+		return sockfd;
+
+	ret = TEMP_FAILURE_RETRY(connect(sockfd, (struct sockaddr *)&addr,
+			addr_len));
+	if (ret < 0)
+		goto err;
+	ret = io_set_non_blocking(sockfd);
+	if (ret < 0)
+		goto err;
+	set_no_delay(type, sockfd);
+
+	return sockfd;
+err:
+	ret = -errno;
+	ut_file_fd_close(&sockfd);
+
+	return ret;
+}
+
+int io_src_sock_conn_init(struct io_src_sock_conn *conn, struct io_mon *mon,
+		const char *name, int fd)
+{
+	int ret;
+
+	if (NULL == conn || fd < 0)
+		return -EINVAL;
+
+	ret = io_io_init(&conn->io, mon, name, fd, fd, 0);
+	if (ret < 0)
+		return ret;
+	conn->fd = fd;
+
+	return 0;
+}
+
+void io_src_sock_conn_clean(struct io_src_sock_conn *conn)
+{
+	if (NULL == conn)
+		return;
+
+	io_io_clean(&conn->io);
+	ut_file_fd_close(&conn->fd);
+}
@@ -0,0 +1,329 @@
+/**
+ * @file io_src_thread_pool.c
+ * @date 19 oct. 2026
+ * @author nicolas.carrier@parrot.com
+ * @brief Fixed size pool of worker threads, running blocking jobs on behalf of
+ * an event loop
+ *
+ * Each worker has it's own queue, protected by it's own mutex, the jobs are
+ * dispatched in a round-robin manner and a worker whose queue is empty steals
+ * the oldest job of the others' queues. Workers with nothing to do sleep on the
+ * pool's condition variable, the number of jobs queued tells them whether it is
+ * worth it.
+ * The completed jobs are pushed by the workers on a lock-free stack, only the
+ * push onto an empty stack notifies the eventfd, the monitor's thread takes the
+ * whole stack at once, after the eventfd has been read.
+ *
+ * Copyright (C) 2026 Parrot S.A.
+ */
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif /* _GNU_SOURCE */
+#include <unistd.h>
+
+#include <errno.h>
+#include <string.h>
+#include <stdlib.h>
+
+#include <ut_utils.h>
+
+#include <io_src_thread_pool.h>
+
+/**
+ * @struct thread_pool_worker
+ * @brief worker thread, with it's own queue of jobs
+ */
+struct thread_pool_worker {
+	/** the very thread */
+	pthread_t thread;
+	/** true iif the pthread_create call has succeeded */
+	bool started;
+	/** protects the queue */
+	pthread_mutex_t lock;
+	/** first job of the queue, the next to run */
+	struct io_src_thread_pool_job *head;
+	/** last job of the queue */
+	struct io_src_thread_pool_job *tail;
+	/** pool the worker belongs to */
+	struct io_src_thread_pool *pool;
+	/** index of the worker in the pool */
+	unsigned index;
+};
+
+/**
+ * Removes the first job of a worker's queue
+ * @param worker Worker
+ * @return job removed, NULL if the queue was empty
+ */
+static struct io_src_thread_pool_job *worker_pop(
+		struct thread_pool_worker *worker)
+{
+	struct io_src_thread_pool_job *job;
+
+	pthread_mutex_lock(&worker->lock);
+	job = worker->head;
+	if (job != NULL) {
+		worker->head = job->next;
+		if (worker->head == NULL)
+			worker->tail = NULL;
+	}
+	pthread_mutex_unlock(&worker->lock);
+
+	return job;
+}
+
+/**
+ * Appends a job to a worker's queue
+ * @param worker Worker
+ * @param job Job to append
+ */
+static void worker_push(struct thread_pool_worker *worker,
+		struct io_src_thread_pool_job *job)
+{
+	job->next = NULL;
+	pthread_mutex_lock(&worker->lock);
+	if (worker->tail == NULL)
+		worker->head = job;
+	else
+		worker->tail->next = job;
+	worker->tail = job;
+	pthread_mutex_unlock(&worker->lock);
+}
+
+/**
+ * Takes the next job a worker must run, from it's own queue, or stolen from
+ * the queue of another worker
+ * @param worker Worker
+ * @return job taken, NULL if no job is queued
+ */
+static struct io_src_thread_pool_job *take_job(
+		struct thread_pool_worker *worker)
+{
+	struct io_src_thread_pool *pool = worker->pool;
+	struct io_src_thread_pool_job *job;
+	unsigned i;
+
+	job = worker_pop(worker);
+	for (i = 1; job == NULL && i < pool->nb_workers; i++)
+		job = worker_pop(pool->workers +
+				(worker->index + i) % pool->nb_workers);
+	if (job != NULL)
+		__atomic_sub_fetch(&pool->nb_queued, 1, __ATOMIC_RELAXED);
+
+	return job;
+}
+
+/**
+ * Pushes a completed job on the lock-free stack and notifies the monitor's
+ * thread, if the stack was empty
+ * @param pool Thread pool
+ * @param job Job completed
+ */
+static void push_completed(struct io_src_thread_pool *pool,
+		struct io_src_thread_pool_job *job)
+{
+	struct io_src_thread_pool_job *head;
+
+	head = __atomic_load_n(&pool->completed, __ATOMIC_RELAXED);
+	do
+		job->next = head;
+	while (!__atomic_compare_exchange_n(&pool->completed, &head, job, true,
+			__ATOMIC_RELEASE, __ATOMIC_RELAXED));
+
+	/* otherwise, the monitor's thread has yet to take the stack */
+	if (head == NULL)
+		io_src_evt_notify(&pool->evt, 1);
+}
+
+/**
+ * Main function of the worker threads
+ * @param arg worker
+ */
+static void *worker_routine(void *arg)
+{
+	struct thread_pool_worker *worker = arg;
+	struct io_src_thread_pool *pool = worker->pool;
+	struct io_src_thread_pool_job *job;
+
+	/* once stopped, the jobs still queued are left for cancellation */
+	while (!__atomic_load_n(&pool->stop, __ATOMIC_RELAXED)) {
+		job = take_job(worker);
+		if (job != NULL) {
+			job->ret = job->work(job);
+			push_completed(pool, job);
+			continue;
+		}
+
+		pthread_mutex_lock(&pool->lock);
+		while (!pool->stop && __atomic_load_n(&pool->nb_queued,
+				__ATOMIC_RELAXED) == 0)
+			pthread_cond_wait(&pool->cond, &pool->lock);
+		pthread_mutex_unlock(&pool->lock);
+	}
+
+	return NULL;
+}
+
+/**
+ * Notifies the completion of the jobs taken from the lock-free stack, in the
+ * order of their completion
+ * @param pool Thread pool
+ */
+static void notify_completed(struct io_src_thread_pool *pool)
+{
+	struct io_src_thread_pool_job *job;
+	struct io_src_thread_pool_job *next;
+	struct io_src_thread_pool_job *fifo = NULL;
+
+	job = __atomic_exchange_n(&pool->completed, NULL, __ATOMIC_ACQUIRE);
+	for (; job != NULL; job = next) {
+		next = job->next;
+		job->next = fifo;
+		fifo = job;
+	}
+
+	for (job = fifo; job != NULL; job = next) {
+		next = job->next;
+		pool->nb_pending--;
+		job->done(job, job->ret);
+	}
+}
+
+/**
+ * Callback notified via the event source, of when jobs have completed
+ * @param evt event fd source
+ * @param value discarded
+ */
+static void thread_pool_cb(struct io_src_evt *evt, uint64_t value)
+{
+	notify_completed(ut_container_of(evt, struct io_src_thread_pool, evt));
+}
+
+int io_src_thread_pool_init(struct io_src_thread_pool *pool,
+		struct io_mon *mon, unsigned nb_workers)
+{
+	int ret;
+	long nb_cpus;
+	unsigned i;
+	struct thread_pool_worker *worker;
+
+	if (pool == NULL || mon == NULL)
+		return -EINVAL;
+
+	memset(pool, 0, sizeof(*pool));
+	if (nb_workers == 0) {
+		nb_cpus = sysconf(_SC_NPROCESSORS_ONLN);
+		nb_workers = nb_cpus > 0 ? nb_cpus : 1;
+	}
+
+	ret = io_src_evt_init(&pool->evt, thread_pool_cb, false, 0);
+	if (ret < 0)
+		return ret;
+	pthread_mutex_init(&pool->lock, NULL);
+	pthread_cond_init(&pool->cond, NULL);
+
+	pool->workers = calloc(nb_workers, sizeof(*pool->workers));
+	if (pool->workers == NULL) {
+		ret = -errno;
+		goto err;
+	}
+	pool->nb_workers = nb_workers;
+	for (i = 0; i < nb_workers; i++) {
+		worker = pool->workers + i;
+		pthread_mutex_init(&worker->lock, NULL);
+		worker->pool = pool;
+		worker->index = i;
+	}
+	for (i = 0; i < nb_workers; i++) {
+		worker = pool->workers + i;
+		ret = pthread_create(&worker->thread, NULL, worker_routine,
+				worker);
+		if (ret != 0) {
+			ret = -ret;
+			goto err;
+		}
+		worker->started = true;
+	}
+
+	ret = io_mon_add_source(mon, io_src_thread_pool_get_source(pool));
+	if (ret < 0)
+		goto err;
+	pool->mon = mon;
+
+	return 0;
+err:
+	io_src_thread_pool_clean(pool);
+
+	return ret;
+}
+
+int io_src_thread_pool_submit(struct io_src_thread_pool *pool,
+		struct io_src_thread_pool_job *job,
+		io_src_thread_pool_work *work,
+		io_src_thread_pool_done_cb *done)
+{
+	struct thread_pool_worker *worker;
+
+	if (pool == NULL || pool->workers == NULL || job == NULL ||
+			work == NULL || done == NULL)
+		return -EINVAL;
+
+	job->work = work;
+	job->done = done;
+	job->ret = 0;
+	worker = pool->workers + pool->next_worker;
+	pool->next_worker = (pool->next_worker + 1) % pool->nb_workers;
+	pool->nb_pending++;
+
+	/*
+	 * counted before being visible, or the job could be taken and
+	 * nb_queued decremented below 0 in between
+	 */
+	pthread_mutex_lock(&pool->lock);
+	__atomic_add_fetch(&pool->nb_queued, 1, __ATOMIC_RELAXED);
+	worker_push(worker, job);
+	pthread_cond_signal(&pool->cond);
+	pthread_mutex_unlock(&pool->lock);
+
+	return 0;
+}
+
+void io_src_thread_pool_clean(struct io_src_thread_pool *pool)
+{
+	unsigned i;
+	struct thread_pool_worker *worker;
+	struct io_src_thread_pool_job *job;
+
+	if (pool == NULL)
+		return;
+
+	pthread_mutex_lock(&pool->lock);
+	/* read without the lock by the workers, before taking a job */
+	__atomic_store_n(&pool->stop, true, __ATOMIC_RELAXED);
+	pthread_cond_broadcast(&pool->cond);
+	pthread_mutex_unlock(&pool->lock);
+	for (i = 0; i < pool->nb_workers; i++)
+		if (pool->workers[i].started)
+			pthread_join(pool->workers[i].thread, NULL);
+
+	/* the jobs which have run, then those which couldn't */
+	notify_completed(pool);
+	for (i = 0; i < pool->nb_workers; i++) {
+		worker = pool->workers + i;
+		while ((job = worker_pop(worker)) != NULL) {
+			pool->nb_pending--;
+			job->done(job, -ECANCELED);
+		}
+		pthread_mutex_destroy(&worker->lock);
+	}
+	free(pool->workers);
+
+	if (pool->mon != NULL)
+		io_mon_remove_source(pool->mon,
+				io_src_thread_pool_get_source(pool));
+	io_src_evt_clean(&pool->evt);
+	pthread_cond_destroy(&pool->cond);
+	pthread_mutex_destroy(&pool->lock);
+
+	memset(pool, 0, sizeof(*pool));
+}
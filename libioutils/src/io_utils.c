@@ -48,6 +48,25 @@ ssize_t io_sendto(int sockfd, const void *buf, size_t len, int flags,
 			addrlen));
 }
 
+int io_recvmmsg(int sockfd, struct mmsghdr *msgvec, unsigned int vlen,
+		int flags, struct timespec *timeout)
+{
+	return TEMP_FAILURE_RETRY(recvmmsg(sockfd, msgvec, vlen, flags,
+			timeout));
+}
+
+int io_sendmmsg(int sockfd, struct mmsghdr *msgvec, unsigned int vlen,
+		int flags)
+{
+	return TEMP_FAILURE_RETRY(sendmmsg(sockfd, msgvec, vlen, flags));
+}
+
+int io_accept4(int sockfd, struct sockaddr *addr, socklen_t *addrlen,
+		int flags)
+{
+	return TEMP_FAILURE_RETRY(accept4(sockfd, addr, addrlen, flags));
+}
+
 pid_t io_waitpid(pid_t pid, int *status, int options)
 {
 	return TEMP_FAILURE_RETRY(waitpid(pid, status, options));
@@ -20,17 +20,22 @@ const char io_interp[] __attribute__((section(".interp"))) =
 		FUSION_INTERPRETER;
 
 struct suite_t *libioutils_test_suites[] = {
+		&frame_suite,
 		&io_suite,
 		&mon_suite,
 		&process_suite,
+		&src_fanotify_suite,
 		&src_inot_suite,
 		&src_msg_suite,
 		&src_msg_uad_suite,
 		&src_pid_suite,
 		&src_sep_suite,
+		&src_shm_suite,
 		&src_sig_suite,
+		&src_sock_suite,
 		&src_suite,
 		&src_tmr_suite,
+		&src_thread_pool_suite,
 		&utils_suite,
 
 		NULL, /* NULL guard */
@@ -38,17 +43,22 @@ struct suite_t *libioutils_test_suites[] = {
 
 static void libioutils_pool_initializer(void)
 {
+	FAUTES_GET_ACTIVE_STATE_FROM_ENVIRONMENT(frame_suite);
 	FAUTES_GET_ACTIVE_STATE_FROM_ENVIRONMENT(io_suite);
 	FAUTES_GET_ACTIVE_STATE_FROM_ENVIRONMENT(mon_suite);
 	FAUTES_GET_ACTIVE_STATE_FROM_ENVIRONMENT(process_suite);
+	FAUTES_GET_ACTIVE_STATE_FROM_ENVIRONMENT(src_fanotify_suite);
 	FAUTES_GET_ACTIVE_STATE_FROM_ENVIRONMENT(src_inot_suite);
 	FAUTES_GET_ACTIVE_STATE_FROM_ENVIRONMENT(src_msg_suite);
 	FAUTES_GET_ACTIVE_STATE_FROM_ENVIRONMENT(src_msg_uad_suite);
 	FAUTES_GET_ACTIVE_STATE_FROM_ENVIRONMENT(src_pid_suite);
 	FAUTES_GET_ACTIVE_STATE_FROM_ENVIRONMENT(src_sep_suite);
+	FAUTES_GET_ACTIVE_STATE_FROM_ENVIRONMENT(src_shm_suite);
 	FAUTES_GET_ACTIVE_STATE_FROM_ENVIRONMENT(src_sig_suite);
+	FAUTES_GET_ACTIVE_STATE_FROM_ENVIRONMENT(src_sock_suite);
 	FAUTES_GET_ACTIVE_STATE_FROM_ENVIRONMENT(src_suite);
 	FAUTES_GET_ACTIVE_STATE_FROM_ENVIRONMENT(src_tmr_suite);
+	FAUTES_GET_ACTIVE_STATE_FROM_ENVIRONMENT(src_thread_pool_suite);
 	FAUTES_GET_ACTIVE_STATE_FROM_ENVIRONMENT(utils_suite);
 }
 
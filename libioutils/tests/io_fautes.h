@@ -10,17 +10,22 @@
 #ifndef IO_FAUTES_H_
 #define IO_FAUTES_H_
 
+extern struct suite_t frame_suite;
 extern struct suite_t io_suite;
 extern struct suite_t mon_suite;
 extern struct suite_t process_suite;
+extern struct suite_t src_fanotify_suite;
 extern struct suite_t src_inot_suite;
 extern struct suite_t src_msg_suite;
 extern struct suite_t src_msg_uad_suite;
 extern struct suite_t src_pid_suite;
 extern struct suite_t src_sep_suite;
+extern struct suite_t src_shm_suite;
 extern struct suite_t src_sig_suite;
+extern struct suite_t src_sock_suite;
 extern struct suite_t src_suite;
 extern struct suite_t src_tmr_suite;
+extern struct suite_t src_thread_pool_suite;
 extern struct suite_t utils_suite;
 
 /**
@@ -0,0 +1,353 @@
+/**
+ * @file io_frame_test.c
+ * @date 19 oct. 2026
+ * @author nicolas.carrier@parrot.com
+ * @brief Unit tests for the framing engine
+ *
+ * Copyright (C) 2026 Parrot S.A.
+ */
+#include <sys/socket.h>
+
+#include <unistd.h>
+
+#include <stdbool.h>
+#include <string.h>
+
+#include <CUnit/Basic.h>
+
+#include <ut_utils.h>
+#include <ut_file.h>
+
+#include <rs_rb.h>
+
+#include <io_frame.h>
+#include <io_mon.h>
+#include <io_io.h>
+#include <io_utils.h>
+
+#include <fautes.h>
+#include <fautes_utils.h>
+
+#define MAX_FRAMES 8
+
+struct my_frame {
+	struct io_frame frame;
+	unsigned nb_frames;
+	uint64_t tags[MAX_FRAMES];
+	char payloads[MAX_FRAMES][64];
+	size_t lens[MAX_FRAMES];
+	bool eof;
+	int stop;
+};
+
+static int frame_cb(struct io_frame *frame, uint64_t tag, const void *payload,
+		size_t len)
+{
+	struct my_frame *my_frame = ut_container_of(frame, struct my_frame,
+			frame);
+
+	if (NULL == payload) {
+		my_frame->eof = true;
+		return 0;
+	}
+	CU_ASSERT_FATAL(my_frame->nb_frames < MAX_FRAMES);
+	CU_ASSERT_FATAL(len < sizeof(my_frame->payloads[0]));
+	my_frame->tags[my_frame->nb_frames] = tag;
+	my_frame->lens[my_frame->nb_frames] = len;
+	memcpy(my_frame->payloads[my_frame->nb_frames], payload, len);
+	my_frame->payloads[my_frame->nb_frames][len] = '\0';
+	my_frame->nb_frames++;
+
+	return my_frame->stop;
+}
+
+static void rb_feed(struct rs_rb *rb, const void *data, size_t len)
+{
+	CU_ASSERT_FATAL(rs_rb_get_write_length(rb) >= len);
+	memcpy(rs_rb_get_write_ptr(rb), data, len);
+	rs_rb_write_incr(rb, len);
+}
+
+static void testFRAME_INIT_LENGTH(void)
+{
+	int ret;
+	struct rs_rb rb;
+	struct my_frame my_frame;
+	/* 1 byte type, 2 bytes big endian length of the payload */
+	static const char stream[] = "\x01\x00\x05hello\x02\x00\x05world";
+
+	memset(&my_frame, 0, sizeof(my_frame));
+	ret = rs_rb_init(&rb, NULL, 0x1000);
+	CU_ASSERT_EQUAL_FATAL(ret, 0);
+	ret = io_frame_init_length(&my_frame.frame, frame_cb, 3, 1, 2,
+			IO_FRAME_BIG_ENDIAN, false);
+	CU_ASSERT_EQUAL_FATAL(ret, 0);
+
+	/* normal use cases */
+	/* frames split at every possible position */
+	rb_feed(&rb, stream, 2);
+	CU_ASSERT_EQUAL(io_frame_process(&my_frame.frame, &rb), 0);
+	CU_ASSERT_EQUAL(my_frame.nb_frames, 0);
+	rb_feed(&rb, stream + 2, 9);
+	CU_ASSERT_EQUAL(io_frame_process(&my_frame.frame, &rb), 0);
+	CU_ASSERT_EQUAL(my_frame.nb_frames, 1);
+	rb_feed(&rb, stream + 11, sizeof(stream) - 1 - 11);
+	CU_ASSERT_EQUAL(io_frame_process(&my_frame.frame, &rb), 0);
+	CU_ASSERT_EQUAL(my_frame.nb_frames, 2);
+	CU_ASSERT_STRING_EQUAL(my_frame.payloads[0], "hello");
+	CU_ASSERT_STRING_EQUAL(my_frame.payloads[1], "world");
+	CU_ASSERT_EQUAL(rs_rb_get_read_length(&rb), 0);
+
+	/* the frame is contiguous, even when it wraps in the ring buffer */
+	rs_rb_write_incr(&rb, 0xFFE);
+	rs_rb_read_incr(&rb, 0xFFE);
+	rb_feed(&rb, stream, 8);
+	CU_ASSERT_EQUAL(io_frame_process(&my_frame.frame, &rb), 0);
+	CU_ASSERT_EQUAL(my_frame.nb_frames, 3);
+	CU_ASSERT_STRING_EQUAL(my_frame.payloads[2], "hello");
+
+	/* frames too big for the ring buffer are dropped */
+	rb_feed(&rb, "\x03\xff\xff", 3);
+	rb_feed(&rb, stream, 8);
+	CU_ASSERT_EQUAL(io_frame_process(&my_frame.frame, &rb), 0);
+	CU_ASSERT_EQUAL(my_frame.frame.nb_dropped, 1);
+	CU_ASSERT_EQUAL(my_frame.nb_frames, 3);
+	CU_ASSERT_EQUAL(rs_rb_get_read_length(&rb), 0);
+	for (ret = 0; ret < 0xFFFF - 8; ret += 0x100) {
+		rb_feed(&rb, my_frame.payloads, MIN(0x100, 0xFFFF - 8 - ret));
+		CU_ASSERT_EQUAL(io_frame_process(&my_frame.frame, &rb), 0);
+	}
+	rb_feed(&rb, stream + 8, sizeof(stream) - 1 - 8);
+	CU_ASSERT_EQUAL(io_frame_process(&my_frame.frame, &rb), 0);
+	CU_ASSERT_EQUAL(my_frame.nb_frames, 4);
+	CU_ASSERT_STRING_EQUAL(my_frame.payloads[3], "world");
+
+	/* the callback can stop the parsing */
+	my_frame.stop = 1;
+	rb_feed(&rb, stream, sizeof(stream) - 1);
+	CU_ASSERT_EQUAL(io_frame_process(&my_frame.frame, &rb), 1);
+	CU_ASSERT_EQUAL(my_frame.nb_frames, 5);
+	CU_ASSERT_EQUAL(io_frame_process(&my_frame.frame, &rb), 1);
+	CU_ASSERT_EQUAL(my_frame.nb_frames, 6);
+	/* a negative value isn't mistaken for an error */
+	my_frame.stop = -EIO;
+	rb_feed(&rb, stream, sizeof(stream) - 1);
+	CU_ASSERT_EQUAL(io_frame_process(&my_frame.frame, &rb), 1);
+	CU_ASSERT_EQUAL(my_frame.nb_frames, 7);
+	my_frame.stop = 0;
+	CU_ASSERT_EQUAL(io_frame_process(&my_frame.frame, &rb), 0);
+	CU_ASSERT_EQUAL(my_frame.nb_frames, 8);
+	io_frame_clean(&my_frame.frame);
+
+	/* little endian, 4 bytes length counting the header */
+	memset(&my_frame, 0, sizeof(my_frame));
+	ret = io_frame_init_length(&my_frame.frame, frame_cb, 4, 0, 4,
+			IO_FRAME_LITTLE_ENDIAN, true);
+	CU_ASSERT_EQUAL_FATAL(ret, 0);
+	rb_feed(&rb, "\x07\x00\x00\x00" "abc" "\x04\x00\x00\x00", 11);
+	CU_ASSERT_EQUAL(io_frame_process(&my_frame.frame, &rb), 0);
+	CU_ASSERT_EQUAL(my_frame.nb_frames, 2);
+	CU_ASSERT_STRING_EQUAL(my_frame.payloads[0], "abc");
+	CU_ASSERT_EQUAL(my_frame.lens[1], 0);
+	io_frame_clean(&my_frame.frame);
+
+	/* error cases */
+	ret = io_frame_init_length(NULL, frame_cb, 3, 1, 2,
+			IO_FRAME_BIG_ENDIAN, false);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+	ret = io_frame_init_length(&my_frame.frame, NULL, 3, 1, 2,
+			IO_FRAME_BIG_ENDIAN, false);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+	ret = io_frame_init_length(&my_frame.frame, frame_cb, 3, 1, 3,
+			IO_FRAME_BIG_ENDIAN, false);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+	ret = io_frame_init_length(&my_frame.frame, frame_cb, 3, 2, 2,
+			IO_FRAME_BIG_ENDIAN, false);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+	ret = io_frame_init_length(&my_frame.frame, frame_cb, 3, 1, 2, 42,
+			false);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+	CU_ASSERT_EQUAL(io_frame_process(NULL, &rb), -EINVAL);
+
+	rs_rb_clean(&rb);
+}
+
+static void testFRAME_INIT_DELIM(void)
+{
+	int ret;
+	struct rs_rb rb;
+	struct my_frame my_frame;
+
+	memset(&my_frame, 0, sizeof(my_frame));
+	ret = rs_rb_init(&rb, NULL, 0x1000);
+	CU_ASSERT_EQUAL_FATAL(ret, 0);
+	ret = io_frame_init_delim(&my_frame.frame, frame_cb, "\r\n", 2,
+			0x1000);
+	CU_ASSERT_EQUAL_FATAL(ret, 0);
+
+	/* normal use cases */
+	/* delimiter split between two reads */
+	rb_feed(&rb, "GET / HTTP/1.1\r", 15);
+	CU_ASSERT_EQUAL(io_frame_process(&my_frame.frame, &rb), 0);
+	CU_ASSERT_EQUAL(my_frame.nb_frames, 0);
+	rb_feed(&rb, "\nHost: x\r\n\r\n", 12);
+	CU_ASSERT_EQUAL(io_frame_process(&my_frame.frame, &rb), 0);
+	CU_ASSERT_EQUAL(my_frame.nb_frames, 3);
+	CU_ASSERT_STRING_EQUAL(my_frame.payloads[0], "GET / HTTP/1.1");
+	CU_ASSERT_STRING_EQUAL(my_frame.payloads[1], "Host: x");
+	CU_ASSERT_EQUAL(my_frame.lens[2], 0);
+	CU_ASSERT_EQUAL(rs_rb_get_read_length(&rb), 0);
+
+	/*
+	 * a full buffer without delimiter is dropped, up to the next delimiter,
+	 * which may start in it's last byte
+	 */
+	memset(rs_rb_get_write_ptr(&rb), 'a', 0x1000);
+	((char *)rs_rb_get_write_ptr(&rb))[0xfff] = '\r';
+	rs_rb_write_incr(&rb, 0x1000);
+	CU_ASSERT_EQUAL(io_frame_process(&my_frame.frame, &rb), 0);
+	CU_ASSERT_EQUAL(my_frame.frame.nb_dropped, 1);
+	CU_ASSERT_EQUAL(rs_rb_get_read_length(&rb), 1);
+	rb_feed(&rb, "\nok\r\n", 5);
+	CU_ASSERT_EQUAL(io_frame_process(&my_frame.frame, &rb), 0);
+	CU_ASSERT_EQUAL(my_frame.nb_frames, 4);
+	CU_ASSERT_STRING_EQUAL(my_frame.payloads[3], "ok");
+
+	/* the tail of a frame longer than the buffer isn't notified */
+	memset(rs_rb_get_write_ptr(&rb), 'a', 0x1000);
+	rs_rb_write_incr(&rb, 0x1000);
+	CU_ASSERT_EQUAL(io_frame_process(&my_frame.frame, &rb), 0);
+	CU_ASSERT_EQUAL(my_frame.frame.nb_dropped, 2);
+	rb_feed(&rb, "aaaa", 4);
+	CU_ASSERT_EQUAL(io_frame_process(&my_frame.frame, &rb), 0);
+	rb_feed(&rb, "aa\r\nvalid\r\n", 11);
+	CU_ASSERT_EQUAL(io_frame_process(&my_frame.frame, &rb), 0);
+	CU_ASSERT_EQUAL(my_frame.frame.nb_dropped, 2);
+	CU_ASSERT_EQUAL(my_frame.nb_frames, 5);
+	CU_ASSERT_STRING_EQUAL(my_frame.payloads[4], "valid");
+	CU_ASSERT_EQUAL(rs_rb_get_read_length(&rb), 0);
+
+	/* error cases */
+	io_frame_clean(&my_frame.frame);
+	ret = io_frame_init_delim(&my_frame.frame, frame_cb, "\r\n", 0,
+			0x1000);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+	ret = io_frame_init_delim(&my_frame.frame, frame_cb, NULL, 2, 0x1000);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+	/* the delimiter couldn't be found after an oversized frame */
+	ret = io_frame_init_delim(&my_frame.frame, frame_cb, "\r\n", 2, 2);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+
+	rs_rb_clean(&rb);
+}
+
+static void testFRAME_INIT_TLV(void)
+{
+	int ret;
+	struct rs_rb rb;
+	struct my_frame my_frame;
+
+	memset(&my_frame, 0, sizeof(my_frame));
+	ret = rs_rb_init(&rb, NULL, 0x1000);
+	CU_ASSERT_EQUAL_FATAL(ret, 0);
+	ret = io_frame_init_tlv(&my_frame.frame, frame_cb, 2, 1,
+			IO_FRAME_LITTLE_ENDIAN);
+	CU_ASSERT_EQUAL_FATAL(ret, 0);
+
+	/* normal use cases */
+	rb_feed(&rb, "\x34\x12\x03" "foo" "\xcd\xab\x00", 9);
+	CU_ASSERT_EQUAL(io_frame_process(&my_frame.frame, &rb), 0);
+	CU_ASSERT_EQUAL(my_frame.nb_frames, 2);
+	CU_ASSERT_EQUAL(my_frame.tags[0], 0x1234);
+	CU_ASSERT_STRING_EQUAL(my_frame.payloads[0], "foo");
+	CU_ASSERT_EQUAL(my_frame.tags[1], 0xabcd);
+	CU_ASSERT_EQUAL(my_frame.lens[1], 0);
+
+	/* error cases */
+	io_frame_clean(&my_frame.frame);
+	ret = io_frame_init_tlv(&my_frame.frame, frame_cb, 3, 1,
+			IO_FRAME_LITTLE_ENDIAN);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+	ret = io_frame_init_tlv(&my_frame.frame, frame_cb, 1, 0,
+			IO_FRAME_LITTLE_ENDIAN);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+
+	rs_rb_clean(&rb);
+}
+
+static void testFRAME_IO_READ_CB(void)
+{
+	int ret;
+	int sv[2];
+	struct io_mon mon;
+	struct io_io io;
+	struct my_frame my_frame;
+
+	memset(&my_frame, 0, sizeof(my_frame));
+	ret = socketpair(AF_UNIX, SOCK_STREAM, 0, sv);
+	CU_ASSERT_EQUAL_FATAL(ret, 0);
+	ret = io_mon_init(&mon);
+	CU_ASSERT_EQUAL_FATAL(ret, 0);
+	ret = io_io_init(&io, &mon, "frame", sv[0], sv[0], 0);
+	CU_ASSERT_EQUAL_FATAL(ret, 0);
+	ret = io_frame_init_delim(&my_frame.frame, frame_cb, "\n", 1,
+			IO_IO_RB_BUFFER_SIZE);
+	CU_ASSERT_EQUAL_FATAL(ret, 0);
+	ret = io_io_read_start(&io, io_frame_io_read_cb, &my_frame.frame, 0);
+	CU_ASSERT_EQUAL(ret, 0);
+
+	/* normal use cases */
+	ret = io_write(sv[1], "one\ntwo\nthr", 11);
+	CU_ASSERT_EQUAL(ret, 11);
+	ret = io_mon_poll(&mon, 100);
+	CU_ASSERT_EQUAL(ret, 1);
+	CU_ASSERT_EQUAL(my_frame.nb_frames, 2);
+	CU_ASSERT_STRING_EQUAL(my_frame.payloads[1], "two");
+	ret = io_write(sv[1], "ee\n", 3);
+	CU_ASSERT_EQUAL(ret, 3);
+	ret = io_mon_poll(&mon, 100);
+	CU_ASSERT_EQUAL(ret, 1);
+	CU_ASSERT_EQUAL(my_frame.nb_frames, 3);
+	CU_ASSERT_STRING_EQUAL(my_frame.payloads[2], "three");
+
+	/* end of file is notified with a NULL payload */
+	ret = shutdown(sv[1], SHUT_WR);
+	CU_ASSERT_EQUAL(ret, 0);
+	io_mon_poll(&mon, 100);
+	CU_ASSERT(my_frame.eof);
+
+	io_io_clean(&io);
+	io_frame_clean(&my_frame.frame);
+	io_mon_clean(&mon);
+	ut_file_fd_close(&sv[0]);
+	ut_file_fd_close(&sv[1]);
+}
+
+static const struct test_t tests[] = {
+		{
+				.fn = testFRAME_INIT_LENGTH,
+				.name = "io_frame_init_length"
+		},
+		{
+				.fn = testFRAME_INIT_DELIM,
+				.name = "io_frame_init_delim"
+		},
+		{
+				.fn = testFRAME_INIT_TLV,
+				.name = "io_frame_init_tlv"
+		},
+		{
+				.fn = testFRAME_IO_READ_CB,
+				.name = "io_frame_io_read_cb"
+		},
+
+		/* NULL guard */
+		{.fn = NULL, .name = NULL},
+};
+
+struct suite_t frame_suite = {
+		.name = "io_frame",
+		.init = NULL,
+		.clean = NULL,
+		.tests = tests,
+};
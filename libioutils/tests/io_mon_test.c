@@ -6,14 +6,19 @@
  *
  * Copyright (C) 2012 Parrot S.A.
  */
+#include <pthread.h>
 #include <unistd.h>
 #include <fcntl.h>
 
 #include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
 
 #include <CUnit/Basic.h>
 
 #include <ut_file.h>
+#include <ut_utils.h>
 
 #include <io_mon.h>
 
@@ -547,6 +552,391 @@ static void testMON_CLEAN(void)
 	CU_ASSERT_NOT_EQUAL(ret, 0);
 }
 
+#define POST_THREADS 4
+#define POST_TASKS 1000
+
+struct post_task {
+	struct io_mon_task task;
+	int producer;
+	int index;
+};
+
+struct post_ctx {
+	struct io_mon *mon;
+	struct post_task tasks[POST_THREADS][POST_TASKS];
+	pthread_t threads[POST_THREADS];
+	/* index of the last task run, per producer, to check the ordering */
+	int last[POST_THREADS];
+	int run;
+	bool in_order;
+	bool on_mon_thread;
+	pthread_t mon_thread;
+};
+
+static struct post_ctx post_ctx;
+
+static void post_task_cb(struct io_mon_task *task)
+{
+	struct post_task *t = ut_container_of(task, struct post_task, task);
+
+	if (t->index != post_ctx.last[t->producer] + 1)
+		post_ctx.in_order = false;
+	post_ctx.last[t->producer] = t->index;
+	if (!pthread_equal(pthread_self(), post_ctx.mon_thread))
+		post_ctx.on_mon_thread = false;
+	post_ctx.run++;
+}
+
+static void *post_routine(void *arg)
+{
+	int producer = (intptr_t)arg;
+	int i;
+	struct post_task *t;
+
+	for (i = 0; i < POST_TASKS; i++) {
+		t = &post_ctx.tasks[producer][i];
+		t->producer = producer;
+		t->index = i;
+		io_mon_post(post_ctx.mon, &t->task, post_task_cb);
+	}
+
+	return NULL;
+}
+
+static void testMON_POST(void)
+{
+	struct io_mon mon;
+	int ret;
+	int i;
+	uint64_t value;
+
+	ret = io_mon_init(&mon);
+	CU_ASSERT_EQUAL_FATAL(ret, 0);
+	memset(&post_ctx, 0, sizeof(post_ctx));
+	post_ctx.mon = &mon;
+	post_ctx.in_order = true;
+	post_ctx.on_mon_thread = true;
+	post_ctx.mon_thread = pthread_self();
+	for (i = 0; i < POST_THREADS; i++)
+		post_ctx.last[i] = -1;
+
+	/* posts done before the monitor runs cost one eventfd write */
+	for (i = 0; i < 10; i++) {
+		ret = io_mon_post(&mon, &post_ctx.tasks[0][i].task,
+				post_task_cb);
+		CU_ASSERT_EQUAL(ret, 0);
+		post_ctx.tasks[0][i].index = i;
+	}
+	CU_ASSERT_EQUAL(read(mon.post_src.fd, &value, sizeof(value)),
+			sizeof(value));
+	CU_ASSERT_EQUAL(value, 1);
+	CU_ASSERT_EQUAL(write(mon.post_src.fd, &value, sizeof(value)),
+			sizeof(value));
+	ret = io_mon_poll(&mon, 1000);
+	CU_ASSERT_EQUAL(ret, 1);
+	CU_ASSERT_EQUAL(post_ctx.run, 10);
+	CU_ASSERT(post_ctx.in_order);
+
+	/* concurrent producers, tasks run in order, on the monitor's thread */
+	post_ctx.run = 0;
+	post_ctx.last[0] = -1;
+	for (i = 0; i < POST_THREADS; i++)
+		pthread_create(post_ctx.threads + i, NULL, post_routine,
+				(void *)(intptr_t)i);
+	for (i = 0; i < 1000 && post_ctx.run < POST_THREADS * POST_TASKS; i++)
+		io_mon_poll(&mon, 100);
+	for (i = 0; i < POST_THREADS; i++)
+		pthread_join(post_ctx.threads[i], NULL);
+	CU_ASSERT_EQUAL(post_ctx.run, POST_THREADS * POST_TASKS);
+	CU_ASSERT(post_ctx.in_order);
+	CU_ASSERT(post_ctx.on_mon_thread);
+	/* the post source isn't a source of the monitor */
+	CU_ASSERT_EQUAL(mon.source.next, NULL);
+
+	/* error use cases */
+	ret = io_mon_post(NULL, &post_ctx.tasks[0][0].task, post_task_cb);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+	ret = io_mon_post(&mon, NULL, post_task_cb);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+	ret = io_mon_post(&mon, &post_ctx.tasks[0][0].task, NULL);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+
+	/* cleanup */
+	io_mon_clean(&mon);
+}
+
+struct defer_ctx {
+	struct io_src src;
+	struct io_mon *mon;
+	struct io_mon_deferred deferred;
+	struct io_mon_deferred idle;
+	/* callbacks called, in order, 's' for the source, 'd' and 'i' */
+	char trace[16];
+	int len;
+	bool again;
+};
+
+static void defer_trace(struct defer_ctx *ctx, char c)
+{
+	if (ctx->len < (int)sizeof(ctx->trace) - 1)
+		ctx->trace[ctx->len++] = c;
+}
+
+static void deferred_cb(struct io_mon_deferred *deferred)
+{
+	struct defer_ctx *ctx = ut_container_of(deferred, struct defer_ctx,
+			deferred);
+
+	defer_trace(ctx, 'd');
+	if (ctx->again) {
+		ctx->again = false;
+		io_mon_defer(ctx->mon, deferred, deferred_cb);
+	}
+}
+
+static void idle_cb(struct io_mon_deferred *deferred)
+{
+	defer_trace(ut_container_of(deferred, struct defer_ctx, idle), 'i');
+}
+
+static void defer_src_cb(struct io_src *src)
+{
+	struct defer_ctx *ctx = ut_container_of(src, struct defer_ctx, src);
+	char c;
+
+	read(src->fd, &c, 1);
+	defer_trace(ctx, 's');
+	io_mon_defer(ctx->mon, &ctx->deferred, deferred_cb);
+	/* already scheduled, runs only once */
+	io_mon_defer(ctx->mon, &ctx->deferred, deferred_cb);
+}
+
+static void testMON_DEFER(void)
+{
+	struct io_mon mon;
+	struct defer_ctx ctx;
+	int pipefd[2] = {-1, -1};
+	int ret;
+
+	memset(&ctx, 0, sizeof(ctx));
+	ctx.mon = &mon;
+	ret = io_mon_init(&mon);
+	CU_ASSERT_EQUAL_FATAL(ret, 0);
+	ret = pipe(pipefd);
+	CU_ASSERT_EQUAL_FATAL(ret, 0);
+	ret = io_src_init(&ctx.src, pipefd[0], IO_IN, defer_src_cb);
+	CU_ASSERT_EQUAL(ret, 0);
+	ret = io_mon_add_source(&mon, &ctx.src);
+	CU_ASSERT_EQUAL(ret, 0);
+
+	/* normal use cases */
+	/* deferred callbacks run after the events batch */
+	CU_ASSERT_EQUAL(write(pipefd[1], "x", 1), 1);
+	ret = io_mon_poll(&mon, -1);
+	CU_ASSERT_EQUAL(ret, 1);
+	CU_ASSERT_STRING_EQUAL(ctx.trace, "sd");
+
+	/* rescheduled from it's callback, it runs in the next poll */
+	ctx.again = true;
+	ret = io_mon_defer(&mon, &ctx.deferred, deferred_cb);
+	CU_ASSERT_EQUAL(ret, 0);
+	/* doesn't block, nor run the idle callbacks */
+	ret = io_mon_defer_idle(&mon, &ctx.idle, idle_cb);
+	CU_ASSERT_EQUAL(ret, 0);
+	/* scheduled outside of a callback, the monitor's fd is readable */
+	ret = io_mon_poll(&mon, -1);
+	CU_ASSERT_EQUAL(ret, 1);
+	CU_ASSERT_STRING_EQUAL(ctx.trace, "sdd");
+	ret = io_mon_poll(&mon, -1);
+	CU_ASSERT_STRING_EQUAL(ctx.trace, "sddd");
+
+	/* idle callbacks run only when no event is pending */
+	CU_ASSERT_EQUAL(write(pipefd[1], "x", 1), 1);
+	ret = io_mon_poll(&mon, -1);
+	CU_ASSERT_EQUAL(ret, 1);
+	CU_ASSERT_STRING_EQUAL(ctx.trace, "sdddsd");
+	ret = io_mon_poll(&mon, -1);
+	CU_ASSERT_EQUAL(ret, 0);
+	CU_ASSERT_STRING_EQUAL(ctx.trace, "sdddsdi");
+
+	/* cancelled callbacks don't run */
+	ret = io_mon_defer(&mon, &ctx.deferred, deferred_cb);
+	CU_ASSERT_EQUAL(ret, 0);
+	ret = io_mon_defer_cancel(&mon, &ctx.deferred);
+	CU_ASSERT_EQUAL(ret, 0);
+	ret = io_mon_poll(&mon, 0);
+	CU_ASSERT_STRING_EQUAL(ctx.trace, "sdddsdi");
+
+	/* error use cases */
+	ret = io_mon_defer_cancel(&mon, &ctx.deferred);
+	CU_ASSERT_EQUAL(ret, -ENOENT);
+	ret = io_mon_defer_cancel(NULL, &ctx.deferred);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+	ret = io_mon_defer_cancel(&mon, NULL);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+	ret = io_mon_defer(NULL, &ctx.deferred, deferred_cb);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+	ret = io_mon_defer(&mon, NULL, deferred_cb);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+	ret = io_mon_defer(&mon, &ctx.deferred, NULL);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+	ret = io_mon_defer_idle(NULL, &ctx.idle, idle_cb);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+
+	/* cleanup, drops the callbacks still scheduled */
+	io_mon_defer_idle(&mon, &ctx.idle, idle_cb);
+	io_mon_clean(&mon);
+	CU_ASSERT_PTR_NULL(ctx.idle.list);
+	ut_file_fd_close(&pipefd[0]);
+	ut_file_fd_close(&pipefd[1]);
+}
+
+static void testMON_DEFER_NESTED(void)
+{
+	struct io_mon parent;
+	struct io_mon mon;
+	struct defer_ctx ctx;
+	int ret;
+
+	memset(&ctx, 0, sizeof(ctx));
+	ctx.mon = &mon;
+	ret = io_mon_init(&parent);
+	CU_ASSERT_EQUAL_FATAL(ret, 0);
+	ret = io_mon_init(&mon);
+	CU_ASSERT_EQUAL_FATAL(ret, 0);
+	ret = io_mon_add_source(&parent, io_mon_get_source(&mon));
+	CU_ASSERT_EQUAL(ret, 0);
+
+	/* normal use cases */
+	/* nothing pending, the parent doesn't see the monitor */
+	ret = io_mon_poll(&parent, 0);
+	CU_ASSERT_EQUAL(ret, 0);
+
+	/* deferred callbacks wake the parent up, the idle ones don't run */
+	ctx.again = true;
+	ret = io_mon_defer(&mon, &ctx.deferred, deferred_cb);
+	CU_ASSERT_EQUAL(ret, 0);
+	ret = io_mon_defer_idle(&mon, &ctx.idle, idle_cb);
+	CU_ASSERT_EQUAL(ret, 0);
+	ret = io_mon_poll(&parent, 1000);
+	CU_ASSERT_EQUAL(ret, 1);
+	CU_ASSERT_STRING_EQUAL(ctx.trace, "d");
+	/* rescheduled from it's callback, it keeps the parent awake */
+	ret = io_mon_poll(&parent, 1000);
+	CU_ASSERT_EQUAL(ret, 1);
+	CU_ASSERT_STRING_EQUAL(ctx.trace, "dd");
+	ret = io_mon_poll(&parent, 0);
+	CU_ASSERT_EQUAL(ret, 0);
+	CU_ASSERT_STRING_EQUAL(ctx.trace, "dd");
+
+	/* the idle callbacks are run by the monitor's own io_mon_poll() */
+	ret = io_mon_poll(&mon, 0);
+	CU_ASSERT_EQUAL(ret, 0);
+	CU_ASSERT_STRING_EQUAL(ctx.trace, "ddi");
+
+	/* cleanup */
+	io_mon_remove_source(&parent, io_mon_get_source(&mon));
+	io_mon_clean(&mon);
+	io_mon_clean(&parent);
+}
+
+static void busy_poll_src_cb(struct io_src *src)
+{
+	char c;
+
+	read(src->fd, &c, 1);
+}
+
+static void testMON_BUSY_POLL(void)
+{
+	struct io_mon mon;
+	struct io_src src;
+	struct io_mon_busy_poll_stats stats;
+	uint64_t spins;
+	uint64_t blocking_waits;
+	int pipefd[2] = {-1, -1};
+	int ret;
+
+	ret = io_mon_init(&mon);
+	CU_ASSERT_EQUAL_FATAL(ret, 0);
+	ret = pipe(pipefd);
+	CU_ASSERT_EQUAL_FATAL(ret, 0);
+	io_src_init(&src, pipefd[0], IO_IN, busy_poll_src_cb);
+	ret = io_mon_add_source(&mon, &src);
+	CU_ASSERT_EQUAL(ret, 0);
+
+	/* normal use cases */
+	/* spins, then blocks until the timeout */
+	ret = io_mon_set_busy_poll(&mon, IO_MON_BUSY_POLL_FIXED, 2000);
+	CU_ASSERT_EQUAL(ret, 0);
+	ret = io_mon_poll(&mon, 10);
+	CU_ASSERT_EQUAL(ret, 0);
+	io_mon_get_busy_poll_stats(&mon, &stats);
+	CU_ASSERT(stats.spins > 0);
+	CU_ASSERT_EQUAL(stats.hits, 0);
+	CU_ASSERT_EQUAL(stats.blocking_waits, 1);
+
+	/* events are caught while spinning */
+	CU_ASSERT_EQUAL(write(pipefd[1], "x", 1), 1);
+	ret = io_mon_poll(&mon, -1);
+	CU_ASSERT_EQUAL(ret, 1);
+	io_mon_get_busy_poll_stats(&mon, &stats);
+	CU_ASSERT_EQUAL(stats.hits, 1);
+	CU_ASSERT_EQUAL(stats.blocking_waits, 1);
+
+	/* a timeout shorter than the spinning duration ends the spin */
+	ret = io_mon_set_busy_poll(&mon, IO_MON_BUSY_POLL_FIXED, 1000000);
+	CU_ASSERT_EQUAL(ret, 0);
+	ret = io_mon_poll(&mon, 5);
+	CU_ASSERT_EQUAL(ret, 0);
+	io_mon_get_busy_poll_stats(&mon, &stats);
+	CU_ASSERT(stats.spins > 0);
+	CU_ASSERT_EQUAL(stats.blocking_waits, 0);
+
+	/* adaptive stops spinning when events are rare */
+	ret = io_mon_set_busy_poll(&mon, IO_MON_BUSY_POLL_ADAPTIVE, 1000);
+	CU_ASSERT_EQUAL(ret, 0);
+	ret = io_mon_poll(&mon, 5);
+	io_mon_get_busy_poll_stats(&mon, &stats);
+	CU_ASSERT(stats.spins > 0);
+	CU_ASSERT_EQUAL(write(pipefd[1], "x", 1), 1);
+	io_mon_poll(&mon, -1);
+	usleep(50000);
+	CU_ASSERT_EQUAL(write(pipefd[1], "x", 1), 1);
+	io_mon_poll(&mon, -1);
+	CU_ASSERT(mon.interarrival_ns > 1000000);
+	io_mon_get_busy_poll_stats(&mon, &stats);
+	spins = stats.spins;
+	blocking_waits = stats.blocking_waits;
+	ret = io_mon_poll(&mon, 5);
+	io_mon_get_busy_poll_stats(&mon, &stats);
+	CU_ASSERT_EQUAL(stats.spins, spins);
+	CU_ASSERT_EQUAL(stats.blocking_waits, blocking_waits + 1);
+
+	/* disabled */
+	ret = io_mon_set_busy_poll(&mon, IO_MON_BUSY_POLL_OFF, 1000);
+	CU_ASSERT_EQUAL(ret, 0);
+	ret = io_mon_poll(&mon, 1);
+	io_mon_get_busy_poll_stats(&mon, &stats);
+	CU_ASSERT_EQUAL(stats.spins, 0);
+	CU_ASSERT_EQUAL(stats.blocking_waits, 1);
+
+	/* error use cases */
+	ret = io_mon_set_busy_poll(NULL, IO_MON_BUSY_POLL_FIXED, 1000);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+	ret = io_mon_set_busy_poll(&mon, IO_MON_BUSY_POLL_ADAPTIVE + 1, 1000);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+	ret = io_mon_get_busy_poll_stats(NULL, &stats);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+	ret = io_mon_get_busy_poll_stats(&mon, NULL);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+
+	/* cleanup */
+	io_mon_clean(&mon);
+	ut_file_fd_close(&pipefd[0]);
+	ut_file_fd_close(&pipefd[1]);
+}
+
 static const struct test_t tests[] = {
 		{
 				.fn = testMON_INIT,
@@ -592,6 +982,22 @@ static const struct test_t tests[] = {
 				.fn = testMON_PROCESS_EVENTS,
 				.name = "io_mon_process_events"
 		},
+		{
+				.fn = testMON_POST,
+				.name = "io_mon_post"
+		},
+		{
+				.fn = testMON_DEFER,
+				.name = "io_mon_defer"
+		},
+		{
+				.fn = testMON_DEFER_NESTED,
+				.name = "io_mon_defer nested"
+		},
+		{
+				.fn = testMON_BUSY_POLL,
+				.name = "io_mon_busy_poll"
+		},
 		{
 				.fn = testMON_CLEAN,
 				.name = "io_mon_clean"
@@ -0,0 +1,283 @@
+/**
+ * @file io_src_fanotify_test.c
+ * @date 19 oct. 2026
+ * @author nicolas.carrier@parrot.com
+ * @brief Unit tests for fanotify source. Filesystem marks need either the
+ * CAP_SYS_ADMIN capability, or a filesystem mounted in a user namespace, so the
+ * scenario runs in a child process, in new user and mount namespaces, on a
+ * tmpfs mounted there, which reports it's status to the parent through a pipe.
+ * If fanotify isn't supported or permitted, the test is skipped.
+ *
+ * Copyright (C) 2026 Parrot S.A.
+ */
+#define _GNU_SOURCE
+#include <sys/mount.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+
+#include <sched.h>
+#include <unistd.h>
+#include <fcntl.h>
+
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <limits.h>
+
+#include <CUnit/Basic.h>
+
+#include <ut_utils.h>
+#include <ut_file.h>
+
+#include <io_mon.h>
+#include <io_src_fanotify.h>
+
+#include <fautes.h>
+#include <fautes_utils.h>
+
+#define TEST_DIR "/tmp/src_fanotify_test"
+
+/* result of the scenario, sent by the child process to it's parent */
+struct scenario_status {
+	bool skipped;
+	/* line of the failed check, 0 if none failed */
+	int line;
+	char cond[128];
+};
+
+struct fan_ctx {
+	struct io_src_fanotify fan;
+	bool sub_created;
+	bool deep_created;
+	bool file_created;
+	bool file_deleted;
+	int path_ret;
+	char path[PATH_MAX];
+};
+
+static void fan_cb(struct io_src_fanotify *fan,
+		struct io_src_fanotify_event *evt,
+		struct io_src_fanotify_mark *mark)
+{
+	struct fan_ctx *ctx = ut_container_of(fan, struct fan_ctx, fan);
+
+	if (evt->name == NULL)
+		return;
+
+	if (strcmp(evt->name, "sub") == 0 && (evt->mask & FAN_CREATE))
+		ctx->sub_created = (evt->mask & FAN_ONDIR) != 0;
+	if (strcmp(evt->name, "deep") == 0 && (evt->mask & FAN_CREATE))
+		ctx->deep_created = (evt->mask & FAN_ONDIR) != 0;
+	if (strcmp(evt->name, "file") == 0 && (evt->mask & FAN_DELETE))
+		ctx->file_deleted = true;
+	if (strcmp(evt->name, "file") == 0 && (evt->mask & FAN_CREATE)) {
+		ctx->file_created = (evt->mask & FAN_ONDIR) == 0;
+		ctx->path_ret = io_src_fanotify_get_path(mark, evt, ctx->path,
+				sizeof(ctx->path));
+	}
+}
+
+static int write_file(const char *path, const char *content)
+{
+	int fd;
+	ssize_t sret;
+
+	fd = open(path, O_WRONLY | O_CLOEXEC);
+	if (fd == -1)
+		return -errno;
+	sret = write(fd, content, strlen(content));
+	close(fd);
+
+	return sret < 0 ? -errno : 0;
+}
+
+/* maps the current user to root in a new user namespace, mounts a tmpfs */
+static bool enter_namespaces(void)
+{
+	char map[32];
+	uid_t uid = getuid();
+	gid_t gid = getgid();
+
+	if (unshare(CLONE_NEWUSER | CLONE_NEWNS) == -1)
+		return false;
+	write_file("/proc/self/setgroups", "deny");
+	snprintf(map, sizeof(map), "0 %d 1", uid);
+	if (write_file("/proc/self/uid_map", map) < 0)
+		return false;
+	snprintf(map, sizeof(map), "0 %d 1", gid);
+	if (write_file("/proc/self/gid_map", map) < 0)
+		return false;
+	if (mount(NULL, "/", NULL, MS_REC | MS_PRIVATE, NULL) == -1)
+		return false;
+
+	return mount("none", TEST_DIR, "tmpfs", 0, NULL) == 0;
+}
+
+#define CHECK(c) do { \
+	if (!(c)) { \
+		status->line = __LINE__; \
+		snprintf(status->cond, sizeof(status->cond), "%s", #c); \
+		return; \
+	} \
+} while (0)
+
+static void scenario(struct scenario_status *status)
+{
+	int ret;
+	int fd;
+	int i;
+	struct io_mon mon;
+	struct fan_ctx ctx;
+	struct io_src_fanotify_mark mark = {
+		.path = TEST_DIR,
+		.type = IO_SRC_FANOTIFY_FILESYSTEM,
+		.events = FAN_CREATE | FAN_DELETE | FAN_ONDIR,
+		.cb = fan_cb,
+	};
+	struct io_src_fanotify_mark sub_mark = {
+		.path = TEST_DIR "/sub",
+		.type = IO_SRC_FANOTIFY_INODE,
+		.events = FAN_CREATE,
+		.cb = fan_cb,
+	};
+
+	/* without namespaces, only privileged users can succeed */
+	enter_namespaces();
+
+	memset(&ctx, 0, sizeof(ctx));
+	ret = io_src_fanotify_init(&ctx.fan);
+	if (ret == -EPERM || ret == -ENOSYS) {
+		status->skipped = true;
+		return;
+	}
+	CHECK(ret == 0);
+	ret = io_mon_init(&mon);
+	CHECK(ret == 0);
+	ret = io_mon_add_source(&mon, io_src_fanotify_get_source(&ctx.fan));
+	CHECK(ret == 0);
+
+	/* normal use cases */
+	ret = io_src_fanotify_add_mark(&ctx.fan, &mark);
+	if (ret == -EPERM) {
+		status->skipped = true;
+		return;
+	}
+	CHECK(ret == 0);
+	/* updating a mark */
+	mark.events |= FAN_MOVE;
+	ret = io_src_fanotify_add_mark(&ctx.fan, &mark);
+	CHECK(ret == 0);
+
+	/* events are reported at any depth, with only one mark */
+	CHECK(mkdir(TEST_DIR "/sub", S_IRWXU) == 0);
+	CHECK(mkdir(TEST_DIR "/sub/deep", S_IRWXU) == 0);
+	fd = open(TEST_DIR "/sub/deep/file", O_WRONLY | O_CREAT | O_CLOEXEC,
+			S_IRUSR);
+	CHECK(fd != -1);
+	close(fd);
+	CHECK(unlink(TEST_DIR "/sub/deep/file") == 0);
+	for (i = 0; i < 20 && !ctx.file_deleted; i++)
+		io_mon_poll(&mon, 100);
+	CHECK(ctx.sub_created);
+	CHECK(ctx.deep_created);
+	CHECK(ctx.file_created);
+	CHECK(ctx.file_deleted);
+	/* resolving handles needs CAP_DAC_READ_SEARCH in the initial userns */
+	CHECK(ctx.path_ret == -EPERM || ctx.path_ret == -ESTALE ||
+			(ctx.path_ret == 0 && strcmp(ctx.path,
+			TEST_DIR "/sub/deep/file") == 0));
+
+	/* events can't be told apart between marks of the same filesystem */
+	ret = io_src_fanotify_add_mark(&ctx.fan, &sub_mark);
+	CHECK(ret == -EBUSY);
+
+	ret = io_src_fanotify_rm_mark(&ctx.fan, &mark);
+	CHECK(ret == 0);
+
+	/* error use cases */
+	ret = io_src_fanotify_rm_mark(&ctx.fan, &mark);
+	CHECK(ret == -ENOENT);
+	mark.path = TEST_DIR "/none";
+	ret = io_src_fanotify_add_mark(&ctx.fan, &mark);
+	CHECK(ret == -ENOENT);
+	mark.cb = NULL;
+	ret = io_src_fanotify_add_mark(&ctx.fan, &mark);
+	CHECK(ret == -EINVAL);
+	ret = io_src_fanotify_add_mark(NULL, &mark);
+	CHECK(ret == -EINVAL);
+	ret = io_src_fanotify_add_mark(&ctx.fan, NULL);
+	CHECK(ret == -EINVAL);
+	ret = io_src_fanotify_init(NULL);
+	CHECK(ret == -EINVAL);
+
+	/* cleanup */
+	io_mon_remove_source(&mon, io_src_fanotify_get_source(&ctx.fan));
+	io_mon_clean(&mon);
+	fd = io_src_get_fd(io_src_fanotify_get_source(&ctx.fan));
+	io_src_fanotify_clean(&ctx.fan);
+	/* the fanotify file descriptor must have been closed */
+	CHECK(fcntl(fd, F_GETFD) == -1 && errno == EBADF);
+}
+
+static void testSRC_FANOTIFY(void)
+{
+	pid_t pid;
+	int ret;
+	int wstatus;
+	int pipefd[2];
+	ssize_t sret;
+	struct scenario_status status;
+
+	rmdir(TEST_DIR);
+	CU_ASSERT_EQUAL_FATAL(mkdir(TEST_DIR, S_IRWXU), 0);
+	ret = pipe2(pipefd, O_CLOEXEC);
+	CU_ASSERT_EQUAL_FATAL(ret, 0);
+
+	pid = fork();
+	CU_ASSERT_NOT_EQUAL_FATAL(pid, -1);
+	if (pid == 0) {
+		close(pipefd[0]);
+		memset(&status, 0, sizeof(status));
+		scenario(&status);
+		sret = write(pipefd[1], &status, sizeof(status));
+		_exit(sret == sizeof(status) ? 0 : 1);
+	}
+	close(pipefd[1]);
+
+	/* a short read means the child died before the end of the scenario */
+	memset(&status, 0, sizeof(status));
+	sret = read(pipefd[0], &status, sizeof(status));
+	close(pipefd[0]);
+	CU_ASSERT_EQUAL(waitpid(pid, &wstatus, 0), pid);
+	CU_ASSERT(WIFEXITED(wstatus) && WEXITSTATUS(wstatus) == 0);
+	CU_ASSERT_EQUAL(sret, sizeof(status));
+	if (status.skipped)
+		fprintf(stderr, "fanotify filesystem marks not permitted, "
+				"skipped\n");
+	if (status.line != 0)
+		fprintf(stderr, "check failed at line %d: %s\n", status.line,
+				status.cond);
+	CU_ASSERT_EQUAL(status.line, 0);
+
+	/* the tmpfs, if any, vanished with the child's mount namespace */
+	rmdir(TEST_DIR "/sub/deep");
+	rmdir(TEST_DIR "/sub");
+	rmdir(TEST_DIR);
+}
+
+static const struct test_t tests[] = {
+		{
+				.fn = testSRC_FANOTIFY,
+				.name = "io_src_fanotify"
+		},
+
+		/* NULL guard */
+		{.fn = NULL, .name = NULL},
+};
+
+struct suite_t src_fanotify_suite = {
+		.name = "io_src_fanotify",
+		.init = NULL,
+		.clean = NULL,
+		.tests = tests,
+};
@@ -11,6 +11,9 @@
 
 #include <unistd.h>
 #include <fcntl.h>
+#include <ftw.h>
+#include <stdio.h>
+#include <stdlib.h>
 
 #include <string.h>
 #include <inttypes.h>
@@ -347,6 +350,272 @@ out:
 	io_src_inot_clean(&ctx.inot);
 }
 
+#define REC_DIR "/tmp/src_inot_rec_test"
+#define REC_MOVED "/tmp/src_inot_rec_moved"
+
+struct rec_ctx {
+	struct io_src_inot inot;
+	unsigned created;
+	bool file_created;
+};
+
+static void rec_cb(struct io_src_inot *inot, struct inotify_event *evt,
+		struct io_src_inot_watch *watch)
+{
+	struct rec_ctx *ctx = ut_container_of(inot, struct rec_ctx, inot);
+
+	/* only the events asked for are notified */
+	CU_ASSERT(evt->mask & (IN_CREATE | IN_DELETE));
+	if (!(evt->mask & IN_CREATE))
+		return;
+	if (evt->mask & IN_ISDIR)
+		ctx->created++;
+	else if (strcmp(evt->name, "f") == 0 &&
+			strcmp(watch->path, REC_DIR "/a/b/c") == 0)
+		ctx->file_created = true;
+}
+
+static int remove_entry(const char *path, const struct stat *st, int flag,
+		struct FTW *ftw)
+{
+	return remove(path);
+}
+
+static void remove_tree(const char *path)
+{
+	nftw(path, remove_entry, 16, FTW_DEPTH | FTW_PHYS);
+}
+
+static void process_until(struct io_mon *mon, struct io_src_inot *inot,
+		size_t count)
+{
+	int i;
+
+	for (i = 0; i < 20 && io_src_inot_get_watch_count(inot) != count; i++)
+		io_mon_poll(mon, 100);
+}
+
+static void testSRC_INOT_RECURSIVE(void)
+{
+	int ret;
+	int fd;
+	struct io_mon mon;
+	struct rec_ctx ctx = {.created = 0};
+	struct io_src_inot_watch watch = {
+			.path = REC_DIR "/",
+			.events = IN_CREATE | IN_DELETE,
+			.cb = rec_cb,
+	};
+
+	remove_tree(REC_DIR);
+	remove_tree(REC_MOVED);
+	ret = mkdir(REC_DIR, S_IRWXU);
+	CU_ASSERT_EQUAL_FATAL(ret, 0);
+	ret = mkdir(REC_DIR "/a", S_IRWXU);
+	CU_ASSERT_EQUAL_FATAL(ret, 0);
+	ret = mkdir(REC_DIR "/a/b", S_IRWXU);
+	CU_ASSERT_EQUAL_FATAL(ret, 0);
+	/* symbolic links aren't followed */
+	ret = symlink("/", REC_DIR "/a/root");
+	CU_ASSERT_EQUAL_FATAL(ret, 0);
+
+	ret = io_mon_init(&mon);
+	CU_ASSERT_EQUAL(ret, 0);
+	ret = io_src_inot_init(&ctx.inot);
+	CU_ASSERT_EQUAL_FATAL(ret, 0);
+	ret = io_mon_add_source(&mon, io_src_inot_get_source(&ctx.inot));
+	CU_ASSERT_EQUAL(ret, 0);
+
+	/* normal use cases */
+	ret = io_src_inot_add_watch_recursive(&ctx.inot, &watch);
+	CU_ASSERT_EQUAL(ret, 0);
+	CU_ASSERT_EQUAL(io_src_inot_get_watch_count(&ctx.inot), 3);
+	/* adding it twice is a noop */
+	ret = io_src_inot_add_watch_recursive(&ctx.inot, &watch);
+	CU_ASSERT_EQUAL(ret, 0);
+	CU_ASSERT_EQUAL(io_src_inot_get_watch_count(&ctx.inot), 3);
+	CU_ASSERT_EQUAL(ctx.created, 0);
+
+	/*
+	 * c/d and c/f are created before the watch of c can be installed, they
+	 * must be found by the scan of c
+	 */
+	ret = mkdir(REC_DIR "/a/b/c", S_IRWXU);
+	CU_ASSERT_EQUAL_FATAL(ret, 0);
+	ret = mkdir(REC_DIR "/a/b/c/d", S_IRWXU);
+	CU_ASSERT_EQUAL_FATAL(ret, 0);
+	fd = open(REC_DIR "/a/b/c/f", O_WRONLY | O_CREAT | O_CLOEXEC, S_IRUSR);
+	CU_ASSERT_NOT_EQUAL_FATAL(fd, -1);
+	close(fd);
+	process_until(&mon, &ctx.inot, 5);
+	CU_ASSERT_EQUAL(io_src_inot_get_watch_count(&ctx.inot), 5);
+	/* c, then d, at least once */
+	CU_ASSERT(ctx.created >= 2);
+	CU_ASSERT(ctx.file_created);
+
+	/* moving a out of the tree drops the watches of a, b, c and d */
+	ret = rename(REC_DIR "/a", REC_MOVED);
+	CU_ASSERT_EQUAL_FATAL(ret, 0);
+	process_until(&mon, &ctx.inot, 1);
+	CU_ASSERT_EQUAL(io_src_inot_get_watch_count(&ctx.inot), 1);
+
+	/* and moving it back in, restores them */
+	ret = rename(REC_MOVED, REC_DIR "/a");
+	CU_ASSERT_EQUAL_FATAL(ret, 0);
+	process_until(&mon, &ctx.inot, 5);
+	CU_ASSERT_EQUAL(io_src_inot_get_watch_count(&ctx.inot), 5);
+
+	/* removing the root watch removes the whole tree */
+	ret = io_src_inot_rm_watch(&ctx.inot, &watch);
+	CU_ASSERT_EQUAL(ret, 0);
+	CU_ASSERT_EQUAL(io_src_inot_get_watch_count(&ctx.inot), 0);
+
+	/* error use cases */
+	watch.path = REC_DIR "/none";
+	ret = io_src_inot_add_watch_recursive(&ctx.inot, &watch);
+	CU_ASSERT_EQUAL(ret, -ENOENT);
+	watch.path = "/proc/self/status";
+	ret = io_src_inot_add_watch_recursive(&ctx.inot, &watch);
+	CU_ASSERT_EQUAL(ret, -ENOTDIR);
+	ret = io_src_inot_add_watch_recursive(NULL, &watch);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+	ret = io_src_inot_add_watch_recursive(&ctx.inot, NULL);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+
+	/* cleanup */
+	io_mon_remove_source(&mon, io_src_inot_get_source(&ctx.inot));
+	io_mon_clean(&mon);
+	io_src_inot_clean(&ctx.inot);
+	remove_tree(REC_DIR);
+}
+
+#define COAL_DIR "/tmp/src_inot_coal_test"
+
+struct coal_ctx {
+	struct io_src_inot inot;
+	unsigned nb_cb;
+	unsigned modified[2];
+	unsigned closed;
+	char order[8];
+};
+
+static void coal_cb(struct io_src_inot *inot, struct inotify_event *evt,
+		struct io_src_inot_watch *watch)
+{
+	struct coal_ctx *ctx = ut_container_of(inot, struct coal_ctx, inot);
+	unsigned i = evt->name[0] == 'a' ? 0 : 1;
+
+	if (ctx->nb_cb < sizeof(ctx->order) - 1)
+		ctx->order[ctx->nb_cb] = evt->mask == IN_MODIFY ?
+				evt->name[0] : 'c';
+	ctx->nb_cb++;
+	if (evt->mask == IN_MODIFY)
+		ctx->modified[i] += io_src_inot_get_event_count(inot);
+	else
+		ctx->closed++;
+}
+
+static void write_alternately(int fd[2], unsigned nb)
+{
+	unsigned i;
+	ssize_t sret;
+
+	/* alternating prevents the kernel from merging the events itself */
+	for (i = 0; i < 2 * nb; i++) {
+		sret = write(fd[i % 2], "x", 1);
+		CU_ASSERT_EQUAL(sret, 1);
+	}
+}
+
+static void testSRC_INOT_COALESCING(void)
+{
+	int ret;
+	int fd[2];
+	int i;
+	struct io_mon mon;
+	struct io_mon *other;
+	struct coal_ctx ctx = {.nb_cb = 0};
+	struct io_src_inot_watch watch = {
+			.path = COAL_DIR,
+			.events = IN_MODIFY | IN_CLOSE_WRITE,
+			.cb = coal_cb,
+	};
+
+	remove_tree(COAL_DIR);
+	ret = mkdir(COAL_DIR, S_IRWXU);
+	CU_ASSERT_EQUAL_FATAL(ret, 0);
+	ret = io_mon_init(&mon);
+	CU_ASSERT_EQUAL(ret, 0);
+	ret = io_src_inot_init(&ctx.inot);
+	CU_ASSERT_EQUAL_FATAL(ret, 0);
+	ret = io_mon_add_source(&mon, io_src_inot_get_source(&ctx.inot));
+	CU_ASSERT_EQUAL(ret, 0);
+	ret = io_src_inot_add_watch(&ctx.inot, &watch);
+	CU_ASSERT_EQUAL(ret, 0);
+	fd[0] = open(COAL_DIR "/a", O_WRONLY | O_CREAT | O_CLOEXEC, S_IRWXU);
+	CU_ASSERT_NOT_EQUAL_FATAL(fd[0], -1);
+	fd[1] = open(COAL_DIR "/b", O_WRONLY | O_CREAT | O_CLOEXEC, S_IRWXU);
+	CU_ASSERT_NOT_EQUAL_FATAL(fd[1], -1);
+
+	/* normal use cases */
+	ret = io_src_inot_set_coalescing(&ctx.inot, &mon, IN_MODIFY, 50);
+	CU_ASSERT_EQUAL(ret, 0);
+
+	/* the window is closed by the timer */
+	write_alternately(fd, 10);
+	for (i = 0; i < 20 && ctx.modified[0] + ctx.modified[1] < 20; i++)
+		io_mon_poll(&mon, 100);
+	CU_ASSERT_EQUAL(ctx.nb_cb, 2);
+	CU_ASSERT_EQUAL(ctx.modified[0], 10);
+	CU_ASSERT_EQUAL(ctx.modified[1], 10);
+
+	/* the window is closed by events which can't be coalesced */
+	memset(ctx.order, 0, sizeof(ctx.order));
+	ctx.nb_cb = ctx.modified[0] = ctx.modified[1] = 0;
+	write_alternately(fd, 50);
+	close(fd[0]);
+	close(fd[1]);
+	for (i = 0; i < 20 && ctx.closed < 2; i++)
+		io_mon_poll(&mon, 100);
+	CU_ASSERT_EQUAL(ctx.nb_cb, 4);
+	CU_ASSERT_EQUAL(ctx.modified[0], 50);
+	CU_ASSERT_EQUAL(ctx.modified[1], 50);
+	CU_ASSERT_STRING_EQUAL(ctx.order, "abcc");
+
+	/* disabling */
+	ret = io_src_inot_set_coalescing(&ctx.inot, NULL, 0, 0);
+	CU_ASSERT_EQUAL(ret, 0);
+
+	/* error use cases */
+	ret = io_src_inot_set_coalescing(NULL, &mon, IN_MODIFY, 50);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+	ret = io_src_inot_set_coalescing(&ctx.inot, NULL, IN_MODIFY, 50);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+	ret = io_src_inot_set_coalescing(&ctx.inot, &mon, IN_MODIFY, -1);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+	ret = io_src_inot_set_coalescing(&ctx.inot, &mon, IN_MOVE, 50);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+
+	/* cleanup */
+	io_mon_remove_source(&mon, io_src_inot_get_source(&ctx.inot));
+	io_mon_clean(&mon);
+	io_src_inot_clean(&ctx.inot);
+
+	/* the monitor of the timer can be released before the source */
+	ret = io_src_inot_init(&ctx.inot);
+	CU_ASSERT_EQUAL_FATAL(ret, 0);
+	other = calloc(1, sizeof(*other));
+	CU_ASSERT_PTR_NOT_NULL_FATAL(other);
+	ret = io_mon_init(other);
+	CU_ASSERT_EQUAL(ret, 0);
+	ret = io_src_inot_set_coalescing(&ctx.inot, other, IN_MODIFY, 50);
+	CU_ASSERT_EQUAL(ret, 0);
+	io_mon_clean(other);
+	free(other);
+	io_src_inot_clean(&ctx.inot);
+	remove_tree(COAL_DIR);
+}
+
 static const struct test_t tests[] = {
 		{
 				.fn = testSRC_INOT_INIT,
@@ -368,6 +637,14 @@ static const struct test_t tests[] = {
 				.fn = testSRC_INOT_FULL_TEST,
 				.name = "io_src_inot_full_test"
 		},
+		{
+				.fn = testSRC_INOT_RECURSIVE,
+				.name = "io_src_inot_recursive"
+		},
+		{
+				.fn = testSRC_INOT_COALESCING,
+				.name = "io_src_inot_coalescing"
+		},
 
 		/* NULL guard */
 		{.fn = NULL, .name = NULL},
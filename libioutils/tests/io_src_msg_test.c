@@ -6,7 +6,9 @@
  *
  * Copyright (C) 2012 Parrot S.A.
  */
-
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif /* _GNU_SOURCE */
 #include <unistd.h>
 #include <fcntl.h>
 
@@ -377,6 +379,145 @@ static void dummy_cb(struct io_src_msg *src, enum io_src_event evt)
 
 }
 
+#define NB_QUEUED 4
+#define PIPE_SIZE 4096
+#define NB_OVERFLOW (PIPE_SIZE / sizeof(struct msg) + NB_QUEUED)
+
+struct my_out {
+	struct io_src_msg_out out;
+	int status;
+	bool done;
+};
+
+static void out_cb(struct io_src_msg_out *out, int status)
+{
+	struct my_out *my_out = ut_container_of(out, struct my_out, out);
+
+	my_out->status = status;
+	my_out->done = true;
+}
+
+static unsigned nb_done(struct my_out *outs, unsigned nb, int status)
+{
+	unsigned i;
+	unsigned done = 0;
+
+	for (i = 0; i < nb; i++)
+		if (outs[i].done && outs[i].status == status)
+			done++;
+
+	return done;
+}
+
+static void testSRC_MSG_SEND(void)
+{
+	int ret;
+	unsigned i;
+	struct io_mon mon;
+	struct my_msg_src msg_src;
+	struct my_out outs[NB_OVERFLOW];
+	struct msg rcvd_msg;
+	struct my_out big_out = {.done = false};
+	static char big_msg[3 * PIPE_SIZE];
+	static char big_rcvd[sizeof(big_msg)];
+	size_t received;
+
+	memset(outs, 0, sizeof(outs));
+	for (i = 0; i < NB_OVERFLOW; i++) {
+		outs[i].out.buf = i % 2 ? &MSG1 : &MSG2;
+		outs[i].out.len = sizeof(struct msg);
+		outs[i].out.cb = out_cb;
+	}
+
+	ret = pipe2(msg_src.pipefds, O_NONBLOCK);
+	CU_ASSERT_EQUAL_FATAL(ret, 0);
+	ret = fcntl(msg_src.pipefds[1], F_SETPIPE_SZ, PIPE_SIZE);
+	CU_ASSERT_EQUAL(ret, PIPE_SIZE);
+	ret = io_src_msg_init(&(msg_src.msg_src), msg_src.pipefds[1], IO_OUT,
+			dummy_cb, &(msg_src.msg), sizeof(msg_src.msg), 1);
+	CU_ASSERT_EQUAL(ret, 0);
+	ret = io_mon_init(&mon);
+	CU_ASSERT_EQUAL(ret, 0);
+	ret = io_mon_add_source(&mon, &(msg_src.msg_src.src));
+	CU_ASSERT_EQUAL(ret, 0);
+
+	/* normal use cases */
+	/* OUT is activated by the first message, all are sent in one go */
+	for (i = 0; i < NB_QUEUED; i++) {
+		ret = io_src_msg_send(&(msg_src.msg_src), &mon, &outs[i].out);
+		CU_ASSERT_EQUAL(ret, 0);
+	}
+	CU_ASSERT(io_src_is_active(&(msg_src.msg_src.src), IO_OUT));
+	CU_ASSERT_EQUAL(io_src_msg_get_send_queue_length(&(msg_src.msg_src)),
+			NB_QUEUED);
+	ret = io_mon_poll(&mon, 100);
+	CU_ASSERT_EQUAL(ret, 1);
+	CU_ASSERT_EQUAL(nb_done(outs, NB_QUEUED, 0), NB_QUEUED);
+	CU_ASSERT_FALSE(io_src_is_active(&(msg_src.msg_src.src), IO_OUT));
+	for (i = 0; i < NB_QUEUED; i++) {
+		ret = read(msg_src.pipefds[0], &rcvd_msg, sizeof(rcvd_msg));
+		CU_ASSERT_EQUAL(ret, sizeof(rcvd_msg));
+		CU_ASSERT_EQUAL(memcmp(&rcvd_msg, outs[i].out.buf,
+				sizeof(rcvd_msg)), 0);
+	}
+
+	/* a message bigger than the pipe is written in several times */
+	for (i = 0; i < sizeof(big_msg); i++)
+		big_msg[i] = (char)i;
+	big_out.out.buf = big_msg;
+	big_out.out.len = sizeof(big_msg);
+	big_out.out.cb = out_cb;
+	ret = io_src_msg_send(&(msg_src.msg_src), &mon, &big_out.out);
+	CU_ASSERT_EQUAL(ret, 0);
+	for (received = 0, i = 0; received < sizeof(big_rcvd) && i < 100; i++) {
+		io_mon_poll(&mon, 100);
+		ret = read(msg_src.pipefds[0], big_rcvd + received,
+				sizeof(big_rcvd) - received);
+		if (ret > 0)
+			received += ret;
+	}
+	CU_ASSERT_EQUAL(received, sizeof(big_rcvd));
+	CU_ASSERT(big_out.done);
+	CU_ASSERT_EQUAL(big_out.status, 0);
+	CU_ASSERT_EQUAL(memcmp(big_msg, big_rcvd, sizeof(big_msg)), 0);
+	CU_ASSERT_FALSE(io_src_is_active(&(msg_src.msg_src.src), IO_OUT));
+
+	/* when the pipe is full, the remaining messages stay queued */
+	memset(outs, 0, NB_QUEUED * sizeof(*outs));
+	for (i = 0; i < NB_OVERFLOW; i++) {
+		outs[i].out.buf = &MSG3;
+		outs[i].out.len = sizeof(struct msg);
+		outs[i].out.cb = out_cb;
+		ret = io_src_msg_send(&(msg_src.msg_src), &mon, &outs[i].out);
+		CU_ASSERT_EQUAL(ret, 0);
+	}
+	ret = io_mon_poll(&mon, 100);
+	CU_ASSERT_EQUAL(ret, 1);
+	CU_ASSERT(nb_done(outs, NB_OVERFLOW, 0) < NB_OVERFLOW);
+	CU_ASSERT(io_src_is_active(&(msg_src.msg_src.src), IO_OUT));
+	CU_ASSERT_EQUAL(io_src_msg_get_send_queue_length(&(msg_src.msg_src)) +
+			nb_done(outs, NB_OVERFLOW, 0), NB_OVERFLOW);
+
+	/* the ones still queued are canceled on clean */
+	io_mon_clean(&mon);
+	my_msg_src_clean(&(msg_src));
+	CU_ASSERT_EQUAL(nb_done(outs, NB_OVERFLOW, 0) +
+			nb_done(outs, NB_OVERFLOW, -ECANCELED), NB_OVERFLOW);
+	CU_ASSERT(nb_done(outs, NB_OVERFLOW, -ECANCELED) > 0);
+
+	/* error cases */
+	ret = io_src_msg_send(NULL, &mon, &outs[0].out);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+	ret = io_src_msg_send(&(msg_src.msg_src), NULL, &outs[0].out);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+	ret = io_src_msg_send(&(msg_src.msg_src), &mon, NULL);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+	outs[0].out.cb = NULL;
+	ret = io_src_msg_send(&(msg_src.msg_src), &mon, &outs[0].out);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+}
+
+
 static void testSRC_MSG_GET_SOURCE(void)
 {
 	int ret;
@@ -440,6 +581,10 @@ static const struct test_t tests[] = {
 				.fn = testSRC_MSG_INIT_write,
 				.name = "io_src_msg_init write"
 		},
+		{
+				.fn = testSRC_MSG_SEND,
+				.name = "io_src_msg_send"
+		},
 		{
 				.fn = testSRC_MSG_GET_SOURCE,
 				.name = "io_src_msg_get_source"
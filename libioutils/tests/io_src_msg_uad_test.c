@@ -6,7 +6,10 @@
  *
  * Copyright (C) 2013 Parrot S.A.
  */
+#include <dirent.h>
+
 #include <stdbool.h>
+#include <stdint.h>
 
 #include <CUnit/Basic.h>
 
@@ -197,6 +200,223 @@ out:
 	/* error use cases */
 }
 
+#define BATCH_NB_SLOTS 4
+#define BATCH_NB_MSGS 6
+
+struct my_batch_src {
+	struct io_src_msg_uad uad_src;
+	unsigned nb_out;
+	unsigned nb_in_calls;
+	unsigned nb_received;
+	bool error;
+};
+
+static void batch_cb(struct io_src_msg_uad *src, enum io_src_event evt,
+		const struct iovec *msgs, unsigned nb_msgs)
+{
+	struct my_batch_src *my_batch = ut_container_of(src,
+			struct my_batch_src, uad_src);
+	unsigned i;
+	int ret;
+
+	if (IO_OUT == evt) {
+		CU_ASSERT_PTR_NULL(msgs);
+		CU_ASSERT_EQUAL(nb_msgs, 0);
+		/* queue the last messages, the first ones are already sent */
+		for (i = BATCH_NB_SLOTS; i < BATCH_NB_MSGS; i++) {
+			ret = io_src_msg_uad_queue_message(src, &i, sizeof(i));
+			CU_ASSERT_EQUAL(ret, 0);
+		}
+		my_batch->nb_out++;
+		ret = io_mon_activate_out_source(&mon,
+				io_src_msg_uad_get_source(src), false);
+		CU_ASSERT_EQUAL(ret, 0);
+		return;
+	}
+
+	my_batch->nb_in_calls++;
+	for (i = 0; i < nb_msgs; i++) {
+		if (msgs[i].iov_len != sizeof(unsigned) ||
+				*(unsigned *)msgs[i].iov_base !=
+				my_batch->nb_received)
+			my_batch->error = true;
+		my_batch->nb_received++;
+	}
+}
+
+static void testSRC_MSG_UAD_INIT_BATCH(void)
+{
+	int ret;
+	unsigned i;
+	struct my_batch_src src = {
+		.nb_out = 0,
+		.nb_in_calls = 0,
+		.nb_received = 0,
+		.error = false,
+	};
+
+	ret = io_src_msg_uad_init_batch(&src.uad_src, batch_cb,
+			sizeof(unsigned), BATCH_NB_SLOTS, "batch_socket_%d", 42);
+	CU_ASSERT_EQUAL_FATAL(ret, 0);
+	ret = io_mon_init(&mon);
+	CU_ASSERT_EQUAL(ret, 0);
+	ret = io_mon_add_source(&mon, io_src_msg_uad_get_source(&src.uad_src));
+	CU_ASSERT_EQUAL(ret, 0);
+
+	/* normal use cases */
+	/* messages queued and flushed directly, with one sendmmsg */
+	for (i = 0; i < BATCH_NB_SLOTS; i++) {
+		ret = io_src_msg_uad_queue_message(&src.uad_src, &i,
+				sizeof(i));
+		CU_ASSERT_EQUAL(ret, 0);
+	}
+	ret = io_src_msg_uad_queue_message(&src.uad_src, &i, sizeof(i));
+	CU_ASSERT_EQUAL(ret, -ENOBUFS);
+	ret = io_src_msg_uad_flush(&src.uad_src);
+	CU_ASSERT_EQUAL(ret, 0);
+
+	/* they are received with one recvmmsg */
+	ret = io_mon_poll(&mon, 1000);
+	CU_ASSERT_EQUAL(ret, 1);
+	CU_ASSERT_EQUAL(src.nb_in_calls, 1);
+	CU_ASSERT_EQUAL(src.nb_received, BATCH_NB_SLOTS);
+
+	/* messages queued from the out callback */
+	ret = io_mon_activate_out_source(&mon,
+			io_src_msg_uad_get_source(&src.uad_src), true);
+	CU_ASSERT_EQUAL(ret, 0);
+	ret = io_mon_poll(&mon, 1000);
+	CU_ASSERT_EQUAL(ret, 1);
+	CU_ASSERT_EQUAL(src.nb_out, 1);
+	ret = io_mon_poll(&mon, 1000);
+	CU_ASSERT_EQUAL(ret, 1);
+	CU_ASSERT_EQUAL(src.nb_in_calls, 2);
+	CU_ASSERT_EQUAL(src.nb_received, BATCH_NB_MSGS);
+	CU_ASSERT(!src.error);
+
+	/* error use cases */
+	ret = io_src_msg_uad_queue_message(&src.uad_src, &i, sizeof(i) + 1);
+	CU_ASSERT_EQUAL(ret, -EMSGSIZE);
+	ret = io_src_msg_uad_queue_message(NULL, &i, sizeof(i));
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+	ret = io_src_msg_uad_flush(NULL);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+	ret = io_src_msg_uad_init_batch(&src.uad_src, batch_cb, 0,
+			BATCH_NB_SLOTS, "batch_socket");
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+	ret = io_src_msg_uad_init_batch(&src.uad_src, batch_cb,
+			sizeof(unsigned), 0, "batch_socket");
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+
+	/* cleanup */
+	io_mon_clean(&mon);
+	io_src_msg_uad_clean(&src.uad_src);
+}
+
+#define BLOB_INLINE_SIZE 64
+#define BLOB_LARGE_SIZE (4 << 20)
+
+struct my_blob_src {
+	struct io_src_msg_uad uad_src;
+	const char *expected;
+	size_t expected_len;
+	unsigned nb_received;
+	bool error;
+};
+
+static void blob_cb(struct io_src_msg_uad *src, enum io_src_event evt,
+		const void *blob, size_t len)
+{
+	struct my_blob_src *my_blob = ut_container_of(src,
+			struct my_blob_src, uad_src);
+
+	CU_ASSERT_EQUAL(evt, IO_IN);
+	my_blob->nb_received++;
+	if (len != my_blob->expected_len ||
+			memcmp(blob, my_blob->expected, len) != 0)
+		my_blob->error = true;
+}
+
+static unsigned count_fds(void)
+{
+	DIR *dir;
+	unsigned nb = 0;
+
+	dir = opendir("/proc/self/fd");
+	if (NULL == dir)
+		return 0;
+	while (NULL != readdir(dir))
+		nb++;
+	closedir(dir);
+
+	return nb;
+}
+
+static void testSRC_MSG_UAD_INIT_BLOB(void)
+{
+	int ret;
+	unsigned nb_fds;
+	unsigned i;
+	char *large;
+	struct my_blob_src src = {
+		.nb_received = 0,
+		.error = false,
+	};
+
+	large = malloc(BLOB_LARGE_SIZE);
+	CU_ASSERT_PTR_NOT_NULL_FATAL(large);
+	for (i = 0; i < BLOB_LARGE_SIZE; i++)
+		large[i] = i % 251;
+
+	ret = io_src_msg_uad_init_blob(&src.uad_src, blob_cb,
+			BLOB_INLINE_SIZE, "blob_socket_%d", 42);
+	CU_ASSERT_EQUAL_FATAL(ret, 0);
+	ret = io_mon_init(&mon);
+	CU_ASSERT_EQUAL(ret, 0);
+	ret = io_mon_add_source(&mon, io_src_msg_uad_get_source(&src.uad_src));
+	CU_ASSERT_EQUAL(ret, 0);
+	nb_fds = count_fds();
+
+	/* normal use cases */
+	/* small blob, transmitted inline */
+	src.expected = large;
+	src.expected_len = BLOB_INLINE_SIZE;
+	ret = io_src_msg_uad_send_blob(&src.uad_src, large, BLOB_INLINE_SIZE);
+	CU_ASSERT_EQUAL(ret, 0);
+	ret = io_mon_poll(&mon, 1000);
+	CU_ASSERT_EQUAL(ret, 1);
+	CU_ASSERT_EQUAL(src.nb_received, 1);
+
+	/* large blob, transmitted in a memfd */
+	src.expected_len = BLOB_LARGE_SIZE;
+	ret = io_src_msg_uad_send_blob(&src.uad_src, large, BLOB_LARGE_SIZE);
+	CU_ASSERT_EQUAL(ret, 0);
+	ret = io_mon_poll(&mon, 1000);
+	CU_ASSERT_EQUAL(ret, 1);
+	CU_ASSERT_EQUAL(src.nb_received, 2);
+	CU_ASSERT(!src.error);
+
+	/* all the memfds have been closed on both sides */
+	CU_ASSERT_EQUAL(count_fds(), nb_fds);
+
+	/* error use cases */
+	ret = io_src_msg_uad_send_blob(NULL, large, BLOB_INLINE_SIZE);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+	ret = io_src_msg_uad_send_blob(&src.uad_src, NULL, BLOB_INLINE_SIZE);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+	ret = io_src_msg_uad_init_blob(&src.uad_src, blob_cb,
+			sizeof(uint64_t) - 1, "blob_socket");
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+	ret = io_src_msg_uad_init_blob(&src.uad_src, NULL, BLOB_INLINE_SIZE,
+			"blob_socket");
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+
+	/* cleanup */
+	io_mon_clean(&mon);
+	io_src_msg_uad_clean(&src.uad_src);
+	free(large);
+}
+
 static void dummy_cb(struct io_src_msg_uad *src, enum io_src_event evt)
 {
 
@@ -240,6 +460,14 @@ static const struct test_t tests[] = {
 				.fn = testSRC_MSG_UAD_INIT,
 				.name = "io_src_msg_uad_init"
 		},
+		{
+				.fn = testSRC_MSG_UAD_INIT_BATCH,
+				.name = "io_src_msg_uad_init_batch"
+		},
+		{
+				.fn = testSRC_MSG_UAD_INIT_BLOB,
+				.name = "io_src_msg_uad_init_blob"
+		},
 		{
 				.fn = testSRC_MSG_UAD_GET_SOURCE,
 				.name = "io_src_msg_uad_get_source"
@@ -185,11 +185,353 @@ static void testSRC_SEP_INIT(void)
 	testSRC_SEP(sep_double, big_msg_double, strlen(big_msg_double));
 }
 
+#define DELIM_MAX_CHUNKS 10
+
+struct delim_ctx {
+	struct io_src_sep src_sep;
+	char chunks[DELIM_MAX_CHUNKS][IO_SRC_SEP_SIZE + 1];
+	unsigned nb_chunks;
+	bool eof;
+};
+
+static void delim_cb(struct io_src_sep *sep, char *chunk, unsigned len)
+{
+	struct delim_ctx *ctx = ut_container_of(sep, struct delim_ctx,
+			src_sep);
+
+	if (0 == len) {
+		ctx->eof = true;
+		return;
+	}
+
+	CU_ASSERT(ctx->nb_chunks < DELIM_MAX_CHUNKS);
+	if (ctx->nb_chunks >= DELIM_MAX_CHUNKS)
+		return;
+	/* the chunk can be written one byte after it's end */
+	chunk[len] = '\0';
+	snprintf(ctx->chunks[ctx->nb_chunks++], IO_SRC_SEP_SIZE + 1, "%s",
+			chunk);
+}
+
+static void testSRC_SEP_INIT_DELIM(void)
+{
+	int ret;
+	struct io_mon mon;
+	struct delim_ctx ctx = {.nb_chunks = 0, .eof = false};
+	int pipefd[2] = {-1, -1};
+	const char *writes[] = {
+		"GET / HTTP/1.1\r\nHost: a\r\n\r",
+		"\nGET /b HTTP/1.1\r\n\r\n0123456789",
+		"abcdefghij\r\n\r\n01234567890123456789012345678901\r\n\r\n",
+	};
+	unsigned i;
+
+	ret = pipe(pipefd);
+	CU_ASSERT_NOT_EQUAL_FATAL(ret, -1);
+	ret = io_mon_init(&mon);
+	CU_ASSERT_EQUAL_FATAL(ret, 0);
+
+	/* normal use cases */
+	ret = io_src_sep_init_delim(&ctx.src_sep, pipefd[0], delim_cb,
+			"\r\n\r\n", 4, 32);
+	CU_ASSERT_EQUAL_FATAL(ret, 0);
+	ret = io_mon_add_source(&mon, io_src_sep_get_source(&ctx.src_sep));
+	CU_ASSERT_EQUAL(ret, 0);
+
+	/* each write splits a delimiter or a chunk */
+	for (i = 0; i < UT_ARRAY_SIZE(writes); i++) {
+		ret = write(pipefd[1], writes[i], strlen(writes[i]));
+		CU_ASSERT_EQUAL(ret, (int)strlen(writes[i]));
+		/* reads are bounded by the buffer size, drain the pipe */
+		do {
+			ret = io_mon_process_events(&mon);
+		} while (ret > 0);
+		CU_ASSERT_EQUAL(ret, 0);
+	}
+	ut_file_fd_close(&pipefd[1]);
+	ret = io_mon_poll(&mon, 100);
+	CU_ASSERT_EQUAL(ret, 1);
+	CU_ASSERT(ctx.eof);
+
+	/* the fourth chunk is emitted because the buffer is full */
+	CU_ASSERT_EQUAL(ctx.nb_chunks, 5);
+	CU_ASSERT_STRING_EQUAL(ctx.chunks[0],
+			"GET / HTTP/1.1\r\nHost: a\r\n\r\n");
+	CU_ASSERT_STRING_EQUAL(ctx.chunks[1], "GET /b HTTP/1.1\r\n\r\n");
+	CU_ASSERT_STRING_EQUAL(ctx.chunks[2],
+			"0123456789abcdefghij\r\n\r\n");
+	CU_ASSERT_STRING_EQUAL(ctx.chunks[3],
+			"01234567890123456789012345678901");
+	CU_ASSERT_STRING_EQUAL(ctx.chunks[4], "\r\n\r\n");
+
+	/* error use cases */
+	ret = io_src_sep_init_delim(&ctx.src_sep, pipefd[0], delim_cb, NULL,
+			4, 32);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+	ret = io_src_sep_init_delim(&ctx.src_sep, pipefd[0], delim_cb, "\n",
+			0, 32);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+	ret = io_src_sep_init_delim(&ctx.src_sep, pipefd[0], delim_cb,
+			"\r\n\r\n", 4, 4);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+
+	/* cleanup */
+	io_mon_clean(&mon);
+	io_src_sep_clean(&ctx.src_sep);
+	ut_file_fd_close(&pipefd[0]);
+}
+
+struct batch_ctx {
+	struct io_src_sep src_sep;
+	char chunks[DELIM_MAX_CHUNKS][IO_SRC_SEP_SIZE + 1];
+	unsigned nb_chunks;
+	unsigned nb_calls;
+	bool eof;
+};
+
+static void batch_cb(struct io_src_sep *sep, struct io_src_sep_chunk *chunks,
+		unsigned nb_chunks)
+{
+	struct batch_ctx *ctx = ut_container_of(sep, struct batch_ctx,
+			src_sep);
+	unsigned i;
+
+	if (0 == nb_chunks) {
+		ctx->eof = true;
+		return;
+	}
+
+	ctx->nb_calls++;
+	for (i = 0; i < nb_chunks; i++) {
+		CU_ASSERT(ctx->nb_chunks < DELIM_MAX_CHUNKS);
+		if (ctx->nb_chunks >= DELIM_MAX_CHUNKS)
+			return;
+		snprintf(ctx->chunks[ctx->nb_chunks++], IO_SRC_SEP_SIZE + 1,
+				"%.*s", chunks[i].len, chunks[i].data);
+	}
+}
+
+static void testSRC_SEP_INIT_BATCH(void)
+{
+	int ret;
+	struct io_mon mon;
+	struct batch_ctx ctx = {.nb_chunks = 0, .nb_calls = 0, .eof = false};
+	int pipefd[2] = {-1, -1};
+	const char *msg = "a\nbb\nccc\n0123456789012345678901234567890123"
+			"456789";
+
+	ret = pipe(pipefd);
+	CU_ASSERT_NOT_EQUAL_FATAL(ret, -1);
+	ret = io_mon_init(&mon);
+	CU_ASSERT_EQUAL_FATAL(ret, 0);
+
+	/* normal use cases */
+	ret = io_src_sep_init_batch(&ctx.src_sep, pipefd[0], batch_cb, "\n",
+			1, 32);
+	CU_ASSERT_EQUAL_FATAL(ret, 0);
+	ret = io_mon_add_source(&mon, io_src_sep_get_source(&ctx.src_sep));
+	CU_ASSERT_EQUAL(ret, 0);
+
+	ret = write(pipefd[1], msg, strlen(msg));
+	CU_ASSERT_EQUAL(ret, (int)strlen(msg));
+	ret = io_mon_poll(&mon, 100);
+	CU_ASSERT_EQUAL(ret, 1);
+
+	/* 49 bytes fit in one read, the long line is cut at 32 bytes */
+	CU_ASSERT_EQUAL(ctx.nb_calls, 1);
+	CU_ASSERT_EQUAL(ctx.nb_chunks, 4);
+	CU_ASSERT_STRING_EQUAL(ctx.chunks[0], "a\n");
+	CU_ASSERT_STRING_EQUAL(ctx.chunks[1], "bb\n");
+	CU_ASSERT_STRING_EQUAL(ctx.chunks[2], "ccc\n");
+	CU_ASSERT_STRING_EQUAL(ctx.chunks[3],
+			"01234567890123456789012345678901");
+
+	/* the rest of the long line is completed by the next read */
+	ret = write(pipefd[1], "\ny", 2);
+	CU_ASSERT_EQUAL(ret, 2);
+	ret = io_mon_poll(&mon, 100);
+	CU_ASSERT_EQUAL(ret, 1);
+	CU_ASSERT_EQUAL(ctx.nb_calls, 2);
+	CU_ASSERT_EQUAL(ctx.nb_chunks, 5);
+	CU_ASSERT_STRING_EQUAL(ctx.chunks[4], "23456789\n");
+	CU_ASSERT(!ctx.eof);
+
+	ut_file_fd_close(&pipefd[1]);
+	ret = io_mon_poll(&mon, 100);
+	CU_ASSERT_EQUAL(ret, 1);
+	CU_ASSERT(ctx.eof);
+
+	/* error use cases */
+	ret = io_src_sep_init_batch(&ctx.src_sep, pipefd[0], NULL, "\n", 1,
+			32);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+	ret = io_src_sep_init_batch(NULL, pipefd[0], batch_cb, "\n", 1, 32);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+	ret = io_src_sep_init_batch(&ctx.src_sep, pipefd[0], batch_cb, "\n",
+			1, 1);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+
+	/* cleanup */
+	io_mon_clean(&mon);
+	io_src_sep_clean(&ctx.src_sep);
+	ut_file_fd_close(&pipefd[0]);
+}
+
+static void testSRC_SEP_BATCH_FULL(void)
+{
+	int ret;
+	struct io_mon mon;
+	struct batch_ctx ctx = {.nb_chunks = 0, .nb_calls = 0, .eof = false};
+	int pipefd[2] = {-1, -1};
+
+	ret = pipe(pipefd);
+	CU_ASSERT_NOT_EQUAL_FATAL(ret, -1);
+	ret = io_mon_init(&mon);
+	CU_ASSERT_EQUAL_FATAL(ret, 0);
+	ret = io_src_sep_init_batch(&ctx.src_sep, pipefd[0], batch_cb, "\n",
+			1, 8);
+	CU_ASSERT_EQUAL_FATAL(ret, 0);
+	ret = io_mon_add_source(&mon, io_src_sep_get_source(&ctx.src_sep));
+	CU_ASSERT_EQUAL(ret, 0);
+
+	/*
+	 * state left by an allocation failure of the chunks array : the buffer
+	 * is full of data without delimiter, not consumed yet
+	 */
+	memset(ctx.src_sep.buf, 'a', 16);
+	ctx.src_sep.up_to = 16;
+	ret = write(pipefd[1], "b\n", 2);
+	CU_ASSERT_EQUAL(ret, 2);
+
+	/* the full buffer is parsed, which isn't an end of file */
+	ret = io_mon_poll(&mon, 100);
+	CU_ASSERT_EQUAL(ret, 1);
+	CU_ASSERT(!ctx.eof);
+	CU_ASSERT_EQUAL(ctx.nb_chunks, 2);
+	CU_ASSERT_STRING_EQUAL(ctx.chunks[0], "aaaaaaaa");
+	CU_ASSERT_STRING_EQUAL(ctx.chunks[1], "aaaaaaaa");
+	ret = io_mon_poll(&mon, 100);
+	CU_ASSERT_EQUAL(ret, 1);
+	CU_ASSERT(!ctx.eof);
+	CU_ASSERT_EQUAL(ctx.nb_chunks, 3);
+	CU_ASSERT_STRING_EQUAL(ctx.chunks[2], "b\n");
+
+	/* cleanup */
+	io_mon_clean(&mon);
+	io_src_sep_clean(&ctx.src_sep);
+	ut_file_fd_close(&pipefd[0]);
+	ut_file_fd_close(&pipefd[1]);
+}
+
+static void clean_cb(struct io_src_sep *sep, char *chunk, unsigned len)
+{
+	struct delim_ctx *ctx = ut_container_of(sep, struct delim_ctx,
+			src_sep);
+
+	ctx->nb_chunks++;
+	io_src_sep_clean(sep);
+}
+
+static void batch_clean_cb(struct io_src_sep *sep,
+		struct io_src_sep_chunk *chunks, unsigned nb_chunks)
+{
+	struct batch_ctx *ctx = ut_container_of(sep, struct batch_ctx,
+			src_sep);
+
+	ctx->nb_calls++;
+	io_src_sep_clean(sep);
+}
+
+static void testSRC_SEP_CLEAN_IN_CB(void)
+{
+	int ret;
+	struct io_mon mon;
+	struct delim_ctx ctx = {.nb_chunks = 0, .eof = false};
+	struct batch_ctx batch = {.nb_chunks = 0, .nb_calls = 0, .eof = false};
+	int pipefd[2] = {-1, -1};
+
+	ret = pipe(pipefd);
+	CU_ASSERT_NOT_EQUAL_FATAL(ret, -1);
+	ret = io_mon_init(&mon);
+	CU_ASSERT_EQUAL_FATAL(ret, 0);
+
+	/* the client cleans the source on the first of three chunks */
+	ret = io_src_sep_init_delim(&ctx.src_sep, pipefd[0], clean_cb, "\n", 1,
+			32);
+	CU_ASSERT_EQUAL_FATAL(ret, 0);
+	ret = io_mon_add_source(&mon, io_src_sep_get_source(&ctx.src_sep));
+	CU_ASSERT_EQUAL(ret, 0);
+	ret = write(pipefd[1], "a\nb\nc\n", 6);
+	CU_ASSERT_EQUAL(ret, 6);
+	io_mon_poll(&mon, 100);
+	CU_ASSERT_EQUAL(ctx.nb_chunks, 1);
+	CU_ASSERT_PTR_NULL(ctx.src_sep.buf);
+	CU_ASSERT_EQUAL(ctx.src_sep.src.fd, -1);
+	io_mon_clean(&mon);
+
+	/* same in batch mode */
+	ret = io_mon_init(&mon);
+	CU_ASSERT_EQUAL_FATAL(ret, 0);
+	ret = io_src_sep_init_batch(&batch.src_sep, pipefd[0], batch_clean_cb,
+			"\n", 1, 32);
+	CU_ASSERT_EQUAL_FATAL(ret, 0);
+	ret = io_mon_add_source(&mon, io_src_sep_get_source(&batch.src_sep));
+	CU_ASSERT_EQUAL(ret, 0);
+	ret = write(pipefd[1], "a\nb\nc\n", 6);
+	CU_ASSERT_EQUAL(ret, 6);
+	io_mon_poll(&mon, 100);
+	CU_ASSERT_EQUAL(batch.nb_calls, 1);
+	CU_ASSERT_PTR_NULL(batch.src_sep.buf);
+	CU_ASSERT_PTR_NULL(batch.src_sep.chunks);
+
+	/* cleanup */
+	io_mon_clean(&mon);
+	ut_file_fd_close(&pipefd[0]);
+	ut_file_fd_close(&pipefd[1]);
+}
+
 static void dummy_cb(struct io_src_sep *sep, char *chunk, unsigned len)
 {
 
 }
 
+static void testSRC_SEP_DELIM_LEN(void)
+{
+	int ret;
+	struct io_src_sep sep_src;
+	int pipefd[2] = {-1, -1};
+
+	ret = pipe(pipefd);
+	CU_ASSERT_NOT_EQUAL_FATAL(ret, -1);
+
+	/* io_src_sep_init() is a special case of io_src_sep_init_delim() */
+	ret = io_src_sep_init(&sep_src, pipefd[0], dummy_cb, '\n', INT_MAX);
+	CU_ASSERT_EQUAL(ret, 0);
+	CU_ASSERT_EQUAL(sep_src.delim_len, 1);
+	CU_ASSERT_EQUAL(sep_src.delim[0], '\n');
+	CU_ASSERT_EQUAL(sep_src.size, IO_SRC_SEP_SIZE);
+	io_src_sep_clean(&sep_src);
+	ret = io_src_sep_init(&sep_src, pipefd[0], dummy_cb, '\r', '\n');
+	CU_ASSERT_EQUAL(ret, 0);
+	CU_ASSERT_EQUAL(sep_src.delim_len, 2);
+	CU_ASSERT_EQUAL(0, memcmp(sep_src.delim, "\r\n", 2));
+	io_src_sep_clean(&sep_src);
+
+	/* the delimiter must be shorter than the buffer */
+	ret = io_src_sep_init_delim(&sep_src, pipefd[0], dummy_cb, "\r\n", 2,
+			2);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+	ret = io_src_sep_init_delim(&sep_src, pipefd[0], dummy_cb, "\r\n", 2,
+			3);
+	CU_ASSERT_EQUAL(ret, 0);
+	CU_ASSERT_EQUAL(sep_src.delim_len, 2);
+	io_src_sep_clean(&sep_src);
+
+	/* cleanup */
+	ut_file_fd_close(&pipefd[0]);
+	ut_file_fd_close(&pipefd[1]);
+}
+
 static void testSRC_SEP_GET_SOURCE(void)
 {
 	int ret;
@@ -225,6 +567,26 @@ static const struct test_t tests[] = {
 				.fn = testSRC_SEP_INIT,
 				.name = "io_src_sep_init"
 		},
+		{
+				.fn = testSRC_SEP_INIT_DELIM,
+				.name = "io_src_sep_init_delim"
+		},
+		{
+				.fn = testSRC_SEP_INIT_BATCH,
+				.name = "io_src_sep_init_batch"
+		},
+		{
+				.fn = testSRC_SEP_BATCH_FULL,
+				.name = "io_src_sep batch full buffer"
+		},
+		{
+				.fn = testSRC_SEP_CLEAN_IN_CB,
+				.name = "io_src_sep_clean from callback"
+		},
+		{
+				.fn = testSRC_SEP_DELIM_LEN,
+				.name = "io_src_sep delimiter length"
+		},
 		{
 				.fn = testSRC_SEP_GET_SOURCE,
 				.name = "io_src_sep_get_source"
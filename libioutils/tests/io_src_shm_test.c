@@ -0,0 +1,274 @@
+/**
+ * @file io_src_shm_test.c
+ * @date 19 oct. 2026
+ * @author nicolas.carrier@parrot.com
+ * @brief Unit tests for shared memory ring source
+ *
+ * Copyright (C) 2026 Parrot S.A.
+ */
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif /* _GNU_SOURCE */
+#include <sys/mman.h>
+
+#include <fcntl.h>
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+
+#include <errno.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <CUnit/Basic.h>
+
+#include <ut_utils.h>
+
+#include <fautes.h>
+
+#include <io_mon.h>
+#include <io_src_shm.h>
+
+#define NB_MESSAGES 100000
+
+static unsigned nb_received;
+static size_t last_len;
+static char last_msg[16];
+static bool in_order;
+
+static void msg_cb(struct io_src_shm *shm, const void *msg, size_t len)
+{
+	nb_received++;
+	last_len = len;
+	memcpy(last_msg, msg, len < sizeof(last_msg) ? len : sizeof(last_msg));
+}
+
+static void counter_cb(struct io_src_shm *shm, const void *msg, size_t len)
+{
+	uint32_t value;
+
+	memcpy(&value, msg, sizeof(value));
+	in_order = in_order && len == sizeof(value) && value == nb_received;
+	nb_received++;
+}
+
+static void testSRC_SHM_INIT(void)
+{
+	int ret;
+	int mem_fd;
+	int evt_fd;
+	int fd;
+	struct io_src_shm consumer;
+	struct io_src_shm producer;
+
+	/* normal use cases */
+	ret = io_src_shm_init(&consumer, msg_cb, 1);
+	CU_ASSERT_EQUAL_FATAL(ret, 0);
+	CU_ASSERT_PTR_NOT_NULL(io_src_shm_get_source(&consumer));
+	ret = io_src_shm_get_fds(&consumer, &mem_fd, &evt_fd);
+	CU_ASSERT_EQUAL(ret, 0);
+	ret = io_src_shm_init_producer(&producer, mem_fd, evt_fd);
+	CU_ASSERT_EQUAL(ret, 0);
+	CU_ASSERT_PTR_NULL(io_src_shm_get_source(&producer));
+	CU_ASSERT_NOT_EQUAL(producer.src.fd, evt_fd);
+	io_src_shm_clean(&producer);
+
+	/* error use cases */
+	ret = io_src_shm_init(NULL, msg_cb, 1);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+	ret = io_src_shm_init(&producer, NULL, 1);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+	ret = io_src_shm_init(&producer, msg_cb, 0);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+	ret = io_src_shm_init(&producer, msg_cb, 3 * sysconf(_SC_PAGE_SIZE));
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+	ret = io_src_shm_get_fds(NULL, &mem_fd, &evt_fd);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+	ret = io_src_shm_get_fds(&consumer, NULL, &evt_fd);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+	ret = io_src_shm_get_fds(&consumer, &mem_fd, NULL);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+	ret = io_src_shm_init_producer(NULL, mem_fd, evt_fd);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+	ret = io_src_shm_init_producer(&producer, -1, evt_fd);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+	ret = io_src_shm_init_producer(&producer, mem_fd, -1);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+	/* a memfd which isn't sealed could be truncated under our feet */
+	fd = memfd_create("io_src_shm_test", MFD_CLOEXEC);
+	CU_ASSERT_FATAL(fd >= 0);
+	ret = io_src_shm_init_producer(&producer, fd, evt_fd);
+	CU_ASSERT_EQUAL(ret, -EPERM);
+	close(fd);
+	/* not a ring */
+	fd = memfd_create("io_src_shm_test", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+	CU_ASSERT_FATAL(fd >= 0);
+	CU_ASSERT_EQUAL(ftruncate(fd, 2 * sysconf(_SC_PAGE_SIZE)), 0);
+	CU_ASSERT_EQUAL(fcntl(fd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW),
+			0);
+	ret = io_src_shm_init_producer(&producer, fd, evt_fd);
+	CU_ASSERT_EQUAL(ret, -EBADMSG);
+	close(fd);
+
+	/* cleanup */
+	io_src_shm_clean(&consumer);
+}
+
+static void testSRC_SHM_SEND(void)
+{
+	int ret;
+	int mem_fd;
+	int evt_fd;
+	uint64_t value;
+	struct io_mon mon;
+	struct io_src_shm consumer;
+	struct io_src_shm producer;
+	size_t size;
+	char *big;
+
+	ret = io_mon_init(&mon);
+	CU_ASSERT_EQUAL_FATAL(ret, 0);
+	ret = io_src_shm_init(&consumer, msg_cb, 1);
+	CU_ASSERT_EQUAL_FATAL(ret, 0);
+	ret = io_mon_add_source(&mon, io_src_shm_get_source(&consumer));
+	CU_ASSERT_EQUAL_FATAL(ret, 0);
+	io_src_shm_get_fds(&consumer, &mem_fd, &evt_fd);
+	ret = io_src_shm_init_producer(&producer, mem_fd, evt_fd);
+	CU_ASSERT_EQUAL_FATAL(ret, 0);
+	size = rs_rb_get_size(&consumer.rb);
+
+	/* normal use cases */
+	nb_received = 0;
+	ret = io_src_shm_send(&producer, "ursule", 6);
+	CU_ASSERT_EQUAL(ret, 0);
+	ret = io_src_shm_send(&producer, NULL, 0);
+	CU_ASSERT_EQUAL(ret, 0);
+	ret = io_src_shm_send(&producer, "gloubi boulga", 13);
+	CU_ASSERT_EQUAL(ret, 0);
+	/* the consumer sleeps, it has been notified only once */
+	CU_ASSERT_EQUAL(read(evt_fd, &value, sizeof(value)), sizeof(value));
+	CU_ASSERT_EQUAL(value, 1);
+	value = 1;
+	CU_ASSERT_EQUAL(write(evt_fd, &value, sizeof(value)), sizeof(value));
+	ret = io_mon_poll(&mon, 1000);
+	CU_ASSERT_EQUAL(ret, 1);
+	CU_ASSERT_EQUAL(nb_received, 3);
+	CU_ASSERT_EQUAL(last_len, 13);
+	CU_ASSERT_EQUAL(memcmp(last_msg, "gloubi boulga", 13), 0);
+	/* back to sleep, the next message notifies it again */
+	ret = io_src_shm_send(&producer, "a", 1);
+	CU_ASSERT_EQUAL(ret, 0);
+	ret = io_mon_poll(&mon, 1000);
+	CU_ASSERT_EQUAL(ret, 1);
+	CU_ASSERT_EQUAL(nb_received, 4);
+	CU_ASSERT_EQUAL(last_len, 1);
+	/* the biggest message fills the ring, wrapping */
+	big = calloc(1, size);
+	CU_ASSERT_PTR_NOT_NULL_FATAL(big);
+	ret = io_src_shm_send(&producer, big, size - 8);
+	CU_ASSERT_EQUAL(ret, 0);
+	ret = io_src_shm_send(&producer, NULL, 0);
+	CU_ASSERT_EQUAL(ret, -EAGAIN);
+	ret = io_mon_poll(&mon, 1000);
+	CU_ASSERT_EQUAL(ret, 1);
+	CU_ASSERT_EQUAL(nb_received, 5);
+	CU_ASSERT_EQUAL(last_len, size - 8);
+
+	/* error use cases */
+	ret = io_src_shm_send(&producer, big, size - 7);
+	CU_ASSERT_EQUAL(ret, -EMSGSIZE);
+	ret = io_src_shm_send(&consumer, "a", 1);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+	ret = io_src_shm_send(NULL, "a", 1);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+	ret = io_src_shm_send(&producer, NULL, 1);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+
+	/* cleanup */
+	free(big);
+	io_src_shm_clean(&producer);
+	io_mon_clean(&mon);
+	io_src_shm_clean(&consumer);
+}
+
+static void *producer_thread(void *arg)
+{
+	struct io_src_shm *producer = arg;
+	uint32_t value;
+	int ret;
+
+	for (value = 0; value < NB_MESSAGES; value++) {
+		while ((ret = io_src_shm_send(producer, &value,
+				sizeof(value))) == -EAGAIN)
+			sched_yield();
+		if (ret < 0)
+			break;
+	}
+
+	return NULL;
+}
+
+static void testSRC_SHM_CONCURRENCY(void)
+{
+	int ret;
+	int mem_fd;
+	int evt_fd;
+	int i;
+	struct io_mon mon;
+	struct io_src_shm consumer;
+	struct io_src_shm producer;
+	pthread_t thread;
+
+	ret = io_mon_init(&mon);
+	CU_ASSERT_EQUAL_FATAL(ret, 0);
+	ret = io_src_shm_init(&consumer, counter_cb, 1);
+	CU_ASSERT_EQUAL_FATAL(ret, 0);
+	ret = io_mon_add_source(&mon, io_src_shm_get_source(&consumer));
+	CU_ASSERT_EQUAL_FATAL(ret, 0);
+	io_src_shm_get_fds(&consumer, &mem_fd, &evt_fd);
+	ret = io_src_shm_init_producer(&producer, mem_fd, evt_fd);
+	CU_ASSERT_EQUAL_FATAL(ret, 0);
+	nb_received = 0;
+	in_order = true;
+
+	/* no wakeup is lost, the loop would time out */
+	ret = pthread_create(&thread, NULL, producer_thread, &producer);
+	CU_ASSERT_EQUAL_FATAL(ret, 0);
+	for (i = 0; i < 5000 && nb_received < NB_MESSAGES; i++)
+		io_mon_poll(&mon, 1000);
+	pthread_join(thread, NULL);
+	CU_ASSERT_EQUAL(nb_received, NB_MESSAGES);
+	CU_ASSERT(in_order);
+
+	/* cleanup */
+	io_src_shm_clean(&producer);
+	io_mon_clean(&mon);
+	io_src_shm_clean(&consumer);
+}
+
+static const struct test_t tests[] = {
+		{
+				.fn = testSRC_SHM_INIT,
+				.name = "io_src_shm_init"
+		},
+		{
+				.fn = testSRC_SHM_SEND,
+				.name = "io_src_shm_send"
+		},
+		{
+				.fn = testSRC_SHM_CONCURRENCY,
+				.name = "io_src_shm_concurrency"
+		},
+
+		/* NULL guard */
+		{.fn = NULL, .name = NULL},
+};
+
+struct suite_t src_shm_suite = {
+		.name = "io_src_shm",
+		.init = NULL,
+		.clean = NULL,
+		.tests = tests,
+};
@@ -0,0 +1,330 @@
+/**
+ * @file io_src_sock_test.c
+ * @date 19 oct. 2026
+ * @author nicolas.carrier@parrot.com
+ * @brief Unit tests for the connection oriented sockets sources
+ *
+ * Copyright (C) 2026 Parrot S.A.
+ */
+#include <sys/resource.h>
+
+#include <stdbool.h>
+
+#include <CUnit/Basic.h>
+
+#include <ut_utils.h>
+#include <ut_file.h>
+
+#include <io_src_sock.h>
+#include <io_mon.h>
+#include <io_utils.h>
+
+#include <fautes.h>
+
+#define NB_CLIENTS 3
+#define FD_LIMIT 256
+#define MSG "gloubi boulga"
+
+struct echo_server {
+	struct io_src_sock_listener listener;
+	struct io_src_sock_conn conns[NB_CLIENTS];
+	unsigned nb_conns;
+	struct io_io_write_buffer buffers[NB_CLIENTS];
+	char echo[NB_CLIENTS][sizeof(MSG)];
+	struct io_mon mon;
+};
+
+#define to_echo_server(l) ut_container_of(l, struct echo_server, listener)
+
+static void write_cb(struct io_io_write_buffer *buffer,
+		enum io_io_write_status status)
+{
+	CU_ASSERT_EQUAL(status, IO_IO_WRITE_OK);
+}
+
+static int echo_read_cb(struct io_io *io, struct rs_rb *rb, void *data)
+{
+	struct echo_server *server = data;
+	struct io_src_sock_conn *conn;
+	unsigned i;
+
+	conn = ut_container_of(io, struct io_src_sock_conn, io);
+	i = conn - server->conns;
+	if (rs_rb_get_read_length(rb) < sizeof(MSG))
+		return 0;
+
+	memcpy(server->echo[i], rs_rb_get_read_ptr(rb), sizeof(MSG));
+	rs_rb_read_incr(rb, sizeof(MSG));
+	server->buffers[i].address = server->echo[i];
+	server->buffers[i].length = sizeof(MSG);
+	server->buffers[i].cb = write_cb;
+	CU_ASSERT_EQUAL(io_io_write_add(io, server->buffers + i), 0);
+
+	return 0;
+}
+
+static void accept_cb(struct io_src_sock_listener *listener, int fd)
+{
+	struct echo_server *server = to_echo_server(listener);
+	struct io_src_sock_conn *conn;
+	int ret;
+
+	CU_ASSERT_FATAL(server->nb_conns < NB_CLIENTS);
+	conn = server->conns + server->nb_conns++;
+	ret = io_src_sock_conn_init(conn, &server->mon, "echo", fd);
+	CU_ASSERT_EQUAL_FATAL(ret, 0);
+	ret = io_io_read_start(io_src_sock_conn_get_io(conn), echo_read_cb,
+			server, 0);
+	CU_ASSERT_EQUAL(ret, 0);
+}
+
+static void echo_test(enum io_src_sock_type type, const char *address)
+{
+	struct echo_server server;
+	int clients[NB_CLIENTS];
+	char buf[sizeof(MSG)];
+	unsigned i;
+	int port;
+	int ret;
+
+	memset(&server, 0, sizeof(server));
+	ret = io_mon_init(&server.mon);
+	CU_ASSERT_EQUAL_FATAL(ret, 0);
+	ret = io_src_sock_listener_init(&server.listener, type, accept_cb,
+			"%s", address);
+	CU_ASSERT_EQUAL_FATAL(ret, 0);
+	ret = io_mon_add_source(&server.mon,
+			io_src_sock_listener_get_source(&server.listener));
+	CU_ASSERT_EQUAL_FATAL(ret, 0);
+
+	port = 0;
+	if (type == IO_SRC_SOCK_TCP) {
+		port = io_src_sock_get_port(&server.listener);
+		CU_ASSERT(port > 0);
+	}
+
+	/* all the connections must be accepted in one go */
+	for (i = 0; i < NB_CLIENTS; i++) {
+		if (type == IO_SRC_SOCK_TCP)
+			clients[i] = io_src_sock_connect(type, "127.0.0.1:%d",
+					port);
+		else
+			clients[i] = io_src_sock_connect(type, "%s", address);
+		CU_ASSERT_FATAL(clients[i] >= 0);
+	}
+	ret = io_mon_poll(&server.mon, 100);
+	CU_ASSERT_EQUAL(ret, 1);
+	CU_ASSERT_EQUAL(server.nb_conns, NB_CLIENTS);
+
+	for (i = 0; i < NB_CLIENTS; i++) {
+		ret = io_write(clients[i], MSG, sizeof(MSG));
+		CU_ASSERT_EQUAL(ret, sizeof(MSG));
+	}
+	for (i = 0; i < NB_CLIENTS; i++) {
+		do {
+			ret = io_read(clients[i], buf, sizeof(buf));
+			if (ret < 0 && errno == EAGAIN)
+				CU_ASSERT(io_mon_poll(&server.mon, 100) > 0);
+		} while (ret < 0 && errno == EAGAIN);
+		CU_ASSERT_EQUAL(ret, sizeof(MSG));
+		CU_ASSERT_STRING_EQUAL(buf, MSG);
+	}
+
+	/* a client closing must be seen as an end of file */
+	ut_file_fd_close(clients);
+	ret = io_mon_poll(&server.mon, 100);
+	CU_ASSERT_EQUAL(ret, 1);
+	CU_ASSERT(io_io_has_read_error(&server.conns[0].io));
+
+	for (i = 0; i < NB_CLIENTS; i++) {
+		ut_file_fd_close(clients + i);
+		io_src_sock_conn_clean(server.conns + i);
+		CU_ASSERT_EQUAL(server.conns[i].fd, -1);
+	}
+	io_src_sock_listener_clean(&server.listener);
+	io_mon_clean(&server.mon);
+}
+
+static void testSRC_SOCK_LISTENER_INIT(void)
+{
+	struct io_src_sock_listener listener;
+	int ret;
+
+	ret = io_src_sock_listener_init(&listener, IO_SRC_SOCK_UNIX_STREAM,
+			accept_cb, "@io_src_sock_test_%d", 1);
+	CU_ASSERT_EQUAL(ret, 0);
+	CU_ASSERT_EQUAL(io_src_sock_get_port(&listener), -EINVAL);
+	io_src_sock_listener_clean(&listener);
+
+	ret = io_src_sock_listener_init(&listener, IO_SRC_SOCK_UNIX_SEQPACKET,
+			accept_cb, "/tmp/io_src_sock_test_%d", 2);
+	CU_ASSERT_EQUAL(ret, 0);
+	io_src_sock_listener_clean(&listener);
+	CU_ASSERT_NOT_EQUAL(access("/tmp/io_src_sock_test_2", F_OK), 0);
+
+	ret = io_src_sock_listener_init(&listener, IO_SRC_SOCK_TCP, accept_cb,
+			"127.0.0.1:0");
+	CU_ASSERT_EQUAL(ret, 0);
+	CU_ASSERT(io_src_sock_get_port(&listener) > 0);
+	io_src_sock_listener_clean(&listener);
+
+	/* error cases */
+	ret = io_src_sock_listener_init(NULL, IO_SRC_SOCK_TCP, accept_cb,
+			"127.0.0.1:0");
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+	ret = io_src_sock_listener_init(&listener, 42, accept_cb,
+			"127.0.0.1:0");
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+	ret = io_src_sock_listener_init(&listener, IO_SRC_SOCK_TCP, NULL,
+			"127.0.0.1:0");
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+	ret = io_src_sock_listener_init(&listener, IO_SRC_SOCK_TCP, accept_cb,
+			"%s", "");
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+	ret = io_src_sock_listener_init(&listener, IO_SRC_SOCK_TCP, accept_cb,
+			"127.0.0.1");
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+	ret = io_src_sock_listener_init(&listener, IO_SRC_SOCK_TCP, accept_cb,
+			"127.0.0.1:65536");
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+	ret = io_src_sock_listener_init(&listener, IO_SRC_SOCK_TCP, accept_cb,
+			"localhost:4242");
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+	ret = io_src_sock_listener_init(&listener, IO_SRC_SOCK_UNIX_STREAM,
+			accept_cb, "@%0200d", 0);
+	CU_ASSERT_EQUAL(ret, -ENAMETOOLONG);
+}
+
+static void testSRC_SOCK_CONNECT(void)
+{
+	int ret;
+
+	ret = io_src_sock_connect(IO_SRC_SOCK_UNIX_STREAM,
+			"@io_src_sock_test_nobody_listens");
+	CU_ASSERT_EQUAL(ret, -ECONNREFUSED);
+
+	/* error cases */
+	ret = io_src_sock_connect(42, "@io_src_sock_test");
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+	ret = io_src_sock_connect(IO_SRC_SOCK_TCP, NULL);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+}
+
+static void testSRC_SOCK_UNIX_STREAM(void)
+{
+	echo_test(IO_SRC_SOCK_UNIX_STREAM, "@io_src_sock_test_stream");
+}
+
+static void testSRC_SOCK_UNIX_SEQPACKET(void)
+{
+	echo_test(IO_SRC_SOCK_UNIX_SEQPACKET, "@io_src_sock_test_seqpacket");
+}
+
+static void testSRC_SOCK_TCP(void)
+{
+	echo_test(IO_SRC_SOCK_TCP, "127.0.0.1:0");
+}
+
+static void testSRC_SOCK_FD_EXHAUSTION(void)
+{
+	struct echo_server server;
+	struct rlimit old_limit;
+	struct rlimit limit;
+	static int fds[FD_LIMIT];
+	unsigned nb_fds;
+	char buf[sizeof(MSG)];
+	int client;
+	int ret;
+
+	memset(&server, 0, sizeof(server));
+	ret = io_mon_init(&server.mon);
+	CU_ASSERT_EQUAL_FATAL(ret, 0);
+	ret = io_src_sock_listener_init(&server.listener,
+			IO_SRC_SOCK_UNIX_STREAM, accept_cb,
+			"@io_src_sock_test_exhaustion");
+	CU_ASSERT_EQUAL_FATAL(ret, 0);
+	ret = io_mon_add_source(&server.mon,
+			io_src_sock_listener_get_source(&server.listener));
+	CU_ASSERT_EQUAL_FATAL(ret, 0);
+	client = io_src_sock_connect(IO_SRC_SOCK_UNIX_STREAM,
+			"@io_src_sock_test_exhaustion");
+	CU_ASSERT_FATAL(client >= 0);
+
+	/* use all the file descriptors available */
+	ret = getrlimit(RLIMIT_NOFILE, &old_limit);
+	CU_ASSERT_EQUAL_FATAL(ret, 0);
+	limit = old_limit;
+	limit.rlim_cur = FD_LIMIT;
+	ret = setrlimit(RLIMIT_NOFILE, &limit);
+	CU_ASSERT_EQUAL_FATAL(ret, 0);
+	for (nb_fds = 0; nb_fds < FD_LIMIT; nb_fds++) {
+		fds[nb_fds] = dup(client);
+		if (-1 == fds[nb_fds])
+			break;
+	}
+	CU_ASSERT_EQUAL(errno, EMFILE);
+
+	/* the connection must be refused and not stay pending */
+	ret = io_mon_poll(&server.mon, 100);
+	CU_ASSERT_EQUAL(ret, 1);
+	CU_ASSERT_EQUAL(server.nb_conns, 0);
+	ret = io_read(client, buf, sizeof(buf));
+	CU_ASSERT_EQUAL(ret, 0);
+	ret = io_mon_poll(&server.mon, 0);
+	CU_ASSERT_EQUAL(ret, 0);
+
+	/* cleanup */
+	while (nb_fds-- > 0)
+		ut_file_fd_close(fds + nb_fds);
+	setrlimit(RLIMIT_NOFILE, &old_limit);
+	ut_file_fd_close(&client);
+	io_src_sock_listener_clean(&server.listener);
+	io_mon_clean(&server.mon);
+}
+
+static const struct test_t tests[] = {
+		{
+				.fn = testSRC_SOCK_LISTENER_INIT,
+				.name = "io_src_sock_listener_init"
+		},
+		{
+				.fn = testSRC_SOCK_CONNECT,
+				.name = "io_src_sock_connect"
+		},
+		{
+				.fn = testSRC_SOCK_UNIX_STREAM,
+				.name = "io_src_sock unix stream"
+		},
+		{
+				.fn = testSRC_SOCK_UNIX_SEQPACKET,
+				.name = "io_src_sock unix seqpacket"
+		},
+		{
+				.fn = testSRC_SOCK_TCP,
+				.name = "io_src_sock tcp"
+		},
+		{
+				.fn = testSRC_SOCK_FD_EXHAUSTION,
+				.name = "io_src_sock fd exhaustion"
+		},
+
+		/* NULL guard */
+		{.fn = NULL, .name = NULL},
+};
+
+static int init_src_sock_suite(void)
+{
+	return 0; /* return non-zero on error */
+}
+
+static int clean_src_sock_suite(void)
+{
+	return 0; /* return non-zero on error */
+}
+
+struct suite_t src_sock_suite = {
+		.name = "io_src_sock",
+		.init = init_src_sock_suite,
+		.clean = clean_src_sock_suite,
+		.tests = tests,
+};
@@ -0,0 +1,263 @@
+/**
+ * @file io_src_thread_pool_test.c
+ * @date 19 oct. 2026
+ * @author nicolas.carrier@parrot.com
+ * @brief Unit tests for thread pool source
+ *
+ * Copyright (C) 2026 Parrot S.A.
+ */
+#include <pthread.h>
+#include <unistd.h>
+
+#include <errno.h>
+#include <stdbool.h>
+
+#include <CUnit/Basic.h>
+
+#include <ut_utils.h>
+
+#include <fautes.h>
+
+#include <io_mon.h>
+#include <io_src_thread_pool.h>
+
+#define NB_JOBS 1000
+
+struct my_job {
+	struct io_src_thread_pool_job job;
+	int value;
+	int done;
+	int ret;
+	pthread_t done_thread;
+};
+
+static int counter;
+static volatile bool released;
+static struct io_src_thread_pool *cleaned_pool;
+
+static int count_work(struct io_src_thread_pool_job *job)
+{
+	struct my_job *j = ut_container_of(job, struct my_job, job);
+
+	__atomic_add_fetch(&counter, 1, __ATOMIC_RELAXED);
+
+	return j->value * 2;
+}
+
+static int blocking_work(struct io_src_thread_pool_job *job)
+{
+	while (!released)
+		usleep(1000);
+
+	return 0;
+}
+
+/* blocks until the pool it runs in is cleaned */
+static int wait_clean_work(struct io_src_thread_pool_job *job)
+{
+	while (!__atomic_load_n(&cleaned_pool->stop, __ATOMIC_RELAXED))
+		usleep(1000);
+
+	return 0;
+}
+
+static void done_cb(struct io_src_thread_pool_job *job, int ret)
+{
+	struct my_job *j = ut_container_of(job, struct my_job, job);
+
+	j->done++;
+	j->ret = ret;
+	j->done_thread = pthread_self();
+}
+
+static void poll_until_idle(struct io_mon *mon, struct io_src_thread_pool *pool)
+{
+	int i;
+
+	for (i = 0; i < 500 && io_src_thread_pool_get_pending(pool) != 0; i++)
+		io_mon_poll(mon, 10);
+}
+
+static void testSRC_THREAD_POOL_INIT(void)
+{
+	int ret;
+	struct io_mon mon;
+	struct io_src_thread_pool pool;
+
+	ret = io_mon_init(&mon);
+	CU_ASSERT_EQUAL_FATAL(ret, 0);
+
+	/* normal use cases */
+	ret = io_src_thread_pool_init(&pool, &mon, 0);
+	CU_ASSERT_EQUAL(ret, 0);
+	CU_ASSERT(pool.nb_workers > 0);
+	CU_ASSERT_EQUAL(io_src_thread_pool_get_pending(&pool), 0);
+	io_src_thread_pool_clean(&pool);
+	ret = io_src_thread_pool_init(&pool, &mon, 3);
+	CU_ASSERT_EQUAL(ret, 0);
+	CU_ASSERT_EQUAL(pool.nb_workers, 3);
+	io_src_thread_pool_clean(&pool);
+
+	/* error use cases */
+	ret = io_src_thread_pool_init(NULL, &mon, 1);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+	ret = io_src_thread_pool_init(&pool, NULL, 1);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+
+	/* cleanup */
+	io_mon_clean(&mon);
+}
+
+static void testSRC_THREAD_POOL_SUBMIT(void)
+{
+	int ret;
+	int i;
+	bool all_done = true;
+	struct io_mon mon;
+	struct io_src_thread_pool pool;
+	static struct my_job jobs[NB_JOBS];
+	pthread_t self = pthread_self();
+
+	ret = io_mon_init(&mon);
+	CU_ASSERT_EQUAL_FATAL(ret, 0);
+	ret = io_src_thread_pool_init(&pool, &mon, 4);
+	CU_ASSERT_EQUAL_FATAL(ret, 0);
+
+	/* normal use cases */
+	counter = 0;
+	for (i = 0; i < NB_JOBS; i++) {
+		jobs[i] = (struct my_job) {.value = i};
+		ret = io_src_thread_pool_submit(&pool, &jobs[i].job, count_work,
+				done_cb);
+		CU_ASSERT_EQUAL(ret, 0);
+	}
+	CU_ASSERT_EQUAL(io_src_thread_pool_get_pending(&pool), NB_JOBS);
+	poll_until_idle(&mon, &pool);
+	CU_ASSERT_EQUAL(io_src_thread_pool_get_pending(&pool), 0);
+	CU_ASSERT_EQUAL(counter, NB_JOBS);
+	for (i = 0; i < NB_JOBS; i++)
+		all_done = all_done && jobs[i].done == 1 &&
+				jobs[i].ret == 2 * i &&
+				pthread_equal(jobs[i].done_thread, self);
+	CU_ASSERT(all_done);
+
+	/* a completed job can be submitted again */
+	ret = io_src_thread_pool_submit(&pool, &jobs[0].job, count_work,
+			done_cb);
+	CU_ASSERT_EQUAL(ret, 0);
+	poll_until_idle(&mon, &pool);
+	CU_ASSERT_EQUAL(jobs[0].done, 2);
+
+	/* error use cases */
+	ret = io_src_thread_pool_submit(NULL, &jobs[0].job, count_work,
+			done_cb);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+	ret = io_src_thread_pool_submit(&pool, NULL, count_work, done_cb);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+	ret = io_src_thread_pool_submit(&pool, &jobs[0].job, NULL, done_cb);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+	ret = io_src_thread_pool_submit(&pool, &jobs[0].job, count_work, NULL);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+
+	/* cleanup */
+	io_src_thread_pool_clean(&pool);
+	io_mon_clean(&mon);
+}
+
+static void testSRC_THREAD_POOL_STEAL(void)
+{
+	int ret;
+	struct io_mon mon;
+	struct io_src_thread_pool pool;
+	struct my_job blocking = {.value = 0};
+	struct my_job second = {.value = 1};
+	struct my_job third = {.value = 2};
+
+	ret = io_mon_init(&mon);
+	CU_ASSERT_EQUAL_FATAL(ret, 0);
+	ret = io_src_thread_pool_init(&pool, &mon, 2);
+	CU_ASSERT_EQUAL_FATAL(ret, 0);
+
+	/*
+	 * third is queued behind blocking, on the first worker, it can only
+	 * complete if the second worker steals it
+	 */
+	released = false;
+	io_src_thread_pool_submit(&pool, &blocking.job, blocking_work, done_cb);
+	io_src_thread_pool_submit(&pool, &second.job, count_work, done_cb);
+	io_src_thread_pool_submit(&pool, &third.job, count_work, done_cb);
+	poll_until_idle(&mon, &pool);
+	CU_ASSERT_EQUAL(io_src_thread_pool_get_pending(&pool), 1);
+	CU_ASSERT_EQUAL(blocking.done, 0);
+	CU_ASSERT_EQUAL(second.done, 1);
+	CU_ASSERT_EQUAL(third.done, 1);
+	CU_ASSERT_EQUAL(third.ret, 4);
+
+	released = true;
+	poll_until_idle(&mon, &pool);
+	CU_ASSERT_EQUAL(blocking.done, 1);
+
+	/* cleanup */
+	io_src_thread_pool_clean(&pool);
+	io_mon_clean(&mon);
+}
+
+static void testSRC_THREAD_POOL_CLEAN(void)
+{
+	int ret;
+	struct io_mon mon;
+	struct io_src_thread_pool pool;
+	struct my_job blocking = {.value = 0};
+	struct my_job queued = {.value = 1};
+
+	ret = io_mon_init(&mon);
+	CU_ASSERT_EQUAL_FATAL(ret, 0);
+	ret = io_src_thread_pool_init(&pool, &mon, 1);
+	CU_ASSERT_EQUAL_FATAL(ret, 0);
+
+	/* the running job completes, the queued one is cancelled */
+	cleaned_pool = &pool;
+	io_src_thread_pool_submit(&pool, &blocking.job, wait_clean_work,
+			done_cb);
+	/* let the worker start the job */
+	while (__atomic_load_n(&pool.nb_queued, __ATOMIC_RELAXED) != 0)
+		usleep(1000);
+	io_src_thread_pool_submit(&pool, &queued.job, count_work, done_cb);
+	io_src_thread_pool_clean(&pool);
+	CU_ASSERT_EQUAL(blocking.done, 1);
+	CU_ASSERT_EQUAL(blocking.ret, 0);
+	CU_ASSERT_EQUAL(queued.done, 1);
+	CU_ASSERT_EQUAL(queued.ret, -ECANCELED);
+
+	/* cleanup */
+	io_mon_clean(&mon);
+}
+
+static const struct test_t tests[] = {
+		{
+				.fn = testSRC_THREAD_POOL_INIT,
+				.name = "io_src_thread_pool_init"
+		},
+		{
+				.fn = testSRC_THREAD_POOL_SUBMIT,
+				.name = "io_src_thread_pool_submit"
+		},
+		{
+				.fn = testSRC_THREAD_POOL_STEAL,
+				.name = "io_src_thread_pool_steal"
+		},
+		{
+				.fn = testSRC_THREAD_POOL_CLEAN,
+				.name = "io_src_thread_pool_clean"
+		},
+
+		/* NULL guard */
+		{.fn = NULL, .name = NULL},
+};
+
+struct suite_t src_thread_pool_suite = {
+		.name = "io_src_thread_pool",
+		.init = NULL,
+		.clean = NULL,
+		.tests = tests,
+};
@@ -16,6 +16,8 @@ LOCAL_SRC_FILES := $(call all-c-files-under,src)
 
 LOCAL_LIBRARIES := libutils
 
+LOCAL_LDLIBS := -lpthread
+
 ifdef TARGET_TEST
 LOCAL_SRC_FILES += $(call all-c-files-under,tests)
 
@@ -24,10 +26,128 @@ LOCAL_CFLAGS := -DFUSION_INTERPRETER=\"$(TARGET_LOADER)\"
 LOCAL_LDFLAGS := -Wl,-e,$(LOCAL_MODULE)_tests
 
 LOCAL_LIBRARIES += libfautes
+
+# frozen map of the rs_fmap tests, generated from it's keys list
+LOCAL_DEPENDS_HOST_MODULES := host.rs-fmap-gen
+LOCAL_GENERATED_SRC_FILES := rs_fmap_test_map.c
+
+$(call local-get-build-dir)/rs_fmap_test_map.c: \
+		$(LOCAL_PATH)/tests/rs_fmap_test_map.txt
+	@mkdir -p $(dir $@)
+	$(HOST_OUT_STAGING)/usr/bin/rs-fmap-gen -o $@ rs_fmap_test_map $<
 endif # TARGET_TEST
 
 include $(BUILD_LIBRARY)
 
+###############################################################################
+# rs-fmap-gen
+###############################################################################
+
+include $(CLEAR_VARS)
+
+LOCAL_HOST_MODULE := rs-fmap-gen
+LOCAL_DESCRIPTION := Generator of the C sources of librs frozen maps
+
+LOCAL_SRC_FILES := \
+	tools/rs_fmap_gen.c \
+	src/rs_fmap.c \
+	src/rs_hash.c
+
+LOCAL_C_INCLUDES := $(LOCAL_PATH)/include
+
+include $(BUILD_HOST_EXECUTABLE)
+
+###############################################################################
+# rs-bench
+###############################################################################
+
+include $(CLEAR_VARS)
+
+LOCAL_MODULE := rs-bench-hmap
+LOCAL_DESCRIPTION := Benchmark of the librs hash maps
+LOCAL_CATEGORY_PATH := devel
+
+LOCAL_SRC_FILES := bench/rs_hmap_bench.c
+
+LOCAL_LIBRARIES := librs libutils
+
+include $(BUILD_EXECUTABLE)
+
+include $(CLEAR_VARS)
+
+LOCAL_MODULE := rs-bench-cmap
+LOCAL_DESCRIPTION := Scalability benchmark of the librs concurrent hash map
+LOCAL_CATEGORY_PATH := devel
+
+LOCAL_SRC_FILES := bench/rs_cmap_bench.c
+
+LOCAL_LIBRARIES := librs libutils
+
+LOCAL_LDLIBS := -lpthread
+
+include $(BUILD_EXECUTABLE)
+
+include $(CLEAR_VARS)
+
+LOCAL_MODULE := rs-bench-fmap-file
+LOCAL_DESCRIPTION := Cold start benchmark of the librs frozen map files
+LOCAL_CATEGORY_PATH := devel
+
+LOCAL_SRC_FILES := bench/rs_fmap_file_bench.c
+
+LOCAL_LIBRARIES := librs libutils
+
+include $(BUILD_EXECUTABLE)
+
+include $(CLEAR_VARS)
+
+LOCAL_MODULE := rs-bench-rb-spsc
+LOCAL_DESCRIPTION := Benchmark of the librs lock-free SPSC ring buffer
+LOCAL_CATEGORY_PATH := devel
+
+LOCAL_SRC_FILES := bench/rs_rb_spsc_bench.c
+
+LOCAL_LIBRARIES := librs libutils
+LOCAL_LDLIBS := -lpthread
+
+include $(BUILD_EXECUTABLE)
+
+include $(CLEAR_VARS)
+
+LOCAL_MODULE := rs-bench-rb-mirror
+LOCAL_DESCRIPTION := Benchmark of the librs mirrored ring buffers allocation
+LOCAL_CATEGORY_PATH := devel
+
+LOCAL_SRC_FILES := bench/rs_rb_mirror_bench.c
+
+LOCAL_LIBRARIES := librs libutils
+
+include $(BUILD_EXECUTABLE)
+
+include $(CLEAR_VARS)
+
+LOCAL_MODULE := rs-bench-rb-search
+LOCAL_DESCRIPTION := Benchmark of the search in librs ring buffers
+LOCAL_CATEGORY_PATH := devel
+
+LOCAL_SRC_FILES := bench/rs_rb_search_bench.c
+
+LOCAL_LIBRARIES := librs
+
+include $(BUILD_EXECUTABLE)
+
+include $(CLEAR_VARS)
+
+LOCAL_MODULE := rs-bench-rbtree-heap
+LOCAL_DESCRIPTION := Benchmark of the librs sorted containers
+LOCAL_CATEGORY_PATH := devel
+
+LOCAL_SRC_FILES := bench/rs_rbtree_heap_bench.c
+
+LOCAL_LIBRARIES := librs libutils
+
+include $(BUILD_EXECUTABLE)
+
 ###############################################################################
 # tst-librs
 ###############################################################################
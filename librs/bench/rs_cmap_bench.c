@@ -0,0 +1,317 @@
+/**
+ * @file rs_cmap_bench.c
+ * @brief Scalability benchmark of rs_cmap, compared to rs_hmap protected by a
+ * global mutex, or by a global read-write lock. From 1 to N threads perform
+ * lookups of random keys among preloaded ones, a given percentage of the
+ * operations being writes, which remove a key private to each thread and
+ * insert it back, as rs_hmap doesn't compare the keys of buckets holding only
+ * one entry, hence can't be asked for absent keys. The total throughput is
+ * reported for each number of threads, with 1% and 10% of writes.
+ *
+ * usage: rs_cmap_bench [max_threads [duration_ms]]
+ *
+ * max_threads defaults to the number of online processors.
+ *
+ * Copyright (C) 2026 Parrot S.A.
+ */
+#include <pthread.h>
+#include <unistd.h>
+
+#include <stdbool.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <errno.h>
+#include <error.h>
+
+#include <ut_utils.h>
+
+#include <rs_hmap.h>
+#include <rs_cmap.h>
+
+#define NB_KEYS 100000
+#define NB_PRIVATE_KEYS 1000
+#define KEY_SIZE 24
+#define DEFAULT_DURATION_MS 500
+
+struct bench_map {
+	const char *name;
+	int (*init)(size_t size);
+	int (*lookup)(const char *key, void **data);
+	int (*insert)(const char *key, void *data);
+	int (*remove)(const char *key, void **data);
+	int (*clean)(void);
+};
+
+struct worker {
+	const struct bench_map *m;
+	pthread_t thread;
+	unsigned id;
+	unsigned write_percent;
+	unsigned long nb_ops;
+} __attribute__((aligned(64)));
+
+static struct rs_hmap hmap;
+static struct rs_cmap cmap;
+static pthread_mutex_t mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_rwlock_t rwlock = PTHREAD_RWLOCK_INITIALIZER;
+
+static char (*keys)[KEY_SIZE];
+static char (*private_keys)[KEY_SIZE];
+static volatile bool stop;
+
+static int mutex_init(size_t size)
+{
+	return rs_hmap_init(&hmap, size);
+}
+
+static int mutex_lookup(const char *key, void **data)
+{
+	int ret;
+
+	pthread_mutex_lock(&mutex);
+	ret = rs_hmap_lookup(&hmap, key, data);
+	pthread_mutex_unlock(&mutex);
+
+	return ret;
+}
+
+static int mutex_insert(const char *key, void *data)
+{
+	int ret;
+
+	pthread_mutex_lock(&mutex);
+	ret = rs_hmap_insert(&hmap, key, data);
+	pthread_mutex_unlock(&mutex);
+
+	return ret;
+}
+
+static int mutex_remove(const char *key, void **data)
+{
+	int ret;
+
+	pthread_mutex_lock(&mutex);
+	ret = rs_hmap_remove(&hmap, key, data);
+	pthread_mutex_unlock(&mutex);
+
+	return ret;
+}
+
+static int hmap_clean(void)
+{
+	return rs_hmap_clean(&hmap);
+}
+
+static int rwlock_lookup(const char *key, void **data)
+{
+	int ret;
+
+	pthread_rwlock_rdlock(&rwlock);
+	ret = rs_hmap_lookup(&hmap, key, data);
+	pthread_rwlock_unlock(&rwlock);
+
+	return ret;
+}
+
+static int rwlock_insert(const char *key, void *data)
+{
+	int ret;
+
+	pthread_rwlock_wrlock(&rwlock);
+	ret = rs_hmap_insert(&hmap, key, data);
+	pthread_rwlock_unlock(&rwlock);
+
+	return ret;
+}
+
+static int rwlock_remove(const char *key, void **data)
+{
+	int ret;
+
+	pthread_rwlock_wrlock(&rwlock);
+	ret = rs_hmap_remove(&hmap, key, data);
+	pthread_rwlock_unlock(&rwlock);
+
+	return ret;
+}
+
+static int cmap_init(size_t size)
+{
+	return rs_cmap_init(&cmap, size);
+}
+
+static int cmap_lookup(const char *key, void **data)
+{
+	return rs_cmap_lookup(&cmap, key, data);
+}
+
+static int cmap_insert(const char *key, void *data)
+{
+	return rs_cmap_insert(&cmap, key, data);
+}
+
+static int cmap_remove(const char *key, void **data)
+{
+	return rs_cmap_remove(&cmap, key, data);
+}
+
+static int cmap_clean(void)
+{
+	return rs_cmap_clean(&cmap);
+}
+
+static uint32_t xorshift(uint32_t *state)
+{
+	*state ^= *state << 13;
+	*state ^= *state >> 17;
+	*state ^= *state << 5;
+
+	return *state;
+}
+
+static void *work(void *arg)
+{
+	struct worker *w = arg;
+	uint32_t state = 2463534242u + w->id;
+	uint32_t r;
+	unsigned long nb_ops = 0;
+	const char *key;
+	void *data;
+	int ret;
+
+	while (!stop) {
+		r = xorshift(&state);
+		if (r % 100 < w->write_percent) {
+			key = private_keys[w->id * NB_PRIVATE_KEYS +
+					(r >> 8) % NB_PRIVATE_KEYS];
+			ret = w->m->remove(key, NULL);
+			if (ret == 0)
+				ret = w->m->insert(key, NULL);
+		} else {
+			ret = w->m->lookup(keys[(r >> 8) % NB_KEYS], &data);
+		}
+		if (ret < 0)
+			error(EXIT_FAILURE, -ret, "%s", w->m->name);
+		nb_ops++;
+	}
+	w->nb_ops = nb_ops;
+
+	return NULL;
+}
+
+static void run(const struct bench_map *m, unsigned nb_threads,
+		unsigned write_percent, unsigned duration_ms)
+{
+	struct worker *workers;
+	unsigned long total = 0;
+	unsigned i;
+	int ret;
+
+	workers = calloc(nb_threads, sizeof(*workers));
+	if (NULL == workers)
+		error(EXIT_FAILURE, ENOMEM, "calloc");
+	ret = m->init(NB_KEYS + nb_threads * NB_PRIVATE_KEYS);
+	if (ret < 0)
+		error(EXIT_FAILURE, -ret, "%s init", m->name);
+	for (i = 0; i < NB_KEYS; i++) {
+		ret = m->insert(keys[i], (void *)(uintptr_t)i);
+		if (ret < 0)
+			error(EXIT_FAILURE, -ret, "%s insert", m->name);
+	}
+	for (i = 0; i < nb_threads * NB_PRIVATE_KEYS; i++) {
+		ret = m->insert(private_keys[i], NULL);
+		if (ret < 0)
+			error(EXIT_FAILURE, -ret, "%s insert", m->name);
+	}
+
+	stop = false;
+	for (i = 0; i < nb_threads; i++) {
+		workers[i].m = m;
+		workers[i].id = i;
+		workers[i].write_percent = write_percent;
+		ret = pthread_create(&workers[i].thread, NULL, work,
+				workers + i);
+		if (ret != 0)
+			error(EXIT_FAILURE, ret, "pthread_create");
+	}
+	usleep(duration_ms * 1000);
+	stop = true;
+	for (i = 0; i < nb_threads; i++) {
+		pthread_join(workers[i].thread, NULL);
+		total += workers[i].nb_ops;
+	}
+
+	printf("%-14s %3u%% writes %3u threads %10.2f Mops/s\n", m->name,
+			write_percent, nb_threads,
+			total / (duration_ms / 1000.) / 1e6);
+
+	m->clean();
+	free(workers);
+}
+
+int main(int argc, char *argv[])
+{
+	const struct bench_map maps[] = {
+		{
+			.name = "rs_hmap+mutex",
+			.init = mutex_init,
+			.lookup = mutex_lookup,
+			.insert = mutex_insert,
+			.remove = mutex_remove,
+			.clean = hmap_clean,
+		},
+		{
+			.name = "rs_hmap+rwlock",
+			.init = mutex_init,
+			.lookup = rwlock_lookup,
+			.insert = rwlock_insert,
+			.remove = rwlock_remove,
+			.clean = hmap_clean,
+		},
+		{
+			.name = "rs_cmap",
+			.init = cmap_init,
+			.lookup = cmap_lookup,
+			.insert = cmap_insert,
+			.remove = cmap_remove,
+			.clean = cmap_clean,
+		},
+	};
+	const unsigned write_percents[] = {1, 10};
+	long max_threads = sysconf(_SC_NPROCESSORS_ONLN);
+	unsigned duration_ms = DEFAULT_DURATION_MS;
+	unsigned nb_threads;
+	unsigned i;
+	unsigned j;
+
+	if (argc > 1)
+		max_threads = strtol(argv[1], NULL, 0);
+	if (argc > 2)
+		duration_ms = strtoul(argv[2], NULL, 0);
+	if (max_threads <= 0 || duration_ms == 0)
+		error(EXIT_FAILURE, EINVAL, "usage: %s [max_threads "
+				"[duration_ms]]", argv[0]);
+
+	keys = calloc(NB_KEYS, KEY_SIZE);
+	private_keys = calloc(max_threads * NB_PRIVATE_KEYS, KEY_SIZE);
+	if (NULL == keys || NULL == private_keys)
+		error(EXIT_FAILURE, ENOMEM, "calloc");
+	for (i = 0; i < NB_KEYS; i++)
+		snprintf(keys[i], KEY_SIZE, "key%u", i);
+	for (i = 0; i < max_threads * NB_PRIVATE_KEYS; i++)
+		snprintf(private_keys[i], KEY_SIZE, "private%u", i);
+
+	for (i = 0; i < UT_ARRAY_SIZE(write_percents); i++)
+		for (nb_threads = 1; nb_threads <= max_threads; nb_threads++)
+			for (j = 0; j < UT_ARRAY_SIZE(maps); j++)
+				run(maps + j, nb_threads, write_percents[i],
+						duration_ms);
+
+	free(private_keys);
+	free(keys);
+
+	return EXIT_SUCCESS;
+}
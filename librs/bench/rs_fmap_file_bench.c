@@ -0,0 +1,213 @@
+/**
+ * @file rs_fmap_file_bench.c
+ * @brief Cold start benchmark of frozen map files, compared to the rebuilding
+ * of an rs_hmap from a text file of "key value" lines, with a strdup of each
+ * key and value, as services do at boot. Both files are evicted from the page
+ * cache before each measurement, which is the time from the opening of the
+ * file to the completion of a number of lookups of random keys.
+ *
+ * usage: rs_fmap_file_bench [nb_keys [nb_lookups [dir]]]
+ *
+ * The files are created in dir, /tmp by default, and removed at exit.
+ *
+ * Copyright (C) 2026 Parrot S.A.
+ */
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <errno.h>
+#include <error.h>
+
+#include <rs_hmap.h>
+#include <rs_fmap_file.h>
+
+#define DEFAULT_NB_KEYS 1000000
+#define DEFAULT_NB_LOOKUPS 1000
+#define KEY_SIZE 24
+
+static double now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/* drops the pages of a file from the page cache, for next reads to be cold */
+static void evict(const char *path)
+{
+	int fd;
+
+	fd = open(path, O_RDONLY);
+	if (fd == -1)
+		error(EXIT_FAILURE, errno, "open %s", path);
+	fdatasync(fd);
+	posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+	close(fd);
+}
+
+static void make_files(const char *text_path, const char *map_path,
+		size_t nb_keys)
+{
+	FILE *f;
+	size_t i;
+	int ret;
+	char (*keys)[KEY_SIZE];
+	char (*values)[KEY_SIZE];
+	struct rs_fmap_file_item *items;
+
+	keys = calloc(nb_keys, KEY_SIZE);
+	values = calloc(nb_keys, KEY_SIZE);
+	items = calloc(nb_keys, sizeof(*items));
+	if (NULL == keys || NULL == values || NULL == items)
+		error(EXIT_FAILURE, ENOMEM, "calloc");
+	f = fopen(text_path, "w");
+	if (NULL == f)
+		error(EXIT_FAILURE, errno, "fopen %s", text_path);
+	for (i = 0; i < nb_keys; i++) {
+		snprintf(keys[i], KEY_SIZE, "key%zu", i);
+		snprintf(values[i], KEY_SIZE, "value%zu", i);
+		fprintf(f, "%s %s\n", keys[i], values[i]);
+		items[i].key = keys[i];
+		items[i].value = values[i];
+		items[i].len = strlen(values[i]) + 1;
+	}
+	if (fclose(f) != 0)
+		error(EXIT_FAILURE, errno, "fclose %s", text_path);
+	ret = rs_fmap_file_write(map_path, items, nb_keys);
+	if (ret < 0)
+		error(EXIT_FAILURE, -ret, "rs_fmap_file_write");
+
+	free(items);
+	free(values);
+	free(keys);
+}
+
+static double run_hmap(const char *text_path, const char *lookups,
+		size_t nb_keys, size_t nb_lookups)
+{
+	struct rs_hmap map;
+	FILE *f;
+	char *line = NULL;
+	size_t size = 0;
+	char *value;
+	void *data;
+	double start;
+	size_t i;
+	int ret;
+
+	evict(text_path);
+	start = now();
+	ret = rs_hmap_init(&map, nb_keys);
+	if (ret < 0)
+		error(EXIT_FAILURE, -ret, "rs_hmap_init");
+	f = fopen(text_path, "r");
+	if (NULL == f)
+		error(EXIT_FAILURE, errno, "fopen %s", text_path);
+	while (getline(&line, &size, f) != -1) {
+		line[strcspn(line, "\n")] = '\0';
+		value = strchr(line, ' ');
+		if (NULL == value)
+			continue;
+		*value++ = '\0';
+		/* rs_hmap_insert strdups the key */
+		value = strdup(value);
+		if (NULL == value)
+			error(EXIT_FAILURE, ENOMEM, "strdup");
+		ret = rs_hmap_insert(&map, line, value);
+		if (ret < 0)
+			error(EXIT_FAILURE, -ret, "rs_hmap_insert");
+	}
+	fclose(f);
+	for (i = 0; i < nb_lookups; i++) {
+		ret = rs_hmap_lookup(&map, lookups + i * KEY_SIZE, &data);
+		if (ret < 0)
+			error(EXIT_FAILURE, -ret, "rs_hmap_lookup");
+	}
+	start = now() - start;
+
+	free(line);
+	rs_hmap_clean_cb(&map, free);
+
+	return start;
+}
+
+static double run_fmap_file(const char *map_path, const char *lookups,
+		size_t nb_lookups)
+{
+	struct rs_fmap_file file;
+	const void *value;
+	double start;
+	size_t i;
+	int ret;
+
+	evict(map_path);
+	start = now();
+	ret = rs_fmap_file_open(&file, map_path);
+	if (ret < 0)
+		error(EXIT_FAILURE, -ret, "rs_fmap_file_open");
+	for (i = 0; i < nb_lookups; i++) {
+		ret = rs_fmap_file_lookup(&file, lookups + i * KEY_SIZE, &value,
+				NULL);
+		if (ret < 0)
+			error(EXIT_FAILURE, -ret, "rs_fmap_file_lookup");
+	}
+	start = now() - start;
+
+	rs_fmap_file_close(&file);
+
+	return start;
+}
+
+int main(int argc, char *argv[])
+{
+	size_t nb_keys = DEFAULT_NB_KEYS;
+	size_t nb_lookups = DEFAULT_NB_LOOKUPS;
+	const char *dir = "/tmp";
+	char text_path[256];
+	char map_path[256];
+	char *lookups;
+	double elapsed;
+	size_t i;
+
+	if (argc > 1)
+		nb_keys = strtoul(argv[1], NULL, 0);
+	if (argc > 2)
+		nb_lookups = strtoul(argv[2], NULL, 0);
+	if (argc > 3)
+		dir = argv[3];
+	if (nb_keys == 0)
+		error(EXIT_FAILURE, EINVAL, "usage: %s [nb_keys [nb_lookups "
+				"[dir]]]", argv[0]);
+	snprintf(text_path, sizeof(text_path), "%s/rs_fmap_file_bench.txt",
+			dir);
+	snprintf(map_path, sizeof(map_path), "%s/rs_fmap_file_bench.map", dir);
+
+	srand(1);
+	lookups = calloc(nb_lookups + 1, KEY_SIZE);
+	if (NULL == lookups)
+		error(EXIT_FAILURE, ENOMEM, "calloc");
+	for (i = 0; i < nb_lookups; i++)
+		snprintf(lookups + i * KEY_SIZE, KEY_SIZE, "key%zu",
+				(size_t)rand() % nb_keys);
+	make_files(text_path, map_path, nb_keys);
+
+	elapsed = run_hmap(text_path, lookups, nb_keys, nb_lookups);
+	printf("%-13s %10zu keys %8zu lookups %10.3f ms\n", "rs_hmap", nb_keys,
+			nb_lookups, elapsed * 1e3);
+	elapsed = run_fmap_file(map_path, lookups, nb_lookups);
+	printf("%-13s %10zu keys %8zu lookups %10.3f ms\n", "rs_fmap_file",
+			nb_keys, nb_lookups, elapsed * 1e3);
+
+	unlink(map_path);
+	unlink(text_path);
+	free(lookups);
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,509 @@
+/**
+ * @file rs_hmap_bench.c
+ * @brief Benchmark of the librs hash maps, compares the insertion, lookup and
+ * removal throughputs of rs_hmap, whose number of buckets is set to the number
+ * of keys, which is it's best case, with rs_ohmap, either sized for the number
+ * of keys too, or starting with it's default size and growing as needed. The
+ * keys are looked up and removed in a random order, to defeat the locality
+ * sequential keys would give to sequential accesses.
+ * A second round uses 64 bits identifiers as keys, which rs_hmap needs
+ * formatted as strings, as they would be for pids or fds, whereas rs_ohmap
+ * stores them as is, with both of it's hash functions, and rs_ihmap finds them
+ * in structures allocated beforehand, in which it's nodes are embedded.
+ * The frozen map rs_fmap is built from the string keys at once, then only
+ * looked up.
+ *
+ * usage: rs_hmap_bench [nb_keys...]
+ *
+ * rs_ohmap+ is the growing rs_ohmap.
+ *
+ * Copyright (C) 2026 Parrot S.A.
+ */
+#include <stdlib.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <errno.h>
+#include <error.h>
+
+#include <ut_utils.h>
+
+#include <rs_fmap.h>
+#include <rs_hmap.h>
+#include <rs_ihmap.h>
+#include <rs_ohmap.h>
+
+#define KEY_SIZE 24
+
+struct bench_map {
+	const char *name;
+	int (*init)(void *map, size_t size);
+	int (*insert)(void *map, const char *key, void *data);
+	int (*lookup)(void *map, const char *key, void **data);
+	int (*remove)(void *map, const char *key, void **data);
+	int (*clean)(void *map);
+};
+
+struct bench_id_map {
+	const char *name;
+	int (*init)(void *map, size_t size);
+	int (*insert)(void *map, uint64_t id, void *data);
+	int (*lookup)(void *map, uint64_t id, void **data);
+	int (*remove)(void *map, uint64_t id, void **data);
+	int (*clean)(void *map);
+};
+
+struct bench_entry {
+	uint64_t id;
+	struct rs_ihmap_node node;
+};
+
+/* structures embedding the nodes of rs_ihmap, one per key */
+static struct bench_entry *entries;
+
+static double now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static int hmap_init(void *map, size_t size)
+{
+	return rs_hmap_init(map, size);
+}
+
+static int hmap_insert(void *map, const char *key, void *data)
+{
+	return rs_hmap_insert(map, key, data);
+}
+
+static int hmap_lookup(void *map, const char *key, void **data)
+{
+	return rs_hmap_lookup(map, key, data);
+}
+
+static int hmap_remove(void *map, const char *key, void **data)
+{
+	return rs_hmap_remove(map, key, data);
+}
+
+static int hmap_clean(void *map)
+{
+	return rs_hmap_clean(map);
+}
+
+static int ohmap_init(void *map, size_t size)
+{
+	return rs_ohmap_init(map, size);
+}
+
+static int ohmap_init_grow(void *map, size_t size)
+{
+	/* grows from the default size */
+	return rs_ohmap_init(map, 0);
+}
+
+static int ohmap_insert(void *map, const char *key, void *data)
+{
+	return rs_ohmap_insert(map, key, data);
+}
+
+static int ohmap_lookup(void *map, const char *key, void **data)
+{
+	return rs_ohmap_lookup(map, key, data);
+}
+
+static int ohmap_remove(void *map, const char *key, void **data)
+{
+	return rs_ohmap_remove(map, key, data);
+}
+
+static int ohmap_clean(void *map)
+{
+	return rs_ohmap_clean(map);
+}
+
+static int hmap_insert_id(void *map, uint64_t id, void *data)
+{
+	char key[KEY_SIZE];
+
+	snprintf(key, KEY_SIZE, "%"PRIu64, id);
+
+	return rs_hmap_insert(map, key, data);
+}
+
+static int hmap_lookup_id(void *map, uint64_t id, void **data)
+{
+	char key[KEY_SIZE];
+
+	snprintf(key, KEY_SIZE, "%"PRIu64, id);
+
+	return rs_hmap_lookup(map, key, data);
+}
+
+static int hmap_remove_id(void *map, uint64_t id, void **data)
+{
+	char key[KEY_SIZE];
+
+	snprintf(key, KEY_SIZE, "%"PRIu64, id);
+
+	return rs_hmap_remove(map, key, data);
+}
+
+static int ohmap_init_wyhash(void *map, size_t size)
+{
+	struct rs_ohmap_keys keys = {
+		.type = RS_OHMAP_KEY_U64,
+		.hash = RS_OHMAP_HASH_WYHASH,
+	};
+
+	return rs_ohmap_init_keys(map, size, &keys);
+}
+
+static int ohmap_init_fnv1a(void *map, size_t size)
+{
+	struct rs_ohmap_keys keys = {
+		.type = RS_OHMAP_KEY_U64,
+		.hash = RS_OHMAP_HASH_FNV1A,
+	};
+
+	return rs_ohmap_init_keys(map, size, &keys);
+}
+
+static int ohmap_insert_id(void *map, uint64_t id, void *data)
+{
+	return rs_ohmap_insert_u64(map, id, data);
+}
+
+static int ohmap_lookup_id(void *map, uint64_t id, void **data)
+{
+	return rs_ohmap_lookup_u64(map, id, data);
+}
+
+static int ohmap_remove_id(void *map, uint64_t id, void **data)
+{
+	return rs_ohmap_remove_u64(map, id, data);
+}
+
+static uint32_t ihmap_hash(const void *key)
+{
+	return rs_hash_u64(*(const uint64_t *)key);
+}
+
+static const void *ihmap_key(const struct rs_ihmap_node *node)
+{
+	return &ut_container_of(node, struct bench_entry, node)->id;
+}
+
+static int ihmap_equals(const void *a, const void *b)
+{
+	return *(const uint64_t *)a == *(const uint64_t *)b;
+}
+
+static int ihmap_init(void *map, size_t size)
+{
+	static const struct rs_ihmap_vtable vtable = {
+		.hash = ihmap_hash,
+		.key = ihmap_key,
+		.equals = ihmap_equals,
+	};
+
+	return rs_ihmap_init(map, size, &vtable);
+}
+
+static int ihmap_insert_id(void *map, uint64_t id, void *data)
+{
+	/* the data is the index of the key */
+	struct bench_entry *e = entries + (size_t)data;
+
+	e->id = id;
+
+	return rs_ihmap_insert(map, &e->node);
+}
+
+static int ihmap_lookup_id(void *map, uint64_t id, void **data)
+{
+	struct rs_ihmap_node *node;
+
+	node = rs_ihmap_lookup(map, &id);
+	if (NULL == node)
+		return -ENOENT;
+	*data = (void *)(ut_container_of(node, struct bench_entry, node) -
+			entries);
+
+	return 0;
+}
+
+static int ihmap_remove_id(void *map, uint64_t id, void **data)
+{
+	struct rs_ihmap_node *node;
+
+	node = rs_ihmap_lookup(map, &id);
+	if (NULL == node)
+		return -ENOENT;
+
+	return rs_ihmap_remove(map, node);
+}
+
+static int ihmap_clean(void *map)
+{
+	return rs_ihmap_clean(map);
+}
+
+static void shuffle(size_t *order, size_t nb_keys)
+{
+	size_t i;
+	size_t j;
+	size_t tmp;
+
+	for (i = 0; i < nb_keys; i++)
+		order[i] = i;
+	for (i = nb_keys - 1; i > 0; i--) {
+		j = ((size_t)rand() * RAND_MAX + rand()) % (i + 1);
+		tmp = order[i];
+		order[i] = order[j];
+		order[j] = tmp;
+	}
+}
+
+static void print_result(const char *name, const char *op, size_t nb_keys,
+		double elapsed)
+{
+	printf("%-15s %-7s %10zu keys %8.3f s %8.2f Mops/s\n", name, op,
+			nb_keys, elapsed, nb_keys / elapsed / 1e6);
+}
+
+static void run(const struct bench_map *m, const char *keys, size_t *order,
+		size_t nb_keys)
+{
+	union {
+		struct rs_hmap hmap;
+		struct rs_ohmap ohmap;
+	} map;
+	size_t i;
+	void *data;
+	double start;
+	int ret;
+
+	ret = m->init(&map, nb_keys);
+	if (ret < 0)
+		error(EXIT_FAILURE, -ret, "%s init", m->name);
+
+	start = now();
+	for (i = 0; i < nb_keys; i++) {
+		ret = m->insert(&map, keys + i * KEY_SIZE, (void *)i);
+		if (ret < 0)
+			error(EXIT_FAILURE, -ret, "%s insert", m->name);
+	}
+	print_result(m->name, "insert", nb_keys, now() - start);
+
+	shuffle(order, nb_keys);
+	start = now();
+	for (i = 0; i < nb_keys; i++) {
+		ret = m->lookup(&map, keys + order[i] * KEY_SIZE, &data);
+		if (ret < 0 || data != (void *)order[i])
+			error(EXIT_FAILURE, -ret, "%s lookup", m->name);
+	}
+	print_result(m->name, "lookup", nb_keys, now() - start);
+
+	shuffle(order, nb_keys);
+	start = now();
+	for (i = 0; i < nb_keys; i++) {
+		ret = m->remove(&map, keys + order[i] * KEY_SIZE, &data);
+		if (ret < 0)
+			error(EXIT_FAILURE, -ret, "%s remove", m->name);
+	}
+	print_result(m->name, "remove", nb_keys, now() - start);
+
+	m->clean(&map);
+}
+
+static void run_frozen(const char *keys, size_t *order, size_t nb_keys)
+{
+	struct rs_fmap map;
+	struct rs_fmap_entry *fmap_entries;
+	size_t i;
+	void *data;
+	double start;
+	int ret;
+
+	fmap_entries = calloc(nb_keys, sizeof(*fmap_entries));
+	if (NULL == fmap_entries)
+		error(EXIT_FAILURE, ENOMEM, "calloc");
+	for (i = 0; i < nb_keys; i++) {
+		fmap_entries[i].key = keys + i * KEY_SIZE;
+		fmap_entries[i].data = (void *)i;
+	}
+
+	start = now();
+	ret = rs_fmap_init(&map, fmap_entries, nb_keys);
+	if (ret < 0)
+		error(EXIT_FAILURE, -ret, "rs_fmap init");
+	print_result("rs_fmap", "build", nb_keys, now() - start);
+
+	shuffle(order, nb_keys);
+	start = now();
+	for (i = 0; i < nb_keys; i++) {
+		ret = rs_fmap_lookup(&map, keys + order[i] * KEY_SIZE, &data);
+		if (ret < 0 || data != (void *)order[i])
+			error(EXIT_FAILURE, -ret, "rs_fmap lookup");
+	}
+	print_result("rs_fmap", "lookup", nb_keys, now() - start);
+
+	rs_fmap_clean(&map);
+	free(fmap_entries);
+}
+
+static void run_ids(const struct bench_id_map *m, const uint64_t *ids,
+		size_t *order, size_t nb_keys)
+{
+	union {
+		struct rs_hmap hmap;
+		struct rs_ohmap ohmap;
+		struct rs_ihmap ihmap;
+	} map;
+	size_t i;
+	void *data;
+	double start;
+	int ret;
+
+	ret = m->init(&map, nb_keys);
+	if (ret < 0)
+		error(EXIT_FAILURE, -ret, "%s init", m->name);
+
+	start = now();
+	for (i = 0; i < nb_keys; i++) {
+		ret = m->insert(&map, ids[i], (void *)i);
+		if (ret < 0)
+			error(EXIT_FAILURE, -ret, "%s insert", m->name);
+	}
+	print_result(m->name, "insert", nb_keys, now() - start);
+
+	shuffle(order, nb_keys);
+	start = now();
+	for (i = 0; i < nb_keys; i++) {
+		ret = m->lookup(&map, ids[order[i]], &data);
+		if (ret < 0 || data != (void *)order[i])
+			error(EXIT_FAILURE, -ret, "%s lookup", m->name);
+	}
+	print_result(m->name, "lookup", nb_keys, now() - start);
+
+	shuffle(order, nb_keys);
+	start = now();
+	for (i = 0; i < nb_keys; i++) {
+		ret = m->remove(&map, ids[order[i]], &data);
+		if (ret < 0)
+			error(EXIT_FAILURE, -ret, "%s remove", m->name);
+	}
+	print_result(m->name, "remove", nb_keys, now() - start);
+
+	m->clean(&map);
+}
+
+int main(int argc, char *argv[])
+{
+	size_t default_sizes[] = {1000, 100000, 10000000};
+	const struct bench_map maps[] = {
+		{
+			.name = "rs_hmap",
+			.init = hmap_init,
+			.insert = hmap_insert,
+			.lookup = hmap_lookup,
+			.remove = hmap_remove,
+			.clean = hmap_clean,
+		},
+		{
+			.name = "rs_ohmap",
+			.init = ohmap_init,
+			.insert = ohmap_insert,
+			.lookup = ohmap_lookup,
+			.remove = ohmap_remove,
+			.clean = ohmap_clean,
+		},
+		{
+			.name = "rs_ohmap+",
+			.init = ohmap_init_grow,
+			.insert = ohmap_insert,
+			.lookup = ohmap_lookup,
+			.remove = ohmap_remove,
+			.clean = ohmap_clean,
+		},
+	};
+	const struct bench_id_map id_maps[] = {
+		{
+			.name = "rs_hmap/string",
+			.init = hmap_init,
+			.insert = hmap_insert_id,
+			.lookup = hmap_lookup_id,
+			.remove = hmap_remove_id,
+			.clean = hmap_clean,
+		},
+		{
+			.name = "rs_ohmap/wyhash",
+			.init = ohmap_init_wyhash,
+			.insert = ohmap_insert_id,
+			.lookup = ohmap_lookup_id,
+			.remove = ohmap_remove_id,
+			.clean = ohmap_clean,
+		},
+		{
+			.name = "rs_ohmap/fnv1a",
+			.init = ohmap_init_fnv1a,
+			.insert = ohmap_insert_id,
+			.lookup = ohmap_lookup_id,
+			.remove = ohmap_remove_id,
+			.clean = ohmap_clean,
+		},
+		{
+			.name = "rs_ihmap",
+			.init = ihmap_init,
+			.insert = ihmap_insert_id,
+			.lookup = ihmap_lookup_id,
+			.remove = ihmap_remove_id,
+			.clean = ihmap_clean,
+		},
+	};
+	size_t nb_keys;
+	size_t i;
+	int s;
+	unsigned j;
+	char *keys;
+	uint64_t *ids;
+	size_t *order;
+
+	srand(1);
+	for (s = 0; s < (argc > 1 ? argc - 1 :
+			(int)UT_ARRAY_SIZE(default_sizes)); s++) {
+		nb_keys = argc > 1 ? strtoul(argv[s + 1], NULL, 0) :
+				default_sizes[s];
+		keys = malloc(nb_keys * KEY_SIZE);
+		ids = calloc(nb_keys, sizeof(*ids));
+		order = calloc(nb_keys, sizeof(*order));
+		entries = calloc(nb_keys, sizeof(*entries));
+		if (NULL == keys || NULL == ids || NULL == order ||
+				NULL == entries)
+			error(EXIT_FAILURE, ENOMEM, "malloc");
+		for (i = 0; i < nb_keys; i++) {
+			snprintf(keys + i * KEY_SIZE, KEY_SIZE, "key%zu", i);
+			/* spread, but unique identifiers */
+			ids[i] = i * 0x9e3779b97f4a7c15ull;
+		}
+
+		for (j = 0; j < UT_ARRAY_SIZE(maps); j++)
+			run(maps + j, keys, order, nb_keys);
+		run_frozen(keys, order, nb_keys);
+		for (j = 0; j < UT_ARRAY_SIZE(id_maps); j++)
+			run_ids(id_maps + j, ids, order, nb_keys);
+		free(entries);
+		free(order);
+		free(ids);
+		free(keys);
+	}
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,166 @@
+/**
+ * @file rs_rb_mirror_bench.c
+ * @brief Benchmark of the allocation of the mirrored buffers of rs_rb.
+ * Measures the time to initialize and clean a ring buffer, with and without
+ * touching all of it's pages, for the memfd mapped twice used by rs_rb,
+ * compared to the anonymous mapping remapped with remap_file_pages() it used
+ * before. Then measures the throughput of data streamed through large ring
+ * buffers, backed by normal pages, transparent huge pages and hugetlb pages,
+ * the latter two only if the system provides them.
+ *
+ * usage: rs_rb_mirror_bench [megabytes]
+ *
+ * Copyright (C) 2026 Parrot S.A.
+ */
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif /* _GNU_SOURCE */
+#include <sys/mman.h>
+
+#include <unistd.h>
+
+#include <stdbool.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <errno.h>
+#include <error.h>
+
+#include <ut_utils.h>
+
+#include <rs_rb.h>
+
+#define NB_INITS 1000
+#define STREAM_RB_SIZE 0x4000000
+#define CHUNK_SIZE 0x10000
+#define DEFAULT_MEGABYTES 4096
+
+static double now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/* the former implementation of the mirrored buffers, as a reference */
+static int legacy_init(struct rs_rb *rb, size_t size)
+{
+	long page_size = sysconf(_SC_PAGE_SIZE);
+
+	memset(rb, 0, sizeof(*rb));
+	rb->base = mmap(NULL, 2 * size, PROT_READ | PROT_WRITE,
+			MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+	if (rb->base == MAP_FAILED)
+		return -errno;
+	if (remap_file_pages(rb->base, size, 0, size / page_size, 0) == -1)
+		return -errno;
+	rb->size = size;
+
+	return 0;
+}
+
+static int legacy_clean(struct rs_rb *rb)
+{
+	return munmap(rb->base, 2 * rb->size) == -1 ? -errno : 0;
+}
+
+static int memfd_init(struct rs_rb *rb, size_t size)
+{
+	return rs_rb_init_mirrored(rb, size, 0);
+}
+
+static int memfd_clean(struct rs_rb *rb)
+{
+	return rs_rb_clean(rb);
+}
+
+static void run_init(const char *name, int (*init)(struct rs_rb *, size_t),
+		int (*clean)(struct rs_rb *), size_t size, bool touch)
+{
+	struct rs_rb rb;
+	double start;
+	int ret;
+	int i;
+
+	start = now();
+	for (i = 0; i < NB_INITS; i++) {
+		ret = init(&rb, size);
+		if (ret < 0)
+			error(EXIT_FAILURE, -ret, "%s init", name);
+		if (touch)
+			memset(rb.base, 0, size);
+		clean(&rb);
+	}
+	start = now() - start;
+
+	printf("%-16s init%s %8zu KiB %10.2f us\n", name,
+			touch ? "+touch" : "      ", size >> 10,
+			start * 1e6 / NB_INITS);
+}
+
+static void run_stream(const char *name, unsigned flags, size_t total)
+{
+	struct rs_rb rb;
+	char *chunk;
+	size_t sent;
+	double start;
+	int ret;
+
+	ret = rs_rb_init_mirrored(&rb, STREAM_RB_SIZE, flags);
+	if (ret < 0) {
+		printf("%-16s stream skipped: %s\n", name, strerror(-ret));
+		return;
+	}
+	chunk = calloc(1, CHUNK_SIZE);
+	if (NULL == chunk)
+		error(EXIT_FAILURE, ENOMEM, "calloc");
+
+	/* keeps the ring buffer half full, data crosses all of it's pages */
+	memset(rs_rb_get_write_ptr(&rb), 0, STREAM_RB_SIZE / 2);
+	rs_rb_write_incr(&rb, STREAM_RB_SIZE / 2);
+	start = now();
+	for (sent = 0; sent < total; sent += CHUNK_SIZE) {
+		memcpy(rs_rb_get_write_ptr(&rb), chunk, CHUNK_SIZE);
+		rs_rb_write_incr(&rb, CHUNK_SIZE);
+		memcpy(chunk, rs_rb_get_read_ptr(&rb), CHUNK_SIZE);
+		rs_rb_read_incr(&rb, CHUNK_SIZE);
+	}
+	start = now() - start;
+
+	printf("%-16s stream %zu MiB ring %10.2f MB/s\n", name,
+			(size_t)STREAM_RB_SIZE >> 20, total / start / 1e6);
+	free(chunk);
+	rs_rb_clean(&rb);
+}
+
+int main(int argc, char *argv[])
+{
+	const size_t sizes[] = {0x1000, 0x10000, 0x100000, 0x1000000};
+	size_t total = (size_t)DEFAULT_MEGABYTES << 20;
+	unsigned i;
+
+	if (argc > 2)
+		error(EXIT_FAILURE, EINVAL, "usage: %s [megabytes]", argv[0]);
+	if (argc > 1)
+		total = strtoul(argv[1], NULL, 0) << 20;
+
+	for (i = 0; i < UT_ARRAY_SIZE(sizes); i++) {
+		run_init("remap_file_pages", legacy_init, legacy_clean,
+				sizes[i], false);
+		run_init("memfd", memfd_init, memfd_clean, sizes[i], false);
+	}
+	for (i = 0; i < UT_ARRAY_SIZE(sizes); i++) {
+		run_init("remap_file_pages", legacy_init, legacy_clean,
+				sizes[i], true);
+		run_init("memfd", memfd_init, memfd_clean, sizes[i], true);
+	}
+
+	run_stream("pages", 0, total);
+	run_stream("thp", RS_RB_THP, total);
+	run_stream("hugetlb", RS_RB_HUGETLB, total);
+
+	return EXIT_SUCCESS;
+}
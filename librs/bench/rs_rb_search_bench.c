@@ -0,0 +1,117 @@
+/**
+ * @file rs_rb_search_bench.c
+ * @brief Benchmark of the search of delimiters in a ring buffer, looping on
+ * rs_rb_read_at(), compared to rs_rb_search(), in a buffer which isn't
+ * mirrored, filled with lines of random lengths, terminated by "\r\n".
+ *
+ * usage: rs_rb_search_bench [megabytes]
+ *
+ * Copyright (C) 2026 Parrot S.A.
+ */
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <errno.h>
+#include <error.h>
+
+#include <rs_rb.h>
+
+#define RB_SIZE 0x10000
+#define MAX_LINE 200
+#define DEFAULT_MEGABYTES 256
+
+static double now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static int search_read_at(struct rs_rb *rb, size_t offset, size_t *position)
+{
+	size_t i;
+	size_t len = rs_rb_get_read_length(rb);
+	char c;
+	char next;
+
+	for (i = offset; i + 1 < len; i++) {
+		rs_rb_read_at(rb, i, &c);
+		if (c != '\r')
+			continue;
+		rs_rb_read_at(rb, i + 1, &next);
+		if (next == '\n') {
+			*position = i;
+			return 0;
+		}
+	}
+
+	return -ENOENT;
+}
+
+static int search_rs_rb(struct rs_rb *rb, size_t offset, size_t *position)
+{
+	return rs_rb_search(rb, offset, "\r\n", 2, position);
+}
+
+static void run(const char *name, struct rs_rb *rb,
+		int (*search)(struct rs_rb *, size_t, size_t *), size_t total)
+{
+	size_t scanned = 0;
+	size_t offset = 0;
+	size_t position;
+	size_t nb_lines = 0;
+	double start;
+
+	start = now();
+	while (scanned < total) {
+		while (search(rb, offset, &position) == 0) {
+			offset = position + 2;
+			nb_lines++;
+		}
+		/* consumes the buffer, then shifts the data by one line */
+		scanned += rs_rb_get_read_length(rb);
+		rs_rb_read_incr(rb, offset);
+		rs_rb_write_incr(rb, offset);
+		offset = 0;
+	}
+	start = now() - start;
+
+	printf("%-14s %10.2f MB/s %zu lines\n", name,
+			scanned / start / 1e6, nb_lines);
+}
+
+int main(int argc, char *argv[])
+{
+	static char buffer[RB_SIZE];
+	struct rs_rb rb;
+	size_t total = (size_t)DEFAULT_MEGABYTES << 20;
+	size_t i;
+	size_t len;
+	int ret;
+
+	if (argc > 2)
+		error(EXIT_FAILURE, EINVAL, "usage: %s [megabytes]", argv[0]);
+	if (argc > 1)
+		total = strtoul(argv[1], NULL, 0) << 20;
+
+	srand(1);
+	for (i = 0; i + 2 <= RB_SIZE; i += len + 2) {
+		len = rand() % MAX_LINE;
+		if (i + len + 2 > RB_SIZE)
+			len = RB_SIZE - i - 2;
+		memset(buffer + i, 'a' + rand() % 26, len);
+		memcpy(buffer + i + len, "\r\n", 2);
+	}
+	ret = rs_rb_init(&rb, buffer, RB_SIZE);
+	if (ret < 0)
+		error(EXIT_FAILURE, -ret, "rs_rb_init");
+	rs_rb_write_incr(&rb, RB_SIZE);
+
+	run("rs_rb_read_at", &rb, search_read_at, total / 16);
+	run("rs_rb_search", &rb, search_rs_rb, total);
+
+	return EXIT_SUCCESS;
+}
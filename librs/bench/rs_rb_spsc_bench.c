@@ -0,0 +1,356 @@
+/**
+ * @file rs_rb_spsc_bench.c
+ * @brief Benchmark of rs_rb_spsc between two threads pinned on two CPUs,
+ * compared to rs_rb protected by a mutex. The throughput is measured by
+ * streaming data in chunks of several sizes from a producer to a consumer, the
+ * latency by bouncing a message back and forth between the two threads,
+ * through two ring buffers, half the round trip time is reported. Both sides
+ * spin when the ring buffer is empty or full, yielding the CPU after a while,
+ * so that the benchmark stays usable with only one CPU.
+ *
+ * usage: rs_rb_spsc_bench [producer_cpu consumer_cpu [megabytes]]
+ *
+ * The CPUs default to 0 and 1, or to 0 and 0 on a single CPU system.
+ *
+ * Copyright (C) 2026 Parrot S.A.
+ */
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif /* _GNU_SOURCE */
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+
+#include <stdbool.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <errno.h>
+#include <error.h>
+
+#include <ut_utils.h>
+
+#include <rs_rb.h>
+#include <rs_rb_spsc.h>
+
+#define RB_SIZE 0x10000
+#define MAX_CHUNK 0x4000
+#define DEFAULT_MEGABYTES 256
+#define NB_ROUND_TRIPS 100000
+#define SPINS_BEFORE_YIELD 100
+
+struct bench_rb {
+	const char *name;
+	int (*init)(void *rb);
+	int (*write)(void *rb, const void *buf, size_t len);
+	int (*read)(void *rb, void *buf, size_t len);
+	int (*clean)(void *rb);
+};
+
+struct locked_rb {
+	struct rs_rb rb;
+	pthread_mutex_t mutex;
+};
+
+union any_rb {
+	struct rs_rb_spsc spsc;
+	struct locked_rb locked;
+};
+
+struct side {
+	const struct bench_rb *b;
+	int cpu;
+	void *in;
+	void *out;
+	size_t chunk;
+	size_t total;
+};
+
+static double now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void pin(int cpu)
+{
+	cpu_set_t set;
+	int ret;
+
+	CPU_ZERO(&set);
+	CPU_SET(cpu, &set);
+	ret = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+	if (ret != 0)
+		error(EXIT_FAILURE, ret, "pthread_setaffinity_np %d", cpu);
+}
+
+static void backoff(unsigned *spins)
+{
+	if (++*spins % SPINS_BEFORE_YIELD == 0)
+		sched_yield();
+}
+
+static int spsc_init(void *rb)
+{
+	return rs_rb_spsc_init(rb, NULL, RB_SIZE);
+}
+
+static int spsc_write(void *rb, const void *buf, size_t len)
+{
+	return rs_rb_spsc_write(rb, buf, len);
+}
+
+static int spsc_read(void *rb, void *buf, size_t len)
+{
+	return rs_rb_spsc_read(rb, buf, len);
+}
+
+static int spsc_clean(void *rb)
+{
+	return rs_rb_spsc_clean(rb);
+}
+
+static int locked_init(void *rb)
+{
+	struct locked_rb *l = rb;
+
+	pthread_mutex_init(&l->mutex, NULL);
+
+	return rs_rb_init(&l->rb, NULL, RB_SIZE);
+}
+
+/* the buffer is mirrored, hence never wraps */
+static int locked_write(void *rb, const void *buf, size_t len)
+{
+	struct locked_rb *l = rb;
+	int ret = -EAGAIN;
+
+	pthread_mutex_lock(&l->mutex);
+	if (rs_rb_get_write_length(&l->rb) >= len) {
+		memcpy(rs_rb_get_write_ptr(&l->rb), buf, len);
+		ret = rs_rb_write_incr(&l->rb, len);
+	}
+	pthread_mutex_unlock(&l->mutex);
+
+	return ret;
+}
+
+static int locked_read(void *rb, void *buf, size_t len)
+{
+	struct locked_rb *l = rb;
+	int ret = -EAGAIN;
+
+	pthread_mutex_lock(&l->mutex);
+	if (rs_rb_get_read_length(&l->rb) >= len) {
+		memcpy(buf, rs_rb_get_read_ptr(&l->rb), len);
+		ret = rs_rb_read_incr(&l->rb, len);
+	}
+	pthread_mutex_unlock(&l->mutex);
+
+	return ret;
+}
+
+static int locked_clean(void *rb)
+{
+	struct locked_rb *l = rb;
+
+	pthread_mutex_destroy(&l->mutex);
+
+	return rs_rb_clean(&l->rb);
+}
+
+static void *produce(void *arg)
+{
+	struct side *s = arg;
+	char chunk[MAX_CHUNK] = {0};
+	size_t sent;
+	unsigned spins = 0;
+	int ret;
+
+	pin(s->cpu);
+	for (sent = 0; sent < s->total; sent += s->chunk) {
+		while ((ret = s->b->write(s->out, chunk, s->chunk)) == -EAGAIN)
+			backoff(&spins);
+		if (ret < 0)
+			error(EXIT_FAILURE, -ret, "%s write", s->b->name);
+	}
+
+	return NULL;
+}
+
+static void run_throughput(const struct bench_rb *b, int cpus[2],
+		size_t chunk, size_t total)
+{
+	union any_rb rb;
+	struct side producer = {
+		.b = b,
+		.cpu = cpus[0],
+		.out = &rb,
+		.chunk = chunk,
+		.total = total,
+	};
+	pthread_t thread;
+	char buf[MAX_CHUNK];
+	size_t received;
+	unsigned spins = 0;
+	double start;
+	int ret;
+
+	ret = b->init(&rb);
+	if (ret < 0)
+		error(EXIT_FAILURE, -ret, "%s init", b->name);
+	pin(cpus[1]);
+
+	start = now();
+	ret = pthread_create(&thread, NULL, produce, &producer);
+	if (ret != 0)
+		error(EXIT_FAILURE, ret, "pthread_create");
+	for (received = 0; received < total; received += chunk) {
+		while ((ret = b->read(&rb, buf, chunk)) == -EAGAIN)
+			backoff(&spins);
+		if (ret < 0)
+			error(EXIT_FAILURE, -ret, "%s read", b->name);
+	}
+	pthread_join(thread, NULL);
+	start = now() - start;
+
+	printf("%-11s throughput %6zu B chunks %10.2f MB/s\n", b->name, chunk,
+			total / start / 1e6);
+	b->clean(&rb);
+}
+
+static void *echo(void *arg)
+{
+	struct side *s = arg;
+	uint64_t message;
+	unsigned spins = 0;
+	size_t i;
+	int ret;
+
+	pin(s->cpu);
+	for (i = 0; i < s->total; i++) {
+		while ((ret = s->b->read(s->in, &message, sizeof(message))) ==
+				-EAGAIN)
+			backoff(&spins);
+		while ((ret = s->b->write(s->out, &message, sizeof(message))) ==
+				-EAGAIN)
+			backoff(&spins);
+		if (ret < 0)
+			error(EXIT_FAILURE, -ret, "%s echo", s->b->name);
+	}
+
+	return NULL;
+}
+
+static int compare_doubles(const void *a, const void *b)
+{
+	double da = *(const double *)a;
+	double db = *(const double *)b;
+
+	return da < db ? -1 : da > db;
+}
+
+static void run_latency(const struct bench_rb *b, int cpus[2])
+{
+	union any_rb ping;
+	union any_rb pong;
+	struct side echoer = {
+		.b = b,
+		.cpu = cpus[1],
+		.in = &ping,
+		.out = &pong,
+		.total = NB_ROUND_TRIPS,
+	};
+	pthread_t thread;
+	uint64_t message;
+	unsigned spins = 0;
+	double *latencies;
+	double start;
+	size_t i;
+	int ret;
+
+	latencies = calloc(NB_ROUND_TRIPS, sizeof(*latencies));
+	if (NULL == latencies)
+		error(EXIT_FAILURE, ENOMEM, "calloc");
+	ret = b->init(&ping);
+	if (ret >= 0)
+		ret = b->init(&pong);
+	if (ret < 0)
+		error(EXIT_FAILURE, -ret, "%s init", b->name);
+	pin(cpus[0]);
+
+	ret = pthread_create(&thread, NULL, echo, &echoer);
+	if (ret != 0)
+		error(EXIT_FAILURE, ret, "pthread_create");
+	for (i = 0; i < NB_ROUND_TRIPS; i++) {
+		message = i;
+		start = now();
+		while ((ret = b->write(&ping, &message, sizeof(message))) ==
+				-EAGAIN)
+			backoff(&spins);
+		while ((ret = b->read(&pong, &message, sizeof(message))) ==
+				-EAGAIN)
+			backoff(&spins);
+		if (ret < 0 || message != i)
+			error(EXIT_FAILURE, -ret, "%s round trip", b->name);
+		latencies[i] = (now() - start) / 2;
+	}
+	pthread_join(thread, NULL);
+
+	qsort(latencies, NB_ROUND_TRIPS, sizeof(*latencies), compare_doubles);
+	printf("%-11s latency    median %8.0f ns  p99 %8.0f ns\n", b->name,
+			latencies[NB_ROUND_TRIPS / 2] * 1e9,
+			latencies[NB_ROUND_TRIPS * 99 / 100] * 1e9);
+
+	b->clean(&pong);
+	b->clean(&ping);
+	free(latencies);
+}
+
+int main(int argc, char *argv[])
+{
+	const struct bench_rb rbs[] = {
+		{
+			.name = "rs_rb+mutex",
+			.init = locked_init,
+			.write = locked_write,
+			.read = locked_read,
+			.clean = locked_clean,
+		},
+		{
+			.name = "rs_rb_spsc",
+			.init = spsc_init,
+			.write = spsc_write,
+			.read = spsc_read,
+			.clean = spsc_clean,
+		},
+	};
+	const size_t chunks[] = {64, 1024, MAX_CHUNK};
+	int cpus[2] = {0, sysconf(_SC_NPROCESSORS_ONLN) > 1 ? 1 : 0};
+	size_t total = (size_t)DEFAULT_MEGABYTES << 20;
+	unsigned i;
+	unsigned j;
+
+	if (argc == 2 || argc > 4)
+		error(EXIT_FAILURE, EINVAL, "usage: %s [producer_cpu "
+				"consumer_cpu [megabytes]]", argv[0]);
+	if (argc > 2) {
+		cpus[0] = atoi(argv[1]);
+		cpus[1] = atoi(argv[2]);
+	}
+	if (argc > 3)
+		total = strtoul(argv[3], NULL, 0) << 20;
+
+	for (j = 0; j < UT_ARRAY_SIZE(chunks); j++)
+		for (i = 0; i < UT_ARRAY_SIZE(rbs); i++)
+			run_throughput(rbs + i, cpus, chunks[j], total);
+	for (i = 0; i < UT_ARRAY_SIZE(rbs); i++)
+		run_latency(rbs + i, cpus);
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,315 @@
+/**
+ * @file rs_rbtree_heap_bench.c
+ * @brief Benchmark of the sorted containers of librs, the doubly linked list
+ * with rs_dll_insert_sorted(), the red-black tree and the d-ary heap, with
+ * arities 2, 4 and 8, used as priority queues holding 10, 1k and 100k
+ * elements. Measures filling the container with random keys then draining it,
+ * and the "hold" pattern of timer lists, where the least element is popped and
+ * re-inserted with a later key. Filling the list being quadratic, it is
+ * skipped for the largest size, where the list is pre-filled in order, for the
+ * hold pattern.
+ *
+ * usage: rs_rbtree_heap_bench [hold_ms]
+ *
+ * Copyright (C) 2026 Parrot S.A.
+ */
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <time.h>
+#include <errno.h>
+#include <error.h>
+
+#include <ut_utils.h>
+
+#include <rs_dll.h>
+#include <rs_heap.h>
+#include <rs_rbtree.h>
+
+#define FILL_DRAIN_ELEMENTS 1000000
+#define HOLD_BATCH 16
+#define MAX_DLL_FILL 1000
+#define DEFAULT_HOLD_MS 500
+#define MAX_DELAY 1000000
+
+struct item {
+	uint64_t key;
+	struct rs_node dll;
+	struct rs_rbtree_node tree;
+	struct rs_heap_node heap;
+};
+
+struct container {
+	const char *name;
+	size_t arity;
+	void (*init)(const struct container *container);
+	void (*fill)(struct item *items, size_t nb);
+	void (*insert)(struct item *item);
+	struct item *(*pop)(void);
+	void (*clean)(void);
+};
+
+static struct rs_dll dll;
+static struct rs_rbtree tree;
+static struct rs_heap heap;
+static uint64_t seed = 88172645463325252ull;
+
+static uint64_t next_random(void)
+{
+	seed ^= seed << 13;
+	seed ^= seed >> 7;
+	seed ^= seed << 17;
+
+	return seed;
+}
+
+static int compare_keys(uint64_t a, uint64_t b)
+{
+	return (a > b) - (a < b);
+}
+
+static int dll_compare(struct rs_node *a, const struct rs_node *b)
+{
+	return compare_keys(ut_container_of(a, struct item, dll)->key,
+			ut_container_of(b, struct item, dll)->key);
+}
+
+static int tree_compare(struct rs_rbtree_node *a,
+		const struct rs_rbtree_node *b)
+{
+	return compare_keys(ut_container_of(a, struct item, tree)->key,
+			ut_container_of(b, struct item, tree)->key);
+}
+
+static int heap_compare(struct rs_heap_node *a, const struct rs_heap_node *b)
+{
+	return compare_keys(ut_container_of(a, struct item, heap)->key,
+			ut_container_of(b, struct item, heap)->key);
+}
+
+static void dll_init(const struct container *container)
+{
+	static const struct rs_dll_vtable vtable = {.compare = dll_compare};
+	int ret;
+
+	ret = rs_dll_init(&dll, &vtable);
+	if (ret < 0)
+		error(EXIT_FAILURE, -ret, "rs_dll_init");
+}
+
+static int compare_items(const void *a, const void *b)
+{
+	return compare_keys(((const struct item *)a)->key,
+			((const struct item *)b)->key);
+}
+
+static void dll_fill(struct item *items, size_t nb)
+{
+	size_t i;
+
+	qsort(items, nb, sizeof(*items), compare_items);
+	for (i = 0; i < nb; i++)
+		rs_dll_enqueue(&dll, &items[i].dll);
+}
+
+static void dll_insert(struct item *item)
+{
+	rs_dll_insert_sorted(&dll, &item->dll);
+}
+
+static struct item *dll_pop(void)
+{
+	struct rs_node *node = rs_dll_pop(&dll);
+
+	return NULL == node ? NULL : ut_container_of(node, struct item, dll);
+}
+
+static void dll_clean(void)
+{
+	rs_dll_remove_all(&dll);
+}
+
+static void tree_init(const struct container *container)
+{
+	static const struct rs_rbtree_vtable vtable = {.compare = tree_compare};
+	int ret;
+
+	ret = rs_rbtree_init(&tree, &vtable);
+	if (ret < 0)
+		error(EXIT_FAILURE, -ret, "rs_rbtree_init");
+}
+
+static void tree_insert(struct item *item)
+{
+	rs_rbtree_insert(&tree, &item->tree);
+}
+
+static void tree_fill(struct item *items, size_t nb)
+{
+	size_t i;
+
+	for (i = 0; i < nb; i++)
+		tree_insert(items + i);
+}
+
+static struct item *tree_pop(void)
+{
+	struct rs_rbtree_node *node = rs_rbtree_pop(&tree);
+
+	return NULL == node ? NULL : ut_container_of(node, struct item, tree);
+}
+
+static void tree_clean(void)
+{
+	rs_rbtree_clean(&tree);
+}
+
+static void heap_init(const struct container *container)
+{
+	static const struct rs_heap_vtable vtable = {.compare = heap_compare};
+	int ret;
+
+	ret = rs_heap_init(&heap, container->arity, 0, &vtable);
+	if (ret < 0)
+		error(EXIT_FAILURE, -ret, "rs_heap_init");
+}
+
+static void heap_insert(struct item *item)
+{
+	if (rs_heap_insert(&heap, &item->heap) < 0)
+		error(EXIT_FAILURE, ENOMEM, "rs_heap_insert");
+}
+
+static void heap_fill(struct item *items, size_t nb)
+{
+	size_t i;
+
+	for (i = 0; i < nb; i++)
+		heap_insert(items + i);
+}
+
+static struct item *heap_pop(void)
+{
+	struct rs_heap_node *node = rs_heap_pop(&heap);
+
+	return NULL == node ? NULL : ut_container_of(node, struct item, heap);
+}
+
+static void heap_clean(void)
+{
+	rs_heap_clean(&heap);
+}
+
+static const struct container containers[] = {
+	{"rs_dll", 0, dll_init, dll_fill, dll_insert, dll_pop, dll_clean},
+	{"rs_rbtree", 0, tree_init, tree_fill, tree_insert, tree_pop,
+			tree_clean},
+	{"rs_heap 2-ary", 2, heap_init, heap_fill, heap_insert, heap_pop,
+			heap_clean},
+	{"rs_heap 4-ary", 4, heap_init, heap_fill, heap_insert, heap_pop,
+			heap_clean},
+	{"rs_heap 8-ary", 8, heap_init, heap_fill, heap_insert, heap_pop,
+			heap_clean},
+};
+
+static double now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static double run_fill_drain(const struct container *container,
+		struct item *items, size_t nb)
+{
+	size_t rounds = (FILL_DRAIN_ELEMENTS + nb - 1) / nb;
+	size_t round;
+	size_t i;
+	double start;
+
+	container->init(container);
+	start = now();
+	for (round = 0; round < rounds; round++) {
+		for (i = 0; i < nb; i++) {
+			items[i].key = next_random();
+			container->insert(items + i);
+		}
+		while (container->pop() != NULL)
+			;
+	}
+	start = now() - start;
+	container->clean();
+
+	return start * 1e9 / (rounds * nb);
+}
+
+static double run_hold(const struct container *container, struct item *items,
+		size_t nb, double duration)
+{
+	struct item *item;
+	unsigned long ops = 0;
+	double start;
+	double elapsed;
+	size_t i;
+
+	container->init(container);
+	for (i = 0; i < nb; i++)
+		items[i].key = next_random() % MAX_DELAY;
+	container->fill(items, nb);
+	start = now();
+	do {
+		for (i = 0; i < HOLD_BATCH; i++) {
+			item = container->pop();
+			item->key += 1 + next_random() % MAX_DELAY;
+			container->insert(item);
+		}
+		ops += HOLD_BATCH;
+		elapsed = now() - start;
+	} while (elapsed < duration);
+	container->clean();
+
+	return elapsed * 1e9 / ops;
+}
+
+int main(int argc, char *argv[])
+{
+	const size_t sizes[] = {10, 1000, 100000};
+	double duration = DEFAULT_HOLD_MS / 1e3;
+	struct item *items;
+	unsigned i;
+	unsigned j;
+	bool skip;
+
+	if (argc > 2)
+		error(EXIT_FAILURE, EINVAL, "usage: %s [hold_ms]", argv[0]);
+	if (argc > 1)
+		duration = strtoul(argv[1], NULL, 0) / 1e3;
+
+	items = calloc(sizes[UT_ARRAY_SIZE(sizes) - 1], sizeof(*items));
+	if (NULL == items)
+		error(EXIT_FAILURE, ENOMEM, "calloc");
+
+	printf("%-14s %8s %18s %14s\n", "container", "elements",
+			"fill+drain ns/elt", "hold ns/op");
+	for (i = 0; i < UT_ARRAY_SIZE(sizes); i++) {
+		for (j = 0; j < UT_ARRAY_SIZE(containers); j++) {
+			printf("%-14s %8zu ", containers[j].name, sizes[i]);
+			skip = containers[j].insert == dll_insert &&
+					sizes[i] > MAX_DLL_FILL;
+			if (skip)
+				printf("%18s ", "skipped");
+			else
+				printf("%18.1f ", run_fill_drain(containers + j,
+						items, sizes[i]));
+			printf("%14.1f\n", run_hold(containers + j, items,
+					sizes[i], duration));
+			fflush(stdout);
+		}
+	}
+	free(items);
+
+	return EXIT_SUCCESS;
+}
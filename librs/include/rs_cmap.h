@@ -0,0 +1,198 @@
+/**
+ * @file rs_cmap.h
+ * @date 19 oct. 2026
+ * @author nicolas.carrier@parrot.com
+ * @brief Concurrent hash map with string keys, for many readers and rare
+ * writers. Lookups take no lock and never block, they only increment, then
+ * decrement, a counter of the current epoch. Insertions and removals lock one
+ * of several mutexes, chosen by the bucket of the key, so that writers on
+ * different buckets don't contend. Removed entries are freed by batches, once
+ * all the lookups which may still see them have completed, which is known
+ * when the counters of the previous epoch drop to zero.
+ * The number of buckets is fixed, keys are unique. The map manages the
+ * lifetime of it's entries only, the data a lookup returns can be removed
+ * concurrently, it's lifetime must be handled by the caller, e.g. with a
+ * reference count or by keeping it until the map is cleaned.
+ *
+ * Copyright (C) 2026 Parrot S.A.
+ */
+#ifndef RS_CMAP_H_
+#define RS_CMAP_H_
+#include <pthread.h>
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @def RS_CMAP_NB_STRIPES
+ * @brief Number of locks writers are spread over, power of 2
+ */
+#define RS_CMAP_NB_STRIPES 64
+
+/**
+ * @def RS_CMAP_NB_READER_SLOTS
+ * @brief Number of epoch counters readers are spread over, power of 2, each
+ * thread always uses the same one
+ */
+#define RS_CMAP_NB_READER_SLOTS 64
+
+/**
+ * @struct rs_cmap_entry
+ * @brief Entry of a concurrent hash map, internal
+ */
+struct rs_cmap_entry {
+	/** next entry in the bucket */
+	struct rs_cmap_entry *next;
+	/**
+	 * next entry in the list of retired entries, readers may still follow
+	 * the next pointer of a retired entry
+	 */
+	struct rs_cmap_entry *next_retired;
+	/** data associated to the key */
+	void *data;
+	/** hash of the key */
+	uint32_t hash;
+	/** key, NUL-terminated */
+	char key[];
+};
+
+/**
+ * @struct rs_cmap_stripe
+ * @brief Lock of writers, on it's own cache line, internal
+ */
+struct rs_cmap_stripe {
+	/** lock of the buckets of this stripe */
+	pthread_mutex_t mutex;
+} __attribute__((aligned(64)));
+
+/**
+ * @struct rs_cmap_reader_slot
+ * @brief Counters of readers in the critical section, per epoch parity, on
+ * their own cache line, internal
+ */
+struct rs_cmap_reader_slot {
+	/** number of lookups in progress, indexed by the epoch's parity */
+	unsigned long count[2];
+} __attribute__((aligned(64)));
+
+/**
+ * @struct rs_cmap
+ * @brief Concurrent hash map
+ */
+struct rs_cmap {
+	/** chains of entries, their number is a power of 2 */
+	struct rs_cmap_entry **buckets;
+	/** number of buckets minus 1 */
+	size_t mask;
+	/** number of entries */
+	size_t count;
+	/** current epoch, readers count themselves in the slot of it's parity */
+	unsigned long epoch;
+	/** locks of the writers */
+	struct rs_cmap_stripe stripes[RS_CMAP_NB_STRIPES];
+	/** counters of the readers */
+	struct rs_cmap_reader_slot readers[RS_CMAP_NB_READER_SLOTS];
+	/** lock of the retired entries and of the epoch changes */
+	pthread_mutex_t retired_mutex;
+	/** entries removed, waiting for the lookups to complete to be freed */
+	struct rs_cmap_entry *retired;
+	/** number of retired entries */
+	size_t nb_retired;
+};
+
+/**
+ * Initializes a concurrent hash map. When not used anymore, a hash map must be
+ * cleaned with a call to rs_cmap_clean()
+ * @param map Hash map to initialize
+ * @param size Expected number of entries, the number of buckets is the next
+ * power of 2, 0 for a default value
+ * @return Negative errno-compatible value on error, 0 on success
+ */
+int rs_cmap_init(struct rs_cmap *map, size_t size);
+
+/**
+ * Returns the number of entries of a concurrent hash map, can be outdated as
+ * soon as returned if writers are running
+ * @param map Hash map
+ * @return number of entries, 0 if map is NULL
+ */
+static inline size_t rs_cmap_get_count(const struct rs_cmap *map)
+{
+	return NULL == map ? 0 : __atomic_load_n(&map->count, __ATOMIC_RELAXED);
+}
+
+/**
+ * Lookup an entry in a concurrent hash map, without locking, can be called
+ * from any thread, concurrently with any function but rs_cmap_init() and
+ * rs_cmap_clean()
+ * @param map Hash map
+ * @param key String key
+ * @param data In output, a pointer to a matching data, or to NULL if no entry
+ * was found. can't be NULL
+ * @return Negative errno-compatible value on error, 0 on success. -ENOENT if
+ * the entry wasn't found
+ */
+int rs_cmap_lookup(struct rs_cmap *map, const char *key, void **data);
+
+/**
+ * Insert an entry in a concurrent hash map, the key is copied. Can be called
+ * from any thread, concurrently with any function but rs_cmap_init() and
+ * rs_cmap_clean()
+ * @param map Hash map
+ * @param key String key
+ * @param data Piece of data to associate with the key. Can be NULL
+ * @return Negative errno-compatible value on error, -EEXIST if the key is
+ * already present, 0 on success
+ */
+int rs_cmap_insert(struct rs_cmap *map, const char *key, void *data);
+
+/**
+ * Remove an entry from a concurrent hash map and retrieve associated data. Can
+ * be called from any thread, concurrently with any function but
+ * rs_cmap_init() and rs_cmap_clean(). May wait for the lookups in progress to
+ * complete, to free the entries removed previously
+ * @param map Hash map
+ * @param key String key
+ * @param data In output, a pointer to a matching data, or NULL if no entry was
+ * found. Can be NULL
+ * @return Negative errno-compatible value on error, 0 on success. -ENOENT if
+ * the entry wasn't found
+ */
+int rs_cmap_remove(struct rs_cmap *map, const char *key, void **data);
+
+/**
+ * Waits for all the lookups in progress to complete and frees the entries
+ * removed until then
+ * @param map Hash map
+ * @return Negative errno-compatible value on error, 0 on success
+ */
+int rs_cmap_synchronize(struct rs_cmap *map);
+
+/**
+ * Reinitializes a concurrent hash map. Releases internally used resources and
+ * allows the user to free the resources allocated, still referenced in the
+ * map. No other function can be running on the map meanwhile
+ * @param map Hash map to clean
+ * @param free_cb callback called on each value still stored in the map, can be
+ * NULL
+ * @return Negative errno-compatible value on error, 0 on success
+ */
+int rs_cmap_clean_cb(struct rs_cmap *map, void (*free_cb)(void *));
+
+/**
+ * Reinitializes a concurrent hash map. Releases internally used resources.
+ * Equivalent to rs_cmap_clean_cb(map, NULL);
+ * @param map Hash map to clean
+ * @return Negative errno-compatible value on error, 0 on success
+ */
+int rs_cmap_clean(struct rs_cmap *map);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* RS_CMAP_H_ */
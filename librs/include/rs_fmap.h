@@ -0,0 +1,128 @@
+/**
+ * @file rs_fmap.h
+ * @date 19 oct. 2026
+ * @author nicolas.carrier@parrot.com
+ * @brief Frozen map, read-only map with string keys, built once from a known
+ * set of keys into a minimal perfect hash: each key has it's own slot in a
+ * flat array holding exactly one entry per key. A lookup computes one hash,
+ * reads the seed of the key's bucket, which gives the slot, then compares the
+ * key stored in the slot to the key looked for, absent keys are thus reported
+ * as such.
+ * A frozen map can be built at runtime with rs_fmap_init(), or generated as a
+ * C source file at build time by the rs_fmap_gen tool, the resulting map is
+ * then a constant, needing neither heap nor construction at startup.
+ *
+ * Copyright (C) 2026 Parrot S.A.
+ */
+#ifndef RS_FMAP_H_
+#define RS_FMAP_H_
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @def RS_FMAP_VERSION
+ * @brief Version of the hashing scheme, generated maps are valid only for the
+ * version they were generated with
+ */
+#define RS_FMAP_VERSION 1
+
+/**
+ * @def RS_FMAP_DIRECT
+ * @brief Flag of a seed giving directly the slot of the only key of it's
+ * bucket, internal
+ */
+#define RS_FMAP_DIRECT 0x80000000u
+
+/**
+ * @struct rs_fmap_entry
+ * @brief Entry of a frozen map
+ */
+struct rs_fmap_entry {
+	/** key, NUL-terminated */
+	const char *key;
+	/** data associated to the key */
+	void *data;
+};
+
+/**
+ * @struct rs_fmap
+ * @brief Frozen map, all the fields are read-only
+ */
+struct rs_fmap {
+	/**
+	 * per bucket, either the seed placing the keys of the bucket, or the
+	 * slot of the bucket's only key, ored with RS_FMAP_DIRECT
+	 */
+	const uint32_t *seeds;
+	/** number of buckets */
+	uint32_t nb_buckets;
+	/** number of entries */
+	uint32_t nb_entries;
+	/** entries, indexed by the slot of their key */
+	const struct rs_fmap_entry *entries;
+};
+
+/**
+ * Builds a frozen map from a set of entries. When not used anymore, a frozen
+ * map built this way must be cleaned with a call to rs_fmap_clean(), maps
+ * generated by rs_fmap_gen must not
+ * @param map Frozen map to initialize
+ * @param entries Entries of the map, copied, but not the keys they point to,
+ * which must stay valid during the map's lifetime. Can be NULL if nb is 0
+ * @param nb Number of entries
+ * @return Negative errno-compatible value on error, -EEXIST if a key is
+ * present twice, -ERANGE in the very unlikely case no perfect hash was found,
+ * 0 on success
+ */
+int rs_fmap_init(struct rs_fmap *map, const struct rs_fmap_entry *entries,
+		size_t nb);
+
+/**
+ * Returns the number of entries of a frozen map
+ * @param map Frozen map
+ * @return number of entries, 0 if map is NULL
+ */
+static inline size_t rs_fmap_get_count(const struct rs_fmap *map)
+{
+	return NULL == map ? 0 : map->nb_entries;
+}
+
+/**
+ * Lookup an entry in a frozen map
+ * @param map Frozen map
+ * @param key String key
+ * @param data In output, a pointer to a matching data, or to NULL if no entry
+ * was found. can't be NULL
+ * @return Negative errno-compatible value on error, 0 on success. -ENOENT if
+ * the entry wasn't found
+ */
+int rs_fmap_lookup(const struct rs_fmap *map, const char *key, void **data);
+
+/**
+ * Returns the slot of a key, i.e. the index of it's entry if the key is in the
+ * map, without comparing the key to the entry's. Allows storing the entries
+ * elsewhere than in the entries field, e.g. in a file, see rs_fmap_file.h
+ * @param map Frozen map, with at least one entry, only the seeds and the
+ * numbers of buckets and entries are used
+ * @param key Key, can be NULL only if len is 0
+ * @param len Length of the key
+ * @return Slot of the key
+ */
+uint32_t rs_fmap_slot(const struct rs_fmap *map, const char *key, size_t len);
+
+/**
+ * Releases the resources allocated by rs_fmap_init()
+ * @param map Frozen map to clean
+ * @return Negative errno-compatible value on error, 0 on success
+ */
+int rs_fmap_clean(struct rs_fmap *map);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* RS_FMAP_H_ */
@@ -0,0 +1,194 @@
+/**
+ * @file rs_fmap_file.h
+ * @date 19 oct. 2026
+ * @author nicolas.carrier@parrot.com
+ * @brief Frozen map files, frozen maps with string keys and binary values,
+ * serialized in a file which is used as is, once mapped in memory: opening
+ * one parses and allocates nothing, only the pages a lookup touches are read
+ * from the disk. All the positions in the file are offsets from it's start,
+ * so that it can be mapped anywhere.
+ * The file starts with a header, versioned and protected by it's own checksum,
+ * which is checked at opening. The rest of the file is covered by a second
+ * checksum, which is checked only on demand, by rs_fmap_file_verify(), not to
+ * read the whole file at startup, a lookup in a corrupted file can't read out
+ * of the file though. Integers are stored in the byte order of the machine
+ * writing the file, a file of the other byte order is refused.
+ *
+ * Copyright (C) 2026 Parrot S.A.
+ */
+#ifndef RS_FMAP_FILE_H_
+#define RS_FMAP_FILE_H_
+#include <stddef.h>
+#include <stdint.h>
+
+#include <rs_fmap.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @def RS_FMAP_FILE_MAGIC
+ * @brief First bytes of a frozen map file, "RSFM" in little endian
+ */
+#define RS_FMAP_FILE_MAGIC 0x4d465352u
+
+/**
+ * @def RS_FMAP_FILE_VERSION
+ * @brief Version of the format of the frozen map files
+ */
+#define RS_FMAP_FILE_VERSION 1
+
+/**
+ * @struct rs_fmap_file_header
+ * @brief Header of a frozen map file, at offset 0
+ */
+struct rs_fmap_file_header {
+	/** RS_FMAP_FILE_MAGIC */
+	uint32_t magic;
+	/** RS_FMAP_FILE_VERSION */
+	uint32_t version;
+	/** RS_FMAP_VERSION, the hashing scheme the seeds were computed for */
+	uint32_t hash_version;
+	/** number of buckets */
+	uint32_t nb_buckets;
+	/** number of entries */
+	uint32_t nb_entries;
+	/** padding, 0 */
+	uint32_t reserved;
+	/** size of the file */
+	uint64_t size;
+	/** offset of the seeds, array of nb_buckets uint32_t */
+	uint64_t seeds;
+	/** offset of the entries, array of nb_entries rs_fmap_file_entry */
+	uint64_t entries;
+	/** checksum of the file, after the header */
+	uint64_t checksum;
+	/** checksum of the header, up to this field excluded */
+	uint64_t header_checksum;
+};
+
+/**
+ * @struct rs_fmap_file_entry
+ * @brief Entry of a frozen map file, indexed by the slot of it's key
+ */
+struct rs_fmap_file_entry {
+	/** offset of the key, NUL-terminated */
+	uint64_t key;
+	/** offset of the value, aligned on 8 bytes */
+	uint64_t value;
+	/** length of the key, NUL excluded */
+	uint32_t key_len;
+	/** length of the value */
+	uint32_t value_len;
+};
+
+/**
+ * @struct rs_fmap_file_item
+ * @brief Key and value to store in a frozen map file
+ */
+struct rs_fmap_file_item {
+	/** key, NUL-terminated */
+	const char *key;
+	/** value, can be NULL if len is 0 */
+	const void *value;
+	/** length of the value */
+	size_t len;
+};
+
+/**
+ * @struct rs_fmap_file
+ * @brief Frozen map file mapped in memory
+ */
+struct rs_fmap_file {
+	/** start of the file's content */
+	const uint8_t *base;
+	/** size of the file */
+	size_t size;
+	/** non-zero if base was mapped by rs_fmap_file_open() */
+	int mapped;
+	/** frozen map whose seeds point in the file, without entries */
+	struct rs_fmap map;
+	/** entries, in the file */
+	const struct rs_fmap_file_entry *entries;
+};
+
+/**
+ * Writes a frozen map file, atomically: the content is written in a temporary
+ * file in the same directory, which is then renamed
+ * @param path Path of the file to write
+ * @param items Keys and values, can be NULL if nb is 0
+ * @param nb Number of items
+ * @return Negative errno-compatible value on error, -EEXIST if a key is
+ * present twice, 0 on success
+ */
+int rs_fmap_file_write(const char *path, const struct rs_fmap_file_item *items,
+		size_t nb);
+
+/**
+ * Maps a frozen map file in memory and checks it's header. When not used
+ * anymore, it must be closed with a call to rs_fmap_file_close()
+ * @param file Frozen map file to initialize
+ * @param path Path of the file to open
+ * @return Negative errno-compatible value on error, -EBADMSG if the file is
+ * corrupted, -ENOTSUP if it is of another version or byte order, 0 on success
+ */
+int rs_fmap_file_open(struct rs_fmap_file *file, const char *path);
+
+/**
+ * Initializes a frozen map file from a content already in memory, e.g.
+ * embedded in the program, checks it's header. rs_fmap_file_close() doesn't
+ * release the content
+ * @param file Frozen map file to initialize
+ * @param buf Content of the file, aligned on 8 bytes, must stay valid until
+ * the file is closed
+ * @param size Size of the content
+ * @return Negative errno-compatible value on error, -EBADMSG if the content is
+ * corrupted, -ENOTSUP if it is of another version or byte order, 0 on success
+ */
+int rs_fmap_file_init(struct rs_fmap_file *file, const void *buf, size_t size);
+
+/**
+ * Returns the number of entries of a frozen map file
+ * @param file Frozen map file
+ * @return number of entries, 0 if file is NULL
+ */
+static inline size_t rs_fmap_file_get_count(const struct rs_fmap_file *file)
+{
+	return NULL == file ? 0 : file->map.nb_entries;
+}
+
+/**
+ * Checks the checksum of the whole content of a frozen map file, which reads
+ * all of it
+ * @param file Frozen map file
+ * @return Negative errno-compatible value on error, -EBADMSG if the file is
+ * corrupted, 0 on success
+ */
+int rs_fmap_file_verify(const struct rs_fmap_file *file);
+
+/**
+ * Lookup an entry in a frozen map file
+ * @param file Frozen map file
+ * @param key String key
+ * @param value In output, a pointer to the value in the file, valid until the
+ * file is closed, or to NULL if no entry was found. can't be NULL
+ * @param len In output, length of the value, can be NULL
+ * @return Negative errno-compatible value on error, 0 on success. -ENOENT if
+ * the entry wasn't found, -EBADMSG if the entry is corrupted
+ */
+int rs_fmap_file_lookup(const struct rs_fmap_file *file, const char *key,
+		const void **value, size_t *len);
+
+/**
+ * Unmaps a frozen map file, the values returned by lookups become invalid
+ * @param file Frozen map file to close
+ * @return Negative errno-compatible value on error, 0 on success
+ */
+int rs_fmap_file_close(struct rs_fmap_file *file);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* RS_FMAP_FILE_H_ */
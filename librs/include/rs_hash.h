@@ -0,0 +1,66 @@
+/**
+ * @file rs_hash.h
+ * @date 19 oct. 2026
+ * @author nicolas.carrier@parrot.com
+ * @brief Hash functions used by the librs hash maps, exported for the hash
+ * callbacks of rs_ihmap. All but rs_hash_wyhash64() return 32 bits values
+ * whose low bits depend on all the bytes of the input, so that they can be
+ * masked to index a table with a power of 2 number of slots.
+ *
+ * Copyright (C) 2026 Parrot S.A.
+ */
+#ifndef RS_HASH_H_
+#define RS_HASH_H_
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Computes the 64 bits wyhash of a buffer, buffers of up to 16 bytes are
+ * hashed with only two multiplications. The value doesn't depend on the
+ * endianness of the platform
+ * @param buf Buffer, can be NULL only if len is 0
+ * @param len Size of the buffer
+ * @return hash value
+ */
+uint64_t rs_hash_wyhash64(const void *buf, size_t len);
+
+/**
+ * Computes the wyhash of a buffer, i.e. the low 32 bits of
+ * rs_hash_wyhash64()
+ * @param buf Buffer, can be NULL only if len is 0
+ * @param len Size of the buffer
+ * @return hash value
+ */
+uint32_t rs_hash_wyhash(const void *buf, size_t len);
+
+/**
+ * Computes the FNV-1a hash of a buffer, followed by the MurmurHash3 finalizer
+ * @param buf Buffer, can be NULL only if len is 0
+ * @param len Size of the buffer
+ * @return hash value
+ */
+uint32_t rs_hash_fnv1a(const void *buf, size_t len);
+
+/**
+ * Computes the wyhash of an integer
+ * @param value Integer
+ * @return hash value
+ */
+uint32_t rs_hash_u64(uint64_t value);
+
+/**
+ * Computes the wyhash of a string, without it's NUL terminator
+ * @param str String, can't be NULL
+ * @return hash value
+ */
+uint32_t rs_hash_string(const char *str);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* RS_HASH_H_ */
@@ -0,0 +1,166 @@
+/**
+ * @file rs_heap.h
+ * @date 19 oct. 2026
+ * @author nicolas.carrier@parrot.com
+ * @brief Intrusive d-ary min-heap. As with rs_node, the user embeds a node in
+ * their own structure and retrieves it with ut_container_of(). The heap only
+ * allocates an array of pointers to the nodes, which grows as needed, each
+ * node storing it's position in the array, so that it can be removed or
+ * repositioned after a change of it's key in O(log n), without searching for
+ * it. Nodes are ordered by the compare operation of the vtable, which follows
+ * the convention of rs_dll_vtable. The order of nodes comparing equal is
+ * unspecified.
+ * The greater the arity, the shallower the heap, which makes insertions
+ * cheaper and removals more expensive, 4 is a good default.
+ *
+ * Copyright (C) 2026 Parrot S.A.
+ */
+#ifndef RS_HEAP_H_
+#define RS_HEAP_H_
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @def RS_HEAP_DEFAULT_ARITY
+ * @brief Arity used when 0 is passed to rs_heap_init()
+ */
+#define RS_HEAP_DEFAULT_ARITY 4
+
+/**
+ * @struct rs_heap_node
+ * @brief Node of a heap
+ */
+struct rs_heap_node {
+	/** position of the node in the heap's array */
+	size_t index;
+};
+
+/**
+ * @typedef rs_heap_cb
+ * @brief Callback called on each node of a heap
+ * @param node Node
+ * @param data User defined data
+ * @return 0 to continue the iteration, non-zero to stop it
+ */
+typedef int (*rs_heap_cb)(struct rs_heap_node *node, void *data);
+
+/**
+ * @struct rs_heap_vtable
+ * @brief User defined operations on heap nodes
+ */
+struct rs_heap_vtable {
+	/**
+	 * returns an integer less than, equal to, or greater than zero if a is
+	 * found, respectively, to be less than, to match, or be greater than b.
+	 */
+	int (*compare)(struct rs_heap_node *a, const struct rs_heap_node *b);
+};
+
+/**
+ * @struct rs_heap
+ * @brief Intrusive d-ary min-heap
+ */
+struct rs_heap {
+	/** nodes, each one lesser than or equal to it's children */
+	struct rs_heap_node **nodes;
+	/** number of nodes in the heap */
+	size_t count;
+	/** number of slots of the nodes array */
+	size_t capacity;
+	/** maximum number of children of a node */
+	size_t arity;
+	/** user defined operations on heap nodes */
+	struct rs_heap_vtable vtable;
+};
+
+/**
+ * Initializes a heap. When not used anymore, a heap must be cleaned with a
+ * call to rs_heap_clean()
+ * @param heap Heap to initialize
+ * @param arity Maximum number of children of a node, at least 2, 0 for
+ * RS_HEAP_DEFAULT_ARITY
+ * @param size Expected number of nodes, the array grows beyond, 0 for a
+ * default value
+ * @param vtable User defined operations on nodes, compare can't be NULL
+ * @return Negative errno-compatible value on error, 0 on success
+ */
+int rs_heap_init(struct rs_heap *heap, size_t arity, size_t size,
+		const struct rs_heap_vtable *vtable);
+
+/**
+ * Returns the number of nodes of a heap
+ * @param heap Heap
+ * @return number of nodes, 0 if heap is NULL
+ */
+static inline size_t rs_heap_get_count(const struct rs_heap *heap)
+{
+	return NULL == heap ? 0 : heap->count;
+}
+
+/**
+ * Inserts a node in a heap
+ * @param heap Heap
+ * @param node Node to insert, mustn't be in a heap
+ * @return Negative errno-compatible value on error, -EBUSY if the node is
+ * already in this heap, -ENOMEM if the array couldn't grow, 0 on success
+ */
+int rs_heap_insert(struct rs_heap *heap, struct rs_heap_node *node);
+
+/**
+ * Returns the least node of a heap, in constant time
+ * @param heap Heap
+ * @return Least node, NULL if the heap is empty or on error
+ */
+struct rs_heap_node *rs_heap_peek(const struct rs_heap *heap);
+
+/**
+ * Removes and returns the least node of a heap
+ * @param heap Heap
+ * @return Least node, removed, NULL if the heap is empty or on error
+ */
+struct rs_heap_node *rs_heap_pop(struct rs_heap *heap);
+
+/**
+ * Removes a node from a heap. The node can then be freed or inserted again
+ * @param heap Heap the node is in
+ * @param node Node to remove
+ * @return Negative errno-compatible value on error, -ENOENT if the node isn't
+ * in the heap, 0 on success
+ */
+int rs_heap_remove(struct rs_heap *heap, struct rs_heap_node *node);
+
+/**
+ * Restores the position of a node in a heap, after it's key has changed
+ * @param heap Heap the node is in
+ * @param node Node whose key has changed
+ * @return Negative errno-compatible value on error, -ENOENT if the node isn't
+ * in the heap, 0 on success
+ */
+int rs_heap_update(struct rs_heap *heap, struct rs_heap_node *node);
+
+/**
+ * Reinitializes a heap. Removes all the nodes, calling a callback on each one
+ * after it's removal, so that it can be freed, then frees the array
+ * @param heap Heap to clean
+ * @param cb Callback called on each node still in the heap, can be NULL, it's
+ * return value is ignored
+ * @param data User defined data passed to the callback
+ * @return Negative errno-compatible value on error, 0 on success
+ */
+int rs_heap_clean_cb(struct rs_heap *heap, rs_heap_cb cb, void *data);
+
+/**
+ * Reinitializes a heap. Equivalent to rs_heap_clean_cb(heap, NULL, NULL);
+ * @param heap Heap to clean
+ * @return Negative errno-compatible value on error, 0 on success
+ */
+int rs_heap_clean(struct rs_heap *heap);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* RS_HEAP_H_ */
@@ -0,0 +1,180 @@
+/**
+ * @file rs_ihmap.h
+ * @date 19 oct. 2026
+ * @author nicolas.carrier@parrot.com
+ * @brief Intrusive hash map. As with rs_node, the user embeds a node in their
+ * own structure and retrieves it with ut_container_of(), the map never
+ * allocates anything but it's buckets, at initialization. Buckets are chains
+ * of nodes, each node pointing back to the pointer pointing to it, so that a
+ * node is removed in constant time, without searching for it.
+ * The number of buckets is fixed, keys are unique.
+ *
+ * Copyright (C) 2026 Parrot S.A.
+ */
+#ifndef RS_IHMAP_H_
+#define RS_IHMAP_H_
+#include <stddef.h>
+#include <stdint.h>
+
+#include <rs_hash.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @struct rs_ihmap_node
+ * @brief Node of an intrusive hash map, must be zeroed before it's first
+ * insertion
+ */
+struct rs_ihmap_node {
+	/** next node in the bucket */
+	struct rs_ihmap_node *next;
+	/** pointer pointing to this node, NULL if not in a map */
+	struct rs_ihmap_node **pprev;
+	/** hash of the node's key */
+	uint32_t hash;
+};
+
+/**
+ * @typedef rs_ihmap_cb
+ * @brief Callback called on each node of a map
+ * @param node Node, can be removed from the map by the callback
+ * @param data User defined data
+ * @return 0 to continue the iteration, non-zero to stop it
+ */
+typedef int (*rs_ihmap_cb)(struct rs_ihmap_node *node, void *data);
+
+/**
+ * @struct rs_ihmap_vtable
+ * @brief User defined operations on keys, none can be NULL
+ */
+struct rs_ihmap_vtable {
+	/**
+	 * returns the hash of a key, the functions of rs_hash.h can be used
+	 */
+	uint32_t (*hash)(const void *key);
+	/** returns the key of the structure enclosing a node */
+	const void *(*key)(const struct rs_ihmap_node *node);
+	/** returns non-zero if two keys are equal */
+	int (*equals)(const void *a, const void *b);
+};
+
+/**
+ * @struct rs_ihmap
+ * @brief Intrusive hash map
+ */
+struct rs_ihmap {
+	/** chains of nodes, their number is a power of 2 */
+	struct rs_ihmap_node **buckets;
+	/** number of buckets minus 1 */
+	size_t mask;
+	/** number of nodes in the map */
+	size_t count;
+	/** operations on keys */
+	struct rs_ihmap_vtable vtable;
+};
+
+/**
+ * Initializes an intrusive hash map. When not used anymore, a hash map must be
+ * cleaned with a call to rs_ihmap_clean()
+ * @param map Hash map to initialize
+ * @param size Expected number of nodes, the number of buckets is the next
+ * power of 2, 0 for a default value
+ * @param vtable Operations on keys
+ * @return Negative errno-compatible value on error, 0 on success
+ */
+int rs_ihmap_init(struct rs_ihmap *map, size_t size,
+		const struct rs_ihmap_vtable *vtable);
+
+/**
+ * Returns the number of nodes of a hash map
+ * @param map Hash map
+ * @return number of nodes, 0 if map is NULL
+ */
+static inline size_t rs_ihmap_get_count(const struct rs_ihmap *map)
+{
+	return NULL == map ? 0 : map->count;
+}
+
+/**
+ * Inserts a node in a hash map
+ * @param map Hash map
+ * @param node Node to insert
+ * @return Negative errno-compatible value on error, -EBUSY if the node is
+ * already in a map, -EEXIST if a node with the same key is already present, 0
+ * on success
+ */
+int rs_ihmap_insert(struct rs_ihmap *map, struct rs_ihmap_node *node);
+
+/**
+ * Searches for the node matching a key
+ * @param map Hash map
+ * @param key Key
+ * @return Node if found, NULL otherwise or on error
+ */
+struct rs_ihmap_node *rs_ihmap_lookup(const struct rs_ihmap *map,
+		const void *key);
+
+/**
+ * Removes a node from a hash map, in constant time. The node can then be freed
+ * or inserted again
+ * @param map Hash map the node is in
+ * @param node Node to remove
+ * @return Negative errno-compatible value on error, -ENOENT if the node isn't
+ * in a map, 0 on success
+ */
+int rs_ihmap_remove(struct rs_ihmap *map, struct rs_ihmap_node *node);
+
+/**
+ * Returns the first node of a hash map, in no particular order
+ * @param map Hash map
+ * @return First node, NULL if the map is empty or on error
+ */
+struct rs_ihmap_node *rs_ihmap_first(const struct rs_ihmap *map);
+
+/**
+ * Returns the node following another one in a hash map. To remove nodes while
+ * iterating, the following node must be retrieved before the current one is
+ * removed
+ * @param map Hash map
+ * @param node Current node, in the map
+ * @return Next node, NULL if node was the last one or on error
+ */
+struct rs_ihmap_node *rs_ihmap_next(const struct rs_ihmap *map,
+		const struct rs_ihmap_node *node);
+
+/**
+ * Calls a callback on each node of a hash map, the callback being allowed to
+ * remove the node it is called on
+ * @param map Hash map
+ * @param cb Callback
+ * @param data User defined data passed to the callback
+ * @return Negative errno-compatible value on error, otherwise the non-zero
+ * value returned by the callback which stopped the iteration, or 0
+ */
+int rs_ihmap_foreach(struct rs_ihmap *map, rs_ihmap_cb cb, void *data);
+
+/**
+ * Reinitializes a hash map. Removes all the nodes, calling a callback on each
+ * one after it's removal, so that it can be freed, then frees the buckets
+ * @param map Hash map to clean
+ * @param cb Callback called on each node still in the map, can be NULL, it's
+ * return value is ignored
+ * @param data User defined data passed to the callback
+ * @return Negative errno-compatible value on error, 0 on success
+ */
+int rs_ihmap_clean_cb(struct rs_ihmap *map, rs_ihmap_cb cb, void *data);
+
+/**
+ * Reinitializes a hash map. Equivalent to rs_ihmap_clean_cb(map, NULL, NULL);
+ * @param map Hash map to clean
+ * @return Negative errno-compatible value on error, 0 on success
+ */
+int rs_ihmap_clean(struct rs_ihmap *map);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* RS_IHMAP_H_ */
@@ -0,0 +1,285 @@
+/**
+ * @file rs_ohmap.h
+ * @date 19 oct. 2026
+ * @author nicolas.carrier@parrot.com
+ * @brief Hash map with open addressing, Robin Hood hashing and incremental
+ * growth. Where rs_hmap has a fixed number of buckets, chaining entries
+ * allocated one by one, rs_ohmap stores it's entries in a flat array of slots,
+ * each with the hash of it's key, which is doubled when it is 7/8th full.
+ * The entries are moved to the new array a few at a time, by the following
+ * insertions and removals, so that no operation stalls on a rehash, lookups
+ * search both arrays meanwhile.
+ * Contrary to rs_hmap, keys are unique and aren't limited to strings, a map
+ * can be keyed by 64 bits integers or by arbitrary byte strings, copied or
+ * not, with a hash function chosen at initialization.
+ *
+ * Copyright (C) 2026 Parrot S.A.
+ */
+#ifndef RS_OHMAP_H_
+#define RS_OHMAP_H_
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @enum rs_ohmap_key_type
+ * @brief Type of the keys of a hash map
+ */
+enum rs_ohmap_key_type {
+	/** NUL-terminated non-empty strings, the default */
+	RS_OHMAP_KEY_STRING = 0,
+	/** arbitrary non-empty byte strings, passed as pointer and length */
+	RS_OHMAP_KEY_BYTES,
+	/** 64 bits unsigned integers, stored in the slots */
+	RS_OHMAP_KEY_U64,
+};
+
+/**
+ * @enum rs_ohmap_hash
+ * @brief Hash function of a hash map
+ */
+enum rs_ohmap_hash {
+	/** wyhash, fast on keys of any length, the default */
+	RS_OHMAP_HASH_WYHASH = 0,
+	/** FNV-1a, followed by the MurmurHash3 finalizer */
+	RS_OHMAP_HASH_FNV1A,
+};
+
+/**
+ * @struct rs_ohmap_keys
+ * @brief Configuration of the keys of a hash map
+ */
+struct rs_ohmap_keys {
+	/** type of the keys */
+	enum rs_ohmap_key_type type;
+	/** hash function used */
+	enum rs_ohmap_hash hash;
+	/**
+	 * if true, string and byte keys aren't copied, the caller must keep
+	 * them unchanged and valid until their entry is removed
+	 */
+	bool borrowed;
+};
+
+/**
+ * @union rs_ohmap_key
+ * @brief Key stored in a slot, internal
+ */
+union rs_ohmap_key {
+	/** string or byte key, either a copy owned by the map, or borrowed */
+	const void *ptr;
+	/** integer key */
+	uint64_t u64;
+};
+
+/**
+ * @struct rs_ohmap_slot
+ * @brief Slot of a hash map table, internal
+ */
+struct rs_ohmap_slot {
+	/** hash of the key */
+	uint32_t hash;
+	/** distance to the slot the hash points to, plus one, 0 if empty */
+	uint32_t dib;
+	/** key */
+	union rs_ohmap_key key;
+	/** length of the key, in bytes, without the NUL terminator of strings */
+	size_t len;
+	/** data associated to the key */
+	void *data;
+};
+
+/**
+ * @struct rs_ohmap_table
+ * @brief Array of slots, internal
+ */
+struct rs_ohmap_table {
+	/** slots, their number is a power of 2 */
+	struct rs_ohmap_slot *slots;
+	/** number of slots minus 1 */
+	size_t mask;
+	/** number of slots used */
+	size_t count;
+};
+
+/**
+ * @struct rs_ohmap
+ * @brief Hash map structure
+ */
+struct rs_ohmap {
+	/** table the entries are inserted in */
+	struct rs_ohmap_table table;
+	/** previous table, being migrated to the current one, if any */
+	struct rs_ohmap_table old;
+	/** next slot of the previous table to migrate */
+	size_t migrated;
+	/** configuration of the keys */
+	struct rs_ohmap_keys keys;
+};
+
+/**
+ * Initializes a hash map with string keys, copied in the map. When not used
+ * anymore, a hash map must be cleaned with a call to rs_ohmap_clean()
+ * @param map Hash map to initialize
+ * @param size Number of entries the hash map must be able to store before it's
+ * first growth, 0 for a default value
+ * @return Negative errno-compatible value on error, 0 on success
+ */
+int rs_ohmap_init(struct rs_ohmap *map, size_t size);
+
+/**
+ * Initializes a hash map with a given type of keys. Only the functions
+ * matching this type can then be used for lookup, insertion and removal, the
+ * others fail with -EINVAL. When not used anymore, a hash map must be cleaned
+ * with a call to rs_ohmap_clean()
+ * @param map Hash map to initialize
+ * @param size Number of entries the hash map must be able to store before it's
+ * first growth, 0 for a default value
+ * @param keys Configuration of the keys, NULL for copied string keys hashed
+ * with the default function, as with rs_ohmap_init()
+ * @return Negative errno-compatible value on error, 0 on success
+ */
+int rs_ohmap_init_keys(struct rs_ohmap *map, size_t size,
+		const struct rs_ohmap_keys *keys);
+
+/**
+ * Returns the number of entries of a hash map
+ * @param map Hash map
+ * @return number of entries, 0 if map is NULL
+ */
+static inline size_t rs_ohmap_get_count(const struct rs_ohmap *map)
+{
+	return NULL == map ? 0 : map->table.count + map->old.count;
+}
+
+/**
+ * Lookup an entry in hash map
+ * @param map Hash map
+ * @param key String key
+ * @param data In output, a pointer to a matching data, or to NULL if no entry
+ * was found. can't be NULL
+ * @return Negative errno-compatible value on error, 0 on success. -ENOENT if
+ * the entry wasn't found
+ */
+int rs_ohmap_lookup(struct rs_ohmap *map, const char *key, void **data);
+
+/**
+ * Insert an entry in hash map, the key is copied unless the keys are borrowed
+ * @param map Hash map
+ * @param key String key
+ * @param data Piece of data to associate with the key. Can be NULL
+ * @return Negative errno-compatible value on error, -EEXIST if the key is
+ * already present, 0 on success
+ */
+int rs_ohmap_insert(struct rs_ohmap *map, const char *key, void *data);
+
+/**
+ * Remove an entry from hash map and retrieve associated data
+ * @param map Hash map
+ * @param key String key
+ * @param data In output, a pointer to a matching data, or NULL if no entry was
+ * found. Can be NULL
+ * @return Negative errno-compatible value on error, 0 on success. -ENOENT if
+ * the entry wasn't found
+ */
+int rs_ohmap_remove(struct rs_ohmap *map, const char *key, void **data);
+
+/**
+ * Lookup an entry in a hash map with byte keys
+ * @param map Hash map
+ * @param key Byte key
+ * @param len Length of the key, can't be 0
+ * @param data In output, a pointer to a matching data, or to NULL if no entry
+ * was found. can't be NULL
+ * @return Negative errno-compatible value on error, 0 on success. -ENOENT if
+ * the entry wasn't found
+ */
+int rs_ohmap_lookup_bytes(struct rs_ohmap *map, const void *key, size_t len,
+		void **data);
+
+/**
+ * Insert an entry in a hash map with byte keys, the key is copied unless the
+ * keys are borrowed
+ * @param map Hash map
+ * @param key Byte key
+ * @param len Length of the key, can't be 0
+ * @param data Piece of data to associate with the key. Can be NULL
+ * @return Negative errno-compatible value on error, -EEXIST if the key is
+ * already present, 0 on success
+ */
+int rs_ohmap_insert_bytes(struct rs_ohmap *map, const void *key, size_t len,
+		void *data);
+
+/**
+ * Remove an entry from a hash map with byte keys and retrieve associated data
+ * @param map Hash map
+ * @param key Byte key
+ * @param len Length of the key, can't be 0
+ * @param data In output, a pointer to a matching data, or NULL if no entry was
+ * found. Can be NULL
+ * @return Negative errno-compatible value on error, 0 on success. -ENOENT if
+ * the entry wasn't found
+ */
+int rs_ohmap_remove_bytes(struct rs_ohmap *map, const void *key, size_t len,
+		void **data);
+
+/**
+ * Lookup an entry in a hash map with integer keys
+ * @param map Hash map
+ * @param key Integer key
+ * @param data In output, a pointer to a matching data, or to NULL if no entry
+ * was found. can't be NULL
+ * @return Negative errno-compatible value on error, 0 on success. -ENOENT if
+ * the entry wasn't found
+ */
+int rs_ohmap_lookup_u64(struct rs_ohmap *map, uint64_t key, void **data);
+
+/**
+ * Insert an entry in a hash map with integer keys
+ * @param map Hash map
+ * @param key Integer key
+ * @param data Piece of data to associate with the key. Can be NULL
+ * @return Negative errno-compatible value on error, -EEXIST if the key is
+ * already present, 0 on success
+ */
+int rs_ohmap_insert_u64(struct rs_ohmap *map, uint64_t key, void *data);
+
+/**
+ * Remove an entry from a hash map with integer keys and retrieve associated
+ * data
+ * @param map Hash map
+ * @param key Integer key
+ * @param data In output, a pointer to a matching data, or NULL if no entry was
+ * found. Can be NULL
+ * @return Negative errno-compatible value on error, 0 on success. -ENOENT if
+ * the entry wasn't found
+ */
+int rs_ohmap_remove_u64(struct rs_ohmap *map, uint64_t key, void **data);
+
+/**
+ * Reinitializes a hash map. Releases internally used resources and allows the
+ * user to free the resources allocated, still referenced in the map
+ * @param map Hash map to clean
+ * @param free_cb callback called on each value still stored in the map, can be
+ * NULL
+ * @return Negative errno-compatible value on error, 0 on success
+ */
+int rs_ohmap_clean_cb(struct rs_ohmap *map, void (*free_cb)(void *));
+
+/**
+ * Reinitializes a hash map. Releases internally used resources. Equivalent to
+ * rs_ohmap_clean_cb(map, NULL);
+ * @param map Hash map to clean
+ * @return Negative errno-compatible value on error, 0 on success
+ */
+int rs_ohmap_clean(struct rs_ohmap *map);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* RS_OHMAP_H_ */
@@ -19,7 +19,11 @@
 extern "C" {
 #endif
 
+#include <sys/types.h>
+#include <sys/uio.h>
+
 #include <stdbool.h>
+#include <stddef.h>
 
 /**
  * @struct rs_rb
@@ -33,8 +37,38 @@ struct rs_rb {
 	size_t read;		/** read offset */
 	size_t write;		/** write offset */
 	bool mirror;		/** memory mirrored, plus base must be freed */
+	int fd;			/** memfd backing a shared mirrored buffer */
 };
 
+/**
+ * @def RS_RB_THP
+ * @brief Asks for transparent huge pages to back a mirrored buffer, only a
+ * hint, honored if the kernel allows it for shared memory, see shmem_enabled
+ * in /sys/kernel/mm/transparent_hugepage
+ */
+#define RS_RB_THP (1 << 0)
+
+/**
+ * @def RS_RB_HUGETLB
+ * @brief Backs a mirrored buffer with huge pages of the default size, taken
+ * from the pool reserved by the administrator, the size of the buffer is
+ * rounded to a multiple of it
+ */
+#define RS_RB_HUGETLB (1 << 1)
+
+/**
+ * @def RS_RB_SHARED
+ * @brief Keeps the memfd backing a mirrored buffer open, so that it can be
+ * passed to another process, see rs_rb_get_fd()
+ */
+#define RS_RB_SHARED (1 << 2)
+
+/**
+ * @def RS_RB_FLAGS
+ * @brief All the flags accepted by rs_rb_init_mirrored()
+ */
+#define RS_RB_FLAGS (RS_RB_THP | RS_RB_HUGETLB | RS_RB_SHARED)
+
 /**
  * Initializes a ring buffer, with a buffer and it's size.
  * @param rb Ring buffer to initialize
@@ -48,9 +82,60 @@ struct rs_rb {
  * must be still be a power of two, so in systems where it is not the case,
  * the buffer parameter can't be NULL.
  * @return -1 on error, 0 otherwise
+ * @note a NULL buffer is equivalent to rs_rb_init_mirrored() without flags
  */
 int rs_rb_init(struct rs_rb *rb, void *buffer, size_t size);
 
+/**
+ * Initializes a ring buffer, allocating a memfd of the given size and mapping
+ * it twice in consecutive locations, so that read and write operations will
+ * not have to care about wrapping.
+ * @param rb Ring buffer to initialize
+ * @param size Size of the buffer, rounded to the next multiple of the size of
+ * the pages backing it, must then be a power of two
+ * @param flags Bitwise or of RS_RB_THP, RS_RB_HUGETLB and RS_RB_SHARED
+ * @return negative errno-compatible value on error, 0 otherwise
+ */
+int rs_rb_init_mirrored(struct rs_rb *rb, size_t size, unsigned flags);
+
+/**
+ * Initializes a ring buffer, mirroring the memfd of a ring buffer created with
+ * RS_RB_SHARED, possibly by another process. Both ring buffers share the
+ * content of the buffer, but not their read and write offsets, which the
+ * processes have to exchange by other means.
+ * @param rb Ring buffer to initialize
+ * @param fd Memfd, whose size is the size of the ring buffer, sealed with
+ * F_SEAL_SHRINK. The ring buffer doesn't take it's ownership, the caller can
+ * close it once this function returns
+ * @return negative errno-compatible value on error, -EPERM if the memfd isn't
+ * sealed against shrinking, 0 otherwise
+ */
+int rs_rb_init_from_fd(struct rs_rb *rb, int fd);
+
+/**
+ * Initializes a ring buffer, mirroring a part of a file, e.g. of a memfd also
+ * holding other data shared between processes
+ * @param rb Ring buffer to initialize
+ * @param fd File, not owned by the ring buffer, sealed with F_SEAL_SHRINK,
+ * thus a memfd
+ * @param offset Offset of the buffer in the file, must be a multiple of the
+ * size of the pages backing it
+ * @param size Size of the buffer, a power of two, multiple of the size of the
+ * pages backing it
+ * @return negative errno-compatible value on error, -EPERM if the file isn't
+ * sealed against shrinking, 0 otherwise
+ */
+int rs_rb_init_from_fd_at(struct rs_rb *rb, int fd, off_t offset, size_t size);
+
+/**
+ * Returns the memfd backing a ring buffer created with RS_RB_SHARED, which is
+ * closed by rs_rb_clean()
+ * @param rb Ring buffer
+ * @return memfd on success, -EBADF if the ring buffer has no memfd kept open,
+ * -EINVAL if rb is NULL
+ */
+int rs_rb_get_fd(const struct rs_rb *rb);
+
 /**
  * Get the ring buffer size. i.e. the total number of bytes the buffer can
  * contain
@@ -117,6 +202,62 @@ int rs_rb_read_incr(struct rs_rb *rb, size_t length);
  */
 int rs_rb_read_at(struct rs_rb *rb, size_t offset, char *value);
 
+/**
+ * Describes the data available to read with iovecs, e.g. for writev()
+ * @param rb Ring buffer
+ * @param iov In output, one iovec if the data doesn't wrap or if the buffer is
+ * mirrored, two otherwise. Only those returned are filled
+ * @return Number of iovecs filled, 0 if the buffer is empty, negative
+ * errno-compatible value on error
+ */
+int rs_rb_get_read_iovec(struct rs_rb *rb, struct iovec iov[2]);
+
+/**
+ * Copies data from the ring buffer, without consuming it, all or nothing
+ * @param rb Ring buffer
+ * @param offset Offset of the data from the read position
+ * @param buf Buffer receiving the data
+ * @param length Number of bytes to copy
+ * @return non-zero negative errno-compatible value on error, -ENOSR if less
+ * than offset + length bytes are stored, 0 otherwise
+ */
+int rs_rb_peek(struct rs_rb *rb, size_t offset, void *buf, size_t length);
+
+/**
+ * Copies data from the ring buffer and consumes it, all or nothing
+ * @param rb Ring buffer
+ * @param buf Buffer receiving the data
+ * @param length Number of bytes to read
+ * @return non-zero negative errno-compatible value on error, -ENOSR if less
+ * than length bytes are stored, 0 otherwise
+ */
+int rs_rb_copy_out(struct rs_rb *rb, void *buf, size_t length);
+
+/**
+ * Searches the data stored for a string of bytes, with memchr() or memmem(),
+ * including the occurrences which wrap at the end of the buffer
+ * @param rb Ring buffer
+ * @param offset Offset from the read position where the search starts
+ * @param needle Bytes to search for
+ * @param needle_len Length of needle, non-zero
+ * @param position In output, offset of the first occurrence found from the
+ * read position
+ * @return non-zero negative errno-compatible value on error, -ENOENT if needle
+ * wasn't found, 0 otherwise
+ */
+int rs_rb_search(struct rs_rb *rb, size_t offset, const void *needle,
+		size_t needle_len, size_t *position);
+
+/**
+ * Writes the data stored to a file descriptor, with one writev() call, and
+ * consumes what was written
+ * @param rb Ring buffer
+ * @param fd File descriptor
+ * @return Number of bytes written, 0 if the buffer is empty, negative
+ * errno-compatible value on error
+ */
+ssize_t rs_rb_write_to_fd(struct rs_rb *rb, int fd);
+
 /* * ring buffer write functions * */
 
 /**
@@ -154,6 +295,36 @@ size_t rs_rb_get_write_length_no_wrap(struct rs_rb *rb);
  */
 int rs_rb_write_incr(struct rs_rb *rb, size_t length);
 
+/**
+ * Describes the room available to write with iovecs, e.g. for readv()
+ * @param rb Ring buffer
+ * @param iov In output, one iovec if the room doesn't wrap or if the buffer is
+ * mirrored, two otherwise. Only those returned are filled
+ * @return Number of iovecs filled, 0 if the buffer is full, negative
+ * errno-compatible value on error
+ */
+int rs_rb_get_write_iovec(struct rs_rb *rb, struct iovec iov[2]);
+
+/**
+ * Copies data into the ring buffer, all or nothing
+ * @param rb Ring buffer
+ * @param buf Data to write
+ * @param length Number of bytes to write
+ * @return non-zero negative errno-compatible value on error, -ENOBUFS if there
+ * is less than length bytes of room, 0 otherwise
+ */
+int rs_rb_copy_in(struct rs_rb *rb, const void *buf, size_t length);
+
+/**
+ * Reads from a file descriptor into the ring buffer, with one readv() call
+ * filling all the room available
+ * @param rb Ring buffer
+ * @param fd File descriptor
+ * @return Number of bytes read, 0 on end of file, negative errno-compatible
+ * value on error, -ENOBUFS if the buffer is full
+ */
+ssize_t rs_rb_read_from_fd(struct rs_rb *rb, int fd);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,168 @@
+/**
+ * @file rs_rb_spsc.h
+ * @date 19 oct. 2026
+ * @author nicolas.carrier@parrot.com
+ * @brief Single producer, single consumer ring buffer, to hand data from one
+ * thread to another without locks. The read and write indices are each
+ * written by only one side and published to the other one with a release
+ * store, there is no shared length. They run freely, the length being their
+ * difference, and live on separate cache lines, not to bounce between the
+ * cores of the two threads.
+ * The buffer is allocated and mirrored as by rs_rb_init(), so that both sides
+ * always get contiguous spans.
+ * The read functions can only be called by the consumer thread, the write
+ * functions by the producer thread, any of the two can call
+ * rs_rb_spsc_get_size(). The others require no thread to be using the ring
+ * buffer.
+ *
+ * Copyright (C) 2026 Parrot S.A.
+ */
+#ifndef RS_RB_SPSC_H_
+#define RS_RB_SPSC_H_
+#include <stddef.h>
+
+#include <rs_rb.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @struct rs_rb_spsc
+ * @brief SPSC ring buffer
+ */
+struct rs_rb_spsc {
+	/** buffer, it's indices and length are unused */
+	struct rs_rb rb;
+	/** read index, written by the consumer */
+	size_t read __attribute__((aligned(64)));
+	/** value of the write index last seen by the consumer */
+	size_t write_cache;
+	/** write index, written by the producer */
+	size_t write __attribute__((aligned(64)));
+	/** value of the read index last seen by the producer */
+	size_t read_cache;
+} __attribute__((aligned(64)));
+
+/**
+ * Initializes a SPSC ring buffer, see rs_rb_init()
+ * @param spsc Ring buffer to initialize
+ * @param buffer Buffer used by the ring buffer, NULL for a mirrored buffer
+ * allocated by the ring buffer
+ * @param size Size of the buffer, see rs_rb_init()
+ * @return Negative errno-compatible value on error, 0 otherwise
+ */
+int rs_rb_spsc_init(struct rs_rb_spsc *spsc, void *buffer, size_t size);
+
+/**
+ * Get the ring buffer size, i.e. the total number of bytes the buffer can
+ * contain
+ * @param spsc Ring buffer
+ * @return The ring buffer size
+ */
+size_t rs_rb_spsc_get_size(const struct rs_rb_spsc *spsc);
+
+/**
+ * Releases the resources of a ring buffer
+ * @param spsc Ring buffer
+ * @return Negative errno-compatible value on error, 0 otherwise
+ */
+int rs_rb_spsc_clean(struct rs_rb_spsc *spsc);
+
+/* * consumer side * */
+
+/**
+ * Get ring buffer read ptr, i.e. where data can be consumed from
+ * @param spsc Ring buffer
+ * @return place in the buffer, where data can be read from, NULL on error
+ * @note not more than the return of rs_rb_spsc_get_read_length_no_wrap() must
+ * be read from here.
+ */
+void *rs_rb_spsc_get_read_ptr(struct rs_rb_spsc *spsc);
+
+/**
+ * Get the number of bytes the producer has published, available to read
+ * @param spsc Ring buffer
+ * @return Data available to read from the buffer, 0 if none, or on error
+ */
+size_t rs_rb_spsc_get_read_length(struct rs_rb_spsc *spsc);
+
+/**
+ * Get the number of bytes available to read without wrapping, which is all
+ * of them if the buffer is mirrored
+ * @param spsc Ring buffer
+ * @return Size which can be read from the buffer in a consecutive manner
+ */
+size_t rs_rb_spsc_get_read_length_no_wrap(struct rs_rb_spsc *spsc);
+
+/**
+ * Increment read pointer, giving the space back to the producer
+ * @param spsc Ring buffer
+ * @param length Amount of data consumed
+ * @return non-zero negative errno-compatible value on error, 0 otherwise
+ */
+int rs_rb_spsc_read_incr(struct rs_rb_spsc *spsc, size_t length);
+
+/**
+ * Copies data out of the ring buffer, all or nothing. Only looks at the
+ * producer's index when the data already known to be available isn't enough
+ * @param spsc Ring buffer
+ * @param buf Buffer receiving the data
+ * @param length Number of bytes to read
+ * @return non-zero negative errno-compatible value on error, -EAGAIN if less
+ * than length bytes are available, 0 otherwise
+ */
+int rs_rb_spsc_read(struct rs_rb_spsc *spsc, void *buf, size_t length);
+
+/* * producer side * */
+
+/**
+ * Get ring buffer write ptr, i.e. where data can be produced to
+ * @param spsc Ring buffer
+ * @return place in the buffer, where data can be written to, NULL on error
+ * @note not more than the return of rs_rb_spsc_get_write_length_no_wrap()
+ * must be written here.
+ */
+void *rs_rb_spsc_get_write_ptr(struct rs_rb_spsc *spsc);
+
+/**
+ * Get the room the consumer has freed, available to write
+ * @param spsc Ring buffer
+ * @return Number of bytes which can be stored into the ring buffer, 0 on error
+ */
+size_t rs_rb_spsc_get_write_length(struct rs_rb_spsc *spsc);
+
+/**
+ * Get the room available to write without wrapping, which is all of it if the
+ * buffer is mirrored
+ * @param spsc Ring buffer
+ * @return Amount of data which can be written linearly in one chunk. 0 on
+ * error
+ */
+size_t rs_rb_spsc_get_write_length_no_wrap(struct rs_rb_spsc *spsc);
+
+/**
+ * Increment write pointer, publishing the data written to the consumer
+ * @param spsc Ring buffer
+ * @param length Amount of data written
+ * @return non-zero negative errno-compatible value on error, 0 otherwise
+ */
+int rs_rb_spsc_write_incr(struct rs_rb_spsc *spsc, size_t length);
+
+/**
+ * Copies data into the ring buffer and publishes it, all or nothing. Only
+ * looks at the consumer's index when the room already known to be free isn't
+ * enough
+ * @param spsc Ring buffer
+ * @param buf Data to write
+ * @param length Number of bytes to write
+ * @return non-zero negative errno-compatible value on error, -EAGAIN if there
+ * is less than length bytes of room, 0 otherwise
+ */
+int rs_rb_spsc_write(struct rs_rb_spsc *spsc, const void *buf, size_t length);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* RS_RB_SPSC_H_ */
@@ -0,0 +1,187 @@
+/**
+ * @file rs_rbtree.h
+ * @date 19 oct. 2026
+ * @author nicolas.carrier@parrot.com
+ * @brief Intrusive red-black tree. As with rs_node, the user embeds a node in
+ * their own structure and retrieves it with ut_container_of(), the tree never
+ * allocates anything. Nodes are kept sorted by the compare operation of the
+ * vtable, which follows the convention of rs_dll_vtable, insertion, removal
+ * and search are performed in O(log n).
+ * Nodes comparing equal are allowed, they are kept in their insertion order,
+ * as rs_dll_insert_sorted() does.
+ *
+ * Copyright (C) 2026 Parrot S.A.
+ */
+#ifndef RS_RBTREE_H_
+#define RS_RBTREE_H_
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @struct rs_rbtree_node
+ * @brief Node of a red-black tree
+ */
+struct rs_rbtree_node {
+	/** parent node, NULL for the root */
+	struct rs_rbtree_node *parent;
+	/** left subtree, lesser than or equal to the node */
+	struct rs_rbtree_node *left;
+	/** right subtree, greater than or equal to the node */
+	struct rs_rbtree_node *right;
+	/** non-zero if the node is red, 0 if it is black */
+	int red;
+};
+
+/**
+ * @typedef rs_rbtree_cb
+ * @brief Callback called on each node of a tree
+ * @param node Node
+ * @param data User defined data
+ * @return 0 to continue the iteration, non-zero to stop it
+ */
+typedef int (*rs_rbtree_cb)(struct rs_rbtree_node *node, void *data);
+
+/**
+ * @struct rs_rbtree_vtable
+ * @brief User defined operations on tree nodes
+ */
+struct rs_rbtree_vtable {
+	/**
+	 * returns an integer less than, equal to, or greater than zero if a is
+	 * found, respectively, to be less than, to match, or be greater than b.
+	 */
+	int (*compare)(struct rs_rbtree_node *a,
+			const struct rs_rbtree_node *b);
+};
+
+/**
+ * @struct rs_rbtree
+ * @brief Intrusive red-black tree
+ */
+struct rs_rbtree {
+	/** root node, NULL if the tree is empty */
+	struct rs_rbtree_node *root;
+	/** number of nodes in the tree */
+	size_t count;
+	/** user defined operations on tree nodes */
+	struct rs_rbtree_vtable vtable;
+};
+
+/**
+ * Initializes a red-black tree
+ * @param tree Tree to initialize
+ * @param vtable User defined operations on nodes, compare can't be NULL
+ * @return Negative errno-compatible value on error, 0 on success
+ */
+int rs_rbtree_init(struct rs_rbtree *tree,
+		const struct rs_rbtree_vtable *vtable);
+
+/**
+ * Returns the number of nodes of a tree
+ * @param tree Red-black tree
+ * @return number of nodes, 0 if tree is NULL
+ */
+static inline size_t rs_rbtree_get_count(const struct rs_rbtree *tree)
+{
+	return NULL == tree ? 0 : tree->count;
+}
+
+/**
+ * Inserts a node in a tree, after the nodes comparing equal to it
+ * @param tree Red-black tree
+ * @param node Node to insert, mustn't be in a tree
+ * @return Negative errno-compatible value on error, 0 on success
+ */
+int rs_rbtree_insert(struct rs_rbtree *tree, struct rs_rbtree_node *node);
+
+/**
+ * Removes a node from a tree. The node can then be freed or inserted again
+ * @param tree Red-black tree the node is in
+ * @param node Node to remove
+ * @return Negative errno-compatible value on error, 0 on success
+ */
+int rs_rbtree_remove(struct rs_rbtree *tree, struct rs_rbtree_node *node);
+
+/**
+ * Searches for the first node comparing equal to a key
+ * @param tree Red-black tree
+ * @param key Node embedded in a structure holding the key to search for,
+ * passed as the second argument of the compare operation
+ * @return Node if found, NULL otherwise or on error
+ */
+struct rs_rbtree_node *rs_rbtree_find(const struct rs_rbtree *tree,
+		const struct rs_rbtree_node *key);
+
+/**
+ * Searches for the first node not lesser than a key
+ * @param tree Red-black tree
+ * @param key Node embedded in a structure holding the key to search for,
+ * passed as the second argument of the compare operation
+ * @return Node if found, NULL if all the nodes are lesser or on error
+ */
+struct rs_rbtree_node *rs_rbtree_lower_bound(const struct rs_rbtree *tree,
+		const struct rs_rbtree_node *key);
+
+/**
+ * Returns the least node of a tree
+ * @param tree Red-black tree
+ * @return First node, NULL if the tree is empty or on error
+ */
+struct rs_rbtree_node *rs_rbtree_first(const struct rs_rbtree *tree);
+
+/**
+ * Returns the greatest node of a tree
+ * @param tree Red-black tree
+ * @return Last node, NULL if the tree is empty or on error
+ */
+struct rs_rbtree_node *rs_rbtree_last(const struct rs_rbtree *tree);
+
+/**
+ * Returns the node following another one in a tree, in amortized constant
+ * time. To remove nodes while iterating, the following node must be retrieved
+ * before the current one is removed
+ * @param node Current node, in a tree
+ * @return Next node, NULL if node was the last one or on error
+ */
+struct rs_rbtree_node *rs_rbtree_next(const struct rs_rbtree_node *node);
+
+/**
+ * Returns the node preceding another one in a tree
+ * @param node Current node, in a tree
+ * @return Previous node, NULL if node was the first one or on error
+ */
+struct rs_rbtree_node *rs_rbtree_prev(const struct rs_rbtree_node *node);
+
+/**
+ * Removes and returns the least node of a tree
+ * @param tree Red-black tree
+ * @return First node, removed, NULL if the tree is empty or on error
+ */
+struct rs_rbtree_node *rs_rbtree_pop(struct rs_rbtree *tree);
+
+/**
+ * Reinitializes a tree. Removes all the nodes, in linear time, calling a
+ * callback on each one after it's removal, so that it can be freed
+ * @param tree Red-black tree to clean
+ * @param cb Callback called on each node still in the tree, can be NULL, it's
+ * return value is ignored
+ * @param data User defined data passed to the callback
+ * @return Negative errno-compatible value on error, 0 on success
+ */
+int rs_rbtree_clean_cb(struct rs_rbtree *tree, rs_rbtree_cb cb, void *data);
+
+/**
+ * Reinitializes a tree. Equivalent to rs_rbtree_clean_cb(tree, NULL, NULL);
+ * @param tree Red-black tree to clean
+ * @return Negative errno-compatible value on error, 0 on success
+ */
+int rs_rbtree_clean(struct rs_rbtree *tree);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* RS_RBTREE_H_ */
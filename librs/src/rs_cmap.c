@@ -0,0 +1,385 @@
+/**
+ * @file rs_cmap.c
+ * @date 19 oct. 2026
+ * @author nicolas.carrier@parrot.com
+ * @brief Concurrent hash map implementation.
+ *
+ * Readers count themselves in the counter of the current epoch's parity,
+ * before reading the buckets, writers publish with release stores what
+ * readers load with acquire loads. To free retired entries, the epoch is
+ * changed and the counters of the previous parity are waited for to drop to
+ * zero, twice, as a reader can have read the epoch before the first change,
+ * but incremented it's counter after the wait, this reader is then waited
+ * for by the second change.
+ *
+ * Copyright (C) 2026 Parrot S.A.
+ */
+#include <sched.h>
+
+#include <string.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <errno.h>
+
+#include <ut_string.h>
+
+#include "rs_hash.h"
+#include "rs_cmap.h"
+
+/* number of buckets of the smallest map */
+#define MIN_BUCKETS 8
+
+/* number of retired entries triggering their reclamation */
+#define RECLAIM_THRESHOLD 64
+
+/* last reader slot attributed to a thread */
+static unsigned last_reader_slot;
+
+/* reader slot of the current thread, plus one, 0 if not attributed yet */
+static __thread unsigned reader_slot;
+
+/**
+ * Returns the counters of the current thread, the threads are spread over the
+ * slots in a round robin fashion
+ * @param map Hash map
+ * @return Reader slot
+ */
+static struct rs_cmap_reader_slot *get_reader_slot(struct rs_cmap *map)
+{
+	if (reader_slot == 0)
+		reader_slot = __atomic_add_fetch(&last_reader_slot, 1,
+				__ATOMIC_RELAXED);
+
+	return map->readers + ((reader_slot - 1) &
+			(RS_CMAP_NB_READER_SLOTS - 1));
+}
+
+/**
+ * Enters a read-side critical section, entries can't be freed until it ends
+ * @param map Hash map
+ * @param slot Reader slot of the current thread
+ * @return Parity of the epoch the reader is counted in
+ */
+static unsigned read_lock(struct rs_cmap *map, struct rs_cmap_reader_slot *slot)
+{
+	unsigned idx;
+
+	idx = __atomic_load_n(&map->epoch, __ATOMIC_SEQ_CST) & 1;
+	/* full barrier, the buckets are read after the counter is visible */
+	__atomic_add_fetch(&slot->count[idx], 1, __ATOMIC_SEQ_CST);
+
+	return idx;
+}
+
+/**
+ * Leaves a read-side critical section
+ * @param slot Reader slot of the current thread
+ * @param idx Value returned by read_lock()
+ */
+static void read_unlock(struct rs_cmap_reader_slot *slot, unsigned idx)
+{
+	__atomic_sub_fetch(&slot->count[idx], 1, __ATOMIC_SEQ_CST);
+}
+
+/**
+ * Sums the counters of readers of an epoch's parity
+ * @param map Hash map
+ * @param idx Parity
+ * @return Number of readers
+ */
+static unsigned long nb_readers(struct rs_cmap *map, unsigned idx)
+{
+	unsigned i;
+	unsigned long sum = 0;
+
+	for (i = 0; i < RS_CMAP_NB_READER_SLOTS; i++)
+		sum += __atomic_load_n(&map->readers[i].count[idx],
+				__ATOMIC_SEQ_CST);
+
+	return sum;
+}
+
+/**
+ * Waits for all the read-side critical sections in progress to complete,
+ * retired_mutex must be held
+ * @param map Hash map
+ */
+static void wait_readers(struct rs_cmap *map)
+{
+	int i;
+	unsigned idx;
+
+	for (i = 0; i < 2; i++) {
+		idx = __atomic_fetch_add(&map->epoch, 1, __ATOMIC_SEQ_CST) & 1;
+		while (nb_readers(map, idx) != 0)
+			sched_yield();
+	}
+}
+
+/**
+ * Frees the retired entries, retired_mutex must be held
+ * @param map Hash map
+ */
+static void free_retired(struct rs_cmap *map)
+{
+	struct rs_cmap_entry *entry;
+	struct rs_cmap_entry *next;
+
+	for (entry = map->retired; entry != NULL; entry = next) {
+		next = entry->next_retired;
+		free(entry);
+	}
+	map->retired = NULL;
+	map->nb_retired = 0;
+}
+
+/**
+ * Frees the retired entries, once no reader can see them anymore,
+ * retired_mutex must be held
+ * @param map Hash map
+ */
+static void reclaim(struct rs_cmap *map)
+{
+	if (map->retired == NULL)
+		return;
+
+	wait_readers(map);
+	free_retired(map);
+}
+
+/**
+ * Queues an entry removed from it's bucket, for it to be freed once no reader
+ * can see it anymore
+ * @param map Hash map
+ * @param entry Entry removed
+ */
+static void retire(struct rs_cmap *map, struct rs_cmap_entry *entry)
+{
+	pthread_mutex_lock(&map->retired_mutex);
+	entry->next_retired = map->retired;
+	map->retired = entry;
+	if (++map->nb_retired >= RECLAIM_THRESHOLD)
+		reclaim(map);
+	pthread_mutex_unlock(&map->retired_mutex);
+}
+
+/**
+ * Says whether or not a hash map is valid
+ * @param map Hash map to test
+ * @return non-zero if the hash map is invalid, 0 otherwise
+ */
+static int map_is_invalid(const struct rs_cmap *map)
+{
+	return NULL == map || NULL == map->buckets;
+}
+
+/**
+ * Returns the head of the bucket a hash falls in
+ * @param map Hash map
+ * @param hash Hash of a key
+ * @return Bucket
+ */
+static struct rs_cmap_entry **bucket(struct rs_cmap *map, uint32_t hash)
+{
+	return map->buckets + (hash & map->mask);
+}
+
+/**
+ * Returns the lock of the bucket a hash falls in
+ * @param map Hash map
+ * @param hash Hash of a key
+ * @return Mutex
+ */
+static pthread_mutex_t *stripe(struct rs_cmap *map, uint32_t hash)
+{
+	return &map->stripes[hash & map->mask & (RS_CMAP_NB_STRIPES - 1)].mutex;
+}
+
+/**
+ * Searches for a key in the bucket of it's hash, either inside a read-side
+ * critical section, or with the bucket's lock held
+ * @param map Hash map
+ * @param hash Hash of the key
+ * @param key Key
+ * @param link If not NULL, in output, pointer to the pointer to the entry, in
+ * the bucket or in the previous entry, or to the last pointer of the bucket if
+ * not found
+ * @return Entry, NULL if not found
+ */
+static struct rs_cmap_entry *find(struct rs_cmap *map, uint32_t hash,
+		const char *key, struct rs_cmap_entry ***link)
+{
+	struct rs_cmap_entry **l = bucket(map, hash);
+	struct rs_cmap_entry *entry;
+
+	for (;; l = &entry->next) {
+		entry = __atomic_load_n(l, __ATOMIC_ACQUIRE);
+		if (NULL == entry ||
+				(entry->hash == hash &&
+				strcmp(entry->key, key) == 0))
+			break;
+	}
+	if (NULL != link)
+		*link = l;
+
+	return entry;
+}
+
+int rs_cmap_init(struct rs_cmap *map, size_t size)
+{
+	size_t nb_buckets = MIN_BUCKETS;
+	unsigned i;
+
+	if (NULL == map)
+		return -EINVAL;
+
+	while (nb_buckets < size) {
+		if (nb_buckets > SIZE_MAX / 2 / sizeof(*map->buckets))
+			return -E2BIG;
+		nb_buckets *= 2;
+	}
+
+	memset(map, 0, sizeof(*map));
+	map->buckets = calloc(nb_buckets, sizeof(*map->buckets));
+	if (NULL == map->buckets)
+		return -ENOMEM;
+	map->mask = nb_buckets - 1;
+	for (i = 0; i < RS_CMAP_NB_STRIPES; i++)
+		pthread_mutex_init(&map->stripes[i].mutex, NULL);
+	pthread_mutex_init(&map->retired_mutex, NULL);
+
+	return 0;
+}
+
+int rs_cmap_lookup(struct rs_cmap *map, const char *key, void **data)
+{
+	unsigned idx;
+	struct rs_cmap_reader_slot *slot;
+	struct rs_cmap_entry *entry;
+
+	if (map_is_invalid(map) || ut_string_is_invalid(key) || NULL == data)
+		return -EINVAL;
+
+	slot = get_reader_slot(map);
+	idx = read_lock(map, slot);
+	entry = find(map, rs_hash_string(key), key, NULL);
+	*data = NULL == entry ? NULL : entry->data;
+	read_unlock(slot, idx);
+
+	return NULL == entry ? -ENOENT : 0;
+}
+
+int rs_cmap_insert(struct rs_cmap *map, const char *key, void *data)
+{
+	size_t len;
+	uint32_t hash;
+	pthread_mutex_t *mutex;
+	struct rs_cmap_entry **link;
+	struct rs_cmap_entry *entry;
+
+	if (map_is_invalid(map) || ut_string_is_invalid(key))
+		return -EINVAL;
+
+	len = strlen(key);
+	entry = malloc(sizeof(*entry) + len + 1);
+	if (NULL == entry)
+		return -ENOMEM;
+	hash = rs_hash_wyhash(key, len);
+	entry->data = data;
+	entry->hash = hash;
+	memcpy(entry->key, key, len + 1);
+
+	mutex = stripe(map, hash);
+	pthread_mutex_lock(mutex);
+	if (NULL != find(map, hash, key, &link)) {
+		pthread_mutex_unlock(mutex);
+		free(entry);
+		return -EEXIST;
+	}
+	/* the entry is complete before readers can see it */
+	entry->next = NULL;
+	__atomic_store_n(link, entry, __ATOMIC_RELEASE);
+	__atomic_add_fetch(&map->count, 1, __ATOMIC_RELAXED);
+	pthread_mutex_unlock(mutex);
+
+	return 0;
+}
+
+int rs_cmap_remove(struct rs_cmap *map, const char *key, void **data)
+{
+	uint32_t hash;
+	pthread_mutex_t *mutex;
+	struct rs_cmap_entry **link;
+	struct rs_cmap_entry *entry;
+
+	if (map_is_invalid(map) || ut_string_is_invalid(key))
+		return -EINVAL;
+	if (NULL != data)
+		*data = NULL;
+
+	hash = rs_hash_string(key);
+	mutex = stripe(map, hash);
+	pthread_mutex_lock(mutex);
+	entry = find(map, hash, key, &link);
+	if (NULL == entry) {
+		pthread_mutex_unlock(mutex);
+		return -ENOENT;
+	}
+	/* readers already on the entry can still follow it's next pointer */
+	__atomic_store_n(link, entry->next, __ATOMIC_RELEASE);
+	__atomic_sub_fetch(&map->count, 1, __ATOMIC_RELAXED);
+	pthread_mutex_unlock(mutex);
+
+	if (NULL != data)
+		*data = entry->data;
+	retire(map, entry);
+
+	return 0;
+}
+
+int rs_cmap_synchronize(struct rs_cmap *map)
+{
+	if (map_is_invalid(map))
+		return -EINVAL;
+
+	pthread_mutex_lock(&map->retired_mutex);
+	reclaim(map);
+	pthread_mutex_unlock(&map->retired_mutex);
+
+	return 0;
+}
+
+int rs_cmap_clean_cb(struct rs_cmap *map, void (*free_cb)(void *))
+{
+	size_t i;
+	unsigned j;
+	struct rs_cmap_entry *entry;
+	struct rs_cmap_entry *next;
+
+	if (NULL == map)
+		return -EINVAL;
+	if (NULL == map->buckets)
+		return 0;
+
+	free_retired(map);
+	for (i = 0; i <= map->mask; i++) {
+		for (entry = map->buckets[i]; entry != NULL; entry = next) {
+			next = entry->next;
+			if (NULL != free_cb)
+				free_cb(entry->data);
+			free(entry);
+		}
+	}
+	free(map->buckets);
+	for (j = 0; j < RS_CMAP_NB_STRIPES; j++)
+		pthread_mutex_destroy(&map->stripes[j].mutex);
+	pthread_mutex_destroy(&map->retired_mutex);
+	memset(map, 0, sizeof(*map));
+
+	return 0;
+}
+
+int rs_cmap_clean(struct rs_cmap *map)
+{
+	return rs_cmap_clean_cb(map, NULL);
+}
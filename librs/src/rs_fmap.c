@@ -0,0 +1,382 @@
+/**
+ * @file rs_fmap.c
+ * @date 19 oct. 2026
+ * @author nicolas.carrier@parrot.com
+ * @brief Frozen map implementation.
+ *
+ * The minimal perfect hash is built by hash and displace: the keys are
+ * distributed in buckets, two keys per bucket on average, by the high bits of
+ * their hash. Starting from the largest, a seed is searched for each bucket,
+ * which, mixed with the hash of each of it's keys, sends them all to free
+ * slots. The buckets of only one key are processed last, their seed is
+ * directly the index of a remaining free slot.
+ * Indexes are reduced to a range by a multiplication and a shift, rather than
+ * by a division.
+ *
+ * Copyright (C) 2026 Parrot S.A.
+ */
+#include <string.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <errno.h>
+
+#include "rs_hash.h"
+#include "rs_fmap.h"
+
+/* average number of keys per bucket */
+#define KEYS_PER_BUCKET 2
+
+/* number of seeds tried for a bucket, before giving up */
+#define MAX_SEED 0x100000u
+
+/**
+ * @struct key_info
+ * @brief Information on a key, used during the build
+ */
+struct key_info {
+	/** hash of the key */
+	uint64_t hash;
+	/** bucket of the key */
+	uint32_t bucket;
+	/** index of the key's entry in the entries passed to rs_fmap_init */
+	uint32_t index;
+};
+
+/**
+ * @struct bucket_info
+ * @brief Information on a bucket, used during the build
+ */
+struct bucket_info {
+	/** index of the bucket */
+	uint32_t bucket;
+	/** index of the bucket's first key, in the sorted key_info array */
+	uint32_t first;
+	/** number of keys in the bucket */
+	uint32_t size;
+};
+
+/**
+ * Maps a 32 bits value to [0, n[
+ * @param x Value
+ * @param n Size of the range
+ * @return Value in the range
+ */
+static uint32_t reduce(uint32_t x, uint32_t n)
+{
+	return ((uint64_t)x * n) >> 32;
+}
+
+/**
+ * Returns the bucket of a key
+ * @param nb_buckets Number of buckets
+ * @param hash Hash of the key
+ * @return Bucket
+ */
+static uint32_t bucket_of(uint32_t nb_buckets, uint64_t hash)
+{
+	return reduce(hash >> 32, nb_buckets);
+}
+
+/**
+ * Returns the slot a seed sends a key to, the hash and the seed are mixed with
+ * the finalizer of murmur3
+ * @param nb_entries Number of slots
+ * @param hash Hash of the key
+ * @param seed Seed of the key's bucket
+ * @return Slot
+ */
+static uint32_t slot_of(uint32_t nb_entries, uint64_t hash, uint32_t seed)
+{
+	uint64_t h = hash + seed * UINT64_C(0x9e3779b97f4a7c15);
+
+	h ^= h >> 33;
+	h *= UINT64_C(0xff51afd7ed558ccd);
+	h ^= h >> 33;
+	h *= UINT64_C(0xc4ceb9fe1a85ec53);
+	h ^= h >> 33;
+
+	return reduce(h >> 32, nb_entries);
+}
+
+/**
+ * Says whether or not a key is valid
+ * @param key Key to test
+ * @return non-zero if the key is NULL or empty, 0 otherwise
+ */
+static int key_is_invalid(const char *key)
+{
+	return NULL == key || '\0' == *key;
+}
+
+/**
+ * Says whether or not a frozen map is valid
+ * @param map Frozen map to test
+ * @return non-zero if the frozen map is invalid, 0 otherwise
+ */
+static int map_is_invalid(const struct rs_fmap *map)
+{
+	return NULL == map || NULL == map->seeds;
+}
+
+/* by bucket, then by hash, so that keys of the same hash are adjacent */
+static int key_info_compare(const void *a, const void *b)
+{
+	const struct key_info *ka = a;
+	const struct key_info *kb = b;
+
+	if (ka->bucket != kb->bucket)
+		return ka->bucket < kb->bucket ? -1 : 1;
+	if (ka->hash != kb->hash)
+		return ka->hash < kb->hash ? -1 : 1;
+
+	return 0;
+}
+
+/* biggest buckets first */
+static int bucket_info_compare(const void *a, const void *b)
+{
+	const struct bucket_info *ba = a;
+	const struct bucket_info *bb = b;
+
+	if (ba->size != bb->size)
+		return ba->size > bb->size ? -1 : 1;
+
+	return ba->bucket < bb->bucket ? -1 : 1;
+}
+
+/**
+ * Searches a seed sending all the keys of a bucket to free slots and marks
+ * them as taken
+ * @param map Frozen map being built
+ * @param keys Keys of the bucket
+ * @param size Number of keys of the bucket
+ * @param taken Slots already taken
+ * @return Seed found, MAX_SEED if none was found
+ */
+static uint32_t place_bucket(struct rs_fmap *map, const struct key_info *keys,
+		uint32_t size, uint8_t *taken)
+{
+	uint32_t seed;
+	uint32_t slot;
+	uint32_t i;
+	uint32_t j;
+
+	for (seed = 0; seed < MAX_SEED; seed++) {
+		for (i = 0; i < size; i++) {
+			slot = slot_of(map->nb_entries, keys[i].hash, seed);
+			if (taken[slot])
+				break;
+			taken[slot] = 1;
+		}
+		if (i == size)
+			return seed;
+		/* undo, the keys of the bucket collide between them or not */
+		for (j = 0; j < i; j++)
+			taken[slot_of(map->nb_entries, keys[j].hash, seed)] = 0;
+	}
+
+	return MAX_SEED;
+}
+
+/**
+ * Computes the seeds and places the entries of a frozen map, whose seeds and
+ * entries arrays are allocated
+ * @param map Frozen map being built
+ * @param keys Information on the keys, sorted by bucket
+ * @param buckets Information on the buckets, sorted by decreasing size
+ * @param entries Entries passed to rs_fmap_init()
+ * @param slots Entries of the map
+ * @return Negative errno-compatible value on error, 0 on success
+ */
+static int place(struct rs_fmap *map, const struct key_info *keys,
+		const struct bucket_info *buckets,
+		const struct rs_fmap_entry *entries,
+		struct rs_fmap_entry *slots)
+{
+	int ret = 0;
+	uint8_t *taken;
+	uint32_t *seeds = (uint32_t *)map->seeds;
+	uint32_t free_slot = 0;
+	uint32_t seed;
+	uint32_t i;
+	uint32_t j;
+	const struct key_info *k;
+
+	taken = calloc(map->nb_entries, sizeof(*taken));
+	if (NULL == taken)
+		return -ENOMEM;
+
+	for (i = 0; i < map->nb_buckets && buckets[i].size != 0; i++) {
+		k = keys + buckets[i].first;
+		if (buckets[i].size == 1) {
+			while (taken[free_slot])
+				free_slot++;
+			taken[free_slot] = 1;
+			seeds[buckets[i].bucket] = RS_FMAP_DIRECT | free_slot;
+			slots[free_slot] = entries[k->index];
+			continue;
+		}
+		seed = place_bucket(map, k, buckets[i].size, taken);
+		if (seed == MAX_SEED) {
+			ret = -ERANGE;
+			break;
+		}
+		seeds[buckets[i].bucket] = seed;
+		for (j = 0; j < buckets[i].size; j++)
+			slots[slot_of(map->nb_entries, k[j].hash, seed)] =
+					entries[k[j].index];
+	}
+
+	free(taken);
+
+	return ret;
+}
+
+/**
+ * Sorts the keys by bucket, checks they are unique and gathers the buckets,
+ * biggest first
+ * @param map Frozen map being built
+ * @param keys Information on the keys
+ * @param buckets In output, information on the buckets
+ * @param entries Entries passed to rs_fmap_init()
+ * @return Negative errno-compatible value on error, 0 on success
+ */
+static int sort(struct rs_fmap *map, struct key_info *keys,
+		struct bucket_info *buckets,
+		const struct rs_fmap_entry *entries)
+{
+	uint32_t i;
+	struct bucket_info *b;
+
+	qsort(keys, map->nb_entries, sizeof(*keys), key_info_compare);
+	for (i = 0; i < map->nb_buckets; i++)
+		buckets[i].bucket = i;
+	for (i = 0; i < map->nb_entries; i++) {
+		if (i > 0 && keys[i].hash == keys[i - 1].hash) {
+			/* no seed can separate keys of the same hash */
+			if (strcmp(entries[keys[i].index].key,
+					entries[keys[i - 1].index].key) == 0)
+				return -EEXIST;
+			return -ERANGE;
+		}
+		b = buckets + keys[i].bucket;
+		if (b->size == 0)
+			b->first = i;
+		b->size++;
+	}
+	qsort(buckets, map->nb_buckets, sizeof(*buckets), bucket_info_compare);
+
+	return 0;
+}
+
+int rs_fmap_init(struct rs_fmap *map, const struct rs_fmap_entry *entries,
+		size_t nb)
+{
+	int ret;
+	size_t i;
+	uint32_t *seeds = NULL;
+	struct rs_fmap_entry *slots = NULL;
+	struct key_info *keys = NULL;
+	struct bucket_info *buckets = NULL;
+
+	if (NULL == map || (NULL == entries && nb != 0))
+		return -EINVAL;
+	if (nb >= RS_FMAP_DIRECT)
+		return -E2BIG;
+	for (i = 0; i < nb; i++)
+		if (key_is_invalid(entries[i].key))
+			return -EINVAL;
+
+	memset(map, 0, sizeof(*map));
+	map->nb_entries = nb;
+	map->nb_buckets = (nb + KEYS_PER_BUCKET - 1) / KEYS_PER_BUCKET;
+	if (map->nb_buckets == 0)
+		map->nb_buckets = 1;
+
+	seeds = calloc(map->nb_buckets, sizeof(*seeds));
+	buckets = calloc(map->nb_buckets, sizeof(*buckets));
+	if (NULL == seeds || NULL == buckets) {
+		ret = -ENOMEM;
+		goto err;
+	}
+	if (nb != 0) {
+		slots = calloc(nb, sizeof(*slots));
+		keys = calloc(nb, sizeof(*keys));
+		if (NULL == slots || NULL == keys) {
+			ret = -ENOMEM;
+			goto err;
+		}
+	}
+	map->seeds = seeds;
+	for (i = 0; i < nb; i++) {
+		keys[i].hash = rs_hash_wyhash64(entries[i].key,
+				strlen(entries[i].key));
+		keys[i].bucket = bucket_of(map->nb_buckets, keys[i].hash);
+		keys[i].index = i;
+	}
+	if (nb != 0) {
+		ret = sort(map, keys, buckets, entries);
+		if (ret < 0)
+			goto err;
+		ret = place(map, keys, buckets, entries, slots);
+		if (ret < 0)
+			goto err;
+	}
+	map->entries = slots;
+
+	free(buckets);
+	free(keys);
+
+	return 0;
+err:
+	free(buckets);
+	free(keys);
+	free(slots);
+	free(seeds);
+	memset(map, 0, sizeof(*map));
+
+	return ret;
+}
+
+uint32_t rs_fmap_slot(const struct rs_fmap *map, const char *key, size_t len)
+{
+	uint64_t hash;
+	uint32_t seed;
+
+	hash = rs_hash_wyhash64(key, len);
+	seed = map->seeds[bucket_of(map->nb_buckets, hash)];
+	if (seed & RS_FMAP_DIRECT)
+		return seed & ~RS_FMAP_DIRECT;
+
+	return slot_of(map->nb_entries, hash, seed);
+}
+
+int rs_fmap_lookup(const struct rs_fmap *map, const char *key, void **data)
+{
+	const struct rs_fmap_entry *entry;
+
+	if (map_is_invalid(map) || key_is_invalid(key) || NULL == data)
+		return -EINVAL;
+	*data = NULL;
+	if (map->nb_entries == 0)
+		return -ENOENT;
+
+	entry = map->entries + rs_fmap_slot(map, key, strlen(key));
+	if (strcmp(entry->key, key) != 0)
+		return -ENOENT;
+	*data = entry->data;
+
+	return 0;
+}
+
+int rs_fmap_clean(struct rs_fmap *map)
+{
+	if (NULL == map)
+		return -EINVAL;
+
+	free((void *)map->seeds);
+	free((void *)map->entries);
+	memset(map, 0, sizeof(*map));
+
+	return 0;
+}
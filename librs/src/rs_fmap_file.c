@@ -0,0 +1,396 @@
+/**
+ * @file rs_fmap_file.c
+ * @date 19 oct. 2026
+ * @author nicolas.carrier@parrot.com
+ * @brief Frozen map files implementation.
+ *
+ * The file is made of the header, the seeds, the entries, then of the keys
+ * and values, each value following it's key, so that a successful lookup
+ * touches at most the pages of a seed, of an entry and of it's key and value.
+ * Everything but the keys is aligned on 8 bytes, the padding is zeroed for
+ * the checksum to be reproducible. The checksums are 64 bits wyhashes.
+ *
+ * Copyright (C) 2026 Parrot S.A.
+ */
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif /* _GNU_SOURCE */
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <errno.h>
+
+#include "rs_hash.h"
+#include "rs_fmap_file.h"
+
+/* rounds an offset up to the next multiple of 8 */
+#define ALIGN8(x) (((x) + 7) & ~(uint64_t)7)
+
+/**
+ * Says whether or not a frozen map file is valid
+ * @param file Frozen map file to test
+ * @return non-zero if the frozen map file is invalid, 0 otherwise
+ */
+static int file_is_invalid(const struct rs_fmap_file *file)
+{
+	return NULL == file || NULL == file->base;
+}
+
+/**
+ * Computes the checksum of a header
+ * @param header Header
+ * @return Checksum
+ */
+static uint64_t header_checksum(const struct rs_fmap_file_header *header)
+{
+	return rs_hash_wyhash64(header,
+			offsetof(struct rs_fmap_file_header, header_checksum));
+}
+
+/**
+ * Computes the size of a file and the offsets of it's parts
+ * @param map Frozen map of the items
+ * @param items Items, in their original order
+ * @param header In output, header with the offsets and the size set
+ * @return Negative errno-compatible value on error, 0 on success
+ */
+static int layout(const struct rs_fmap *map,
+		const struct rs_fmap_file_item *items,
+		struct rs_fmap_file_header *header)
+{
+	uint32_t i;
+	uint64_t off;
+	const struct rs_fmap_file_item *item;
+
+	header->seeds = sizeof(*header);
+	off = header->seeds + (uint64_t)map->nb_buckets * sizeof(uint32_t);
+	header->entries = ALIGN8(off);
+	off = header->entries +
+			(uint64_t)map->nb_entries *
+			sizeof(struct rs_fmap_file_entry);
+	for (i = 0; i < map->nb_entries; i++) {
+		item = items + (uintptr_t)map->entries[i].data;
+		off = ALIGN8(off + strlen(item->key) + 1) + ALIGN8(item->len);
+	}
+	if (off > SIZE_MAX)
+		return -E2BIG;
+	header->size = off;
+
+	return 0;
+}
+
+/**
+ * Fills the content of a file, whose layout is computed
+ * @param image Content of the file, zeroed
+ * @param map Frozen map of the items
+ * @param items Items, in their original order
+ * @param header Header, with the layout set
+ */
+static void fill(uint8_t *image, const struct rs_fmap *map,
+		const struct rs_fmap_file_item *items,
+		struct rs_fmap_file_header *header)
+{
+	uint32_t i;
+	uint64_t off;
+	struct rs_fmap_file_entry *entry;
+	const struct rs_fmap_file_item *item;
+
+	memcpy(image + header->seeds, map->seeds,
+			map->nb_buckets * sizeof(*map->seeds));
+	entry = (struct rs_fmap_file_entry *)(image + header->entries);
+	off = header->entries + map->nb_entries * sizeof(*entry);
+	for (i = 0; i < map->nb_entries; i++, entry++) {
+		item = items + (uintptr_t)map->entries[i].data;
+		entry->key = off;
+		entry->key_len = strlen(item->key);
+		memcpy(image + off, item->key, entry->key_len);
+		off = ALIGN8(off + entry->key_len + 1);
+		entry->value = off;
+		entry->value_len = item->len;
+		if (item->len != 0)
+			memcpy(image + off, item->value, item->len);
+		off += ALIGN8(item->len);
+	}
+
+	header->magic = RS_FMAP_FILE_MAGIC;
+	header->version = RS_FMAP_FILE_VERSION;
+	header->hash_version = RS_FMAP_VERSION;
+	header->nb_buckets = map->nb_buckets;
+	header->nb_entries = map->nb_entries;
+	header->checksum = rs_hash_wyhash64(image + sizeof(*header),
+			header->size - sizeof(*header));
+	header->header_checksum = header_checksum(header);
+	memcpy(image, header, sizeof(*header));
+}
+
+/**
+ * Writes a buffer to a new file, then renames it to it's final path
+ * @param path Path of the file
+ * @param buf Content of the file
+ * @param size Size of the content
+ * @return Negative errno-compatible value on error, 0 on success
+ */
+static int write_atomically(const char *path, const uint8_t *buf, size_t size)
+{
+	int ret;
+	int fd;
+	char *tmp;
+	ssize_t sret;
+	size_t written = 0;
+
+	ret = asprintf(&tmp, "%s.XXXXXX", path);
+	if (ret < 0)
+		return -ENOMEM;
+	fd = mkstemp(tmp);
+	if (fd == -1) {
+		ret = -errno;
+		free(tmp);
+		return ret;
+	}
+	while (written < size) {
+		sret = write(fd, buf + written, size - written);
+		if (sret == -1) {
+			if (errno == EINTR)
+				continue;
+			ret = -errno;
+			goto err;
+		}
+		written += sret;
+	}
+	if (fchmod(fd, 0644) == -1 || fsync(fd) == -1) {
+		ret = -errno;
+		goto err;
+	}
+	if (close(fd) == -1) {
+		fd = -1;
+		ret = -errno;
+		goto err;
+	}
+	fd = -1;
+	if (rename(tmp, path) == -1) {
+		ret = -errno;
+		goto err;
+	}
+	free(tmp);
+
+	return 0;
+err:
+	if (fd != -1)
+		close(fd);
+	unlink(tmp);
+	free(tmp);
+
+	return ret;
+}
+
+int rs_fmap_file_write(const char *path, const struct rs_fmap_file_item *items,
+		size_t nb)
+{
+	int ret;
+	size_t i;
+	uint8_t *image;
+	struct rs_fmap map;
+	struct rs_fmap_entry *entries = NULL;
+	struct rs_fmap_file_header header;
+
+	if (NULL == path || (NULL == items && nb != 0))
+		return -EINVAL;
+	for (i = 0; i < nb; i++) {
+		if (NULL == items[i].key || (NULL == items[i].value &&
+				items[i].len != 0))
+			return -EINVAL;
+		if (items[i].len > UINT32_MAX ||
+				strlen(items[i].key) > UINT32_MAX)
+			return -E2BIG;
+	}
+
+	if (nb != 0) {
+		entries = calloc(nb, sizeof(*entries));
+		if (NULL == entries)
+			return -ENOMEM;
+	}
+	/* the data of each entry is the index of it's item */
+	for (i = 0; i < nb; i++) {
+		entries[i].key = items[i].key;
+		entries[i].data = (void *)(uintptr_t)i;
+	}
+	ret = rs_fmap_init(&map, entries, nb);
+	free(entries);
+	if (ret < 0)
+		return ret;
+
+	memset(&header, 0, sizeof(header));
+	ret = layout(&map, items, &header);
+	if (ret < 0)
+		goto out;
+	image = calloc(1, header.size);
+	if (NULL == image) {
+		ret = -ENOMEM;
+		goto out;
+	}
+	fill(image, &map, items, &header);
+	ret = write_atomically(path, image, header.size);
+	free(image);
+out:
+	rs_fmap_clean(&map);
+
+	return ret;
+}
+
+int rs_fmap_file_open(struct rs_fmap_file *file, const char *path)
+{
+	int ret;
+	int fd;
+	void *base;
+	struct stat st;
+
+	if (NULL == file || NULL == path)
+		return -EINVAL;
+
+	fd = open(path, O_RDONLY | O_CLOEXEC);
+	if (fd == -1)
+		return -errno;
+	if (fstat(fd, &st) == -1) {
+		ret = -errno;
+		close(fd);
+		return ret;
+	}
+	if ((uint64_t)st.st_size < sizeof(struct rs_fmap_file_header) ||
+			(uint64_t)st.st_size > SIZE_MAX) {
+		close(fd);
+		return -EBADMSG;
+	}
+	/* pages are read from the disk only when accessed */
+	base = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+	ret = -errno;
+	close(fd);
+	if (MAP_FAILED == base)
+		return ret;
+
+	ret = rs_fmap_file_init(file, base, st.st_size);
+	if (ret < 0) {
+		munmap(base, st.st_size);
+		return ret;
+	}
+	file->mapped = 1;
+
+	return 0;
+}
+
+int rs_fmap_file_init(struct rs_fmap_file *file, const void *buf, size_t size)
+{
+	const struct rs_fmap_file_header *header = buf;
+
+	if (NULL == file || NULL == buf || ((uintptr_t)buf & 7) != 0)
+		return -EINVAL;
+	if (size < sizeof(*header))
+		return -EBADMSG;
+
+	if (header->magic == __builtin_bswap32(RS_FMAP_FILE_MAGIC))
+		return -ENOTSUP;
+	if (header->magic != RS_FMAP_FILE_MAGIC)
+		return -EBADMSG;
+	if (header->version != RS_FMAP_FILE_VERSION)
+		return -ENOTSUP;
+	if (header->header_checksum != header_checksum(header))
+		return -EBADMSG;
+	if (header->hash_version != RS_FMAP_VERSION)
+		return -ENOTSUP;
+
+	/* the offsets are checked one after the other, no sum can overflow */
+	if (header->size != size || header->nb_buckets == 0 ||
+			header->nb_entries >= RS_FMAP_DIRECT ||
+			header->seeds < sizeof(*header) ||
+			header->seeds % sizeof(uint32_t) != 0 ||
+			header->seeds > size ||
+			header->entries % 8 != 0 ||
+			header->entries > size ||
+			header->seeds + (uint64_t)header->nb_buckets *
+			sizeof(uint32_t) > header->entries ||
+			header->entries + (uint64_t)header->nb_entries *
+			sizeof(struct rs_fmap_file_entry) > size)
+		return -EBADMSG;
+
+	memset(file, 0, sizeof(*file));
+	file->base = buf;
+	file->size = size;
+	file->map.seeds = (const uint32_t *)(file->base + header->seeds);
+	file->map.nb_buckets = header->nb_buckets;
+	file->map.nb_entries = header->nb_entries;
+	file->entries = (const struct rs_fmap_file_entry *)
+			(file->base + header->entries);
+
+	return 0;
+}
+
+int rs_fmap_file_verify(const struct rs_fmap_file *file)
+{
+	const struct rs_fmap_file_header *header;
+
+	if (file_is_invalid(file))
+		return -EINVAL;
+
+	header = (const struct rs_fmap_file_header *)file->base;
+	if (rs_hash_wyhash64(file->base + sizeof(*header),
+			file->size - sizeof(*header)) != header->checksum)
+		return -EBADMSG;
+
+	return 0;
+}
+
+int rs_fmap_file_lookup(const struct rs_fmap_file *file, const char *key,
+		const void **value, size_t *len)
+{
+	size_t key_len;
+	uint32_t slot;
+	const struct rs_fmap_file_entry *entry;
+
+	if (file_is_invalid(file) || NULL == key || '\0' == *key ||
+			NULL == value)
+		return -EINVAL;
+	*value = NULL;
+	if (NULL != len)
+		*len = 0;
+	if (file->map.nb_entries == 0)
+		return -ENOENT;
+
+	key_len = strlen(key);
+	slot = rs_fmap_slot(&file->map, key, key_len);
+	if (slot >= file->map.nb_entries)
+		return -EBADMSG;
+	entry = file->entries + slot;
+	if (entry->key_len != key_len)
+		return -ENOENT;
+	if (entry->key > file->size || key_len > file->size - entry->key)
+		return -EBADMSG;
+	if (memcmp(file->base + entry->key, key, key_len) != 0)
+		return -ENOENT;
+	if (entry->value > file->size ||
+			entry->value_len > file->size - entry->value)
+		return -EBADMSG;
+
+	*value = file->base + entry->value;
+	if (NULL != len)
+		*len = entry->value_len;
+
+	return 0;
+}
+
+int rs_fmap_file_close(struct rs_fmap_file *file)
+{
+	if (NULL == file)
+		return -EINVAL;
+
+	if (file->mapped)
+		munmap((void *)file->base, file->size);
+	memset(file, 0, sizeof(*file));
+
+	return 0;
+}
@@ -0,0 +1,177 @@
+/**
+ * @file rs_hash.c
+ * @date 19 oct. 2026
+ * @author nicolas.carrier@parrot.com
+ * @brief Hash functions for the librs hash maps. wyhash is a public domain
+ * hash function by Wang Yi, of which this is the final version 4, reading
+ * the bytes in little endian order on all platforms, so that tables generated
+ * on the build machine can be used on the target.
+ *
+ * Copyright (C) 2026 Parrot S.A.
+ */
+#include <string.h>
+#include <stdint.h>
+
+#include "rs_hash.h"
+
+/* secrets of wyhash */
+static const uint64_t wyp[] = {
+	0x2d358dccaa6c78a5ull,
+	0x8bb84b93962eacc9ull,
+	0x4b33a62ed433d4a3ull,
+	0x4d5a2da51de1aa47ull,
+};
+
+/**
+ * Computes the full 128 bits product of two 64 bits integers
+ * @param a In input, first operand, in output, low 64 bits of the product
+ * @param b In input, second operand, in output, high 64 bits of the product
+ */
+static inline void wymum(uint64_t *a, uint64_t *b)
+{
+#ifdef __SIZEOF_INT128__
+	__uint128_t r = (__uint128_t)*a * *b;
+
+	*a = (uint64_t)r;
+	*b = (uint64_t)(r >> 64);
+#else /* __SIZEOF_INT128__ */
+	uint64_t ha = *a >> 32;
+	uint64_t hb = *b >> 32;
+	uint64_t la = (uint32_t)*a;
+	uint64_t lb = (uint32_t)*b;
+	uint64_t rh = ha * hb;
+	uint64_t rm0 = ha * lb;
+	uint64_t rm1 = hb * la;
+	uint64_t rl = la * lb;
+	uint64_t t = rl + (rm0 << 32);
+	uint64_t c = t < rl;
+	uint64_t lo = t + (rm1 << 32);
+
+	c += lo < t;
+	*a = lo;
+	*b = rh + (rm0 >> 32) + (rm1 >> 32) + c;
+#endif /* __SIZEOF_INT128__ */
+}
+
+static inline uint64_t wymix(uint64_t a, uint64_t b)
+{
+	wymum(&a, &b);
+
+	return a ^ b;
+}
+
+static inline uint64_t wyr8(const uint8_t *p)
+{
+	uint64_t v;
+
+	memcpy(&v, p, sizeof(v));
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+	v = __builtin_bswap64(v);
+#endif
+
+	return v;
+}
+
+static inline uint64_t wyr4(const uint8_t *p)
+{
+	uint32_t v;
+
+	memcpy(&v, p, sizeof(v));
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+	v = __builtin_bswap32(v);
+#endif
+
+	return v;
+}
+
+static inline uint64_t wyr3(const uint8_t *p, size_t k)
+{
+	return ((uint64_t)p[0] << 16) | ((uint64_t)p[k >> 1] << 8) | p[k - 1];
+}
+
+uint64_t rs_hash_wyhash64(const void *buf, size_t len)
+{
+	const uint8_t *p = buf;
+	size_t i = len;
+	uint64_t seed = wymix(wyp[0], wyp[1]);
+	uint64_t see1;
+	uint64_t see2;
+	uint64_t a;
+	uint64_t b;
+
+	if (len <= 16) {
+		if (len >= 4) {
+			a = (wyr4(p) << 32) | wyr4(p + ((len >> 3) << 2));
+			b = (wyr4(p + len - 4) << 32) |
+					wyr4(p + len - 4 - ((len >> 3) << 2));
+		} else if (len > 0) {
+			a = wyr3(p, len);
+			b = 0;
+		} else {
+			a = 0;
+			b = 0;
+		}
+	} else {
+		if (i > 48) {
+			see1 = seed;
+			see2 = seed;
+			do {
+				seed = wymix(wyr8(p) ^ wyp[1], wyr8(p + 8) ^ seed);
+				see1 = wymix(wyr8(p + 16) ^ wyp[2],
+						wyr8(p + 24) ^ see1);
+				see2 = wymix(wyr8(p + 32) ^ wyp[3],
+						wyr8(p + 40) ^ see2);
+				p += 48;
+				i -= 48;
+			} while (i > 48);
+			seed ^= see1 ^ see2;
+		}
+		while (i > 16) {
+			seed = wymix(wyr8(p) ^ wyp[1], wyr8(p + 8) ^ seed);
+			i -= 16;
+			p += 16;
+		}
+		a = wyr8(p + i - 16);
+		b = wyr8(p + i - 8);
+	}
+	a ^= wyp[1];
+	b ^= seed;
+	wymum(&a, &b);
+
+	return wymix(a ^ wyp[0] ^ len, b ^ wyp[1]);
+}
+
+uint32_t rs_hash_wyhash(const void *buf, size_t len)
+{
+	return (uint32_t)rs_hash_wyhash64(buf, len);
+}
+
+uint32_t rs_hash_fnv1a(const void *buf, size_t len)
+{
+	const unsigned char *p = buf;
+	const unsigned char *end = p + len;
+	uint32_t hash = 2166136261u;
+
+	while (p < end) {
+		hash ^= *p++;
+		hash *= 16777619u;
+	}
+
+	hash ^= hash >> 16;
+	hash *= 0x85ebca6bu;
+	hash ^= hash >> 13;
+	hash *= 0xc2b2ae35u;
+	hash ^= hash >> 16;
+
+	return hash;
+}
+
+uint32_t rs_hash_u64(uint64_t value)
+{
+	return rs_hash_wyhash(&value, sizeof(value));
+}
+
+uint32_t rs_hash_string(const char *str)
+{
+	return rs_hash_wyhash(str, strlen(str));
+}
@@ -0,0 +1,250 @@
+/**
+ * @file rs_heap.c
+ * @date 19 oct. 2026
+ * @author nicolas.carrier@parrot.com
+ * @brief Intrusive d-ary min-heap implementation. The children of the node at
+ * index i are at indices i * arity + 1 to i * arity + arity.
+ *
+ * Copyright (C) 2026 Parrot S.A.
+ */
+#include <string.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <errno.h>
+
+#include "rs_heap.h"
+
+/* number of slots of the array of the smallest heap */
+#define MIN_CAPACITY 16
+
+/**
+ * Says whether or not a heap is valid
+ * @param heap Heap to test
+ * @return non-zero if the heap is invalid, 0 otherwise
+ */
+static int heap_is_invalid(const struct rs_heap *heap)
+{
+	return NULL == heap || NULL == heap->nodes;
+}
+
+/**
+ * Says whether or not a node is in a heap
+ * @param heap Heap
+ * @param node Node
+ * @return non-zero if the node is in the heap, 0 otherwise
+ */
+static int contains(const struct rs_heap *heap, const struct rs_heap_node *node)
+{
+	return node->index < heap->count && heap->nodes[node->index] == node;
+}
+
+/**
+ * Stores a node in a slot of the array
+ * @param heap Heap
+ * @param node Node to store
+ * @param i Index of the slot
+ */
+static void place(struct rs_heap *heap, struct rs_heap_node *node, size_t i)
+{
+	heap->nodes[i] = node;
+	node->index = i;
+}
+
+/**
+ * Moves a node up, from a free slot, until it's parent is lesser than or equal
+ * to it
+ * @param heap Heap
+ * @param node Node to place
+ * @param i Index of the free slot to start from
+ */
+static void sift_up(struct rs_heap *heap, struct rs_heap_node *node, size_t i)
+{
+	size_t parent;
+
+	while (i > 0) {
+		parent = (i - 1) / heap->arity;
+		if (heap->vtable.compare(node, heap->nodes[parent]) >= 0)
+			break;
+		place(heap, heap->nodes[parent], i);
+		i = parent;
+	}
+	place(heap, node, i);
+}
+
+/**
+ * Moves a node down, from a free slot, until all it's children are greater
+ * than or equal to it
+ * @param heap Heap
+ * @param node Node to place
+ * @param i Index of the free slot to start from
+ */
+static void sift_down(struct rs_heap *heap, struct rs_heap_node *node,
+		size_t i)
+{
+	size_t child;
+	size_t last;
+	size_t least;
+
+	/* while i has at least one child, written not to overflow */
+	while (heap->count > 1 && i <= (heap->count - 2) / heap->arity) {
+		child = i * heap->arity + 1;
+		if (heap->count - child > heap->arity)
+			last = child + heap->arity;
+		else
+			last = heap->count;
+		for (least = child++; child < last; child++)
+			if (heap->vtable.compare(heap->nodes[child],
+					heap->nodes[least]) < 0)
+				least = child;
+		if (heap->vtable.compare(heap->nodes[least], node) >= 0)
+			break;
+		place(heap, heap->nodes[least], i);
+		i = least;
+	}
+	place(heap, node, i);
+}
+
+/**
+ * Puts a node in a free slot and moves it up or down to it's place
+ * @param heap Heap
+ * @param node Node to place
+ * @param i Index of the free slot
+ */
+static void reposition(struct rs_heap *heap, struct rs_heap_node *node,
+		size_t i)
+{
+	if (i > 0 && heap->vtable.compare(node,
+			heap->nodes[(i - 1) / heap->arity]) < 0)
+		sift_up(heap, node, i);
+	else
+		sift_down(heap, node, i);
+}
+
+int rs_heap_init(struct rs_heap *heap, size_t arity, size_t size,
+		const struct rs_heap_vtable *vtable)
+{
+	if (NULL == heap || 1 == arity || NULL == vtable ||
+			NULL == vtable->compare)
+		return -EINVAL;
+	if (size > SIZE_MAX / sizeof(*heap->nodes))
+		return -E2BIG;
+
+	if (0 == arity)
+		arity = RS_HEAP_DEFAULT_ARITY;
+	if (size < MIN_CAPACITY)
+		size = MIN_CAPACITY;
+
+	memset(heap, 0, sizeof(*heap));
+	heap->nodes = calloc(size, sizeof(*heap->nodes));
+	if (NULL == heap->nodes)
+		return -ENOMEM;
+	heap->capacity = size;
+	heap->arity = arity;
+	heap->vtable = *vtable;
+
+	return 0;
+}
+
+int rs_heap_insert(struct rs_heap *heap, struct rs_heap_node *node)
+{
+	struct rs_heap_node **nodes;
+	size_t capacity;
+
+	if (heap_is_invalid(heap) || NULL == node)
+		return -EINVAL;
+	if (contains(heap, node))
+		return -EBUSY;
+
+	if (heap->count == heap->capacity) {
+		if (heap->capacity > SIZE_MAX / 2 / sizeof(*nodes))
+			return -ENOMEM;
+		capacity = 2 * heap->capacity;
+		nodes = realloc(heap->nodes, capacity * sizeof(*nodes));
+		if (NULL == nodes)
+			return -ENOMEM;
+		heap->nodes = nodes;
+		heap->capacity = capacity;
+	}
+	heap->count++;
+	sift_up(heap, node, heap->count - 1);
+
+	return 0;
+}
+
+struct rs_heap_node *rs_heap_peek(const struct rs_heap *heap)
+{
+	if (heap_is_invalid(heap) || 0 == heap->count)
+		return NULL;
+
+	return heap->nodes[0];
+}
+
+struct rs_heap_node *rs_heap_pop(struct rs_heap *heap)
+{
+	struct rs_heap_node *node;
+
+	node = rs_heap_peek(heap);
+	if (NULL != node)
+		rs_heap_remove(heap, node);
+
+	return node;
+}
+
+int rs_heap_remove(struct rs_heap *heap, struct rs_heap_node *node)
+{
+	struct rs_heap_node *last;
+	size_t i;
+
+	if (heap_is_invalid(heap) || NULL == node)
+		return -EINVAL;
+	if (!contains(heap, node))
+		return -ENOENT;
+
+	/* the last node fills the hole */
+	i = node->index;
+	heap->count--;
+	last = heap->nodes[heap->count];
+	heap->nodes[heap->count] = NULL;
+	if (last != node)
+		reposition(heap, last, i);
+	node->index = SIZE_MAX;
+
+	return 0;
+}
+
+int rs_heap_update(struct rs_heap *heap, struct rs_heap_node *node)
+{
+	if (heap_is_invalid(heap) || NULL == node)
+		return -EINVAL;
+	if (!contains(heap, node))
+		return -ENOENT;
+
+	reposition(heap, node, node->index);
+
+	return 0;
+}
+
+int rs_heap_clean_cb(struct rs_heap *heap, rs_heap_cb cb, void *data)
+{
+	struct rs_heap_node *node;
+
+	if (heap_is_invalid(heap))
+		return -EINVAL;
+
+	while (heap->count > 0) {
+		heap->count--;
+		node = heap->nodes[heap->count];
+		node->index = SIZE_MAX;
+		if (NULL != cb)
+			cb(node, data);
+	}
+	free(heap->nodes);
+	memset(heap, 0, sizeof(*heap));
+
+	return 0;
+}
+
+int rs_heap_clean(struct rs_heap *heap)
+{
+	return rs_heap_clean_cb(heap, NULL, NULL);
+}
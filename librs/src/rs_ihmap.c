@@ -0,0 +1,225 @@
+/**
+ * @file rs_ihmap.c
+ * @date 19 oct. 2026
+ * @author nicolas.carrier@parrot.com
+ * @brief Intrusive hash map implementation.
+ *
+ * Copyright (C) 2026 Parrot S.A.
+ */
+#include <string.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <errno.h>
+
+#include "rs_ihmap.h"
+
+/* number of buckets of the smallest map */
+#define MIN_BUCKETS 8
+
+/**
+ * Says whether or not a hash map is valid
+ * @param map Hash map to test
+ * @return non-zero if the hash map is invalid, 0 otherwise
+ */
+static int map_is_invalid(const struct rs_ihmap *map)
+{
+	return NULL == map || NULL == map->buckets;
+}
+
+/**
+ * Returns the bucket a hash value falls in
+ * @param map Hash map
+ * @param hash Hash value
+ * @return Head of the bucket's chain
+ */
+static struct rs_ihmap_node **bucket(const struct rs_ihmap *map, uint32_t hash)
+{
+	return map->buckets + (hash & map->mask);
+}
+
+/**
+ * Searches for a key in the bucket of it's hash
+ * @param map Hash map
+ * @param hash Hash of the key
+ * @param key Key
+ * @return Node if found, NULL otherwise
+ */
+static struct rs_ihmap_node *find(const struct rs_ihmap *map, uint32_t hash,
+		const void *key)
+{
+	struct rs_ihmap_node *node;
+
+	for (node = *bucket(map, hash); node != NULL; node = node->next)
+		if (node->hash == hash &&
+				map->vtable.equals(map->vtable.key(node), key))
+			return node;
+
+	return NULL;
+}
+
+/**
+ * Returns the first node of the buckets starting at a given one
+ * @param map Hash map
+ * @param i Index of the first bucket to search
+ * @return Node, NULL if all these buckets are empty
+ */
+static struct rs_ihmap_node *first_from(const struct rs_ihmap *map, size_t i)
+{
+	for (; i <= map->mask; i++)
+		if (map->buckets[i] != NULL)
+			return map->buckets[i];
+
+	return NULL;
+}
+
+/**
+ * Unchains a node, in constant time
+ * @param map Hash map
+ * @param node Node, in the map
+ */
+static void unlink_node(struct rs_ihmap *map, struct rs_ihmap_node *node)
+{
+	*node->pprev = node->next;
+	if (node->next != NULL)
+		node->next->pprev = node->pprev;
+	node->next = NULL;
+	node->pprev = NULL;
+	map->count--;
+}
+
+int rs_ihmap_init(struct rs_ihmap *map, size_t size,
+		const struct rs_ihmap_vtable *vtable)
+{
+	size_t nb_buckets = MIN_BUCKETS;
+
+	if (NULL == map || NULL == vtable || NULL == vtable->hash ||
+			NULL == vtable->key || NULL == vtable->equals)
+		return -EINVAL;
+
+	while (nb_buckets < size) {
+		if (nb_buckets > SIZE_MAX / 2 / sizeof(*map->buckets))
+			return -E2BIG;
+		nb_buckets *= 2;
+	}
+
+	memset(map, 0, sizeof(*map));
+	map->buckets = calloc(nb_buckets, sizeof(*map->buckets));
+	if (NULL == map->buckets)
+		return -ENOMEM;
+	map->mask = nb_buckets - 1;
+	map->vtable = *vtable;
+
+	return 0;
+}
+
+int rs_ihmap_insert(struct rs_ihmap *map, struct rs_ihmap_node *node)
+{
+	struct rs_ihmap_node **head;
+
+	if (map_is_invalid(map) || NULL == node)
+		return -EINVAL;
+	if (NULL != node->pprev)
+		return -EBUSY;
+
+	node->hash = map->vtable.hash(map->vtable.key(node));
+	if (NULL != find(map, node->hash, map->vtable.key(node)))
+		return -EEXIST;
+
+	head = bucket(map, node->hash);
+	node->next = *head;
+	if (NULL != node->next)
+		node->next->pprev = &node->next;
+	node->pprev = head;
+	*head = node;
+	map->count++;
+
+	return 0;
+}
+
+struct rs_ihmap_node *rs_ihmap_lookup(const struct rs_ihmap *map,
+		const void *key)
+{
+	if (map_is_invalid(map))
+		return NULL;
+
+	return find(map, map->vtable.hash(key), key);
+}
+
+int rs_ihmap_remove(struct rs_ihmap *map, struct rs_ihmap_node *node)
+{
+	if (map_is_invalid(map) || NULL == node)
+		return -EINVAL;
+	if (NULL == node->pprev)
+		return -ENOENT;
+
+	unlink_node(map, node);
+
+	return 0;
+}
+
+struct rs_ihmap_node *rs_ihmap_first(const struct rs_ihmap *map)
+{
+	if (map_is_invalid(map))
+		return NULL;
+
+	return first_from(map, 0);
+}
+
+struct rs_ihmap_node *rs_ihmap_next(const struct rs_ihmap *map,
+		const struct rs_ihmap_node *node)
+{
+	if (map_is_invalid(map) || NULL == node)
+		return NULL;
+
+	if (NULL != node->next)
+		return node->next;
+
+	return first_from(map, (node->hash & map->mask) + 1);
+}
+
+int rs_ihmap_foreach(struct rs_ihmap *map, rs_ihmap_cb cb, void *data)
+{
+	int ret;
+	struct rs_ihmap_node *node;
+	struct rs_ihmap_node *next;
+
+	if (map_is_invalid(map) || NULL == cb)
+		return -EINVAL;
+
+	for (node = rs_ihmap_first(map); node != NULL; node = next) {
+		/* retrieved first, the callback can remove the node */
+		next = rs_ihmap_next(map, node);
+		ret = cb(node, data);
+		if (ret != 0)
+			return ret;
+	}
+
+	return 0;
+}
+
+int rs_ihmap_clean_cb(struct rs_ihmap *map, rs_ihmap_cb cb, void *data)
+{
+	size_t i;
+	struct rs_ihmap_node *node;
+
+	if (NULL == map)
+		return -EINVAL;
+
+	for (i = 0; map->buckets != NULL && i <= map->mask; i++) {
+		while (map->buckets[i] != NULL) {
+			node = map->buckets[i];
+			unlink_node(map, node);
+			if (NULL != cb)
+				cb(node, data);
+		}
+	}
+	free(map->buckets);
+	memset(map, 0, sizeof(*map));
+
+	return 0;
+}
+
+int rs_ihmap_clean(struct rs_ihmap *map)
+{
+	return rs_ihmap_clean_cb(map, NULL, NULL);
+}
@@ -0,0 +1,651 @@
+/**
+ * @file rs_ohmap.c
+ * @date 19 oct. 2026
+ * @author nicolas.carrier@parrot.com
+ * @brief Hash map with open addressing, Robin Hood hashing and incremental
+ * growth.
+ *
+ * Each entry is placed as close as possible to the slot it's hash points to,
+ * the distance to this slot being stored along with the hash. On insertion,
+ * an entry takes the slot of any entry closer to it's own slot than itself,
+ * which is then re-inserted further, this keeps probe sequences short and
+ * allows a lookup to stop as soon as it finds an entry closer to it's slot
+ * than the key searched would be. Removal shifts back the following entries,
+ * so that no tombstone is needed.
+ * Whatever their type, keys are handled as byte strings, integer keys being
+ * their 8 bytes in native order.
+ *
+ * Copyright (C) 2026 Parrot S.A.
+ */
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <errno.h>
+
+#include <ut_string.h>
+
+#include "rs_hash.h"
+#include "rs_ohmap.h"
+
+/* number of slots of the smallest table */
+#define MIN_SLOTS 8
+
+/*
+ * number of slots of the previous table migrated per insertion or removal, the
+ * previous table is always emptied before the current one needs to grow
+ */
+#define MIGRATE_STEP 4
+
+/**
+ * @struct key
+ * @brief Key searched or inserted, integer keys point to their value
+ */
+struct key {
+	/** key bytes */
+	const void *ptr;
+	/** length of the key, without the NUL terminator of strings */
+	size_t len;
+};
+
+/**
+ * Computes the hash of a key, with the function configured for the map
+ * @param map Hash map
+ * @param key Key
+ * @return hash value
+ */
+static uint32_t hash_key(const struct rs_ohmap *map, const struct key *key)
+{
+	if (map->keys.hash == RS_OHMAP_HASH_FNV1A)
+		return rs_hash_fnv1a(key->ptr, key->len);
+
+	return rs_hash_wyhash(key->ptr, key->len);
+}
+
+/**
+ * Says whether the key of a slot matches a given key
+ * @param keys Configuration of the keys
+ * @param slot Slot
+ * @param key Key
+ * @return true if the keys are equal
+ */
+static bool slot_matches(const struct rs_ohmap_keys *keys,
+		const struct rs_ohmap_slot *slot, const struct key *key)
+{
+	if (keys->type == RS_OHMAP_KEY_U64)
+		return slot->key.u64 == *(const uint64_t *)key->ptr;
+
+	return slot->len == key->len &&
+			memcmp(slot->key.ptr, key->ptr, key->len) == 0;
+}
+
+/**
+ * Says whether the keys of a map are owned by it
+ * @param keys Configuration of the keys
+ * @return true if the keys are copies, which must be freed
+ */
+static bool keys_are_owned(const struct rs_ohmap_keys *keys)
+{
+	return keys->type != RS_OHMAP_KEY_U64 && !keys->borrowed;
+}
+
+/**
+ * Frees the key of a slot, if owned
+ * @param keys Configuration of the keys
+ * @param slot Slot
+ */
+static void slot_free_key(const struct rs_ohmap_keys *keys,
+		struct rs_ohmap_slot *slot)
+{
+	if (keys_are_owned(keys))
+		free((void *)slot->key.ptr);
+}
+
+/**
+ * Stores a key in a slot, copying it if the map owns it's keys
+ * @param keys Configuration of the keys
+ * @param slot Slot
+ * @param key Key
+ * @return Negative errno-compatible value on error, 0 on success
+ */
+static int slot_set_key(const struct rs_ohmap_keys *keys,
+		struct rs_ohmap_slot *slot, const struct key *key)
+{
+	void *copy;
+	/* the NUL terminator of strings is copied too */
+	size_t size = key->len + (keys->type == RS_OHMAP_KEY_STRING);
+
+	slot->len = key->len;
+	if (keys->type == RS_OHMAP_KEY_U64) {
+		slot->key.u64 = *(const uint64_t *)key->ptr;
+		return 0;
+	}
+	if (keys->borrowed) {
+		slot->key.ptr = key->ptr;
+		return 0;
+	}
+
+	copy = malloc(size);
+	if (NULL == copy)
+		return -ENOMEM;
+	memcpy(copy, key->ptr, size);
+	slot->key.ptr = copy;
+
+	return 0;
+}
+
+/**
+ * Returns the number of entries a table can store before having to grow
+ * @param nb_slots Number of slots of the table
+ * @return Maximum number of entries
+ */
+static size_t table_capacity(size_t nb_slots)
+{
+	return nb_slots - nb_slots / 8;
+}
+
+/**
+ * Allocates the slots of a table
+ * @param table Table
+ * @param nb_slots Number of slots, must be a power of 2
+ * @return Negative errno-compatible value on error, 0 on success
+ */
+static int table_init(struct rs_ohmap_table *table, size_t nb_slots)
+{
+	table->slots = calloc(nb_slots, sizeof(*table->slots));
+	if (NULL == table->slots)
+		return -ENOMEM;
+	table->mask = nb_slots - 1;
+	table->count = 0;
+
+	return 0;
+}
+
+/**
+ * Searches for a key in a table, the position where the search ended is where
+ * the key must be inserted, if it wasn't found
+ * @param table Table
+ * @param keys Configuration of the keys
+ * @param hash Hash of the key
+ * @param key Key
+ * @param pos In output, position where the search ended
+ * @param dib In output, distance of this position to the key's slot, plus one
+ * @return Slot of the key, NULL if not found
+ */
+static struct rs_ohmap_slot *table_probe(struct rs_ohmap_table *table,
+		const struct rs_ohmap_keys *keys, uint32_t hash,
+		const struct key *key, size_t *pos, uint32_t *dib)
+{
+	struct rs_ohmap_slot *slot;
+
+	*pos = hash & table->mask;
+	for (*dib = 1;; (*dib)++) {
+		slot = table->slots + *pos;
+		/* empty or closer to it's slot than the key would be */
+		if (slot->dib < *dib)
+			return NULL;
+		if (slot->hash == hash && slot_matches(keys, slot, key))
+			return slot;
+		*pos = (*pos + 1) & table->mask;
+	}
+}
+
+/**
+ * Searches for a key in a table
+ * @param table Table
+ * @param keys Configuration of the keys
+ * @param hash Hash of the key
+ * @param key Key
+ * @return Slot of the key, NULL if not found
+ */
+static struct rs_ohmap_slot *table_find(struct rs_ohmap_table *table,
+		const struct rs_ohmap_keys *keys, uint32_t hash,
+		const struct key *key)
+{
+	size_t pos;
+	uint32_t dib;
+
+	if (NULL == table->slots)
+		return NULL;
+
+	return table_probe(table, keys, hash, key, &pos, &dib);
+}
+
+/**
+ * Inserts an entry in a table, which must have room for it, starting at a
+ * given position of it's probe sequence, entries before being richer than it
+ * @param table Table
+ * @param pos Position to start from
+ * @param entry Entry to insert, dib set for pos
+ */
+static void table_put_at(struct rs_ohmap_table *table, size_t pos,
+		struct rs_ohmap_slot entry)
+{
+	struct rs_ohmap_slot *slot;
+	struct rs_ohmap_slot tmp;
+
+	for (;; entry.dib++) {
+		slot = table->slots + pos;
+		if (slot->dib == 0) {
+			*slot = entry;
+			table->count++;
+			return;
+		}
+		/* robin hood, takes from the rich to give to the poor */
+		if (slot->dib < entry.dib) {
+			tmp = *slot;
+			*slot = entry;
+			entry = tmp;
+		}
+		pos = (pos + 1) & table->mask;
+	}
+}
+
+/**
+ * Inserts an entry in a table, which must have room for it and not contain
+ * the key yet
+ * @param table Table
+ * @param entry Entry to insert, dib is ignored
+ */
+static void table_put(struct rs_ohmap_table *table, struct rs_ohmap_slot entry)
+{
+	entry.dib = 1;
+	table_put_at(table, entry.hash & table->mask, entry);
+}
+
+/**
+ * Removes an entry from a table, shifting back the entries following it, which
+ * aren't in their own slot
+ * @param table Table
+ * @param slot Slot of the entry to remove
+ */
+static void table_erase(struct rs_ohmap_table *table,
+		struct rs_ohmap_slot *slot)
+{
+	size_t pos = slot - table->slots;
+	size_t next;
+
+	for (;;) {
+		next = (pos + 1) & table->mask;
+		if (table->slots[next].dib <= 1)
+			break;
+		table->slots[pos] = table->slots[next];
+		table->slots[pos].dib--;
+		pos = next;
+	}
+	memset(table->slots + pos, 0, sizeof(*table->slots));
+	table->count--;
+}
+
+/**
+ * Frees the entries and the slots of a table
+ * @param table Table
+ * @param keys Configuration of the keys
+ * @param free_cb Callback called on each entry's data, can be NULL
+ */
+static void table_clean(struct rs_ohmap_table *table,
+		const struct rs_ohmap_keys *keys, void (*free_cb)(void *))
+{
+	size_t i;
+	struct rs_ohmap_slot *slot;
+
+	for (i = 0; table->slots != NULL && i <= table->mask; i++) {
+		slot = table->slots + i;
+		if (slot->dib == 0)
+			continue;
+		if (NULL != free_cb)
+			free_cb(slot->data);
+		slot_free_key(keys, slot);
+	}
+	free(table->slots);
+	memset(table, 0, sizeof(*table));
+}
+
+/**
+ * Moves entries from the previous table to the current one
+ * @param map Hash map
+ * @param steps Number of slots of the previous table to process
+ */
+static void migrate(struct rs_ohmap *map, size_t steps)
+{
+	struct rs_ohmap_slot *slot;
+	struct rs_ohmap_slot entry;
+
+	if (NULL == map->old.slots)
+		return;
+
+	while (steps-- > 0 && map->old.count > 0) {
+		slot = map->old.slots + map->migrated;
+		/* the erasure can shift the next entry in the slot */
+		while (slot->dib != 0) {
+			entry = *slot;
+			table_erase(&map->old, slot);
+			table_put(&map->table, entry);
+		}
+		map->migrated++;
+	}
+
+	if (map->old.count == 0) {
+		free(map->old.slots);
+		memset(&map->old, 0, sizeof(map->old));
+		map->migrated = 0;
+	}
+}
+
+/**
+ * Doubles the size of the current table, the previous being emptied first if
+ * still in use. Entries will be migrated progressively from the current table
+ * which becomes the previous one
+ * @param map Hash map
+ * @return Negative errno-compatible value on error, 0 on success
+ */
+static int grow(struct rs_ohmap *map)
+{
+	int ret;
+	struct rs_ohmap_table table;
+
+	migrate(map, SIZE_MAX);
+	ret = table_init(&table, 2 * (map->table.mask + 1));
+	if (ret < 0)
+		return ret;
+	map->old = map->table;
+	map->table = table;
+	map->migrated = 0;
+
+	return 0;
+}
+
+/**
+ * Says whether or not a hash map is valid
+ * @param map Hash map to test
+ * @return non-zero if the hash map is invalid, 0 otherwise
+ */
+static int map_is_invalid(struct rs_ohmap *map)
+{
+	return NULL == map || NULL == map->table.slots;
+}
+
+/**
+ * Searches for a key in both tables of a map
+ * @param map Hash map
+ * @param hash Hash of the key
+ * @param key Key
+ * @param table In output, table the key was found in
+ * @return Slot of the key, NULL if not found
+ */
+static struct rs_ohmap_slot *map_find(struct rs_ohmap *map, uint32_t hash,
+		const struct key *key, struct rs_ohmap_table **table)
+{
+	struct rs_ohmap_slot *slot;
+
+	*table = &map->table;
+	slot = table_find(*table, &map->keys, hash, key);
+	if (NULL != slot)
+		return slot;
+	*table = &map->old;
+
+	return table_find(*table, &map->keys, hash, key);
+}
+
+/**
+ * Says whether or not a configuration of keys is valid
+ * @param keys Configuration to test
+ * @return non-zero if the configuration is invalid, 0 otherwise
+ */
+static int keys_are_invalid(const struct rs_ohmap_keys *keys)
+{
+	switch (keys->type) {
+	case RS_OHMAP_KEY_STRING:
+	case RS_OHMAP_KEY_BYTES:
+	case RS_OHMAP_KEY_U64:
+		break;
+
+	default:
+		return 1;
+	}
+
+	return keys->hash != RS_OHMAP_HASH_WYHASH &&
+			keys->hash != RS_OHMAP_HASH_FNV1A;
+}
+
+/**
+ * Lookup an entry in hash map, once the key is validated
+ * @param map Hash map
+ * @param key Key
+ * @param data In output, a pointer to a matching data, or to NULL if no entry
+ * was found
+ * @return -ENOENT if the entry wasn't found, 0 on success
+ */
+static int map_lookup(struct rs_ohmap *map, const struct key *key, void **data)
+{
+	struct rs_ohmap_slot *slot;
+	struct rs_ohmap_table *table;
+
+	slot = map_find(map, hash_key(map, key), key, &table);
+	*data = NULL == slot ? NULL : slot->data;
+
+	return NULL == slot ? -ENOENT : 0;
+}
+
+/**
+ * Insert an entry in hash map, once the key is validated
+ * @param map Hash map
+ * @param key Key
+ * @param data Piece of data to associate with the key
+ * @return Negative errno-compatible value on error, -EEXIST if the key is
+ * already present, 0 on success
+ */
+static int map_insert(struct rs_ohmap *map, const struct key *key, void *data)
+{
+	int ret;
+	size_t pos;
+	struct rs_ohmap_slot entry = {.data = data};
+
+	migrate(map, MIGRATE_STEP);
+	if (rs_ohmap_get_count(map) >= table_capacity(map->table.mask + 1)) {
+		ret = grow(map);
+		if (ret < 0)
+			return ret;
+	}
+
+	/* the search in the current table stops where the key must go */
+	entry.hash = hash_key(map, key);
+	if (NULL != table_find(&map->old, &map->keys, entry.hash, key) ||
+			NULL != table_probe(&map->table, &map->keys, entry.hash,
+					key, &pos, &entry.dib))
+		return -EEXIST;
+
+	ret = slot_set_key(&map->keys, &entry, key);
+	if (ret < 0)
+		return ret;
+	table_put_at(&map->table, pos, entry);
+
+	return 0;
+}
+
+/**
+ * Remove an entry from hash map, once the key is validated
+ * @param map Hash map
+ * @param key Key
+ * @param data In output, a pointer to a matching data, or NULL if no entry was
+ * found. Can be NULL
+ * @return -ENOENT if the entry wasn't found, 0 on success
+ */
+static int map_remove(struct rs_ohmap *map, const struct key *key, void **data)
+{
+	struct rs_ohmap_slot *slot;
+	struct rs_ohmap_table *table;
+
+	if (NULL != data)
+		*data = NULL;
+
+	migrate(map, MIGRATE_STEP);
+	slot = map_find(map, hash_key(map, key), key, &table);
+	if (NULL == slot)
+		return -ENOENT;
+
+	if (NULL != data)
+		*data = slot->data;
+	slot_free_key(&map->keys, slot);
+	table_erase(table, slot);
+	migrate(map, 0);
+
+	return 0;
+}
+
+/**
+ * Says whether or not a string key can be used with a hash map
+ * @param map Hash map
+ * @param key String key
+ * @return non-zero if the map or the key is invalid, 0 otherwise
+ */
+static int string_key_is_invalid(struct rs_ohmap *map, const char *key)
+{
+	return map_is_invalid(map) || map->keys.type != RS_OHMAP_KEY_STRING ||
+			ut_string_is_invalid(key);
+}
+
+/**
+ * Says whether or not a byte key can be used with a hash map
+ * @param map Hash map
+ * @param key Byte key
+ * @param len Length of the key
+ * @return non-zero if the map or the key is invalid, 0 otherwise
+ */
+static int bytes_key_is_invalid(struct rs_ohmap *map, const void *key,
+		size_t len)
+{
+	return map_is_invalid(map) || map->keys.type != RS_OHMAP_KEY_BYTES ||
+			NULL == key || 0 == len;
+}
+
+/**
+ * Says whether or not an integer key can be used with a hash map
+ * @param map Hash map
+ * @return non-zero if the map is invalid or hasn't integer keys, 0 otherwise
+ */
+static int u64_key_is_invalid(struct rs_ohmap *map)
+{
+	return map_is_invalid(map) || map->keys.type != RS_OHMAP_KEY_U64;
+}
+
+int rs_ohmap_init(struct rs_ohmap *map, size_t size)
+{
+	return rs_ohmap_init_keys(map, size, NULL);
+}
+
+int rs_ohmap_init_keys(struct rs_ohmap *map, size_t size,
+		const struct rs_ohmap_keys *keys)
+{
+	size_t nb_slots = MIN_SLOTS;
+
+	if (NULL == map || (NULL != keys && keys_are_invalid(keys)))
+		return -EINVAL;
+
+	while (table_capacity(nb_slots) < size) {
+		if (nb_slots > SIZE_MAX / 2 / sizeof(struct rs_ohmap_slot))
+			return -E2BIG;
+		nb_slots *= 2;
+	}
+
+	memset(map, 0, sizeof(*map));
+	if (NULL != keys)
+		map->keys = *keys;
+
+	return table_init(&map->table, nb_slots);
+}
+
+int rs_ohmap_lookup(struct rs_ohmap *map, const char *key, void **data)
+{
+	if (string_key_is_invalid(map, key) || NULL == data)
+		return -EINVAL;
+
+	return map_lookup(map, &(struct key){key, strlen(key)}, data);
+}
+
+int rs_ohmap_insert(struct rs_ohmap *map, const char *key, void *data)
+{
+	if (string_key_is_invalid(map, key))
+		return -EINVAL;
+
+	return map_insert(map, &(struct key){key, strlen(key)}, data);
+}
+
+int rs_ohmap_remove(struct rs_ohmap *map, const char *key, void **data)
+{
+	if (string_key_is_invalid(map, key))
+		return -EINVAL;
+
+	return map_remove(map, &(struct key){key, strlen(key)}, data);
+}
+
+int rs_ohmap_lookup_bytes(struct rs_ohmap *map, const void *key, size_t len,
+		void **data)
+{
+	if (bytes_key_is_invalid(map, key, len) || NULL == data)
+		return -EINVAL;
+
+	return map_lookup(map, &(struct key){key, len}, data);
+}
+
+int rs_ohmap_insert_bytes(struct rs_ohmap *map, const void *key, size_t len,
+		void *data)
+{
+	if (bytes_key_is_invalid(map, key, len))
+		return -EINVAL;
+
+	return map_insert(map, &(struct key){key, len}, data);
+}
+
+int rs_ohmap_remove_bytes(struct rs_ohmap *map, const void *key, size_t len,
+		void **data)
+{
+	if (bytes_key_is_invalid(map, key, len))
+		return -EINVAL;
+
+	return map_remove(map, &(struct key){key, len}, data);
+}
+
+int rs_ohmap_lookup_u64(struct rs_ohmap *map, uint64_t key, void **data)
+{
+	if (u64_key_is_invalid(map) || NULL == data)
+		return -EINVAL;
+
+	return map_lookup(map, &(struct key){&key, sizeof(key)}, data);
+}
+
+int rs_ohmap_insert_u64(struct rs_ohmap *map, uint64_t key, void *data)
+{
+	if (u64_key_is_invalid(map))
+		return -EINVAL;
+
+	return map_insert(map, &(struct key){&key, sizeof(key)}, data);
+}
+
+int rs_ohmap_remove_u64(struct rs_ohmap *map, uint64_t key, void **data)
+{
+	if (u64_key_is_invalid(map))
+		return -EINVAL;
+
+	return map_remove(map, &(struct key){&key, sizeof(key)}, data);
+}
+
+int rs_ohmap_clean_cb(struct rs_ohmap *map, void (*free_cb)(void *))
+{
+	if (NULL == map)
+		return -EINVAL;
+
+	table_clean(&map->table, &map->keys, free_cb);
+	table_clean(&map->old, &map->keys, free_cb);
+	map->migrated = 0;
+
+	return 0;
+}
+
+int rs_ohmap_clean(struct rs_ohmap *map)
+{
+	return rs_ohmap_clean_cb(map, NULL);
+}
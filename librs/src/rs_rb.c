@@ -12,11 +12,16 @@
  */
 #define _GNU_SOURCE         /* See feature_test_macros(7) */
 #include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
 
+#include <fcntl.h>
 #include <unistd.h>
 
 #include <assert.h>
 #include <errno.h>
+#include <stdint.h>
+#include <stdio.h>
 #include <string.h>
 
 #include <rs_rb.h>
@@ -32,65 +37,322 @@
 	})
 
 /**
- * Allocates a buffer of the given size, but mapped consecutively twice in
- * memory, to avoid wrapping at the (first) end of the buffer
- * @param rb ring buffer
- * @param size size requested for the buffer, must be a multiple of page_size
- * @param page_size actual page_size in the system
+ * Returns the size of the huge pages used by transparent huge pages
+ * @return size of a THP, 0 if unknown
+ */
+static size_t get_thp_size(void)
+{
+	FILE *f;
+	unsigned long thp_size = 0;
+
+	f = fopen("/sys/kernel/mm/transparent_hugepage/hpage_pmd_size", "re");
+	if (f == NULL)
+		return 0;
+	if (fscanf(f, "%lu", &thp_size) != 1)
+		thp_size = 0;
+	fclose(f);
+
+	return thp_size;
+}
+
+/**
+ * Maps a file twice consecutively in memory, to avoid wrapping at the (first)
+ * end of the buffer
+ * @param rb ring buffer, it's base is set on success
+ * @param fd file to map
+ * @param offset offset of the buffer in the file, a multiple of align
+ * @param size size of the buffer, must be a multiple of align
+ * @param align alignment of the mappings, a power of two, multiple of the size
+ * of a page
  * @return errno-compatible negative value on error, 0 otherwise
  */
-static int allocate_mirrored_buffer(struct rs_rb *rb, size_t size,
-		long page_size)
+static int map_mirrored(struct rs_rb *rb, int fd, off_t offset, size_t size,
+		size_t align)
 {
 	int ret;
+	char *area;
+	char *base;
+	size_t area_size = 2 * size + align;
 
-	rb->base = mmap(NULL, 2 * size, PROT_READ | PROT_WRITE,
-			MAP_SHARED | MAP_ANONYMOUS, -1, 0);
-	if (rb->base == MAP_FAILED)
+	/*
+	 * reserve a range large enough to be aligned, in which the two
+	 * mappings replace the reservation
+	 */
+	area = mmap(NULL, area_size, PROT_NONE,
+			MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+	if (area == MAP_FAILED)
 		return -errno;
+	base = (char *)(((uintptr_t)area + align - 1) &
+			~(uintptr_t)(align - 1));
+
+	if (mmap(base, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED,
+			fd, offset) == MAP_FAILED ||
+			mmap(base + size, size, PROT_READ | PROT_WRITE,
+					MAP_SHARED | MAP_FIXED, fd, offset) ==
+					MAP_FAILED) {
+		ret = -errno;
+		munmap(area, area_size);
+		return ret;
+	}
 
-	ret = remap_file_pages(rb->base, size, 0, (size / page_size), 0);
-	if (ret == -1)
-		return -errno;
+	/* release the parts of the reservation left unused */
+	if (base != area)
+		munmap(area, base - area);
+	if (base + 2 * size != area + area_size)
+		munmap(base + 2 * size, area + area_size - (base + 2 * size));
+	rb->base = base;
 
 	return 0;
 }
 
-int rs_rb_init(struct rs_rb *rb, void *buffer, size_t size)
+/**
+ * Describes a span of the buffer with at most two iovecs, only one if it
+ * doesn't wrap, or if the buffer is mirrored
+ * @param rb ring buffer
+ * @param start offset of the span
+ * @param length length of the span, at most the size of the buffer
+ * @param iov in output, the iovecs, only those returned are filled
+ * @return number of iovecs filled
+ */
+static int fill_iovec(struct rs_rb *rb, size_t start, size_t length,
+		struct iovec iov[2])
 {
-	/*
-	 * this initialization is absurd, but it is to silence gcc which issues
-	 * a warning because it isn't smart enough to see that page_size is
-	 * initialized AND used iif rb->mirror is true
-	 */
-	long page_size = 0;
+	size_t first;
 
-	if (rb == NULL)
-		return -EINVAL;
-	rb->mirror = buffer == NULL;
-	if (rb->mirror) {
-		/* augment size to the next multiple of page size */
-		page_size = sysconf(_SC_PAGE_SIZE);
-		if ((size % page_size) != 0)
-			size = ((size / page_size) + 1) * page_size;
+	if (length == 0)
+		return 0;
+
+	first = rb->mirror ? length : rb->size - start;
+	iov[0].iov_base = (char *)rb->base + start;
+	if (length <= first) {
+		iov[0].iov_len = length;
+		return 1;
 	}
+	iov[0].iov_len = first;
+	iov[1].iov_base = rb->base;
+	iov[1].iov_len = length - first;
 
-	if (!is_power_of_two(size))
-		return -EINVAL;
+	return 2;
+}
+
+/**
+ * Copies data stored in the buffer, which may wrap
+ * @param rb ring buffer
+ * @param start offset of the data
+ * @param buf destination
+ * @param length length of the data
+ */
+static void copy_from(struct rs_rb *rb, size_t start, void *buf,
+		size_t length)
+{
+	size_t first = rb->size - start;
 
+	if (length <= first) {
+		memcpy(buf, (char *)rb->base + start, length);
+	} else {
+		memcpy(buf, (char *)rb->base + start, first);
+		memcpy((char *)buf + first, rb->base, length - first);
+	}
+}
+
+/**
+ * Compares data stored in the buffer, which may wrap, to a string of bytes
+ * @param rb ring buffer
+ * @param start offset of the data
+ * @param needle bytes to compare to
+ * @param length length of the data and of needle
+ * @return true if they are equal
+ */
+static bool equals_at(struct rs_rb *rb, size_t start, const void *needle,
+		size_t length)
+{
+	size_t first = rb->size - start;
+
+	if (length <= first)
+		return memcmp((char *)rb->base + start, needle, length) == 0;
+
+	return memcmp((char *)rb->base + start, needle, first) == 0 &&
+			memcmp(rb->base, (const char *)needle + first,
+					length - first) == 0;
+}
+
+/**
+ * Searches a string of bytes in a contiguous region
+ * @param haystack region to search in
+ * @param length length of the region
+ * @param needle bytes to search for
+ * @param needle_len length of needle
+ * @return first occurrence of needle, NULL if none
+ */
+static const char *search(const char *haystack, size_t length,
+		const void *needle, size_t needle_len)
+{
+	if (needle_len == 1)
+		return memchr(haystack, *(const char *)needle, length);
+
+	return memmem(haystack, length, needle, needle_len);
+}
+
+/**
+ * Initializes the fields of a ring buffer
+ * @param rb ring buffer
+ * @param buffer memory buffer
+ * @param size size of the buffer, a power of two
+ * @param mirror true if buffer is mapped twice
+ * @param fd memfd backing the buffer, kept open, or -1
+ */
+static void set_buffer(struct rs_rb *rb, void *buffer, size_t size,
+		bool mirror, int fd)
+{
 	rb->base = buffer;
 	rb->size = size;
 	rb->size_mask = size - 1;
 	rb->read = 0;
 	rb->write = 0;
 	rb->len = 0;
+	rb->mirror = mirror;
+	rb->fd = fd;
+}
+
+int rs_rb_init(struct rs_rb *rb, void *buffer, size_t size)
+{
+	if (buffer == NULL)
+		return rs_rb_init_mirrored(rb, size, 0);
+	if (rb == NULL || !is_power_of_two(size))
+		return -EINVAL;
+
+	set_buffer(rb, buffer, size, false, -1);
+
+	return 0;
+}
+
+int rs_rb_init_mirrored(struct rs_rb *rb, size_t size, unsigned flags)
+{
+	int ret;
+	int fd;
+	struct stat st;
+	size_t page_size;
+	size_t align;
+	size_t thp_size;
+	unsigned mfd_flags = MFD_CLOEXEC;
+
+	if (rb == NULL || (flags & ~RS_RB_FLAGS) != 0)
+		return -EINVAL;
+
+	if (flags & RS_RB_HUGETLB)
+		mfd_flags |= MFD_HUGETLB;
+	if (flags & RS_RB_SHARED)
+		mfd_flags |= MFD_ALLOW_SEALING;
+	fd = memfd_create("rs_rb", mfd_flags);
+	if (fd == -1)
+		return -errno;
+
+	/* the block size of a hugetlb file is the size of it's pages */
+	if (fstat(fd, &st) == -1) {
+		ret = -errno;
+		goto err;
+	}
+	page_size = st.st_blksize;
+	/* augment size to the next multiple of page size */
+	if ((size % page_size) != 0)
+		size = ((size / page_size) + 1) * page_size;
+	if (!is_power_of_two(size) || !is_power_of_two(page_size)) {
+		ret = -EINVAL;
+		goto err;
+	}
+	if (ftruncate(fd, size) == -1) {
+		ret = -errno;
+		goto err;
+	}
+	/* the peer can't shrink the file under our feet, causing SIGBUS */
+	if ((flags & RS_RB_SHARED) && fcntl(fd, F_ADD_SEALS,
+			F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_SEAL) == -1) {
+		ret = -errno;
+		goto err;
+	}
+
+	/* huge pages can only back mappings aligned on their size */
+	align = page_size;
+	if (flags & RS_RB_THP) {
+		thp_size = get_thp_size();
+		if (thp_size > align && size >= thp_size &&
+				is_power_of_two(thp_size))
+			align = thp_size;
+	}
+	ret = map_mirrored(rb, fd, 0, size, align);
+	if (ret < 0)
+		goto err;
+	/* only a hint, the kernel can be configured to ignore it */
+	if (flags & RS_RB_THP)
+		madvise(rb->base, 2 * size, MADV_HUGEPAGE);
+
+	if (!(flags & RS_RB_SHARED)) {
+		close(fd);
+		fd = -1;
+	}
+	set_buffer(rb, rb->base, size, true, fd);
+
+	return 0;
+err:
+	close(fd);
+
+	return ret;
+}
+
+int rs_rb_init_from_fd(struct rs_rb *rb, int fd)
+{
+	struct stat st;
 
-	if (rb->mirror)
-		return allocate_mirrored_buffer(rb, size, page_size);
+	if (rb == NULL || fd < 0)
+		return -EINVAL;
+
+	if (fstat(fd, &st) == -1)
+		return -errno;
+
+	return rs_rb_init_from_fd_at(rb, fd, 0, st.st_size);
+}
+
+int rs_rb_init_from_fd_at(struct rs_rb *rb, int fd, off_t offset, size_t size)
+{
+	int ret;
+	int seals;
+	struct stat st;
+	size_t block_size;
+
+	if (rb == NULL || fd < 0 || offset < 0)
+		return -EINVAL;
+
+	/* a peer shrinking the file would make accessing the buffer SIGBUS */
+	seals = fcntl(fd, F_GET_SEALS);
+	if (seals == -1)
+		return -errno;
+	if (!(seals & F_SEAL_SHRINK))
+		return -EPERM;
+	if (fstat(fd, &st) == -1)
+		return -errno;
+	block_size = st.st_blksize;
+	if (!is_power_of_two(size) || !is_power_of_two(block_size) ||
+			(size % block_size) != 0 ||
+			((size_t)offset % block_size) != 0 ||
+			(size_t)offset > (size_t)st.st_size ||
+			size > (size_t)st.st_size - (size_t)offset)
+		return -EINVAL;
+	ret = map_mirrored(rb, fd, offset, size, block_size);
+	if (ret < 0)
+		return ret;
+	set_buffer(rb, rb->base, size, true, -1);
 
 	return 0;
 }
 
+int rs_rb_get_fd(const struct rs_rb *rb)
+{
+	if (rb == NULL)
+		return -EINVAL;
+
+	return rb->mirror && rb->fd >= 0 ? rb->fd : -EBADF;
+}
+
 size_t rs_rb_get_size(struct rs_rb *rb)
 {
 	return NULL == rb ? 0 : rb->size;
@@ -119,6 +381,8 @@ int rs_rb_clean(struct rs_rb *rb)
 		ret = munmap(rb->base, 2 * rb->size);
 		if (ret == -1)
 			ret = -errno;
+		if (rb->fd >= 0)
+			close(rb->fd);
 	}
 
 	memset(rb, 0, sizeof(*rb));
@@ -205,3 +469,149 @@ int rs_rb_write_incr(struct rs_rb *rb, size_t length)
 
 	return 0;
 }
+
+int rs_rb_get_read_iovec(struct rs_rb *rb, struct iovec iov[2])
+{
+	if (NULL == rb || NULL == iov)
+		return -EINVAL;
+
+	return fill_iovec(rb, rb->read, rb->len, iov);
+}
+
+int rs_rb_get_write_iovec(struct rs_rb *rb, struct iovec iov[2])
+{
+	if (NULL == rb || NULL == iov)
+		return -EINVAL;
+
+	return fill_iovec(rb, rb->write, rb->size - rb->len, iov);
+}
+
+int rs_rb_peek(struct rs_rb *rb, size_t offset, void *buf, size_t length)
+{
+	if (NULL == rb || (NULL == buf && length != 0))
+		return -EINVAL;
+	if (offset > rb->len || length > rb->len - offset)
+		return -ENOSR;
+
+	copy_from(rb, (rb->read + offset) & rb->size_mask, buf, length);
+
+	return 0;
+}
+
+int rs_rb_copy_out(struct rs_rb *rb, void *buf, size_t length)
+{
+	int ret;
+
+	ret = rs_rb_peek(rb, 0, buf, length);
+	if (ret < 0)
+		return ret;
+
+	return rs_rb_read_incr(rb, length);
+}
+
+int rs_rb_copy_in(struct rs_rb *rb, const void *buf, size_t length)
+{
+	size_t first;
+
+	if (NULL == rb || (NULL == buf && length != 0))
+		return -EINVAL;
+	if (length > rb->size - rb->len)
+		return -ENOBUFS;
+
+	first = rb->size - rb->write;
+	if (length <= first) {
+		memcpy((char *)rb->base + rb->write, buf, length);
+	} else {
+		memcpy((char *)rb->base + rb->write, buf, first);
+		memcpy(rb->base, (const char *)buf + first, length - first);
+	}
+
+	return rs_rb_write_incr(rb, length);
+}
+
+int rs_rb_search(struct rs_rb *rb, size_t offset, const void *needle,
+		size_t needle_len, size_t *position)
+{
+	const char *base;
+	const char *found;
+	size_t start;
+	size_t first;
+	size_t length;
+	size_t i;
+
+	if (NULL == rb || NULL == needle || needle_len == 0 ||
+			NULL == position)
+		return -EINVAL;
+	if (offset > rb->len || needle_len > rb->len - offset)
+		return -ENOENT;
+
+	base = rb->base;
+	start = (rb->read + offset) & rb->size_mask;
+	length = rb->len - offset;
+	/* thanks to the mirroring, the data stored is contiguous */
+	first = rb->mirror ? length : rb->size - start;
+	if (first > length)
+		first = length;
+	found = search(base + start, first, needle, needle_len);
+	if (found != NULL) {
+		*position = offset + (found - (base + start));
+		return 0;
+	}
+	if (first == length)
+		return -ENOENT;
+
+	/* occurrences straddling the end of the buffer */
+	i = first >= needle_len ? first - needle_len + 1 : 0;
+	for (; i < first && i + needle_len <= length; i++)
+		if (equals_at(rb, start + i, needle, needle_len)) {
+			*position = offset + i;
+			return 0;
+		}
+
+	found = search(base, length - first, needle, needle_len);
+	if (found == NULL)
+		return -ENOENT;
+	*position = offset + first + (found - base);
+
+	return 0;
+}
+
+ssize_t rs_rb_read_from_fd(struct rs_rb *rb, int fd)
+{
+	struct iovec iov[2];
+	ssize_t ret;
+	int nb;
+
+	if (NULL == rb || fd < 0)
+		return -EINVAL;
+
+	nb = rs_rb_get_write_iovec(rb, iov);
+	if (nb == 0)
+		return -ENOBUFS;
+	ret = readv(fd, iov, nb);
+	if (ret == -1)
+		return -errno;
+	rs_rb_write_incr(rb, ret);
+
+	return ret;
+}
+
+ssize_t rs_rb_write_to_fd(struct rs_rb *rb, int fd)
+{
+	struct iovec iov[2];
+	ssize_t ret;
+	int nb;
+
+	if (NULL == rb || fd < 0)
+		return -EINVAL;
+
+	nb = rs_rb_get_read_iovec(rb, iov);
+	if (nb == 0)
+		return 0;
+	ret = writev(fd, iov, nb);
+	if (ret == -1)
+		return -errno;
+	rs_rb_read_incr(rb, ret);
+
+	return ret;
+}
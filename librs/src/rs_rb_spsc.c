@@ -0,0 +1,213 @@
+/**
+ * @file rs_rb_spsc.c
+ * @date 19 oct. 2026
+ * @author nicolas.carrier@parrot.com
+ * @brief Single producer, single consumer ring buffer implementation.
+ *
+ * data stored into the ring buffer span from spsc->read included to
+ * spsc->write excluded, both indices only ever increase, they are reduced
+ * with the size mask of the buffer to give offsets. Each side loads the
+ * other's index with acquire semantics, which pairs with the release store
+ * publishing it, so that the data written before an index is published is
+ * visible to whom sees the index.
+ *
+ * Copyright (C) 2026 Parrot S.A.
+ */
+#include <errno.h>
+#include <string.h>
+
+#include <rs_rb_spsc.h>
+
+/**
+ * Returns the offset in the buffer of an index
+ * @param spsc Ring buffer
+ * @param index Read or write index
+ * @return Offset
+ */
+static size_t offset(const struct rs_rb_spsc *spsc, size_t index)
+{
+	return index & spsc->rb.size_mask;
+}
+
+/**
+ * Limits a length to the end of the buffer, if it isn't mirrored
+ * @param spsc Ring buffer
+ * @param index Index the span starts at
+ * @param length Length of the span
+ * @return Length of the span which doesn't wrap
+ */
+static size_t no_wrap(const struct rs_rb_spsc *spsc, size_t index,
+		size_t length)
+{
+	size_t end;
+
+	if (spsc->rb.mirror)
+		return length;
+	end = spsc->rb.size - offset(spsc, index);
+
+	return length < end ? length : end;
+}
+
+/**
+ * Loads the producer's index, consumer side
+ * @param spsc Ring buffer
+ * @return Number of bytes available to read
+ */
+static size_t refresh_write(struct rs_rb_spsc *spsc)
+{
+	spsc->write_cache = __atomic_load_n(&spsc->write, __ATOMIC_ACQUIRE);
+
+	return spsc->write_cache - spsc->read;
+}
+
+/**
+ * Loads the consumer's index, producer side
+ * @param spsc Ring buffer
+ * @return Number of bytes of room available to write
+ */
+static size_t refresh_read(struct rs_rb_spsc *spsc)
+{
+	spsc->read_cache = __atomic_load_n(&spsc->read, __ATOMIC_ACQUIRE);
+
+	return spsc->rb.size - (spsc->write - spsc->read_cache);
+}
+
+int rs_rb_spsc_init(struct rs_rb_spsc *spsc, void *buffer, size_t size)
+{
+	if (NULL == spsc)
+		return -EINVAL;
+
+	memset(spsc, 0, sizeof(*spsc));
+
+	return rs_rb_init(&spsc->rb, buffer, size);
+}
+
+size_t rs_rb_spsc_get_size(const struct rs_rb_spsc *spsc)
+{
+	return NULL == spsc ? 0 : spsc->rb.size;
+}
+
+int rs_rb_spsc_clean(struct rs_rb_spsc *spsc)
+{
+	int ret;
+
+	if (NULL == spsc)
+		return -EINVAL;
+
+	ret = rs_rb_clean(&spsc->rb);
+	memset(spsc, 0, sizeof(*spsc));
+
+	return ret;
+}
+
+void *rs_rb_spsc_get_read_ptr(struct rs_rb_spsc *spsc)
+{
+	if (NULL == spsc || NULL == spsc->rb.base)
+		return NULL;
+
+	return (char *)spsc->rb.base + offset(spsc, spsc->read);
+}
+
+size_t rs_rb_spsc_get_read_length(struct rs_rb_spsc *spsc)
+{
+	return NULL == spsc ? 0 : refresh_write(spsc);
+}
+
+size_t rs_rb_spsc_get_read_length_no_wrap(struct rs_rb_spsc *spsc)
+{
+	if (NULL == spsc)
+		return 0;
+
+	return no_wrap(spsc, spsc->read, refresh_write(spsc));
+}
+
+int rs_rb_spsc_read_incr(struct rs_rb_spsc *spsc, size_t length)
+{
+	if (NULL == spsc)
+		return -EINVAL;
+	if (length > spsc->write_cache - spsc->read &&
+			length > refresh_write(spsc))
+		return -ENOSR;
+
+	/* the producer can reuse the space once it sees the new index */
+	__atomic_store_n(&spsc->read, spsc->read + length, __ATOMIC_RELEASE);
+
+	return 0;
+}
+
+int rs_rb_spsc_read(struct rs_rb_spsc *spsc, void *buf, size_t length)
+{
+	size_t first;
+
+	if (NULL == spsc || NULL == spsc->rb.base ||
+			(NULL == buf && length != 0))
+		return -EINVAL;
+	if (length > spsc->write_cache - spsc->read &&
+			length > refresh_write(spsc))
+		return -EAGAIN;
+	if (length == 0)
+		return 0;
+
+	first = no_wrap(spsc, spsc->read, length);
+	memcpy(buf, (char *)spsc->rb.base + offset(spsc, spsc->read), first);
+	memcpy((char *)buf + first, spsc->rb.base, length - first);
+	__atomic_store_n(&spsc->read, spsc->read + length, __ATOMIC_RELEASE);
+
+	return 0;
+}
+
+void *rs_rb_spsc_get_write_ptr(struct rs_rb_spsc *spsc)
+{
+	if (NULL == spsc || NULL == spsc->rb.base)
+		return NULL;
+
+	return (char *)spsc->rb.base + offset(spsc, spsc->write);
+}
+
+size_t rs_rb_spsc_get_write_length(struct rs_rb_spsc *spsc)
+{
+	return NULL == spsc ? 0 : refresh_read(spsc);
+}
+
+size_t rs_rb_spsc_get_write_length_no_wrap(struct rs_rb_spsc *spsc)
+{
+	if (NULL == spsc)
+		return 0;
+
+	return no_wrap(spsc, spsc->write, refresh_read(spsc));
+}
+
+int rs_rb_spsc_write_incr(struct rs_rb_spsc *spsc, size_t length)
+{
+	if (NULL == spsc)
+		return -EINVAL;
+	if (length > spsc->rb.size - (spsc->write - spsc->read_cache) &&
+			length > refresh_read(spsc))
+		return -ENOBUFS;
+
+	/* the data written is visible to whom sees the new index */
+	__atomic_store_n(&spsc->write, spsc->write + length, __ATOMIC_RELEASE);
+
+	return 0;
+}
+
+int rs_rb_spsc_write(struct rs_rb_spsc *spsc, const void *buf, size_t length)
+{
+	size_t first;
+
+	if (NULL == spsc || NULL == spsc->rb.base ||
+			(NULL == buf && length != 0))
+		return -EINVAL;
+	if (length > spsc->rb.size - (spsc->write - spsc->read_cache) &&
+			length > refresh_read(spsc))
+		return -EAGAIN;
+	if (length == 0)
+		return 0;
+
+	first = no_wrap(spsc, spsc->write, length);
+	memcpy((char *)spsc->rb.base + offset(spsc, spsc->write), buf, first);
+	memcpy(spsc->rb.base, (const char *)buf + first, length - first);
+	__atomic_store_n(&spsc->write, spsc->write + length, __ATOMIC_RELEASE);
+
+	return 0;
+}
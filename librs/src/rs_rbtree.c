@@ -0,0 +1,434 @@
+/**
+ * @file rs_rbtree.c
+ * @date 19 oct. 2026
+ * @author nicolas.carrier@parrot.com
+ * @brief Intrusive red-black tree implementation. Leaves are NULL pointers,
+ * considered black.
+ *
+ * Copyright (C) 2026 Parrot S.A.
+ */
+#include <string.h>
+#include <errno.h>
+
+#include "rs_rbtree.h"
+
+/**
+ * Says whether or not a node is red, NULL leaves being black
+ * @param node Node, can be NULL
+ * @return non-zero if the node is red, 0 otherwise
+ */
+static int is_red(const struct rs_rbtree_node *node)
+{
+	return NULL != node && node->red;
+}
+
+/**
+ * Puts a node at the place of another one, in the latter's parent
+ * @param tree Red-black tree
+ * @param node Node replaced
+ * @param by Node replacing node, can be NULL
+ */
+static void replace_child(struct rs_rbtree *tree, struct rs_rbtree_node *node,
+		struct rs_rbtree_node *by)
+{
+	struct rs_rbtree_node *parent = node->parent;
+
+	if (NULL != by)
+		by->parent = parent;
+	if (NULL == parent)
+		tree->root = by;
+	else if (parent->left == node)
+		parent->left = by;
+	else
+		parent->right = by;
+}
+
+/**
+ * Rotates a node with it's right child, which becomes it's parent
+ * @param tree Red-black tree
+ * @param node Node to rotate, must have a right child
+ */
+static void rotate_left(struct rs_rbtree *tree, struct rs_rbtree_node *node)
+{
+	struct rs_rbtree_node *right = node->right;
+
+	node->right = right->left;
+	if (NULL != right->left)
+		right->left->parent = node;
+	replace_child(tree, node, right);
+	right->left = node;
+	node->parent = right;
+}
+
+/**
+ * Rotates a node with it's left child, which becomes it's parent
+ * @param tree Red-black tree
+ * @param node Node to rotate, must have a left child
+ */
+static void rotate_right(struct rs_rbtree *tree, struct rs_rbtree_node *node)
+{
+	struct rs_rbtree_node *left = node->left;
+
+	node->left = left->right;
+	if (NULL != left->right)
+		left->right->parent = node;
+	replace_child(tree, node, left);
+	left->right = node;
+	node->parent = left;
+}
+
+/**
+ * Restores the red-black properties after the insertion of a red node
+ * @param tree Red-black tree
+ * @param node Node just inserted
+ */
+static void insert_fixup(struct rs_rbtree *tree, struct rs_rbtree_node *node)
+{
+	struct rs_rbtree_node *parent;
+	struct rs_rbtree_node *grand;
+	struct rs_rbtree_node *uncle;
+
+	/* a red parent isn't the root, so the grand parent exists */
+	while (is_red(parent = node->parent)) {
+		grand = parent->parent;
+		if (parent == grand->left) {
+			uncle = grand->right;
+			if (is_red(uncle)) {
+				parent->red = uncle->red = 0;
+				grand->red = 1;
+				node = grand;
+				continue;
+			}
+			if (node == parent->right) {
+				rotate_left(tree, parent);
+				node = parent;
+				parent = node->parent;
+			}
+			parent->red = 0;
+			grand->red = 1;
+			rotate_right(tree, grand);
+		} else {
+			uncle = grand->left;
+			if (is_red(uncle)) {
+				parent->red = uncle->red = 0;
+				grand->red = 1;
+				node = grand;
+				continue;
+			}
+			if (node == parent->left) {
+				rotate_right(tree, parent);
+				node = parent;
+				parent = node->parent;
+			}
+			parent->red = 0;
+			grand->red = 1;
+			rotate_left(tree, grand);
+		}
+	}
+	tree->root->red = 0;
+}
+
+/**
+ * Restores the red-black properties after the removal of a black node
+ * @param tree Red-black tree
+ * @param node Node which took the place of the node removed, can be NULL,
+ * it's subtree lacks one black node
+ * @param parent Parent of node
+ */
+static void remove_fixup(struct rs_rbtree *tree, struct rs_rbtree_node *node,
+		struct rs_rbtree_node *parent)
+{
+	struct rs_rbtree_node *sibling;
+
+	/* node's subtree is one black short, so it's sibling exists */
+	while (node != tree->root && !is_red(node)) {
+		if (node == parent->left) {
+			sibling = parent->right;
+			if (sibling->red) {
+				sibling->red = 0;
+				parent->red = 1;
+				rotate_left(tree, parent);
+				sibling = parent->right;
+			}
+			if (!is_red(sibling->left) && !is_red(sibling->right)) {
+				sibling->red = 1;
+				node = parent;
+				parent = node->parent;
+				continue;
+			}
+			if (!is_red(sibling->right)) {
+				sibling->left->red = 0;
+				sibling->red = 1;
+				rotate_right(tree, sibling);
+				sibling = parent->right;
+			}
+			sibling->red = parent->red;
+			parent->red = 0;
+			sibling->right->red = 0;
+			rotate_left(tree, parent);
+		} else {
+			sibling = parent->left;
+			if (sibling->red) {
+				sibling->red = 0;
+				parent->red = 1;
+				rotate_right(tree, parent);
+				sibling = parent->left;
+			}
+			if (!is_red(sibling->left) && !is_red(sibling->right)) {
+				sibling->red = 1;
+				node = parent;
+				parent = node->parent;
+				continue;
+			}
+			if (!is_red(sibling->left)) {
+				sibling->right->red = 0;
+				sibling->red = 1;
+				rotate_left(tree, sibling);
+				sibling = parent->left;
+			}
+			sibling->red = parent->red;
+			parent->red = 0;
+			sibling->left->red = 0;
+			rotate_right(tree, parent);
+		}
+		node = tree->root;
+	}
+	if (NULL != node)
+		node->red = 0;
+}
+
+/**
+ * Returns the least node of a subtree
+ * @param node Root of the subtree, can't be NULL
+ * @return Leftmost node of the subtree
+ */
+static struct rs_rbtree_node *leftmost(const struct rs_rbtree_node *node)
+{
+	while (NULL != node->left)
+		node = node->left;
+
+	return (struct rs_rbtree_node *)node;
+}
+
+/**
+ * Returns the greatest node of a subtree
+ * @param node Root of the subtree, can't be NULL
+ * @return Rightmost node of the subtree
+ */
+static struct rs_rbtree_node *rightmost(const struct rs_rbtree_node *node)
+{
+	while (NULL != node->right)
+		node = node->right;
+
+	return (struct rs_rbtree_node *)node;
+}
+
+int rs_rbtree_init(struct rs_rbtree *tree,
+		const struct rs_rbtree_vtable *vtable)
+{
+	if (NULL == tree || NULL == vtable || NULL == vtable->compare)
+		return -EINVAL;
+
+	memset(tree, 0, sizeof(*tree));
+	tree->vtable = *vtable;
+
+	return 0;
+}
+
+int rs_rbtree_insert(struct rs_rbtree *tree, struct rs_rbtree_node *node)
+{
+	struct rs_rbtree_node *parent = NULL;
+	struct rs_rbtree_node **link;
+
+	if (NULL == tree || NULL == node)
+		return -EINVAL;
+
+	link = &tree->root;
+	while (NULL != *link) {
+		parent = *link;
+		if (tree->vtable.compare(node, parent) < 0)
+			link = &parent->left;
+		else
+			link = &parent->right;
+	}
+	node->parent = parent;
+	node->left = node->right = NULL;
+	node->red = 1;
+	*link = node;
+	tree->count++;
+
+	insert_fixup(tree, node);
+
+	return 0;
+}
+
+int rs_rbtree_remove(struct rs_rbtree *tree, struct rs_rbtree_node *node)
+{
+	struct rs_rbtree_node *child;
+	struct rs_rbtree_node *parent;
+	struct rs_rbtree_node *successor;
+	int red;
+
+	if (NULL == tree || NULL == node || 0 == tree->count)
+		return -EINVAL;
+
+	if (NULL == node->left || NULL == node->right) {
+		child = NULL == node->left ? node->right : node->left;
+		parent = node->parent;
+		red = node->red;
+		replace_child(tree, node, child);
+	} else {
+		/* the successor, which has no left child, takes node's place */
+		successor = leftmost(node->right);
+		child = successor->right;
+		red = successor->red;
+		if (successor->parent == node) {
+			parent = successor;
+		} else {
+			parent = successor->parent;
+			replace_child(tree, successor, child);
+			successor->right = node->right;
+			successor->right->parent = successor;
+		}
+		replace_child(tree, node, successor);
+		successor->left = node->left;
+		successor->left->parent = successor;
+		successor->red = node->red;
+	}
+	tree->count--;
+	node->parent = node->left = node->right = NULL;
+
+	if (!red)
+		remove_fixup(tree, child, parent);
+
+	return 0;
+}
+
+struct rs_rbtree_node *rs_rbtree_find(const struct rs_rbtree *tree,
+		const struct rs_rbtree_node *key)
+{
+	struct rs_rbtree_node *node;
+
+	node = rs_rbtree_lower_bound(tree, key);
+	if (NULL == node || tree->vtable.compare(node, key) != 0)
+		return NULL;
+
+	return node;
+}
+
+struct rs_rbtree_node *rs_rbtree_lower_bound(const struct rs_rbtree *tree,
+		const struct rs_rbtree_node *key)
+{
+	struct rs_rbtree_node *node;
+	struct rs_rbtree_node *found = NULL;
+
+	if (NULL == tree || NULL == key)
+		return NULL;
+
+	node = tree->root;
+	while (NULL != node) {
+		if (tree->vtable.compare(node, key) < 0) {
+			node = node->right;
+		} else {
+			found = node;
+			node = node->left;
+		}
+	}
+
+	return found;
+}
+
+struct rs_rbtree_node *rs_rbtree_first(const struct rs_rbtree *tree)
+{
+	if (NULL == tree || NULL == tree->root)
+		return NULL;
+
+	return leftmost(tree->root);
+}
+
+struct rs_rbtree_node *rs_rbtree_last(const struct rs_rbtree *tree)
+{
+	if (NULL == tree || NULL == tree->root)
+		return NULL;
+
+	return rightmost(tree->root);
+}
+
+struct rs_rbtree_node *rs_rbtree_next(const struct rs_rbtree_node *node)
+{
+	if (NULL == node)
+		return NULL;
+
+	if (NULL != node->right)
+		return leftmost(node->right);
+	while (NULL != node->parent && node == node->parent->right)
+		node = node->parent;
+
+	return node->parent;
+}
+
+struct rs_rbtree_node *rs_rbtree_prev(const struct rs_rbtree_node *node)
+{
+	if (NULL == node)
+		return NULL;
+
+	if (NULL != node->left)
+		return rightmost(node->left);
+	while (NULL != node->parent && node == node->parent->left)
+		node = node->parent;
+
+	return node->parent;
+}
+
+struct rs_rbtree_node *rs_rbtree_pop(struct rs_rbtree *tree)
+{
+	struct rs_rbtree_node *node;
+
+	node = rs_rbtree_first(tree);
+	if (NULL != node)
+		rs_rbtree_remove(tree, node);
+
+	return node;
+}
+
+int rs_rbtree_clean_cb(struct rs_rbtree *tree, rs_rbtree_cb cb, void *data)
+{
+	struct rs_rbtree_node *node;
+	struct rs_rbtree_node *parent;
+
+	if (NULL == tree)
+		return -EINVAL;
+
+	/* post-order walk, each leaf is unchained before being passed to cb */
+	node = tree->root;
+	while (NULL != node) {
+		if (NULL != node->left) {
+			node = node->left;
+			continue;
+		}
+		if (NULL != node->right) {
+			node = node->right;
+			continue;
+		}
+		parent = node->parent;
+		if (NULL != parent) {
+			if (parent->left == node)
+				parent->left = NULL;
+			else
+				parent->right = NULL;
+		}
+		node->parent = NULL;
+		if (NULL != cb)
+			cb(node, data);
+		node = parent;
+	}
+	tree->root = NULL;
+	tree->count = 0;
+
+	return 0;
+}
+
+int rs_rbtree_clean(struct rs_rbtree *tree)
+{
+	return rs_rbtree_clean_cb(tree, NULL, NULL);
+}
@@ -0,0 +1,272 @@
+/**
+ * @file rs_cmap_test.c
+ * @date 19 oct. 2026
+ * @author nicolas.carrier@parrot.com
+ * @brief unit tests for librs concurrent hash map implementation
+ *
+ * Copyright (C) 2026 Parrot S.A.
+ */
+#include <pthread.h>
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <errno.h>
+
+#include <CUnit/Basic.h>
+
+#include <ut_utils.h>
+
+#include <fautes.h>
+
+#include <rs_cmap.h>
+
+#define NB_STABLE_KEYS 1000
+#define NB_VOLATILE_KEYS 100
+#define NB_READERS 4
+#define NB_WRITERS 2
+#define NB_WRITES 20000
+
+struct worker {
+	struct rs_cmap *map;
+	pthread_t thread;
+	int id;
+	bool ok;
+};
+
+static volatile bool stop;
+
+static void testRS_CMAP_INIT(void)
+{
+	int ret;
+	struct rs_cmap map;
+
+	/* normal use cases */
+	ret = rs_cmap_init(&map, 0);
+	CU_ASSERT_EQUAL(ret, 0);
+	CU_ASSERT_PTR_NOT_NULL(map.buckets);
+	CU_ASSERT_EQUAL(rs_cmap_get_count(&map), 0);
+	rs_cmap_clean(&map);
+	ret = rs_cmap_init(&map, 1000);
+	CU_ASSERT_EQUAL(ret, 0);
+	CU_ASSERT_EQUAL(map.mask + 1, 1024);
+	rs_cmap_clean(&map);
+	/* cleaning twice is harmless */
+	ret = rs_cmap_clean(&map);
+	CU_ASSERT_EQUAL(ret, 0);
+
+	/* error use cases */
+	ret = rs_cmap_init(NULL, 0);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+	ret = rs_cmap_init(&map, SIZE_MAX);
+	CU_ASSERT_EQUAL(ret, -E2BIG);
+	ret = rs_cmap_clean(NULL);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+}
+
+static void testRS_CMAP_OPERATIONS(void)
+{
+	int ret;
+	struct rs_cmap map;
+	void *data1 = (void *)42;
+	void *data2 = (void *)66;
+	void *needle = NULL;
+
+	ret = rs_cmap_init(&map, 0);
+	CU_ASSERT_EQUAL_FATAL(ret, 0);
+
+	/* normal use cases */
+	ret = rs_cmap_insert(&map, "ursule", data1);
+	CU_ASSERT_EQUAL(ret, 0);
+	ret = rs_cmap_insert(&map, "gédéon", data2);
+	CU_ASSERT_EQUAL(ret, 0);
+	CU_ASSERT_EQUAL(rs_cmap_get_count(&map), 2);
+	ret = rs_cmap_lookup(&map, "ursule", &needle);
+	CU_ASSERT_EQUAL(ret, 0);
+	CU_ASSERT_PTR_EQUAL(needle, data1);
+	ret = rs_cmap_lookup(&map, "frénégonde", &needle);
+	CU_ASSERT_EQUAL(ret, -ENOENT);
+	CU_ASSERT_PTR_NULL(needle);
+	ret = rs_cmap_remove(&map, "ursule", &needle);
+	CU_ASSERT_EQUAL(ret, 0);
+	CU_ASSERT_PTR_EQUAL(needle, data1);
+	ret = rs_cmap_lookup(&map, "ursule", &needle);
+	CU_ASSERT_EQUAL(ret, -ENOENT);
+	ret = rs_cmap_lookup(&map, "gédéon", &needle);
+	CU_ASSERT_EQUAL(ret, 0);
+	CU_ASSERT_PTR_EQUAL(needle, data2);
+	CU_ASSERT_EQUAL(map.nb_retired, 1);
+	ret = rs_cmap_synchronize(&map);
+	CU_ASSERT_EQUAL(ret, 0);
+	CU_ASSERT_EQUAL(map.nb_retired, 0);
+
+	/* error use cases */
+	ret = rs_cmap_insert(&map, "gédéon", data1);
+	CU_ASSERT_EQUAL(ret, -EEXIST);
+	ret = rs_cmap_remove(&map, "ursule", &needle);
+	CU_ASSERT_EQUAL(ret, -ENOENT);
+	CU_ASSERT_PTR_NULL(needle);
+	ret = rs_cmap_insert(NULL, "ursule", data1);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+	ret = rs_cmap_insert(&map, "", data1);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+	ret = rs_cmap_lookup(&map, NULL, &needle);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+	ret = rs_cmap_lookup(&map, "ursule", NULL);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+	ret = rs_cmap_remove(&map, NULL, NULL);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+	ret = rs_cmap_synchronize(NULL);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+
+	/* cleanup */
+	rs_cmap_clean(&map);
+	/* using a cleaned hash map must fail cleanly */
+	ret = rs_cmap_insert(&map, "ursule", data1);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+}
+
+static void *reader(void *arg)
+{
+	struct worker *w = arg;
+	char key[16];
+	void *needle;
+	int i = 0;
+	int ret;
+
+	/* the stable keys must always be found, with their data */
+	while (!stop) {
+		snprintf(key, sizeof(key), "stable%d", i);
+		ret = rs_cmap_lookup(w->map, key, &needle);
+		if (ret != 0 || needle != (void *)(intptr_t)i)
+			w->ok = false;
+		snprintf(key, sizeof(key), "volatile%d", i % NB_VOLATILE_KEYS);
+		ret = rs_cmap_lookup(w->map, key, &needle);
+		if (ret != 0 && ret != -ENOENT)
+			w->ok = false;
+		i = (i + 1) % NB_STABLE_KEYS;
+	}
+
+	return NULL;
+}
+
+static void *writer(void *arg)
+{
+	struct worker *w = arg;
+	char key[16];
+	int i;
+	int ret;
+
+	/* each writer toggles it's own half of the volatile keys */
+	for (i = 0; i < NB_WRITES; i++) {
+		snprintf(key, sizeof(key), "volatile%d",
+				(i * NB_WRITERS + w->id) % NB_VOLATILE_KEYS);
+		ret = rs_cmap_remove(w->map, key, NULL);
+		if (ret == -ENOENT)
+			ret = rs_cmap_insert(w->map, key, NULL);
+		if (ret != 0)
+			w->ok = false;
+	}
+
+	return NULL;
+}
+
+static void testRS_CMAP_CONCURRENCY(void)
+{
+	int ret;
+	int i;
+	bool ok = true;
+	char key[16];
+	struct rs_cmap map;
+	struct worker readers[NB_READERS];
+	struct worker writers[NB_WRITERS];
+
+	ret = rs_cmap_init(&map, NB_STABLE_KEYS + NB_VOLATILE_KEYS);
+	CU_ASSERT_EQUAL_FATAL(ret, 0);
+	for (i = 0; i < NB_STABLE_KEYS; i++) {
+		snprintf(key, sizeof(key), "stable%d", i);
+		ok = ok && rs_cmap_insert(&map, key, (void *)(intptr_t)i) == 0;
+	}
+	CU_ASSERT_FATAL(ok);
+
+	stop = false;
+	for (i = 0; i < NB_READERS; i++) {
+		readers[i] = (struct worker) {.map = &map, .id = i, .ok = true};
+		pthread_create(&readers[i].thread, NULL, reader, readers + i);
+	}
+	for (i = 0; i < NB_WRITERS; i++) {
+		writers[i] = (struct worker) {.map = &map, .id = i, .ok = true};
+		pthread_create(&writers[i].thread, NULL, writer, writers + i);
+	}
+	for (i = 0; i < NB_WRITERS; i++) {
+		pthread_join(writers[i].thread, NULL);
+		ok = ok && writers[i].ok;
+	}
+	stop = true;
+	for (i = 0; i < NB_READERS; i++) {
+		pthread_join(readers[i].thread, NULL);
+		ok = ok && readers[i].ok;
+	}
+	CU_ASSERT(ok);
+	/* each volatile key was toggled an even number of times */
+	CU_ASSERT_EQUAL(rs_cmap_get_count(&map), NB_STABLE_KEYS);
+
+	/* cleanup */
+	rs_cmap_clean(&map);
+}
+
+static void testRS_CMAP_CLEAN_FREE(void)
+{
+	int ret;
+	struct rs_cmap map;
+
+	ret = rs_cmap_init(&map, 0);
+	CU_ASSERT_EQUAL_FATAL(ret, 0);
+	ret = rs_cmap_insert(&map, "ursule", calloc(1, sizeof(int)));
+	CU_ASSERT_EQUAL(ret, 0);
+	ret = rs_cmap_insert(&map, "gédéon", calloc(1, sizeof(int)));
+	CU_ASSERT_EQUAL(ret, 0);
+	/* retired entries are freed too */
+	ret = rs_cmap_insert(&map, "frénégonde", NULL);
+	CU_ASSERT_EQUAL(ret, 0);
+	ret = rs_cmap_remove(&map, "frénégonde", NULL);
+	CU_ASSERT_EQUAL(ret, 0);
+
+	/* normal use cases */
+	ret = rs_cmap_clean_cb(&map, free);
+	CU_ASSERT_EQUAL(ret, 0);
+
+	/* error use cases */
+	ret = rs_cmap_clean_cb(NULL, free);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+}
+
+static const struct test_t tests[] = {
+		{
+				.fn = testRS_CMAP_INIT,
+				.name = "rs_cmap_init"
+		},
+		{
+				.fn = testRS_CMAP_OPERATIONS,
+				.name = "rs_cmap_operations"
+		},
+		{
+				.fn = testRS_CMAP_CONCURRENCY,
+				.name = "rs_cmap_concurrency"
+		},
+		{
+				.fn = testRS_CMAP_CLEAN_FREE,
+				.name = "rs_cmap_clean_free"
+		},
+
+		/* NULL guard */
+		{.fn = NULL, .name = NULL},
+};
+
+struct suite_t cmap_suite = {
+		.name = "rs_cmap",
+		.init = NULL,
+		.clean = NULL,
+		.tests = tests,
+};
@@ -18,19 +18,35 @@
 const char rs_interp[] __attribute__((section(".interp"))) = FUSION_INTERPRETER;
 
 struct suite_t *librs_test_suites[] = {
+		&cmap_suite,
 		&dll_suite,
+		&fmap_file_suite,
+		&fmap_suite,
+		&heap_suite,
 		&hmap_suite,
+		&ihmap_suite,
 		&node_suite,
+		&ohmap_suite,
 		&rb_suite,
+		&rb_spsc_suite,
+		&rbtree_suite,
 		NULL, /* NULL guard */
 };
 
 static void librs_pool_initializer(void)
 {
+	FAUTES_GET_ACTIVE_STATE_FROM_ENVIRONMENT(cmap_suite);
 	FAUTES_GET_ACTIVE_STATE_FROM_ENVIRONMENT(dll_suite);
+	FAUTES_GET_ACTIVE_STATE_FROM_ENVIRONMENT(fmap_file_suite);
+	FAUTES_GET_ACTIVE_STATE_FROM_ENVIRONMENT(fmap_suite);
+	FAUTES_GET_ACTIVE_STATE_FROM_ENVIRONMENT(heap_suite);
 	FAUTES_GET_ACTIVE_STATE_FROM_ENVIRONMENT(hmap_suite);
+	FAUTES_GET_ACTIVE_STATE_FROM_ENVIRONMENT(ihmap_suite);
 	FAUTES_GET_ACTIVE_STATE_FROM_ENVIRONMENT(node_suite);
+	FAUTES_GET_ACTIVE_STATE_FROM_ENVIRONMENT(ohmap_suite);
 	FAUTES_GET_ACTIVE_STATE_FROM_ENVIRONMENT(rb_suite);
+	FAUTES_GET_ACTIVE_STATE_FROM_ENVIRONMENT(rb_spsc_suite);
+	FAUTES_GET_ACTIVE_STATE_FROM_ENVIRONMENT(rbtree_suite);
 }
 
 struct pool_t fautes_pool = {
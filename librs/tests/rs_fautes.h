@@ -10,10 +10,18 @@
 #ifndef RS_FAUTES_H_
 #define RS_FAUTES_H_
 
+extern struct suite_t cmap_suite;
 extern struct suite_t dll_suite;
+extern struct suite_t fmap_file_suite;
+extern struct suite_t fmap_suite;
+extern struct suite_t heap_suite;
 extern struct suite_t hmap_suite;
+extern struct suite_t ihmap_suite;
 extern struct suite_t node_suite;
+extern struct suite_t ohmap_suite;
 extern struct suite_t rb_suite;
+extern struct suite_t rb_spsc_suite;
+extern struct suite_t rbtree_suite;
 
 /**
  * Entry point of the library when the .so in executed directly.
@@ -0,0 +1,332 @@
+/**
+ * @file rs_fmap_file_test.c
+ * @date 19 oct. 2026
+ * @author nicolas.carrier@parrot.com
+ * @brief unit tests for librs frozen map files implementation
+ *
+ * Copyright (C) 2026 Parrot S.A.
+ */
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+#include <CUnit/Basic.h>
+
+#include <ut_utils.h>
+
+#include <fautes.h>
+
+#include <rs_fmap_file.h>
+
+#define NB_KEYS 10000
+#define KEY_SIZE 16
+
+static const uint64_t big_value = UINT64_C(0x0123456789abcdef);
+
+static const struct rs_fmap_file_item items[] = {
+		{.key = "ursule", .value = "bear", .len = 5},
+		{.key = "gédéon", .value = &big_value,
+				.len = sizeof(big_value)},
+		{.key = "frénégonde", .value = NULL, .len = 0},
+};
+
+static char path[] = "/tmp/rs_fmap_file_test.XXXXXX";
+
+static int init_suite(void)
+{
+	int fd;
+
+	fd = mkstemp(path);
+	if (fd == -1)
+		return -1;
+	close(fd);
+
+	return 0;
+}
+
+static int clean_suite(void)
+{
+	unlink(path);
+
+	return 0;
+}
+
+/* changes one byte of the file at the given offset */
+static void corrupt(off_t offset)
+{
+	int fd;
+	uint8_t byte;
+
+	fd = open(path, O_RDWR);
+	CU_ASSERT_NOT_EQUAL_FATAL(fd, -1);
+	CU_ASSERT_EQUAL(pread(fd, &byte, 1, offset), 1);
+	byte ^= 0x55;
+	CU_ASSERT_EQUAL(pwrite(fd, &byte, 1, offset), 1);
+	close(fd);
+}
+
+static void testRS_FMAP_FILE_WRITE(void)
+{
+	int ret;
+	const struct rs_fmap_file_item duplicates[] = {
+			{.key = "ursule", .value = "bear", .len = 5},
+			{.key = "ursule", .value = "bear", .len = 5},
+	};
+	const struct rs_fmap_file_item invalid[] = {
+			{.key = "ursule", .value = NULL, .len = 5},
+	};
+
+	/* normal use cases */
+	ret = rs_fmap_file_write(path, items, UT_ARRAY_SIZE(items));
+	CU_ASSERT_EQUAL(ret, 0);
+	ret = rs_fmap_file_write(path, NULL, 0);
+	CU_ASSERT_EQUAL(ret, 0);
+
+	/* error use cases */
+	ret = rs_fmap_file_write(NULL, items, UT_ARRAY_SIZE(items));
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+	ret = rs_fmap_file_write(path, NULL, 1);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+	ret = rs_fmap_file_write(path, invalid, UT_ARRAY_SIZE(invalid));
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+	ret = rs_fmap_file_write(path, duplicates, UT_ARRAY_SIZE(duplicates));
+	CU_ASSERT_EQUAL(ret, -EEXIST);
+	ret = rs_fmap_file_write("/nonexistent/dir/map", items,
+			UT_ARRAY_SIZE(items));
+	CU_ASSERT_EQUAL(ret, -ENOENT);
+}
+
+static void testRS_FMAP_FILE_LOOKUP(void)
+{
+	int ret;
+	struct rs_fmap_file file;
+	const void *value;
+	size_t len;
+
+	ret = rs_fmap_file_write(path, items, UT_ARRAY_SIZE(items));
+	CU_ASSERT_EQUAL_FATAL(ret, 0);
+	ret = rs_fmap_file_open(&file, path);
+	CU_ASSERT_EQUAL_FATAL(ret, 0);
+
+	/* normal use cases */
+	CU_ASSERT_EQUAL(rs_fmap_file_get_count(&file), UT_ARRAY_SIZE(items));
+	ret = rs_fmap_file_verify(&file);
+	CU_ASSERT_EQUAL(ret, 0);
+	ret = rs_fmap_file_lookup(&file, "ursule", &value, &len);
+	CU_ASSERT_EQUAL(ret, 0);
+	CU_ASSERT_EQUAL(len, 5);
+	CU_ASSERT_STRING_EQUAL(value, "bear");
+	ret = rs_fmap_file_lookup(&file, "gédéon", &value, &len);
+	CU_ASSERT_EQUAL(ret, 0);
+	CU_ASSERT_EQUAL(len, sizeof(big_value));
+	/* values are aligned on 8 bytes */
+	CU_ASSERT_EQUAL((uintptr_t)value % 8, 0);
+	CU_ASSERT_EQUAL(*(const uint64_t *)value, big_value);
+	ret = rs_fmap_file_lookup(&file, "frénégonde", &value, NULL);
+	CU_ASSERT_EQUAL(ret, 0);
+	CU_ASSERT_PTR_NOT_NULL(value);
+	ret = rs_fmap_file_lookup(&file, "gaston", &value, &len);
+	CU_ASSERT_EQUAL(ret, -ENOENT);
+	CU_ASSERT_PTR_NULL(value);
+	CU_ASSERT_EQUAL(len, 0);
+
+	/* error use cases */
+	ret = rs_fmap_file_lookup(NULL, "ursule", &value, &len);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+	ret = rs_fmap_file_lookup(&file, NULL, &value, &len);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+	ret = rs_fmap_file_lookup(&file, "", &value, &len);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+	ret = rs_fmap_file_lookup(&file, "ursule", NULL, &len);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+	ret = rs_fmap_file_verify(NULL);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+
+	/* cleanup */
+	rs_fmap_file_close(&file);
+	/* using a closed file must fail cleanly */
+	ret = rs_fmap_file_lookup(&file, "ursule", &value, &len);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+	/* closing twice is harmless */
+	ret = rs_fmap_file_close(&file);
+	CU_ASSERT_EQUAL(ret, 0);
+	ret = rs_fmap_file_close(NULL);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+
+	/* an empty frozen map file contains nothing */
+	ret = rs_fmap_file_write(path, NULL, 0);
+	CU_ASSERT_EQUAL_FATAL(ret, 0);
+	ret = rs_fmap_file_open(&file, path);
+	CU_ASSERT_EQUAL_FATAL(ret, 0);
+	ret = rs_fmap_file_lookup(&file, "ursule", &value, &len);
+	CU_ASSERT_EQUAL(ret, -ENOENT);
+	rs_fmap_file_close(&file);
+}
+
+static void testRS_FMAP_FILE_INIT(void)
+{
+	int ret;
+	int fd;
+	struct stat st;
+	uint64_t *buf;
+	struct rs_fmap_file file;
+	const void *value;
+	size_t len;
+
+	ret = rs_fmap_file_write(path, items, UT_ARRAY_SIZE(items));
+	CU_ASSERT_EQUAL_FATAL(ret, 0);
+	fd = open(path, O_RDONLY);
+	CU_ASSERT_NOT_EQUAL_FATAL(fd, -1);
+	CU_ASSERT_EQUAL_FATAL(fstat(fd, &st), 0);
+	/* malloc aligns on 8 bytes */
+	buf = malloc(st.st_size + 1);
+	CU_ASSERT_PTR_NOT_NULL_FATAL(buf);
+	CU_ASSERT_EQUAL(read(fd, buf, st.st_size), st.st_size);
+	close(fd);
+
+	/* normal use cases */
+	ret = rs_fmap_file_init(&file, buf, st.st_size);
+	CU_ASSERT_EQUAL(ret, 0);
+	ret = rs_fmap_file_lookup(&file, "ursule", &value, &len);
+	CU_ASSERT_EQUAL(ret, 0);
+	/* the value is read in place */
+	CU_ASSERT(value > (void *)buf &&
+			value < (void *)((uint8_t *)buf + st.st_size));
+	rs_fmap_file_close(&file);
+
+	/* error use cases */
+	ret = rs_fmap_file_init(NULL, buf, st.st_size);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+	ret = rs_fmap_file_init(&file, NULL, st.st_size);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+	ret = rs_fmap_file_init(&file, (uint8_t *)buf + 1, st.st_size);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+	ret = rs_fmap_file_init(&file, buf, st.st_size - 1);
+	CU_ASSERT_EQUAL(ret, -EBADMSG);
+	ret = rs_fmap_file_init(&file, buf, 8);
+	CU_ASSERT_EQUAL(ret, -EBADMSG);
+
+	/* cleanup */
+	free(buf);
+}
+
+static void testRS_FMAP_FILE_CORRUPTED(void)
+{
+	int ret;
+	struct rs_fmap_file file;
+
+	/* a corrupted header is detected at opening */
+	ret = rs_fmap_file_write(path, items, UT_ARRAY_SIZE(items));
+	CU_ASSERT_EQUAL_FATAL(ret, 0);
+	corrupt(offsetof(struct rs_fmap_file_header, nb_entries));
+	ret = rs_fmap_file_open(&file, path);
+	CU_ASSERT_EQUAL(ret, -EBADMSG);
+	ret = rs_fmap_file_write(path, items, UT_ARRAY_SIZE(items));
+	CU_ASSERT_EQUAL_FATAL(ret, 0);
+	corrupt(offsetof(struct rs_fmap_file_header, magic));
+	ret = rs_fmap_file_open(&file, path);
+	CU_ASSERT_EQUAL(ret, -EBADMSG);
+	ret = rs_fmap_file_write(path, items, UT_ARRAY_SIZE(items));
+	CU_ASSERT_EQUAL_FATAL(ret, 0);
+	corrupt(offsetof(struct rs_fmap_file_header, version));
+	ret = rs_fmap_file_open(&file, path);
+	CU_ASSERT_EQUAL(ret, -ENOTSUP);
+
+	/* a corrupted content is detected on demand */
+	ret = rs_fmap_file_write(path, items, UT_ARRAY_SIZE(items));
+	CU_ASSERT_EQUAL_FATAL(ret, 0);
+	corrupt(sizeof(struct rs_fmap_file_header));
+	ret = rs_fmap_file_open(&file, path);
+	CU_ASSERT_EQUAL_FATAL(ret, 0);
+	ret = rs_fmap_file_verify(&file);
+	CU_ASSERT_EQUAL(ret, -EBADMSG);
+	rs_fmap_file_close(&file);
+
+	/* error use cases */
+	ret = rs_fmap_file_open(&file, "/nonexistent");
+	CU_ASSERT_EQUAL(ret, -ENOENT);
+	ret = rs_fmap_file_open(NULL, path);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+	ret = rs_fmap_file_open(&file, NULL);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+}
+
+static void testRS_FMAP_FILE_MANY_KEYS(void)
+{
+	int ret;
+	unsigned i;
+	bool ok = true;
+	struct rs_fmap_file file;
+	struct rs_fmap_file_item *many;
+	char (*keys)[KEY_SIZE];
+	const void *value;
+	size_t len;
+
+	many = calloc(NB_KEYS, sizeof(*many));
+	keys = calloc(NB_KEYS, KEY_SIZE);
+	CU_ASSERT_FATAL(many != NULL && keys != NULL);
+	for (i = 0; i < NB_KEYS; i++) {
+		snprintf(keys[i], KEY_SIZE, "key%u", i);
+		many[i].key = keys[i];
+		many[i].value = keys[i];
+		many[i].len = strlen(keys[i]) + 1;
+	}
+	ret = rs_fmap_file_write(path, many, NB_KEYS);
+	CU_ASSERT_EQUAL_FATAL(ret, 0);
+	ret = rs_fmap_file_open(&file, path);
+	CU_ASSERT_EQUAL_FATAL(ret, 0);
+
+	/* normal use cases */
+	CU_ASSERT_EQUAL(rs_fmap_file_verify(&file), 0);
+	for (i = 0; i < NB_KEYS; i++) {
+		ret = rs_fmap_file_lookup(&file, keys[i], &value, &len);
+		ok = ok && ret == 0 && len == strlen(keys[i]) + 1 &&
+				strcmp(value, keys[i]) == 0;
+	}
+	CU_ASSERT(ok);
+
+	/* cleanup */
+	rs_fmap_file_close(&file);
+	free(keys);
+	free(many);
+}
+
+static const struct test_t tests[] = {
+		{
+				.fn = testRS_FMAP_FILE_WRITE,
+				.name = "rs_fmap_file_write"
+		},
+		{
+				.fn = testRS_FMAP_FILE_LOOKUP,
+				.name = "rs_fmap_file_lookup"
+		},
+		{
+				.fn = testRS_FMAP_FILE_INIT,
+				.name = "rs_fmap_file_init"
+		},
+		{
+				.fn = testRS_FMAP_FILE_CORRUPTED,
+				.name = "rs_fmap_file_corrupted"
+		},
+		{
+				.fn = testRS_FMAP_FILE_MANY_KEYS,
+				.name = "rs_fmap_file_many_keys"
+		},
+
+		/* NULL guard */
+		{.fn = NULL, .name = NULL},
+};
+
+struct suite_t fmap_file_suite = {
+		.name = "rs_fmap_file",
+		.init = init_suite,
+		.clean = clean_suite,
+		.tests = tests,
+};
@@ -0,0 +1,219 @@
+/**
+ * @file rs_fmap_test.c
+ * @date 19 oct. 2026
+ * @author nicolas.carrier@parrot.com
+ * @brief unit tests for librs frozen map implementation
+ *
+ * Copyright (C) 2026 Parrot S.A.
+ */
+#include <stdio.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <errno.h>
+
+#include <CUnit/Basic.h>
+
+#include <ut_utils.h>
+
+#include <fautes.h>
+
+#include <rs_fmap.h>
+
+#define NB_KEYS 10000
+#define KEY_SIZE 16
+
+/* generated by rs_fmap_gen from rs_fmap_test_map.txt */
+extern const struct rs_fmap rs_fmap_test_map;
+
+static const struct rs_fmap_entry entries[] = {
+		{.key = "ursule", .data = (void *)42},
+		{.key = "gédéon", .data = (void *)66},
+		{.key = "frénégonde", .data = NULL},
+};
+
+static void testRS_FMAP_INIT(void)
+{
+	int ret;
+	struct rs_fmap map;
+	const struct rs_fmap_entry duplicates[] = {
+			{.key = "ursule", .data = (void *)42},
+			{.key = "gédéon", .data = (void *)66},
+			{.key = "ursule", .data = (void *)66},
+	};
+	const struct rs_fmap_entry invalid[] = {
+			{.key = "ursule", .data = (void *)42},
+			{.key = "", .data = (void *)66},
+	};
+
+	/* normal use cases */
+	ret = rs_fmap_init(&map, entries, UT_ARRAY_SIZE(entries));
+	CU_ASSERT_EQUAL(ret, 0);
+	CU_ASSERT_EQUAL(rs_fmap_get_count(&map), UT_ARRAY_SIZE(entries));
+	rs_fmap_clean(&map);
+	ret = rs_fmap_init(&map, NULL, 0);
+	CU_ASSERT_EQUAL(ret, 0);
+	CU_ASSERT_EQUAL(rs_fmap_get_count(&map), 0);
+	rs_fmap_clean(&map);
+	/* cleaning twice is harmless */
+	ret = rs_fmap_clean(&map);
+	CU_ASSERT_EQUAL(ret, 0);
+
+	/* error use cases */
+	ret = rs_fmap_init(NULL, entries, UT_ARRAY_SIZE(entries));
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+	ret = rs_fmap_init(&map, NULL, 1);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+	ret = rs_fmap_init(&map, invalid, UT_ARRAY_SIZE(invalid));
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+	ret = rs_fmap_init(&map, duplicates, UT_ARRAY_SIZE(duplicates));
+	CU_ASSERT_EQUAL(ret, -EEXIST);
+	ret = rs_fmap_clean(NULL);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+}
+
+static void testRS_FMAP_LOOKUP(void)
+{
+	int ret;
+	struct rs_fmap map;
+	void *needle = (void *)1;
+
+	ret = rs_fmap_init(&map, entries, UT_ARRAY_SIZE(entries));
+	CU_ASSERT_EQUAL_FATAL(ret, 0);
+
+	/* normal use cases */
+	ret = rs_fmap_lookup(&map, "ursule", &needle);
+	CU_ASSERT_EQUAL(ret, 0);
+	CU_ASSERT_PTR_EQUAL(needle, (void *)42);
+	ret = rs_fmap_lookup(&map, "gédéon", &needle);
+	CU_ASSERT_EQUAL(ret, 0);
+	CU_ASSERT_PTR_EQUAL(needle, (void *)66);
+	ret = rs_fmap_lookup(&map, "frénégonde", &needle);
+	CU_ASSERT_EQUAL(ret, 0);
+	CU_ASSERT_PTR_NULL(needle);
+	ret = rs_fmap_lookup(&map, "gaston", &needle);
+	CU_ASSERT_EQUAL(ret, -ENOENT);
+	CU_ASSERT_PTR_NULL(needle);
+
+	/* error use cases */
+	ret = rs_fmap_lookup(NULL, "ursule", &needle);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+	ret = rs_fmap_lookup(&map, NULL, &needle);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+	ret = rs_fmap_lookup(&map, "", &needle);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+	ret = rs_fmap_lookup(&map, "ursule", NULL);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+
+	/* cleanup */
+	rs_fmap_clean(&map);
+	/* using a cleaned frozen map must fail cleanly */
+	ret = rs_fmap_lookup(&map, "ursule", &needle);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+
+	/* an empty frozen map contains nothing */
+	ret = rs_fmap_init(&map, NULL, 0);
+	CU_ASSERT_EQUAL_FATAL(ret, 0);
+	ret = rs_fmap_lookup(&map, "ursule", &needle);
+	CU_ASSERT_EQUAL(ret, -ENOENT);
+	rs_fmap_clean(&map);
+}
+
+static void testRS_FMAP_MANY_KEYS(void)
+{
+	int ret;
+	unsigned i;
+	bool ok = true;
+	struct rs_fmap map;
+	struct rs_fmap_entry *many;
+	char (*keys)[KEY_SIZE];
+	char key[KEY_SIZE];
+	void *needle;
+
+	many = calloc(NB_KEYS, sizeof(*many));
+	keys = calloc(NB_KEYS, KEY_SIZE);
+	CU_ASSERT_FATAL(many != NULL && keys != NULL);
+	for (i = 0; i < NB_KEYS; i++) {
+		snprintf(keys[i], KEY_SIZE, "key%u", i);
+		many[i].key = keys[i];
+		many[i].data = (void *)(uintptr_t)i;
+	}
+	ret = rs_fmap_init(&map, many, NB_KEYS);
+	CU_ASSERT_EQUAL_FATAL(ret, 0);
+
+	/* normal use cases */
+	for (i = 0; i < NB_KEYS; i++) {
+		ret = rs_fmap_lookup(&map, keys[i], &needle);
+		ok = ok && ret == 0 && needle == (void *)(uintptr_t)i;
+	}
+	CU_ASSERT(ok);
+	/* absent keys are compared to the key of their slot */
+	for (i = 0; i < NB_KEYS; i++) {
+		snprintf(key, KEY_SIZE, "absent%u", i);
+		ret = rs_fmap_lookup(&map, key, &needle);
+		ok = ok && ret == -ENOENT;
+	}
+	CU_ASSERT(ok);
+
+	/* cleanup */
+	rs_fmap_clean(&map);
+	free(keys);
+	free(many);
+}
+
+static void testRS_FMAP_GENERATED(void)
+{
+	int ret;
+	unsigned i;
+	void *needle;
+	const struct rs_fmap_entry expected[] = {
+			{.key = "ursule", .data = (void *)1},
+			{.key = "gédéon", .data = (void *)2},
+			{.key = "frénégonde", .data = (void *)3},
+			{.key = "\"quoted\"", .data = (void *)4},
+			{.key = "back\\slash", .data = (void *)5},
+			{.key = "what??", .data = (void *)6},
+			{.key = "no_data", .data = NULL},
+	};
+
+	/* normal use cases */
+	CU_ASSERT_EQUAL(rs_fmap_get_count(&rs_fmap_test_map),
+			UT_ARRAY_SIZE(expected));
+	for (i = 0; i < UT_ARRAY_SIZE(expected); i++) {
+		ret = rs_fmap_lookup(&rs_fmap_test_map, expected[i].key,
+				&needle);
+		CU_ASSERT_EQUAL(ret, 0);
+		CU_ASSERT_PTR_EQUAL(needle, expected[i].data);
+	}
+	ret = rs_fmap_lookup(&rs_fmap_test_map, "gaston", &needle);
+	CU_ASSERT_EQUAL(ret, -ENOENT);
+}
+
+static const struct test_t tests[] = {
+		{
+				.fn = testRS_FMAP_INIT,
+				.name = "rs_fmap_init"
+		},
+		{
+				.fn = testRS_FMAP_LOOKUP,
+				.name = "rs_fmap_lookup"
+		},
+		{
+				.fn = testRS_FMAP_MANY_KEYS,
+				.name = "rs_fmap_many_keys"
+		},
+		{
+				.fn = testRS_FMAP_GENERATED,
+				.name = "rs_fmap_generated"
+		},
+
+		/* NULL guard */
+		{.fn = NULL, .name = NULL},
+};
+
+struct suite_t fmap_suite = {
+		.name = "rs_fmap",
+		.init = NULL,
+		.clean = NULL,
+		.tests = tests,
+};
@@ -0,0 +1,242 @@
+/**
+ * @file rs_heap_test.c
+ * @date 19 oct. 2026
+ * @author nicolas.carrier@parrot.com
+ * @brief unit tests for librs intrusive d-ary heap implementation
+ *
+ * Copyright (C) 2026 Parrot S.A.
+ */
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <errno.h>
+
+#include <CUnit/Basic.h>
+
+#include <ut_utils.h>
+
+#include <fautes.h>
+
+#include <rs_heap.h>
+
+#define NB_TIMERS 1000
+
+struct timer {
+	int expiry;
+	struct rs_heap_node node;
+};
+
+static struct timer *to_timer(const struct rs_heap_node *node)
+{
+	return NULL == node ? NULL :
+			ut_container_of(node, struct timer, node);
+}
+
+static int timer_compare(struct rs_heap_node *a, const struct rs_heap_node *b)
+{
+	return to_timer(a)->expiry - to_timer(b)->expiry;
+}
+
+static const struct rs_heap_vtable vtable = {
+	.compare = timer_compare,
+};
+
+/* checks the heap property and the indices stored in the nodes */
+static bool heap_is_valid(const struct rs_heap *heap)
+{
+	size_t i;
+
+	for (i = 0; i < heap->count; i++) {
+		if (heap->nodes[i]->index != i)
+			return false;
+		if (i > 0 && timer_compare(heap->nodes[i],
+				heap->nodes[(i - 1) / heap->arity]) < 0)
+			return false;
+	}
+
+	return true;
+}
+
+static int count_cb(struct rs_heap_node *node, void *data)
+{
+	int *count = data;
+
+	(*count)++;
+
+	return 0;
+}
+
+static void testRS_HEAP_INIT(void)
+{
+	int ret;
+	struct rs_heap heap;
+	struct rs_heap_vtable incomplete = {.compare = NULL};
+
+	/* normal use cases */
+	ret = rs_heap_init(&heap, 0, 0, &vtable);
+	CU_ASSERT_EQUAL(ret, 0);
+	CU_ASSERT_EQUAL(heap.arity, RS_HEAP_DEFAULT_ARITY);
+	CU_ASSERT_EQUAL(rs_heap_get_count(&heap), 0);
+	CU_ASSERT_PTR_NULL(rs_heap_peek(&heap));
+	CU_ASSERT_PTR_NULL(rs_heap_pop(&heap));
+	ret = rs_heap_clean(&heap);
+	CU_ASSERT_EQUAL(ret, 0);
+	ret = rs_heap_init(&heap, 2, 1000, &vtable);
+	CU_ASSERT_EQUAL(ret, 0);
+	CU_ASSERT_EQUAL(heap.capacity, 1000);
+	rs_heap_clean(&heap);
+
+	/* error use cases */
+	ret = rs_heap_init(NULL, 0, 0, &vtable);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+	ret = rs_heap_init(&heap, 1, 0, &vtable);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+	ret = rs_heap_init(&heap, 0, 0, NULL);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+	ret = rs_heap_init(&heap, 0, 0, &incomplete);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+	ret = rs_heap_init(&heap, 0, SIZE_MAX, &vtable);
+	CU_ASSERT_EQUAL(ret, -E2BIG);
+	ret = rs_heap_clean(NULL);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+	CU_ASSERT_EQUAL(rs_heap_get_count(NULL), 0);
+}
+
+static void check_insert_pop(size_t arity)
+{
+	int ret;
+	int i;
+	int count = 0;
+	bool ok = true;
+	struct rs_heap heap;
+	static struct timer t[NB_TIMERS];
+	struct timer *timer;
+
+	/* starts small, to exercise the growth of the array */
+	ret = rs_heap_init(&heap, arity, 0, &vtable);
+	CU_ASSERT_EQUAL_FATAL(ret, 0);
+
+	/* normal use cases */
+	srand(42);
+	for (i = 0; i < NB_TIMERS; i++) {
+		t[i].expiry = rand() % 500;
+		ok = ok && rs_heap_insert(&heap, &t[i].node) == 0;
+	}
+	CU_ASSERT(ok);
+	CU_ASSERT(heap_is_valid(&heap));
+	CU_ASSERT_EQUAL(rs_heap_get_count(&heap), NB_TIMERS);
+	/* pop returns the nodes in order, the heap stays valid */
+	i = -1;
+	while (rs_heap_get_count(&heap) > NB_TIMERS / 2) {
+		timer = to_timer(rs_heap_pop(&heap));
+		ok = ok && timer->expiry >= i && heap_is_valid(&heap);
+		i = timer->expiry;
+	}
+	CU_ASSERT(ok);
+
+	/* error use cases */
+	ret = rs_heap_insert(&heap, heap.nodes[0]);
+	CU_ASSERT_EQUAL(ret, -EBUSY);
+	ret = rs_heap_insert(NULL, &t[0].node);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+	ret = rs_heap_insert(&heap, NULL);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+	CU_ASSERT_PTR_NULL(rs_heap_peek(NULL));
+	CU_ASSERT_PTR_NULL(rs_heap_pop(NULL));
+
+	/* cleanup, the callback is called on each node */
+	ret = rs_heap_clean_cb(&heap, count_cb, &count);
+	CU_ASSERT_EQUAL(ret, 0);
+	CU_ASSERT_EQUAL(count, NB_TIMERS - NB_TIMERS / 2);
+	/* inserting in a cleaned heap must fail cleanly */
+	ret = rs_heap_insert(&heap, &t[0].node);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+}
+
+static void testRS_HEAP_INSERT_POP(void)
+{
+	check_insert_pop(2);
+	check_insert_pop(4);
+	check_insert_pop(7);
+}
+
+static void testRS_HEAP_REMOVE_UPDATE(void)
+{
+	int ret;
+	int i;
+	int j;
+	bool ok = true;
+	struct rs_heap heap;
+	static struct timer t[NB_TIMERS];
+	bool in_heap[NB_TIMERS] = {false};
+
+	ret = rs_heap_init(&heap, 0, NB_TIMERS, &vtable);
+	CU_ASSERT_EQUAL_FATAL(ret, 0);
+
+	/* normal use cases */
+	/* random insertions, removals and rescheduling */
+	srand(42);
+	for (i = 0; i < 10 * NB_TIMERS; i++) {
+		j = rand() % NB_TIMERS;
+		if (!in_heap[j]) {
+			t[j].expiry = rand() % 500;
+			ok = ok && rs_heap_insert(&heap, &t[j].node) == 0;
+			in_heap[j] = true;
+		} else if (rand() % 2) {
+			ok = ok && rs_heap_remove(&heap, &t[j].node) == 0;
+			in_heap[j] = false;
+		} else {
+			t[j].expiry = rand() % 500;
+			ok = ok && rs_heap_update(&heap, &t[j].node) == 0;
+		}
+		ok = ok && heap_is_valid(&heap);
+	}
+	CU_ASSERT(ok);
+	for (i = 0; i < NB_TIMERS; i++)
+		if (in_heap[i])
+			ok = ok && rs_heap_remove(&heap, &t[i].node) == 0;
+	CU_ASSERT(ok);
+	CU_ASSERT_EQUAL(rs_heap_get_count(&heap), 0);
+
+	/* error use cases */
+	ret = rs_heap_remove(&heap, &t[0].node);
+	CU_ASSERT_EQUAL(ret, -ENOENT);
+	ret = rs_heap_update(&heap, &t[0].node);
+	CU_ASSERT_EQUAL(ret, -ENOENT);
+	ret = rs_heap_remove(NULL, &t[0].node);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+	ret = rs_heap_remove(&heap, NULL);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+	ret = rs_heap_update(NULL, &t[0].node);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+	ret = rs_heap_update(&heap, NULL);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+
+	/* cleanup */
+	rs_heap_clean(&heap);
+}
+
+static const struct test_t tests[] = {
+		{
+				.fn = testRS_HEAP_INIT,
+				.name = "rs_heap_init"
+		},
+		{
+				.fn = testRS_HEAP_INSERT_POP,
+				.name = "rs_heap_insert_pop"
+		},
+		{
+				.fn = testRS_HEAP_REMOVE_UPDATE,
+				.name = "rs_heap_remove_update"
+		},
+
+		/* NULL guard */
+		{.fn = NULL, .name = NULL},
+};
+
+struct suite_t heap_suite = {
+		.name = "rs_heap",
+		.init = NULL,
+		.clean = NULL,
+		.tests = tests,
+};
@@ -0,0 +1,346 @@
+/**
+ * @file rs_ihmap_test.c
+ * @date 19 oct. 2026
+ * @author nicolas.carrier@parrot.com
+ * @brief unit tests for librs intrusive hash map implementation
+ *
+ * Copyright (C) 2026 Parrot S.A.
+ */
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <errno.h>
+
+#include <CUnit/Basic.h>
+
+#include <ut_utils.h>
+
+#include <fautes.h>
+
+#include <rs_ihmap.h>
+
+#define NB_CONNECTIONS 1000
+
+struct connection {
+	uint64_t id;
+	int visits;
+	struct rs_ihmap_node node;
+};
+
+static uint32_t id_hash(const void *key)
+{
+	return rs_hash_u64(*(const uint64_t *)key);
+}
+
+/* every key collides, to exercise the chains */
+static uint32_t bad_hash(const void *key)
+{
+	return 42;
+}
+
+static const void *connection_key(const struct rs_ihmap_node *node)
+{
+	return &ut_container_of(node, struct connection, node)->id;
+}
+
+static int id_equals(const void *a, const void *b)
+{
+	return *(const uint64_t *)a == *(const uint64_t *)b;
+}
+
+static const struct rs_ihmap_vtable vtable = {
+	.hash = id_hash,
+	.key = connection_key,
+	.equals = id_equals,
+};
+
+static const struct rs_ihmap_vtable bad_vtable = {
+	.hash = bad_hash,
+	.key = connection_key,
+	.equals = id_equals,
+};
+
+static struct connection *lookup(struct rs_ihmap *map, uint64_t id)
+{
+	struct rs_ihmap_node *node;
+
+	node = rs_ihmap_lookup(map, &id);
+
+	return NULL == node ? NULL :
+			ut_container_of(node, struct connection, node);
+}
+
+static void testRS_IHMAP_INIT(void)
+{
+	int ret;
+	struct rs_ihmap map;
+	struct rs_ihmap_vtable incomplete = vtable;
+
+	/* normal use cases */
+	ret = rs_ihmap_init(&map, 0, &vtable);
+	CU_ASSERT_EQUAL(ret, 0);
+	CU_ASSERT_PTR_NOT_NULL(map.buckets);
+	CU_ASSERT_EQUAL(rs_ihmap_get_count(&map), 0);
+	CU_ASSERT_PTR_NULL(rs_ihmap_first(&map));
+	rs_ihmap_clean(&map);
+	ret = rs_ihmap_init(&map, 1000, &vtable);
+	CU_ASSERT_EQUAL(ret, 0);
+	CU_ASSERT_EQUAL(map.mask + 1, 1024);
+	rs_ihmap_clean(&map);
+
+	/* error use cases */
+	ret = rs_ihmap_init(NULL, 0, &vtable);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+	ret = rs_ihmap_init(&map, 0, NULL);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+	incomplete.equals = NULL;
+	ret = rs_ihmap_init(&map, 0, &incomplete);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+	ret = rs_ihmap_init(&map, SIZE_MAX, &vtable);
+	CU_ASSERT_EQUAL(ret, -E2BIG);
+	ret = rs_ihmap_clean(NULL);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+}
+
+static void check_insert_lookup(const struct rs_ihmap_vtable *vt)
+{
+	int ret;
+	int i;
+	bool ok = true;
+	struct rs_ihmap map;
+	static struct connection c[NB_CONNECTIONS];
+	struct connection dup = {.id = 0};
+
+	ret = rs_ihmap_init(&map, NB_CONNECTIONS, vt);
+	CU_ASSERT_EQUAL_FATAL(ret, 0);
+
+	/* normal use cases */
+	for (i = 0; i < NB_CONNECTIONS; i++) {
+		c[i] = (struct connection) {.id = (uint64_t)i << 32};
+		ok = ok && rs_ihmap_insert(&map, &c[i].node) == 0;
+	}
+	CU_ASSERT(ok);
+	CU_ASSERT_EQUAL(rs_ihmap_get_count(&map), NB_CONNECTIONS);
+	for (i = 0; i < NB_CONNECTIONS; i++)
+		ok = ok && lookup(&map, (uint64_t)i << 32) == c + i;
+	CU_ASSERT(ok);
+	CU_ASSERT_PTR_NULL(lookup(&map, 1));
+
+	/* error use cases */
+	/* keys are unique */
+	ret = rs_ihmap_insert(&map, &dup.node);
+	CU_ASSERT_EQUAL(ret, -EEXIST);
+	CU_ASSERT_PTR_NULL(dup.node.pprev);
+	/* a node can't be in two maps at once */
+	ret = rs_ihmap_insert(&map, &c[0].node);
+	CU_ASSERT_EQUAL(ret, -EBUSY);
+	ret = rs_ihmap_insert(NULL, &dup.node);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+	ret = rs_ihmap_insert(&map, NULL);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+	CU_ASSERT_PTR_NULL(rs_ihmap_lookup(NULL, &dup.id));
+
+	/* cleanup, unlinks the nodes */
+	rs_ihmap_clean(&map);
+	CU_ASSERT_PTR_NULL(c[0].node.pprev);
+	/* inserting in a cleaned hash map must fail cleanly */
+	ret = rs_ihmap_insert(&map, &c[0].node);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+}
+
+static void testRS_IHMAP_INSERT_LOOKUP(void)
+{
+	check_insert_lookup(&vtable);
+	check_insert_lookup(&bad_vtable);
+}
+
+static void testRS_IHMAP_REMOVE(void)
+{
+	int ret;
+	struct rs_ihmap map;
+	struct connection a = {.id = 1};
+	struct connection b = {.id = 2};
+	struct connection c = {.id = 3};
+
+	/* all in the same chain, removed from the middle, head and tail */
+	ret = rs_ihmap_init(&map, 0, &bad_vtable);
+	CU_ASSERT_EQUAL_FATAL(ret, 0);
+	rs_ihmap_insert(&map, &a.node);
+	rs_ihmap_insert(&map, &b.node);
+	rs_ihmap_insert(&map, &c.node);
+
+	/* normal use cases */
+	ret = rs_ihmap_remove(&map, &b.node);
+	CU_ASSERT_EQUAL(ret, 0);
+	CU_ASSERT_PTR_NULL(lookup(&map, 2));
+	CU_ASSERT_PTR_EQUAL(lookup(&map, 1), &a);
+	CU_ASSERT_PTR_EQUAL(lookup(&map, 3), &c);
+	ret = rs_ihmap_remove(&map, &c.node);
+	CU_ASSERT_EQUAL(ret, 0);
+	CU_ASSERT_PTR_EQUAL(lookup(&map, 1), &a);
+	ret = rs_ihmap_remove(&map, &a.node);
+	CU_ASSERT_EQUAL(ret, 0);
+	CU_ASSERT_EQUAL(rs_ihmap_get_count(&map), 0);
+	CU_ASSERT_PTR_NULL(rs_ihmap_first(&map));
+	/* a removed node can be inserted again */
+	ret = rs_ihmap_insert(&map, &b.node);
+	CU_ASSERT_EQUAL(ret, 0);
+	CU_ASSERT_PTR_EQUAL(lookup(&map, 2), &b);
+
+	/* error use cases */
+	ret = rs_ihmap_remove(&map, &a.node);
+	CU_ASSERT_EQUAL(ret, -ENOENT);
+	ret = rs_ihmap_remove(NULL, &b.node);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+	ret = rs_ihmap_remove(&map, NULL);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+
+	/* cleanup */
+	rs_ihmap_clean(&map);
+}
+
+static int visit_and_remove_odd(struct rs_ihmap_node *node, void *data)
+{
+	struct connection *c = ut_container_of(node, struct connection, node);
+
+	c->visits++;
+	if (c->id % 2 == 1)
+		rs_ihmap_remove(data, node);
+
+	return 0;
+}
+
+static int stop_at_id(struct rs_ihmap_node *node, void *data)
+{
+	struct connection *c = ut_container_of(node, struct connection, node);
+
+	return c->id == *(uint64_t *)data ? 42 : 0;
+}
+
+static void testRS_IHMAP_ITERATE(void)
+{
+	int ret;
+	int i;
+	bool ok = true;
+	size_t count = 0;
+	uint64_t id = 7;
+	struct rs_ihmap map;
+	struct rs_ihmap_node *node;
+	struct rs_ihmap_node *next;
+	static struct connection c[NB_CONNECTIONS];
+
+	/* few buckets, so that chains are long */
+	ret = rs_ihmap_init(&map, 0, &vtable);
+	CU_ASSERT_EQUAL_FATAL(ret, 0);
+	for (i = 0; i < NB_CONNECTIONS; i++) {
+		c[i] = (struct connection) {.id = i};
+		rs_ihmap_insert(&map, &c[i].node);
+	}
+
+	/* each node visited once, odd ones removed during the iteration */
+	ret = rs_ihmap_foreach(&map, visit_and_remove_odd, &map);
+	CU_ASSERT_EQUAL(ret, 0);
+	for (i = 0; i < NB_CONNECTIONS; i++)
+		ok = ok && c[i].visits == 1;
+	CU_ASSERT(ok);
+	CU_ASSERT_EQUAL(rs_ihmap_get_count(&map), NB_CONNECTIONS / 2);
+
+	/* the iteration stops at the callback's request */
+	ret = rs_ihmap_foreach(&map, stop_at_id, &id);
+	CU_ASSERT_EQUAL(ret, 0);
+	id = 8;
+	ret = rs_ihmap_foreach(&map, stop_at_id, &id);
+	CU_ASSERT_EQUAL(ret, 42);
+
+	/* manual iteration, removing every node */
+	for (node = rs_ihmap_first(&map); node != NULL; node = next) {
+		next = rs_ihmap_next(&map, node);
+		ok = ok && rs_ihmap_remove(&map, node) == 0;
+		count++;
+	}
+	CU_ASSERT(ok);
+	CU_ASSERT_EQUAL(count, NB_CONNECTIONS / 2);
+	CU_ASSERT_EQUAL(rs_ihmap_get_count(&map), 0);
+
+	/* error use cases */
+	ret = rs_ihmap_foreach(NULL, stop_at_id, &id);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+	ret = rs_ihmap_foreach(&map, NULL, &id);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+	CU_ASSERT_PTR_NULL(rs_ihmap_next(&map, NULL));
+
+	/* cleanup */
+	rs_ihmap_clean(&map);
+}
+
+static int free_connection(struct rs_ihmap_node *node, void *data)
+{
+	(*(int *)data)++;
+	free(ut_container_of(node, struct connection, node));
+
+	return 0;
+}
+
+static void testRS_IHMAP_CLEAN_CB(void)
+{
+	int ret;
+	int i;
+	int freed = 0;
+	struct rs_ihmap map;
+	struct connection *c;
+
+	ret = rs_ihmap_init(&map, 0, &vtable);
+	CU_ASSERT_EQUAL_FATAL(ret, 0);
+	for (i = 0; i < 100; i++) {
+		c = calloc(1, sizeof(*c));
+		c->id = i;
+		rs_ihmap_insert(&map, &c->node);
+	}
+
+	/* normal use cases */
+	ret = rs_ihmap_clean_cb(&map, free_connection, &freed);
+	CU_ASSERT_EQUAL(ret, 0);
+	CU_ASSERT_EQUAL(freed, 100);
+	CU_ASSERT_PTR_NULL(map.buckets);
+	/* cleaning twice is harmless */
+	ret = rs_ihmap_clean_cb(&map, free_connection, &freed);
+	CU_ASSERT_EQUAL(ret, 0);
+	CU_ASSERT_EQUAL(freed, 100);
+
+	/* error use cases */
+	ret = rs_ihmap_clean_cb(NULL, free_connection, &freed);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+}
+
+static const struct test_t tests[] = {
+		{
+				.fn = testRS_IHMAP_INIT,
+				.name = "rs_ihmap_init"
+		},
+		{
+				.fn = testRS_IHMAP_INSERT_LOOKUP,
+				.name = "rs_ihmap_insert_lookup"
+		},
+		{
+				.fn = testRS_IHMAP_REMOVE,
+				.name = "rs_ihmap_remove"
+		},
+		{
+				.fn = testRS_IHMAP_ITERATE,
+				.name = "rs_ihmap_iterate"
+		},
+		{
+				.fn = testRS_IHMAP_CLEAN_CB,
+				.name = "rs_ihmap_clean_cb"
+		},
+
+		/* NULL guard */
+		{.fn = NULL, .name = NULL},
+};
+
+struct suite_t ihmap_suite = {
+		.name = "rs_ihmap",
+		.init = NULL,
+		.clean = NULL,
+		.tests = tests,
+};
@@ -0,0 +1,515 @@
+/**
+ * @file rs_ohmap_test.c
+ * @date 19 oct. 2026
+ * @author nicolas.carrier@parrot.com
+ * @brief unit tests for librs open addressing hash map implementation
+ *
+ * Copyright (C) 2026 Parrot S.A.
+ */
+#include <stdio.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+#include <CUnit/Basic.h>
+
+#include <fautes.h>
+
+#include <rs_ohmap.h>
+
+#define NB_KEYS 10000
+
+static void testRS_OHMAP_INIT(void)
+{
+	int ret;
+	struct rs_ohmap map;
+
+	/* normal use cases */
+	ret = rs_ohmap_init(&map, 0);
+	CU_ASSERT_EQUAL(ret, 0);
+	CU_ASSERT_PTR_NOT_NULL(map.table.slots);
+	CU_ASSERT_EQUAL(rs_ohmap_get_count(&map), 0);
+	rs_ohmap_clean(&map);
+	ret = rs_ohmap_init(&map, 1000);
+	CU_ASSERT_EQUAL(ret, 0);
+	/* no growth is needed for the size requested */
+	CU_ASSERT((map.table.mask + 1) * 7 / 8 >= 1000);
+	rs_ohmap_clean(&map);
+
+	/* error use cases */
+	ret = rs_ohmap_init(&map, SIZE_MAX);
+	CU_ASSERT_EQUAL(ret, -E2BIG);
+	ret = rs_ohmap_init(NULL, 10);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+}
+
+static void testRS_OHMAP_CLEAN_FREE(void)
+{
+	int ret;
+	struct rs_ohmap map;
+	int *data1 = calloc(1, sizeof(int));
+	int *data2 = calloc(1, sizeof(int));
+
+	/* init */
+	ret = rs_ohmap_init(&map, 0);
+	CU_ASSERT_EQUAL(ret, 0);
+	ret = rs_ohmap_insert(&map, "ursule", data1);
+	CU_ASSERT_EQUAL(ret, 0);
+	ret = rs_ohmap_insert(&map, "gédéon", data2);
+	CU_ASSERT_EQUAL(ret, 0);
+
+	/* normal use cases */
+	ret = rs_ohmap_clean_cb(&map, free);
+	CU_ASSERT_EQUAL(ret, 0);
+	ret = rs_ohmap_clean_cb(&map, NULL);
+	CU_ASSERT_EQUAL(ret, 0);
+
+	/* error use cases */
+	ret = rs_ohmap_clean_cb(NULL, free);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+	ret = rs_ohmap_clean(NULL);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+}
+
+static void testRS_OHMAP_LOOKUP(void)
+{
+	int ret;
+	struct rs_ohmap map;
+	void *data1 = (void *)42;
+	void *data2 = (void *)66;
+	void *needle = NULL;
+
+	/* initialization */
+	ret = rs_ohmap_init(&map, 0);
+	CU_ASSERT_EQUAL(ret, 0);
+	ret = rs_ohmap_insert(&map, "ursule", data1);
+	CU_ASSERT_EQUAL(ret, 0);
+	ret = rs_ohmap_insert(&map, "gédéon", data2);
+	CU_ASSERT_EQUAL(ret, 0);
+
+	/* normal use cases */
+	ret = rs_ohmap_lookup(&map, "ursule", &needle);
+	CU_ASSERT_EQUAL(ret, 0);
+	CU_ASSERT_PTR_EQUAL(needle, data1);
+	ret = rs_ohmap_lookup(&map, "gédéon", &needle);
+	CU_ASSERT_EQUAL(ret, 0);
+	CU_ASSERT_PTR_EQUAL(needle, data2);
+	ret = rs_ohmap_lookup(&map, "frénégonde", &needle);
+	CU_ASSERT_EQUAL(ret, -ENOENT);
+	CU_ASSERT_PTR_EQUAL(needle, NULL);
+
+	/* error use cases */
+	ret = rs_ohmap_lookup(NULL, "ursule", &needle);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+	ret = rs_ohmap_lookup(&map, NULL, &needle);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+	ret = rs_ohmap_lookup(&map, "", &needle);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+	ret = rs_ohmap_lookup(&map, "ursule", NULL);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+
+	/* cleanup */
+	rs_ohmap_clean(&map);
+}
+
+static void testRS_OHMAP_INSERT(void)
+{
+	int ret;
+	struct rs_ohmap map;
+	void *needle = NULL;
+
+	/* initialization */
+	ret = rs_ohmap_init(&map, 0);
+	CU_ASSERT_EQUAL(ret, 0);
+
+	/* normal use cases */
+	/* inserting NULL is allowed */
+	ret = rs_ohmap_insert(&map, "ursule", NULL);
+	CU_ASSERT_EQUAL(ret, 0);
+	CU_ASSERT_EQUAL(rs_ohmap_get_count(&map), 1);
+
+	/* error use cases */
+	/* keys are unique */
+	ret = rs_ohmap_insert(&map, "ursule", &needle);
+	CU_ASSERT_EQUAL(ret, -EEXIST);
+	ret = rs_ohmap_insert(NULL, "ursule", &needle);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+	ret = rs_ohmap_insert(&map, NULL, &needle);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+	ret = rs_ohmap_insert(&map, "", &needle);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+	rs_ohmap_clean(&map);
+	/* inserting in a cleaned hash map must fail cleanly */
+	ret = rs_ohmap_insert(&map, "ursule", &needle);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+}
+
+static void testRS_OHMAP_REMOVE(void)
+{
+	int ret;
+	struct rs_ohmap map;
+	void *data1 = (void *)42;
+	void *data2 = (void *)66;
+	void *needle = NULL;
+
+	/* initialization */
+	ret = rs_ohmap_init(&map, 0);
+	CU_ASSERT_EQUAL(ret, 0);
+	ret = rs_ohmap_insert(&map, "ursule", data1);
+	CU_ASSERT_EQUAL(ret, 0);
+	ret = rs_ohmap_insert(&map, "gédéon", data2);
+	CU_ASSERT_EQUAL(ret, 0);
+
+	/* normal use cases */
+	ret = rs_ohmap_remove(&map, "ursule", &needle);
+	CU_ASSERT_EQUAL(ret, 0);
+	CU_ASSERT_PTR_EQUAL(needle, data1);
+	ret = rs_ohmap_remove(&map, "gédéon", NULL);
+	CU_ASSERT_EQUAL(ret, 0);
+	CU_ASSERT_EQUAL(rs_ohmap_get_count(&map), 0);
+	ret = rs_ohmap_remove(&map, "ursule", &needle);
+	CU_ASSERT_EQUAL(ret, -ENOENT);
+	CU_ASSERT_PTR_EQUAL(needle, NULL);
+
+	/* error use cases */
+	ret = rs_ohmap_remove(NULL, "ursule", &needle);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+	ret = rs_ohmap_remove(&map, NULL, &needle);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+	ret = rs_ohmap_remove(&map, "", &needle);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+
+	/* cleanup */
+	rs_ohmap_clean(&map);
+}
+
+static bool lookup_range(struct rs_ohmap *map, int from, int to, bool present)
+{
+	char key[16];
+	void *needle;
+	int ret;
+	int i;
+
+	for (i = from; i < to; i++) {
+		snprintf(key, sizeof(key), "key%d", i);
+		ret = rs_ohmap_lookup(map, key, &needle);
+		if (present && (ret != 0 || needle != (void *)(intptr_t)i))
+			return false;
+		if (!present && ret != -ENOENT)
+			return false;
+	}
+
+	return true;
+}
+
+static void testRS_OHMAP_GROWTH(void)
+{
+	int ret;
+	int i;
+	bool migrating = false;
+	bool ok = true;
+	char key[16];
+	void *needle;
+	struct rs_ohmap map;
+
+	ret = rs_ohmap_init(&map, 0);
+	CU_ASSERT_EQUAL_FATAL(ret, 0);
+
+	/* all the keys are found, while entries are migrated too */
+	for (i = 0; i < NB_KEYS; i++) {
+		snprintf(key, sizeof(key), "key%d", i);
+		ret = rs_ohmap_insert(&map, key, (void *)(intptr_t)i);
+		ok = ok && ret == 0;
+		if (map.old.slots != NULL && i % 97 == 0) {
+			migrating = true;
+			ok = ok && lookup_range(&map, 0, i + 1, true);
+		}
+	}
+	CU_ASSERT(ok);
+	CU_ASSERT(migrating);
+	CU_ASSERT_EQUAL(rs_ohmap_get_count(&map), NB_KEYS);
+	CU_ASSERT(lookup_range(&map, 0, NB_KEYS, true));
+
+	/* half of the keys removed, the others are still found */
+	for (i = 0; i < NB_KEYS; i += 2) {
+		snprintf(key, sizeof(key), "key%d", i);
+		ok = ok && rs_ohmap_remove(&map, key, NULL) == 0;
+	}
+	CU_ASSERT(ok);
+	CU_ASSERT_EQUAL(rs_ohmap_get_count(&map), NB_KEYS / 2);
+	for (i = 0; i < NB_KEYS; i++) {
+		snprintf(key, sizeof(key), "key%d", i);
+		ret = rs_ohmap_lookup(&map, key, &needle);
+		ok = ok && (i % 2 == 0 ? ret == -ENOENT : ret == 0);
+	}
+	CU_ASSERT(ok);
+
+	/* cleanup */
+	rs_ohmap_clean(&map);
+}
+
+static void testRS_OHMAP_INIT_KEYS(void)
+{
+	int ret;
+	struct rs_ohmap map;
+	void *needle;
+	struct rs_ohmap_keys keys = {
+		.type = RS_OHMAP_KEY_U64,
+		.hash = RS_OHMAP_HASH_FNV1A,
+	};
+
+	/* normal use cases */
+	ret = rs_ohmap_init_keys(&map, 0, NULL);
+	CU_ASSERT_EQUAL(ret, 0);
+	CU_ASSERT_EQUAL(map.keys.type, RS_OHMAP_KEY_STRING);
+	CU_ASSERT_EQUAL(map.keys.hash, RS_OHMAP_HASH_WYHASH);
+	CU_ASSERT_FALSE(map.keys.borrowed);
+	rs_ohmap_clean(&map);
+	ret = rs_ohmap_init_keys(&map, 100, &keys);
+	CU_ASSERT_EQUAL(ret, 0);
+	CU_ASSERT_EQUAL(map.keys.type, RS_OHMAP_KEY_U64);
+	CU_ASSERT_EQUAL(map.keys.hash, RS_OHMAP_HASH_FNV1A);
+
+	/* error use cases */
+	/* only the functions matching the type of keys can be used */
+	ret = rs_ohmap_insert(&map, "ursule", NULL);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+	ret = rs_ohmap_insert_bytes(&map, "ursule", 6, NULL);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+	ret = rs_ohmap_lookup(&map, "ursule", &needle);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+	ret = rs_ohmap_remove_bytes(&map, "ursule", 6, NULL);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+	rs_ohmap_clean(&map);
+	ret = rs_ohmap_init(&map, 0);
+	CU_ASSERT_EQUAL(ret, 0);
+	ret = rs_ohmap_insert_u64(&map, 42, NULL);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+	rs_ohmap_clean(&map);
+	keys.type = RS_OHMAP_KEY_U64 + 1;
+	ret = rs_ohmap_init_keys(&map, 0, &keys);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+	keys.type = RS_OHMAP_KEY_BYTES;
+	keys.hash = RS_OHMAP_HASH_FNV1A + 1;
+	ret = rs_ohmap_init_keys(&map, 0, &keys);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+	ret = rs_ohmap_init_keys(NULL, 0, NULL);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+}
+
+static void check_u64(enum rs_ohmap_hash hash)
+{
+	int ret;
+	uint64_t i;
+	bool ok = true;
+	void *needle = NULL;
+	struct rs_ohmap map;
+	struct rs_ohmap_keys keys = {.type = RS_OHMAP_KEY_U64, .hash = hash};
+
+	ret = rs_ohmap_init_keys(&map, 0, &keys);
+	CU_ASSERT_EQUAL_FATAL(ret, 0);
+
+	/* normal use cases */
+	ret = rs_ohmap_insert_u64(&map, 0, (void *)42);
+	CU_ASSERT_EQUAL(ret, 0);
+	ret = rs_ohmap_insert_u64(&map, UINT64_MAX, (void *)66);
+	CU_ASSERT_EQUAL(ret, 0);
+	ret = rs_ohmap_lookup_u64(&map, 0, &needle);
+	CU_ASSERT_EQUAL(ret, 0);
+	CU_ASSERT_PTR_EQUAL(needle, (void *)42);
+	ret = rs_ohmap_remove_u64(&map, UINT64_MAX, &needle);
+	CU_ASSERT_EQUAL(ret, 0);
+	CU_ASSERT_PTR_EQUAL(needle, (void *)66);
+	ret = rs_ohmap_lookup_u64(&map, UINT64_MAX, &needle);
+	CU_ASSERT_EQUAL(ret, -ENOENT);
+	CU_ASSERT_PTR_EQUAL(needle, NULL);
+	ret = rs_ohmap_remove_u64(&map, 0, NULL);
+	CU_ASSERT_EQUAL(ret, 0);
+
+	/* keys differing only by their high bits, through growth */
+	for (i = 0; i < NB_KEYS; i++)
+		ok = ok && rs_ohmap_insert_u64(&map, i << 40,
+				(void *)(intptr_t)i) == 0;
+	CU_ASSERT(ok);
+	CU_ASSERT_EQUAL(rs_ohmap_get_count(&map), NB_KEYS);
+	for (i = 0; i < NB_KEYS; i++) {
+		ret = rs_ohmap_lookup_u64(&map, i << 40, &needle);
+		ok = ok && ret == 0 && needle == (void *)(intptr_t)i;
+	}
+	CU_ASSERT(ok);
+
+	/* error use cases */
+	ret = rs_ohmap_insert_u64(&map, 0, NULL);
+	CU_ASSERT_EQUAL(ret, -EEXIST);
+	ret = rs_ohmap_lookup_u64(&map, 0, NULL);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+	ret = rs_ohmap_remove_u64(NULL, 0, NULL);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+
+	/* cleanup */
+	rs_ohmap_clean(&map);
+}
+
+static void testRS_OHMAP_U64(void)
+{
+	check_u64(RS_OHMAP_HASH_WYHASH);
+	check_u64(RS_OHMAP_HASH_FNV1A);
+}
+
+struct tuple {
+	uint32_t a;
+	uint16_t b;
+	uint8_t c[2];
+};
+
+static void testRS_OHMAP_BYTES(void)
+{
+	int ret;
+	struct rs_ohmap map;
+	struct tuple t1 = {.a = 1, .b = 2, .c = {0, 3}};
+	struct tuple t2 = {.a = 1, .b = 2, .c = {0, 4}};
+	void *needle = NULL;
+	struct rs_ohmap_keys keys = {.type = RS_OHMAP_KEY_BYTES};
+
+	ret = rs_ohmap_init_keys(&map, 0, &keys);
+	CU_ASSERT_EQUAL_FATAL(ret, 0);
+
+	/* normal use cases */
+	ret = rs_ohmap_insert_bytes(&map, &t1, sizeof(t1), (void *)42);
+	CU_ASSERT_EQUAL(ret, 0);
+	/* a prefix of a key is another key */
+	ret = rs_ohmap_insert_bytes(&map, &t1, 6, (void *)66);
+	CU_ASSERT_EQUAL(ret, 0);
+	ret = rs_ohmap_lookup_bytes(&map, &t2, sizeof(t2), &needle);
+	CU_ASSERT_EQUAL(ret, -ENOENT);
+	ret = rs_ohmap_lookup_bytes(&map, &t2, 6, &needle);
+	CU_ASSERT_EQUAL(ret, 0);
+	CU_ASSERT_PTR_EQUAL(needle, (void *)66);
+	/* the key was copied */
+	t1.c[1] = 5;
+	t2.c[1] = 3;
+	ret = rs_ohmap_lookup_bytes(&map, &t2, sizeof(t2), &needle);
+	CU_ASSERT_EQUAL(ret, 0);
+	CU_ASSERT_PTR_EQUAL(needle, (void *)42);
+	ret = rs_ohmap_remove_bytes(&map, &t2, sizeof(t2), &needle);
+	CU_ASSERT_EQUAL(ret, 0);
+	CU_ASSERT_PTR_EQUAL(needle, (void *)42);
+	CU_ASSERT_EQUAL(rs_ohmap_get_count(&map), 1);
+
+	/* error use cases */
+	ret = rs_ohmap_insert_bytes(&map, &t2, 6, NULL);
+	CU_ASSERT_EQUAL(ret, -EEXIST);
+	ret = rs_ohmap_insert_bytes(&map, &t2, 0, NULL);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+	ret = rs_ohmap_insert_bytes(&map, NULL, 6, NULL);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+	ret = rs_ohmap_lookup_bytes(&map, &t2, 6, NULL);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+	ret = rs_ohmap_remove_bytes(NULL, &t2, 6, NULL);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+
+	/* cleanup */
+	rs_ohmap_clean(&map);
+}
+
+static bool slot_has_key(struct rs_ohmap *map, const void *key)
+{
+	size_t i;
+
+	for (i = 0; i <= map->table.mask; i++)
+		if (map->table.slots[i].dib != 0 &&
+				map->table.slots[i].key.ptr == key)
+			return true;
+
+	return false;
+}
+
+static void testRS_OHMAP_BORROWED(void)
+{
+	int ret;
+	struct rs_ohmap map;
+	char name[] = "ursule";
+	struct tuple t = {.a = 1, .b = 2};
+	void *needle = NULL;
+	struct rs_ohmap_keys keys = {
+		.type = RS_OHMAP_KEY_STRING,
+		.borrowed = true,
+	};
+
+	/* normal use cases */
+	ret = rs_ohmap_init_keys(&map, 0, &keys);
+	CU_ASSERT_EQUAL_FATAL(ret, 0);
+	ret = rs_ohmap_insert(&map, name, (void *)42);
+	CU_ASSERT_EQUAL(ret, 0);
+	CU_ASSERT(slot_has_key(&map, name));
+	ret = rs_ohmap_lookup(&map, "ursule", &needle);
+	CU_ASSERT_EQUAL(ret, 0);
+	CU_ASSERT_PTR_EQUAL(needle, (void *)42);
+	ret = rs_ohmap_remove(&map, "ursule", NULL);
+	CU_ASSERT_EQUAL(ret, 0);
+	rs_ohmap_clean(&map);
+
+	keys.type = RS_OHMAP_KEY_BYTES;
+	ret = rs_ohmap_init_keys(&map, 0, &keys);
+	CU_ASSERT_EQUAL_FATAL(ret, 0);
+	ret = rs_ohmap_insert_bytes(&map, &t, sizeof(t), (void *)66);
+	CU_ASSERT_EQUAL(ret, 0);
+	CU_ASSERT(slot_has_key(&map, &t));
+	/* cleaning must not free the keys */
+	rs_ohmap_clean(&map);
+}
+
+static const struct test_t tests[] = {
+		{
+				.fn = testRS_OHMAP_INIT,
+				.name = "rs_ohmap_init"
+		},
+		{
+				.fn = testRS_OHMAP_CLEAN_FREE,
+				.name = "rs_ohmap_clean_free"
+		},
+		{
+				.fn = testRS_OHMAP_LOOKUP,
+				.name = "rs_ohmap_lookup"
+		},
+		{
+				.fn = testRS_OHMAP_INSERT,
+				.name = "rs_ohmap_insert"
+		},
+		{
+				.fn = testRS_OHMAP_REMOVE,
+				.name = "rs_ohmap_remove"
+		},
+		{
+				.fn = testRS_OHMAP_GROWTH,
+				.name = "rs_ohmap_growth"
+		},
+		{
+				.fn = testRS_OHMAP_INIT_KEYS,
+				.name = "rs_ohmap_init_keys"
+		},
+		{
+				.fn = testRS_OHMAP_U64,
+				.name = "rs_ohmap_u64"
+		},
+		{
+				.fn = testRS_OHMAP_BYTES,
+				.name = "rs_ohmap_bytes"
+		},
+		{
+				.fn = testRS_OHMAP_BORROWED,
+				.name = "rs_ohmap_borrowed"
+		},
+
+		/* NULL guard */
+		{.fn = NULL, .name = NULL},
+};
+
+struct suite_t ohmap_suite = {
+		.name = "rs_ohmap",
+		.init = NULL,
+		.clean = NULL,
+		.tests = tests,
+};
@@ -0,0 +1,239 @@
+/**
+ * @file rs_rb_spsc_test.c
+ * @date 19 oct. 2026
+ * @author nicolas.carrier@parrot.com
+ * @brief unit tests for librs single producer, single consumer ring buffer
+ *
+ * Copyright (C) 2026 Parrot S.A.
+ */
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+
+#include <CUnit/Basic.h>
+
+#include <ut_utils.h>
+
+#include <fautes.h>
+
+#include <rs_rb_spsc.h>
+
+#define NB_VALUES 1000000
+
+static void testRS_RB_SPSC_INIT(void)
+{
+	int ret;
+	struct rs_rb_spsc spsc;
+	char buffer[8];
+
+	/* normal use cases */
+	ret = rs_rb_spsc_init(&spsc, buffer, sizeof(buffer));
+	CU_ASSERT_EQUAL(ret, 0);
+	CU_ASSERT_EQUAL(rs_rb_spsc_get_size(&spsc), sizeof(buffer));
+	CU_ASSERT_EQUAL(rs_rb_spsc_get_read_length(&spsc), 0);
+	CU_ASSERT_EQUAL(rs_rb_spsc_get_write_length(&spsc), sizeof(buffer));
+	ret = rs_rb_spsc_clean(&spsc);
+	CU_ASSERT_EQUAL(ret, 0);
+	ret = rs_rb_spsc_init(&spsc, NULL, 1);
+	CU_ASSERT_EQUAL(ret, 0);
+	CU_ASSERT_EQUAL(rs_rb_spsc_get_size(&spsc), sysconf(_SC_PAGE_SIZE));
+	ret = rs_rb_spsc_clean(&spsc);
+	CU_ASSERT_EQUAL(ret, 0);
+
+	/* error use cases */
+	ret = rs_rb_spsc_init(NULL, buffer, sizeof(buffer));
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+	ret = rs_rb_spsc_init(&spsc, buffer, 7);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+	ret = rs_rb_spsc_clean(NULL);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+	CU_ASSERT_EQUAL(rs_rb_spsc_get_size(NULL), 0);
+	CU_ASSERT_EQUAL(rs_rb_spsc_get_read_length(NULL), 0);
+	CU_ASSERT_EQUAL(rs_rb_spsc_get_write_length(NULL), 0);
+	CU_ASSERT_PTR_NULL(rs_rb_spsc_get_read_ptr(NULL));
+	CU_ASSERT_PTR_NULL(rs_rb_spsc_get_write_ptr(NULL));
+}
+
+static void testRS_RB_SPSC_READ_WRITE(void)
+{
+	int ret;
+	struct rs_rb_spsc spsc;
+	char buffer[8];
+	char out[8];
+
+	ret = rs_rb_spsc_init(&spsc, buffer, sizeof(buffer));
+	CU_ASSERT_EQUAL_FATAL(ret, 0);
+
+	/* normal use cases */
+	ret = rs_rb_spsc_write(&spsc, "abcdef", 6);
+	CU_ASSERT_EQUAL(ret, 0);
+	CU_ASSERT_EQUAL(rs_rb_spsc_get_read_length(&spsc), 6);
+	CU_ASSERT_EQUAL(rs_rb_spsc_get_write_length(&spsc), 2);
+	ret = rs_rb_spsc_read(&spsc, out, 4);
+	CU_ASSERT_EQUAL(ret, 0);
+	CU_ASSERT_EQUAL(memcmp(out, "abcd", 4), 0);
+	/* wraps at the end of the buffer */
+	ret = rs_rb_spsc_write(&spsc, "ghijkl", 6);
+	CU_ASSERT_EQUAL(ret, 0);
+	CU_ASSERT_EQUAL(rs_rb_spsc_get_write_length(&spsc), 0);
+	CU_ASSERT_EQUAL(rs_rb_spsc_get_read_length_no_wrap(&spsc), 4);
+	CU_ASSERT_EQUAL(rs_rb_spsc_get_read_ptr(&spsc), buffer + 4);
+	ret = rs_rb_spsc_read(&spsc, out, 8);
+	CU_ASSERT_EQUAL(ret, 0);
+	CU_ASSERT_EQUAL(memcmp(out, "efghijkl", 8), 0);
+	CU_ASSERT_EQUAL(rs_rb_spsc_get_read_length(&spsc), 0);
+	ret = rs_rb_spsc_write(&spsc, NULL, 0);
+	CU_ASSERT_EQUAL(ret, 0);
+
+	/* error use cases */
+	ret = rs_rb_spsc_read(&spsc, out, 1);
+	CU_ASSERT_EQUAL(ret, -EAGAIN);
+	ret = rs_rb_spsc_write(&spsc, "abcdefghi", 9);
+	CU_ASSERT_EQUAL(ret, -EAGAIN);
+	ret = rs_rb_spsc_read(NULL, out, 1);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+	ret = rs_rb_spsc_read(&spsc, NULL, 1);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+	ret = rs_rb_spsc_write(NULL, "a", 1);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+	ret = rs_rb_spsc_write(&spsc, NULL, 1);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+
+	/* cleanup */
+	rs_rb_spsc_clean(&spsc);
+}
+
+static void testRS_RB_SPSC_INCR(void)
+{
+	int ret;
+	struct rs_rb_spsc spsc;
+	char *ptr;
+
+	ret = rs_rb_spsc_init(&spsc, NULL, 1);
+	CU_ASSERT_EQUAL_FATAL(ret, 0);
+
+	/* normal use cases */
+	ptr = rs_rb_spsc_get_write_ptr(&spsc);
+	CU_ASSERT_PTR_NOT_NULL_FATAL(ptr);
+	memcpy(ptr, "ursule", 6);
+	ret = rs_rb_spsc_write_incr(&spsc, 6);
+	CU_ASSERT_EQUAL(ret, 0);
+	CU_ASSERT_EQUAL(rs_rb_spsc_get_read_length(&spsc), 6);
+	CU_ASSERT_EQUAL(memcmp(rs_rb_spsc_get_read_ptr(&spsc), "ursule", 6), 0);
+	ret = rs_rb_spsc_read_incr(&spsc, 6);
+	CU_ASSERT_EQUAL(ret, 0);
+	/* the mirrored buffer never wraps */
+	ret = rs_rb_spsc_write_incr(&spsc, rs_rb_spsc_get_size(&spsc) - 6);
+	CU_ASSERT_EQUAL(ret, 0);
+	ret = rs_rb_spsc_read_incr(&spsc, rs_rb_spsc_get_size(&spsc) - 6);
+	CU_ASSERT_EQUAL(ret, 0);
+	ptr = rs_rb_spsc_get_write_ptr(&spsc);
+	CU_ASSERT_EQUAL(rs_rb_spsc_get_write_length_no_wrap(&spsc),
+			rs_rb_spsc_get_size(&spsc));
+	memset(ptr, 'x', rs_rb_spsc_get_size(&spsc));
+	ret = rs_rb_spsc_write_incr(&spsc, rs_rb_spsc_get_size(&spsc));
+	CU_ASSERT_EQUAL(ret, 0);
+	CU_ASSERT_EQUAL(rs_rb_spsc_get_read_length_no_wrap(&spsc),
+			rs_rb_spsc_get_size(&spsc));
+
+	/* error use cases */
+	ret = rs_rb_spsc_write_incr(&spsc, 1);
+	CU_ASSERT_EQUAL(ret, -ENOBUFS);
+	ret = rs_rb_spsc_read_incr(&spsc, rs_rb_spsc_get_size(&spsc) + 1);
+	CU_ASSERT_EQUAL(ret, -ENOSR);
+	ret = rs_rb_spsc_read_incr(NULL, 1);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+	ret = rs_rb_spsc_write_incr(NULL, 1);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+
+	/* cleanup */
+	rs_rb_spsc_clean(&spsc);
+}
+
+static void *producer(void *arg)
+{
+	struct rs_rb_spsc *spsc = arg;
+	uint32_t values[7];
+	uint32_t next = 0;
+	unsigned n;
+	unsigned i;
+
+	/* batches of varying sizes, to cross the end of the buffer anywhere */
+	while (next < NB_VALUES) {
+		n = next % UT_ARRAY_SIZE(values) + 1;
+		if (n > NB_VALUES - next)
+			n = NB_VALUES - next;
+		for (i = 0; i < n; i++)
+			values[i] = next + i;
+		while (rs_rb_spsc_write(spsc, values, n * sizeof(*values)) ==
+				-EAGAIN)
+			sched_yield();
+		next += n;
+	}
+
+	return NULL;
+}
+
+static void testRS_RB_SPSC_CONCURRENCY(void)
+{
+	int ret;
+	bool ok = true;
+	struct rs_rb_spsc spsc;
+	pthread_t thread;
+	uint32_t value;
+	uint32_t expected;
+	char buffer[64];
+
+	/* a small, not mirrored buffer, which wraps often */
+	ret = rs_rb_spsc_init(&spsc, buffer, sizeof(buffer));
+	CU_ASSERT_EQUAL_FATAL(ret, 0);
+	ret = pthread_create(&thread, NULL, producer, &spsc);
+	CU_ASSERT_EQUAL_FATAL(ret, 0);
+
+	/* the values are received in order, none is lost or corrupted */
+	for (expected = 0; expected < NB_VALUES; expected++) {
+		while (rs_rb_spsc_read(&spsc, &value, sizeof(value)) == -EAGAIN)
+			sched_yield();
+		ok = ok && value == expected;
+	}
+	CU_ASSERT(ok);
+	pthread_join(thread, NULL);
+	CU_ASSERT_EQUAL(rs_rb_spsc_get_read_length(&spsc), 0);
+
+	/* cleanup */
+	rs_rb_spsc_clean(&spsc);
+}
+
+static const struct test_t tests[] = {
+		{
+				.fn = testRS_RB_SPSC_INIT,
+				.name = "rs_rb_spsc_init"
+		},
+		{
+				.fn = testRS_RB_SPSC_READ_WRITE,
+				.name = "rs_rb_spsc_read_write"
+		},
+		{
+				.fn = testRS_RB_SPSC_INCR,
+				.name = "rs_rb_spsc_incr"
+		},
+		{
+				.fn = testRS_RB_SPSC_CONCURRENCY,
+				.name = "rs_rb_spsc_concurrency"
+		},
+
+		/* NULL guard */
+		{.fn = NULL, .name = NULL},
+};
+
+struct suite_t rb_spsc_suite = {
+		.name = "rs_rb_spsc",
+		.init = NULL,
+		.clean = NULL,
+		.tests = tests,
+};
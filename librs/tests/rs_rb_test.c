@@ -6,6 +6,16 @@
  *
  * Copyright (C) 2013 Parrot S.A.
  */
+#define _GNU_SOURCE
+#include <sys/mman.h>
+#include <sys/uio.h>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <errno.h>
+#include <string.h>
+
 #include <CUnit/Basic.h>
 
 #include <fautes.h>
@@ -38,6 +48,151 @@ static void testRS_RB_INIT(void)
 	CU_ASSERT_NOT_EQUAL(ret, 0);
 }
 
+static void testRS_RB_INIT_MIRRORED(void)
+{
+	struct rs_rb rb;
+	int ret;
+	size_t page_size = sysconf(_SC_PAGE_SIZE);
+	char *base;
+
+	/* normal use cases */
+	ret = rs_rb_init_mirrored(&rb, 1, 0);
+	CU_ASSERT_EQUAL_FATAL(ret, 0);
+	CU_ASSERT_EQUAL(rb.size, page_size);
+	CU_ASSERT(rb.mirror);
+	CU_ASSERT_EQUAL(rs_rb_get_fd(&rb), -EBADF);
+	/* what is written at the end of the buffer appears at it's start */
+	base = rb.base;
+	memcpy(base + page_size - 3, "abcdef", 6);
+	CU_ASSERT_EQUAL(memcmp(base, "def", 3), 0);
+	CU_ASSERT_EQUAL(memcmp(base + 2 * page_size - 3, "abc", 3), 0);
+	ret = rs_rb_clean(&rb);
+	CU_ASSERT_EQUAL(ret, 0);
+	/* transparent huge pages are only a hint */
+	ret = rs_rb_init_mirrored(&rb, 0x400000, RS_RB_THP);
+	CU_ASSERT_EQUAL_FATAL(ret, 0);
+	CU_ASSERT_EQUAL(rb.size, 0x400000);
+	base = rb.base;
+	base[0x3fffff] = 'x';
+	CU_ASSERT_EQUAL(base[0x7fffff], 'x');
+	ret = rs_rb_clean(&rb);
+	CU_ASSERT_EQUAL(ret, 0);
+	/* huge pages may not be reserved on the test machine */
+	ret = rs_rb_init_mirrored(&rb, 1, RS_RB_HUGETLB);
+	if (ret == 0) {
+		CU_ASSERT(rb.size > page_size);
+		ret = rs_rb_clean(&rb);
+		CU_ASSERT_EQUAL(ret, 0);
+	}
+
+	/* error use cases */
+	ret = rs_rb_init_mirrored(NULL, 1, 0);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+	ret = rs_rb_init_mirrored(&rb, 0, 0);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+	ret = rs_rb_init_mirrored(&rb, 3 * page_size, 0);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+	ret = rs_rb_init_mirrored(&rb, 1, ~RS_RB_FLAGS);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+	ret = rs_rb_get_fd(NULL);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+}
+
+static void testRS_RB_INIT_FROM_FD(void)
+{
+	struct rs_rb rb;
+	struct rs_rb peer;
+	int ret;
+	int fd;
+	int unsealed;
+
+	ret = rs_rb_init_mirrored(&rb, 0x2000, RS_RB_SHARED);
+	CU_ASSERT_EQUAL_FATAL(ret, 0);
+	fd = rs_rb_get_fd(&rb);
+	CU_ASSERT_FATAL(fd >= 0);
+
+	/* normal use cases */
+	ret = rs_rb_init_from_fd(&peer, fd);
+	CU_ASSERT_EQUAL_FATAL(ret, 0);
+	CU_ASSERT_EQUAL(peer.size, rb.size);
+	CU_ASSERT_NOT_EQUAL(peer.base, rb.base);
+	CU_ASSERT_EQUAL(rs_rb_get_fd(&peer), -EBADF);
+	/* the content is shared, not the offsets */
+	memcpy(rs_rb_get_write_ptr(&rb), "ursule", 6);
+	ret = rs_rb_write_incr(&rb, 6);
+	CU_ASSERT_EQUAL(ret, 0);
+	CU_ASSERT_EQUAL(memcmp(rs_rb_get_read_ptr(&peer), "ursule", 6), 0);
+	CU_ASSERT_EQUAL(rs_rb_get_read_length(&peer), 0);
+	/* the peer can't resize the buffer */
+	CU_ASSERT_EQUAL(ftruncate(fd, 0x1000), -1);
+	ret = rs_rb_clean(&peer);
+	CU_ASSERT_EQUAL(ret, 0);
+
+	/* error use cases */
+	ret = rs_rb_init_from_fd(NULL, fd);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+	ret = rs_rb_init_from_fd(&peer, -1);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+	/* a file which can be shrunk under our feet is refused */
+	unsealed = memfd_create("rs_rb_test", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+	CU_ASSERT_FATAL(unsealed >= 0);
+	CU_ASSERT_EQUAL(ftruncate(unsealed, 0x2000), 0);
+	ret = rs_rb_init_from_fd(&peer, unsealed);
+	CU_ASSERT_EQUAL(ret, -EPERM);
+	CU_ASSERT_EQUAL(fcntl(unsealed, F_ADD_SEALS, F_SEAL_SHRINK), 0);
+	ret = rs_rb_init_from_fd(&peer, unsealed);
+	CU_ASSERT_EQUAL(ret, 0);
+	rs_rb_clean(&peer);
+	close(unsealed);
+	/* the memfd is closed with it's ring buffer */
+	ret = rs_rb_clean(&rb);
+	CU_ASSERT_EQUAL(ret, 0);
+	ret = rs_rb_init_from_fd(&peer, fd);
+	CU_ASSERT_EQUAL(ret, -EBADF);
+}
+
+static void testRS_RB_INIT_FROM_FD_AT(void)
+{
+	struct rs_rb rb;
+	struct rs_rb peer;
+	int ret;
+	int fd;
+	size_t page_size = sysconf(_SC_PAGE_SIZE);
+
+	ret = rs_rb_init_mirrored(&rb, 2 * page_size, RS_RB_SHARED);
+	CU_ASSERT_EQUAL_FATAL(ret, 0);
+	fd = rs_rb_get_fd(&rb);
+
+	/* normal use cases */
+	ret = rs_rb_init_from_fd_at(&peer, fd, page_size, page_size);
+	CU_ASSERT_EQUAL_FATAL(ret, 0);
+	CU_ASSERT_EQUAL(peer.size, page_size);
+	/* the second page of the file, mirrored */
+	memcpy((char *)rb.base + page_size, "ursule", 6);
+	CU_ASSERT_EQUAL(memcmp(peer.base, "ursule", 6), 0);
+	CU_ASSERT_EQUAL(memcmp((char *)peer.base + page_size, "ursule", 6),
+			0);
+	ret = rs_rb_clean(&peer);
+	CU_ASSERT_EQUAL(ret, 0);
+
+	/* error use cases */
+	ret = rs_rb_init_from_fd_at(NULL, fd, 0, page_size);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+	ret = rs_rb_init_from_fd_at(&peer, -1, 0, page_size);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+	ret = rs_rb_init_from_fd_at(&peer, fd, -1, page_size);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+	ret = rs_rb_init_from_fd_at(&peer, fd, page_size / 2, page_size);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+	ret = rs_rb_init_from_fd_at(&peer, fd, page_size, 2 * page_size);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+	ret = rs_rb_init_from_fd_at(&peer, fd, 0, 3 * page_size);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+
+	/* cleanup */
+	rs_rb_clean(&rb);
+}
+
 static void testRS_RB_GET_SIZE(void)
 {
 	struct rs_rb rb;
@@ -395,11 +550,268 @@ static void testRS_RB_WRITE_INCR(void)
 	CU_ASSERT_NOT_EQUAL(ret, 0);
 }
 
+static void testRS_RB_IOVEC(void)
+{
+	struct rs_rb rb;
+	int ret;
+	char buffer[8];
+	struct iovec iov[2];
+
+	ret = rs_rb_init(&rb, buffer, sizeof(buffer));
+	CU_ASSERT_EQUAL_FATAL(ret, 0);
+
+	/* normal use cases */
+	CU_ASSERT_EQUAL(rs_rb_get_read_iovec(&rb, iov), 0);
+	ret = rs_rb_get_write_iovec(&rb, iov);
+	CU_ASSERT_EQUAL(ret, 1);
+	CU_ASSERT_EQUAL(iov[0].iov_base, buffer);
+	CU_ASSERT_EQUAL(iov[0].iov_len, 8);
+	rs_rb_write_incr(&rb, 6);
+	rs_rb_read_incr(&rb, 4);
+	/* room wraps, from 6 to 4 */
+	ret = rs_rb_get_write_iovec(&rb, iov);
+	CU_ASSERT_EQUAL(ret, 2);
+	CU_ASSERT_EQUAL(iov[0].iov_base, buffer + 6);
+	CU_ASSERT_EQUAL(iov[0].iov_len, 2);
+	CU_ASSERT_EQUAL(iov[1].iov_base, buffer);
+	CU_ASSERT_EQUAL(iov[1].iov_len, 4);
+	rs_rb_write_incr(&rb, 3);
+	/* data wraps, from 4 to 1 */
+	ret = rs_rb_get_read_iovec(&rb, iov);
+	CU_ASSERT_EQUAL(ret, 2);
+	CU_ASSERT_EQUAL(iov[0].iov_base, buffer + 4);
+	CU_ASSERT_EQUAL(iov[0].iov_len, 4);
+	CU_ASSERT_EQUAL(iov[1].iov_base, buffer);
+	CU_ASSERT_EQUAL(iov[1].iov_len, 1);
+	ret = rs_rb_get_write_iovec(&rb, iov);
+	CU_ASSERT_EQUAL(ret, 1);
+	CU_ASSERT_EQUAL(iov[0].iov_base, buffer + 1);
+	CU_ASSERT_EQUAL(iov[0].iov_len, 3);
+	rs_rb_write_incr(&rb, 3);
+	CU_ASSERT_EQUAL(rs_rb_get_write_iovec(&rb, iov), 0);
+	rs_rb_clean(&rb);
+	/* the mirrored buffer never wraps */
+	ret = rs_rb_init(&rb, NULL, 1);
+	CU_ASSERT_EQUAL_FATAL(ret, 0);
+	rs_rb_write_incr(&rb, rb.size - 1);
+	rs_rb_read_incr(&rb, rb.size - 1);
+	ret = rs_rb_get_write_iovec(&rb, iov);
+	CU_ASSERT_EQUAL(ret, 1);
+	CU_ASSERT_EQUAL(iov[0].iov_len, rb.size);
+	rs_rb_write_incr(&rb, 2);
+	ret = rs_rb_get_read_iovec(&rb, iov);
+	CU_ASSERT_EQUAL(ret, 1);
+	CU_ASSERT_EQUAL(iov[0].iov_len, 2);
+
+	/* error use cases */
+	ret = rs_rb_get_read_iovec(NULL, iov);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+	ret = rs_rb_get_read_iovec(&rb, NULL);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+	ret = rs_rb_get_write_iovec(NULL, iov);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+	ret = rs_rb_get_write_iovec(&rb, NULL);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+
+	/* cleanup */
+	rs_rb_clean(&rb);
+}
+
+static void testRS_RB_COPY(void)
+{
+	struct rs_rb rb;
+	int ret;
+	char buffer[8];
+	char out[8];
+
+	ret = rs_rb_init(&rb, buffer, sizeof(buffer));
+	CU_ASSERT_EQUAL_FATAL(ret, 0);
+
+	/* normal use cases */
+	ret = rs_rb_copy_in(&rb, "abcdef", 6);
+	CU_ASSERT_EQUAL(ret, 0);
+	ret = rs_rb_copy_out(&rb, out, 4);
+	CU_ASSERT_EQUAL(ret, 0);
+	CU_ASSERT_EQUAL(memcmp(out, "abcd", 4), 0);
+	/* wraps at the end of the buffer */
+	ret = rs_rb_copy_in(&rb, "ghijkl", 6);
+	CU_ASSERT_EQUAL(ret, 0);
+	CU_ASSERT_EQUAL(memcmp(buffer, "ijkl", 4), 0);
+	ret = rs_rb_peek(&rb, 3, out, 4);
+	CU_ASSERT_EQUAL(ret, 0);
+	CU_ASSERT_EQUAL(memcmp(out, "hijk", 4), 0);
+	CU_ASSERT_EQUAL(rs_rb_get_read_length(&rb), 8);
+	ret = rs_rb_copy_out(&rb, out, 8);
+	CU_ASSERT_EQUAL(ret, 0);
+	CU_ASSERT_EQUAL(memcmp(out, "efghijkl", 8), 0);
+	ret = rs_rb_copy_in(&rb, NULL, 0);
+	CU_ASSERT_EQUAL(ret, 0);
+
+	/* error use cases */
+	ret = rs_rb_copy_out(&rb, out, 1);
+	CU_ASSERT_EQUAL(ret, -ENOSR);
+	ret = rs_rb_copy_in(&rb, "abcdefghi", 9);
+	CU_ASSERT_EQUAL(ret, -ENOBUFS);
+	rs_rb_copy_in(&rb, "ab", 2);
+	ret = rs_rb_peek(&rb, 1, out, 2);
+	CU_ASSERT_EQUAL(ret, -ENOSR);
+	ret = rs_rb_peek(&rb, 3, out, 0);
+	CU_ASSERT_EQUAL(ret, -ENOSR);
+	ret = rs_rb_peek(NULL, 0, out, 1);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+	ret = rs_rb_peek(&rb, 0, NULL, 1);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+	ret = rs_rb_copy_out(NULL, out, 1);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+	ret = rs_rb_copy_in(NULL, "a", 1);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+	ret = rs_rb_copy_in(&rb, NULL, 1);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+
+	/* cleanup */
+	rs_rb_clean(&rb);
+}
+
+static void testRS_RB_SEARCH(void)
+{
+	struct rs_rb rb;
+	struct rs_rb mirrored;
+	int ret;
+	char buffer[8];
+	size_t position;
+
+	ret = rs_rb_init(&rb, buffer, sizeof(buffer));
+	CU_ASSERT_EQUAL_FATAL(ret, 0);
+	ret = rs_rb_init(&mirrored, NULL, 1);
+	CU_ASSERT_EQUAL_FATAL(ret, 0);
+	/* "xxx\r\nyy\r" stored from offset 5, wrapping after "xxx" */
+	rs_rb_write_incr(&rb, 5);
+	rs_rb_read_incr(&rb, 5);
+	rs_rb_copy_in(&rb, "xxx\r\nyy\r", 8);
+	rs_rb_write_incr(&mirrored, mirrored.size - 3);
+	rs_rb_read_incr(&mirrored, mirrored.size - 3);
+	rs_rb_copy_in(&mirrored, "xxx\r\nyy\r", 8);
+
+	/* normal use cases */
+	ret = rs_rb_search(&rb, 0, "\r\n", 2, &position);
+	CU_ASSERT_EQUAL(ret, 0);
+	CU_ASSERT_EQUAL(position, 3);
+	ret = rs_rb_search(&mirrored, 0, "\r\n", 2, &position);
+	CU_ASSERT_EQUAL(ret, 0);
+	CU_ASSERT_EQUAL(position, 3);
+	/* straddling the end of the buffer */
+	ret = rs_rb_search(&rb, 0, "xx\r\ny", 5, &position);
+	CU_ASSERT_EQUAL(ret, 0);
+	CU_ASSERT_EQUAL(position, 1);
+	ret = rs_rb_search(&rb, 0, "x", 1, &position);
+	CU_ASSERT_EQUAL(ret, 0);
+	CU_ASSERT_EQUAL(position, 0);
+	ret = rs_rb_search(&rb, 1, "\r", 1, &position);
+	CU_ASSERT_EQUAL(ret, 0);
+	CU_ASSERT_EQUAL(position, 3);
+	ret = rs_rb_search(&rb, 4, "\r", 1, &position);
+	CU_ASSERT_EQUAL(ret, 0);
+	CU_ASSERT_EQUAL(position, 7);
+	ret = rs_rb_search(&mirrored, 4, "\r", 1, &position);
+	CU_ASSERT_EQUAL(ret, 0);
+	CU_ASSERT_EQUAL(position, 7);
+
+	/* error use cases */
+	ret = rs_rb_search(&rb, 0, "\n\n", 2, &position);
+	CU_ASSERT_EQUAL(ret, -ENOENT);
+	ret = rs_rb_search(&rb, 5, "\r\n", 2, &position);
+	CU_ASSERT_EQUAL(ret, -ENOENT);
+	ret = rs_rb_search(&rb, 7, "\r\n", 2, &position);
+	CU_ASSERT_EQUAL(ret, -ENOENT);
+	ret = rs_rb_search(&rb, 9, "\r", 1, &position);
+	CU_ASSERT_EQUAL(ret, -ENOENT);
+	ret = rs_rb_search(NULL, 0, "\r", 1, &position);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+	ret = rs_rb_search(&rb, 0, NULL, 1, &position);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+	ret = rs_rb_search(&rb, 0, "\r", 0, &position);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+	ret = rs_rb_search(&rb, 0, "\r", 1, NULL);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+
+	/* cleanup */
+	rs_rb_clean(&mirrored);
+	rs_rb_clean(&rb);
+}
+
+static void testRS_RB_FD(void)
+{
+	struct rs_rb rb;
+	ssize_t sret;
+	int ret;
+	char buffer[8];
+	char out[8];
+	int pipefd[2];
+
+	ret = rs_rb_init(&rb, buffer, sizeof(buffer));
+	CU_ASSERT_EQUAL_FATAL(ret, 0);
+	ret = pipe(pipefd);
+	CU_ASSERT_EQUAL_FATAL(ret, 0);
+
+	/* normal use cases */
+	rs_rb_write_incr(&rb, 5);
+	rs_rb_read_incr(&rb, 5);
+	CU_ASSERT_EQUAL(write(pipefd[1], "abcdefghij", 10), 10);
+	/* fills the room with one call, across the end of the buffer */
+	sret = rs_rb_read_from_fd(&rb, pipefd[0]);
+	CU_ASSERT_EQUAL(sret, 8);
+	CU_ASSERT_EQUAL(rs_rb_get_read_length(&rb), 8);
+	CU_ASSERT_EQUAL(memcmp(buffer, "defghabc", 8), 0);
+	sret = rs_rb_write_to_fd(&rb, pipefd[1]);
+	CU_ASSERT_EQUAL(sret, 8);
+	CU_ASSERT_EQUAL(rs_rb_get_read_length(&rb), 0);
+	CU_ASSERT_EQUAL(read(pipefd[0], out, sizeof(out)), 8);
+	CU_ASSERT_EQUAL(memcmp(out, "ijabcdef", 8), 0);
+	CU_ASSERT_EQUAL(read(pipefd[0], out, sizeof(out)), 2);
+	CU_ASSERT_EQUAL(memcmp(out, "gh", 2), 0);
+	sret = rs_rb_write_to_fd(&rb, pipefd[1]);
+	CU_ASSERT_EQUAL(sret, 0);
+	close(pipefd[1]);
+	sret = rs_rb_read_from_fd(&rb, pipefd[0]);
+	CU_ASSERT_EQUAL(sret, 0);
+
+	/* error use cases */
+	rs_rb_write_incr(&rb, 8);
+	sret = rs_rb_read_from_fd(&rb, pipefd[0]);
+	CU_ASSERT_EQUAL(sret, -ENOBUFS);
+	sret = rs_rb_write_to_fd(&rb, pipefd[0]);
+	CU_ASSERT_EQUAL(sret, -EBADF);
+	sret = rs_rb_read_from_fd(NULL, pipefd[0]);
+	CU_ASSERT_EQUAL(sret, -EINVAL);
+	sret = rs_rb_read_from_fd(&rb, -1);
+	CU_ASSERT_EQUAL(sret, -EINVAL);
+	sret = rs_rb_write_to_fd(NULL, pipefd[1]);
+	CU_ASSERT_EQUAL(sret, -EINVAL);
+	sret = rs_rb_write_to_fd(&rb, -1);
+	CU_ASSERT_EQUAL(sret, -EINVAL);
+
+	/* cleanup */
+	close(pipefd[0]);
+	rs_rb_clean(&rb);
+}
+
 static const struct test_t tests[] = {
 		{
 				.fn = testRS_RB_INIT,
 				.name = "rs_rb_init"
 		},
+		{
+				.fn = testRS_RB_INIT_MIRRORED,
+				.name = "rs_rb_init_mirrored"
+		},
+		{
+				.fn = testRS_RB_INIT_FROM_FD,
+				.name = "rs_rb_init_from_fd"
+		},
+		{
+				.fn = testRS_RB_INIT_FROM_FD_AT,
+				.name = "rs_rb_init_from_fd_at"
+		},
 		{
 				.fn = testRS_RB_GET_SIZE,
 				.name = "rs_rb_get_size"
@@ -448,6 +860,22 @@ static const struct test_t tests[] = {
 				.fn = testRS_RB_WRITE_INCR,
 				.name = "rs_rb_write_incr"
 		},
+		{
+				.fn = testRS_RB_IOVEC,
+				.name = "rs_rb_iovec"
+		},
+		{
+				.fn = testRS_RB_COPY,
+				.name = "rs_rb_copy"
+		},
+		{
+				.fn = testRS_RB_SEARCH,
+				.name = "rs_rb_search"
+		},
+		{
+				.fn = testRS_RB_FD,
+				.name = "rs_rb_fd"
+		},
 
 		/* NULL guard */
 		{.fn = NULL, .name = NULL},
@@ -0,0 +1,314 @@
+/**
+ * @file rs_rbtree_test.c
+ * @date 19 oct. 2026
+ * @author nicolas.carrier@parrot.com
+ * @brief unit tests for librs intrusive red-black tree implementation
+ *
+ * Copyright (C) 2026 Parrot S.A.
+ */
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <errno.h>
+
+#include <CUnit/Basic.h>
+
+#include <ut_utils.h>
+
+#include <fautes.h>
+
+#include <rs_rbtree.h>
+
+#define NB_TIMERS 1000
+
+struct timer {
+	int expiry;
+	int id;
+	struct rs_rbtree_node node;
+};
+
+static struct timer *to_timer(const struct rs_rbtree_node *node)
+{
+	return NULL == node ? NULL :
+			ut_container_of(node, struct timer, node);
+}
+
+static int timer_compare(struct rs_rbtree_node *a,
+		const struct rs_rbtree_node *b)
+{
+	return to_timer(a)->expiry - to_timer(b)->expiry;
+}
+
+static const struct rs_rbtree_vtable vtable = {
+	.compare = timer_compare,
+};
+
+/* returns the black height of a subtree, -1 if it's invalid */
+static int check_subtree(const struct rs_rbtree_node *node,
+		const struct rs_rbtree_node *parent)
+{
+	int left;
+	int right;
+
+	if (NULL == node)
+		return 1;
+	if (node->parent != parent)
+		return -1;
+	if (node->red && ((node->left != NULL && node->left->red) ||
+			(node->right != NULL && node->right->red)))
+		return -1;
+	if (node->left != NULL && timer_compare(node->left, node) > 0)
+		return -1;
+	if (node->right != NULL && timer_compare(node->right, node) < 0)
+		return -1;
+	left = check_subtree(node->left, node);
+	right = check_subtree(node->right, node);
+	if (left < 0 || left != right)
+		return -1;
+
+	return left + !node->red;
+}
+
+static bool tree_is_valid(const struct rs_rbtree *tree)
+{
+	if (tree->root != NULL && tree->root->red)
+		return false;
+
+	return check_subtree(tree->root, NULL) > 0;
+}
+
+/* checks the order and the count, walking forward and backward */
+static bool tree_is_sorted(const struct rs_rbtree *tree)
+{
+	struct rs_rbtree_node *node;
+	size_t count = 0;
+
+	for (node = rs_rbtree_first(tree); node != NULL;
+			node = rs_rbtree_next(node)) {
+		count++;
+		if (rs_rbtree_next(node) != NULL &&
+				timer_compare(node, rs_rbtree_next(node)) > 0)
+			return false;
+	}
+	if (count != rs_rbtree_get_count(tree))
+		return false;
+	for (node = rs_rbtree_last(tree); node != NULL;
+			node = rs_rbtree_prev(node))
+		count--;
+
+	return count == 0;
+}
+
+static int count_cb(struct rs_rbtree_node *node, void *data)
+{
+	int *count = data;
+
+	(*count)++;
+
+	return 0;
+}
+
+static void testRS_RBTREE_INIT(void)
+{
+	int ret;
+	struct rs_rbtree tree;
+	struct rs_rbtree_vtable incomplete = {.compare = NULL};
+
+	/* normal use cases */
+	ret = rs_rbtree_init(&tree, &vtable);
+	CU_ASSERT_EQUAL(ret, 0);
+	CU_ASSERT_EQUAL(rs_rbtree_get_count(&tree), 0);
+	CU_ASSERT_PTR_NULL(rs_rbtree_first(&tree));
+	CU_ASSERT_PTR_NULL(rs_rbtree_last(&tree));
+	CU_ASSERT_PTR_NULL(rs_rbtree_pop(&tree));
+	ret = rs_rbtree_clean(&tree);
+	CU_ASSERT_EQUAL(ret, 0);
+
+	/* error use cases */
+	ret = rs_rbtree_init(NULL, &vtable);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+	ret = rs_rbtree_init(&tree, NULL);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+	ret = rs_rbtree_init(&tree, &incomplete);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+	ret = rs_rbtree_clean(NULL);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+	CU_ASSERT_EQUAL(rs_rbtree_get_count(NULL), 0);
+}
+
+static void testRS_RBTREE_INSERT(void)
+{
+	int ret;
+	int i;
+	int count = 0;
+	bool ok = true;
+	struct rs_rbtree tree;
+	static struct timer t[NB_TIMERS];
+
+	ret = rs_rbtree_init(&tree, &vtable);
+	CU_ASSERT_EQUAL_FATAL(ret, 0);
+
+	/* normal use cases */
+	/* ascending, descending then random, with a lot of duplicates */
+	srand(42);
+	for (i = 0; i < NB_TIMERS; i++) {
+		t[i].id = i;
+		if (i < NB_TIMERS / 3)
+			t[i].expiry = i;
+		else if (i < 2 * NB_TIMERS / 3)
+			t[i].expiry = NB_TIMERS - i;
+		else
+			t[i].expiry = rand() % 100;
+		ok = ok && rs_rbtree_insert(&tree, &t[i].node) == 0;
+	}
+	CU_ASSERT(ok);
+	CU_ASSERT_EQUAL(rs_rbtree_get_count(&tree), NB_TIMERS);
+	CU_ASSERT(tree_is_valid(&tree));
+	CU_ASSERT(tree_is_sorted(&tree));
+	/* equal nodes are kept in insertion order */
+	for (i = 1; i < NB_TIMERS; i++)
+		ok = ok && (to_timer(rs_rbtree_next(&t[i].node)) == NULL ||
+				to_timer(rs_rbtree_next(&t[i].node))->expiry >
+				t[i].expiry ||
+				to_timer(rs_rbtree_next(&t[i].node))->id >
+				t[i].id);
+	CU_ASSERT(ok);
+	CU_ASSERT_EQUAL(to_timer(rs_rbtree_first(&tree))->expiry, 0);
+	CU_ASSERT_EQUAL(to_timer(rs_rbtree_last(&tree))->expiry,
+			NB_TIMERS - NB_TIMERS / 3);
+
+	/* error use cases */
+	ret = rs_rbtree_insert(NULL, &t[0].node);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+	ret = rs_rbtree_insert(&tree, NULL);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+	CU_ASSERT_PTR_NULL(rs_rbtree_first(NULL));
+	CU_ASSERT_PTR_NULL(rs_rbtree_next(NULL));
+	CU_ASSERT_PTR_NULL(rs_rbtree_prev(NULL));
+
+	/* cleanup, the callback is called on each node */
+	ret = rs_rbtree_clean_cb(&tree, count_cb, &count);
+	CU_ASSERT_EQUAL(ret, 0);
+	CU_ASSERT_EQUAL(count, NB_TIMERS);
+	CU_ASSERT_EQUAL(rs_rbtree_get_count(&tree), 0);
+	CU_ASSERT_PTR_NULL(tree.root);
+}
+
+static void testRS_RBTREE_FIND(void)
+{
+	int ret;
+	int i;
+	struct rs_rbtree tree;
+	struct timer t[10];
+	struct timer key;
+
+	ret = rs_rbtree_init(&tree, &vtable);
+	CU_ASSERT_EQUAL_FATAL(ret, 0);
+	/* expiries 0, 0, 2, 2, 4, 4... */
+	for (i = 0; i < 10; i++) {
+		t[i] = (struct timer) {.expiry = i & ~1, .id = i};
+		rs_rbtree_insert(&tree, &t[i].node);
+	}
+
+	/* normal use cases */
+	key.expiry = 4;
+	CU_ASSERT_PTR_EQUAL(to_timer(rs_rbtree_find(&tree, &key.node)), &t[4]);
+	key.expiry = 3;
+	CU_ASSERT_PTR_NULL(rs_rbtree_find(&tree, &key.node));
+	CU_ASSERT_PTR_EQUAL(to_timer(rs_rbtree_lower_bound(&tree, &key.node)),
+			&t[4]);
+	key.expiry = -1;
+	CU_ASSERT_PTR_EQUAL(to_timer(rs_rbtree_lower_bound(&tree, &key.node)),
+			&t[0]);
+	key.expiry = 9;
+	CU_ASSERT_PTR_NULL(rs_rbtree_lower_bound(&tree, &key.node));
+
+	/* error use cases */
+	CU_ASSERT_PTR_NULL(rs_rbtree_find(NULL, &key.node));
+	CU_ASSERT_PTR_NULL(rs_rbtree_find(&tree, NULL));
+	CU_ASSERT_PTR_NULL(rs_rbtree_lower_bound(NULL, &key.node));
+
+	/* cleanup */
+	rs_rbtree_clean(&tree);
+}
+
+static void testRS_RBTREE_REMOVE(void)
+{
+	int ret;
+	int i;
+	int j;
+	bool ok = true;
+	struct rs_rbtree tree;
+	static struct timer t[NB_TIMERS];
+	bool in_tree[NB_TIMERS] = {false};
+	struct timer *timer;
+
+	ret = rs_rbtree_init(&tree, &vtable);
+	CU_ASSERT_EQUAL_FATAL(ret, 0);
+
+	/* normal use cases */
+	/* random insertions and removals, checking the tree each time */
+	srand(42);
+	for (i = 0; i < 10 * NB_TIMERS; i++) {
+		j = rand() % NB_TIMERS;
+		if (in_tree[j]) {
+			ok = ok && rs_rbtree_remove(&tree, &t[j].node) == 0;
+		} else {
+			t[j] = (struct timer) {.expiry = rand() % 500, .id = j};
+			ok = ok && rs_rbtree_insert(&tree, &t[j].node) == 0;
+		}
+		in_tree[j] = !in_tree[j];
+		ok = ok && tree_is_valid(&tree);
+	}
+	CU_ASSERT(ok);
+	CU_ASSERT(tree_is_sorted(&tree));
+	/* pop returns the nodes in order, the tree stays valid */
+	j = -1;
+	while ((timer = to_timer(rs_rbtree_pop(&tree))) != NULL) {
+		ok = ok && timer->expiry >= j && tree_is_valid(&tree);
+		j = timer->expiry;
+	}
+	CU_ASSERT(ok);
+	CU_ASSERT_EQUAL(rs_rbtree_get_count(&tree), 0);
+
+	/* error use cases */
+	ret = rs_rbtree_remove(&tree, &t[0].node);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+	ret = rs_rbtree_remove(NULL, &t[0].node);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+	ret = rs_rbtree_remove(&tree, NULL);
+	CU_ASSERT_EQUAL(ret, -EINVAL);
+	CU_ASSERT_PTR_NULL(rs_rbtree_pop(NULL));
+
+	/* cleanup */
+	rs_rbtree_clean(&tree);
+}
+
+static const struct test_t tests[] = {
+		{
+				.fn = testRS_RBTREE_INIT,
+				.name = "rs_rbtree_init"
+		},
+		{
+				.fn = testRS_RBTREE_INSERT,
+				.name = "rs_rbtree_insert"
+		},
+		{
+				.fn = testRS_RBTREE_FIND,
+				.name = "rs_rbtree_find"
+		},
+		{
+				.fn = testRS_RBTREE_REMOVE,
+				.name = "rs_rbtree_remove"
+		},
+
+		/* NULL guard */
+		{.fn = NULL, .name = NULL},
+};
+
+struct suite_t rbtree_suite = {
+		.name = "rs_rbtree",
+		.init = NULL,
+		.clean = NULL,
+		.tests = tests,
+};
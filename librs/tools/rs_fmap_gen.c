@@ -0,0 +1,246 @@
+/**
+ * @file rs_fmap_gen.c
+ * @brief Generator of frozen maps, builds a frozen map from a list of keys and
+ * writes it as a C source file defining a constant struct rs_fmap, which
+ * needs neither heap nor construction at runtime.
+ *
+ * usage: rs_fmap_gen [-i header]... [-o output] name [input]
+ *
+ * Each line of the input, stdin by default, is a key, optionally followed by
+ * blanks and by a C constant expression, the data associated to the key, NULL
+ * if absent. Keys can't contain blanks, empty lines and lines starting with #
+ * are ignored. The headers given with -i are included by the generated file,
+ * e.g. for it to see the declarations the data expressions refer to. The map
+ * is defined with the external linkage, under the given name.
+ *
+ * Copyright (C) 2026 Parrot S.A.
+ */
+#include <unistd.h>
+
+#include <stdbool.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <ctype.h>
+#include <errno.h>
+#include <error.h>
+
+#include <rs_fmap.h>
+
+/* number of seeds per line of the generated file */
+#define SEEDS_PER_LINE 6
+
+struct line {
+	char *key;
+	char *expression;
+};
+
+static struct line *lines;
+static size_t nb_lines;
+
+static void usage(const char *progname)
+{
+	fprintf(stderr, "usage: %s [-i header]... [-o output] name [input]\n",
+			progname);
+	exit(EXIT_FAILURE);
+}
+
+static void add_line(char *key, char *expression)
+{
+	struct line *new_lines;
+
+	new_lines = realloc(lines, (nb_lines + 1) * sizeof(*lines));
+	if (NULL == new_lines)
+		error(EXIT_FAILURE, ENOMEM, "realloc");
+	lines = new_lines;
+	lines[nb_lines].key = strdup(key);
+	lines[nb_lines].expression = strdup(expression);
+	if (NULL == lines[nb_lines].key || NULL == lines[nb_lines].expression)
+		error(EXIT_FAILURE, ENOMEM, "strdup");
+	nb_lines++;
+}
+
+static void read_input(FILE *input, const char *input_name)
+{
+	char *buf = NULL;
+	size_t size = 0;
+	unsigned line_number = 0;
+	char *key;
+	char *expression;
+	char *end;
+
+	while (getline(&buf, &size, input) != -1) {
+		line_number++;
+		end = buf + strlen(buf);
+		while (end > buf && isspace((unsigned char)end[-1]))
+			*--end = '\0';
+		for (key = buf; isblank((unsigned char)*key); key++)
+			;
+		if (*key == '\0' || *key == '#')
+			continue;
+		for (expression = key; *expression != '\0' &&
+				!isblank((unsigned char)*expression);
+				expression++)
+			;
+		if (*expression != '\0')
+			*expression++ = '\0';
+		while (isblank((unsigned char)*expression))
+			expression++;
+		add_line(key, expression);
+	}
+	if (ferror(input))
+		error(EXIT_FAILURE, errno, "%s:%u", input_name, line_number);
+	free(buf);
+}
+
+/* prints a key as a C string literal, escaping all but printable ASCII */
+static void print_key(FILE *output, const char *key)
+{
+	const unsigned char *c;
+
+	fputc('"', output);
+	for (c = (const unsigned char *)key; *c != '\0'; c++) {
+		if (*c == '"' || *c == '\\' || *c == '?')
+			fprintf(output, "\\%c", *c);
+		else if (*c >= 0x20 && *c < 0x7f)
+			fputc(*c, output);
+		else
+			fprintf(output, "\\%03o", *c);
+	}
+	fputc('"', output);
+}
+
+static void print_map(FILE *output, const struct rs_fmap *map,
+		const char *name, const char *input_name, char **headers,
+		int nb_headers)
+{
+	const struct line *line;
+	uint32_t i;
+	int j;
+
+	fprintf(output, "/*\n * generated by rs_fmap_gen from %s, "
+			"do not edit\n */\n", input_name);
+	fprintf(output, "#include <stddef.h>\n#include <stdint.h>\n\n");
+	fprintf(output, "#include <rs_fmap.h>\n");
+	if (nb_headers != 0)
+		fputc('\n', output);
+	for (j = 0; j < nb_headers; j++)
+		fprintf(output, "#include \"%s\"\n", headers[j]);
+	fprintf(output, "\n#if RS_FMAP_VERSION != %d\n"
+			"#error \"generated for another version of rs_fmap\"\n"
+			"#endif\n\n", RS_FMAP_VERSION);
+
+	fprintf(output, "static const uint32_t %s_seeds[] = {", name);
+	for (i = 0; i < map->nb_buckets; i++)
+		fprintf(output, "%s0x%08x,", i % SEEDS_PER_LINE == 0 ?
+				"\n\t" : " ", map->seeds[i]);
+	fprintf(output, "\n};\n\n");
+
+	if (map->nb_entries != 0) {
+		fprintf(output, "static const struct rs_fmap_entry "
+				"%s_entries[] = {\n", name);
+		for (i = 0; i < map->nb_entries; i++) {
+			line = lines + (uintptr_t)map->entries[i].data;
+			fprintf(output, "\t{");
+			print_key(output, line->key);
+			if (*line->expression == '\0')
+				fprintf(output, ", NULL},\n");
+			else
+				fprintf(output, ", (void *)(%s)},\n",
+						line->expression);
+		}
+		fprintf(output, "};\n\n");
+	}
+
+	fprintf(output, "const struct rs_fmap %s = {\n", name);
+	fprintf(output, "\t.seeds = %s_seeds,\n", name);
+	fprintf(output, "\t.nb_buckets = %u,\n", map->nb_buckets);
+	fprintf(output, "\t.nb_entries = %u,\n", map->nb_entries);
+	if (map->nb_entries != 0)
+		fprintf(output, "\t.entries = %s_entries,\n", name);
+	else
+		fprintf(output, "\t.entries = NULL,\n");
+	fprintf(output, "};\n");
+}
+
+int main(int argc, char *argv[])
+{
+	int ret;
+	int opt;
+	size_t i;
+	const char *name;
+	const char *input_name = "stdin";
+	const char *output_name = NULL;
+	char **headers;
+	int nb_headers = 0;
+	FILE *input = stdin;
+	FILE *output = stdout;
+	struct rs_fmap map;
+	struct rs_fmap_entry *entries;
+
+	headers = calloc(argc, sizeof(*headers));
+	if (NULL == headers)
+		error(EXIT_FAILURE, ENOMEM, "calloc");
+	while ((opt = getopt(argc, argv, "i:o:")) != -1) {
+		switch (opt) {
+		case 'i':
+			headers[nb_headers++] = optarg;
+			break;
+
+		case 'o':
+			output_name = optarg;
+			break;
+
+		default:
+			usage(argv[0]);
+		}
+	}
+	if (optind != argc - 1 && optind != argc - 2)
+		usage(argv[0]);
+	name = argv[optind];
+	if (optind == argc - 2) {
+		input_name = argv[optind + 1];
+		input = fopen(input_name, "r");
+		if (NULL == input)
+			error(EXIT_FAILURE, errno, "fopen %s", input_name);
+	}
+	read_input(input, input_name);
+	if (input != stdin)
+		fclose(input);
+
+	entries = calloc(nb_lines, sizeof(*entries));
+	if (NULL == entries && nb_lines != 0)
+		error(EXIT_FAILURE, ENOMEM, "calloc");
+	/* the data of each entry is the index of it's line */
+	for (i = 0; i < nb_lines; i++) {
+		entries[i].key = lines[i].key;
+		entries[i].data = (void *)(uintptr_t)i;
+	}
+	ret = rs_fmap_init(&map, entries, nb_lines);
+	if (ret < 0)
+		error(EXIT_FAILURE, -ret, "rs_fmap_init");
+
+	if (NULL != output_name) {
+		output = fopen(output_name, "w");
+		if (NULL == output)
+			error(EXIT_FAILURE, errno, "fopen %s", output_name);
+	}
+	print_map(output, &map, name, input_name, headers, nb_headers);
+	if (fclose(output) != 0) {
+		if (NULL != output_name)
+			unlink(output_name);
+		error(EXIT_FAILURE, errno, "fclose");
+	}
+
+	rs_fmap_clean(&map);
+	free(entries);
+	for (i = 0; i < nb_lines; i++) {
+		free(lines[i].key);
+		free(lines[i].expression);
+	}
+	free(lines);
+	free(headers);
+
+	return EXIT_SUCCESS;
+}